@@ -16,6 +16,7 @@
 #include "plugin_src/PlatformFileDialogs.h"
 #include "plugin_src/params/DynamicParamSchema.h"
 #include "plugin_src/morph/MorphFactory.h"
+#include "plugin_src/audio/FFTPlanner.h"
 #include "plugin_src/modules/WindowCoordinator.h"
 #include "plugin_src/modules/WindowModeHelpers.h"
 #include <thread>
@@ -26,7 +27,7 @@
 
 SynapticResynthesis::SynapticResynthesis(const InstanceInfo& info)
 : Plugin(info, MakeConfig(synaptic::ParameterManager::GetTotalParams(), kNumPresets))
-, mBrainManager(&mBrain, &mAnalysisWindow)
+, mBrainManager(&mBrain)
 , mDSPContext(2)
 , mWindowCoordinator(&mAnalysisWindow, &mDSPContext.GetOutputWindow(), &mBrain, &mDSPContext.GetChunker(), &mParamManager, &mBrainManager)
 , mUISyncManager(this, &mBrain, &mBrainManager, &mParamManager, &mWindowCoordinator, &mDSPConfig)
@@ -61,7 +62,7 @@ SynapticResynthesis::SynapticResynthesis(const InstanceInfo& info)
   MakePreset("Three", 0.);
 
   // Initialize DSP Context
-  mDSPContext.Init(this, &mParamManager, &mBrain, mDSPConfig);
+  mDSPContext.Init(&mBrain, mDSPConfig);
 
   // Initialize analysis window
   mAnalysisWindow.Set(synaptic::Window::Type::Hann, mDSPConfig.chunkSize);
@@ -91,6 +92,9 @@ SynapticResynthesis::~SynapticResynthesis()
 {
   // Unregister progress overlay manager
   synaptic::ui::ProgressOverlayManager::Unregister(this);
+
+  // Make sure a brain save started by the last project save is on disk before we go away
+  mBrainManager.FlushPendingWrites();
 }
 
 void SynapticResynthesis::ProcessBlock(sample** inputs, sample** outputs, int nFrames)
@@ -117,7 +121,13 @@ void SynapticResynthesis::OnReset()
   if (analysisWindowIdx >= 0) mDSPConfig.analysisWindowMode = synaptic::WindowMode::ParamToConfig(GetParam(analysisWindowIdx)->Int());
   if (enableOverlapIdx >= 0) mDSPConfig.enableOverlapAdd = GetParam(enableOverlapIdx)->Bool();
 
+  // Plan the FFT size off the audio thread; Configure() on the audio thread then only hits the table
+  synaptic::FFTPlanner::Instance().Plan(mDSPConfig.chunkSize);
+  synaptic::FFTPlanner::Instance().SaveCostTable();
+
   mWindowCoordinator.UpdateBrainAnalysisWindow(mDSPConfig);
+  // Brain layers are analyzed at the host rate, like rechunks
+  mBrainManager.SetAnalysisSampleRate((int) sr);
 
   mDSPContext.OnReset(sr, GetBlockSize(), NInChansConnected(), this, mDSPConfig, &mParamManager, &mBrain);
 
@@ -0,0 +1,493 @@
+/**
+ * @file ProcessBlockBenchmark.cpp
+ * @brief Headless benchmark of the DSP hot paths
+ *
+ * Drives DSPContext::ProcessBlock with synthetic input over a matrix of chunk sizes, host block
+ * sizes, channel counts, brain sizes, transformers, morphs and autotune on/off, and prints one
+ * JSON document that CI can keep as a baseline. Each case reports:
+ * - nsPerSample: processing time per sample frame (all channels), from the fastest repeat
+ * - realtimeFactor: seconds of audio processed per second of processing, from the fastest repeat
+ * - worstBlockUs / p99BlockUs: block times over all repeats, next to the block's real-time budget
+ * - outputRms: so a change that silences the output doesn't pass as a speedup
+ *
+ * The first half second of every run is processed but not timed (chunker and lookahead filling).
+ * Transformers that don't read the brain run once per case, with brainSeconds 0. Every brain the
+ * matrix needs is built once; "brains" reports that time, i.e. decoding plus Brain::AnalyzeChunk
+ * for every chunk (the analysis cache is disabled, so it is always a full analysis).
+ *
+ * Only the processing core of DSPContext is used, so this builds without a plugin API. From the
+ * project folder inside an iPlug2 checkout (see README):
+ *
+ *   g++ -std=c++17 -O2 -DNDEBUG -DSYNAPTIC_HEADLESS -I. -I../../IPlug -I../../IPlug/Extras -I../../WDL \
+ *     benchmarks/ProcessBlockBenchmark.cpp plugin_src/audio/DSPContext.cpp \
+ *     plugin_src/modules/AudioStreamChunker.cpp plugin_src/brain/Brain.cpp exdeps/pffft/pffft.c \
+ *     -lpthread -ldl -lm -o synaptic-bench
+ *
+ *   ./synaptic-bench --chunk-sizes=512,3000 --transformers=samplebrain > baseline.json
+ *
+ * Input and brain audio are generated from fixed seeds, so every run processes the same audio.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "plugin_src/audio/DSPContext.h"
+#include "plugin_src/audio/FFTPlanner.h"
+#include "plugin_src/audio/Window.h"
+#include "plugin_src/brain/AnalysisCache.h"
+#include "plugin_src/brain/Brain.h"
+#include "plugin_src/modules/DSPConfig.h"
+#include "plugin_src/morph/MorphFactory.h"
+#include "plugin_src/transformers/TransformerFactory.h"
+
+using namespace synaptic;
+
+namespace
+{
+  constexpr double kWarmupSeconds = 0.5;
+  constexpr double kTwoPi = 6.283185307179586;
+
+  struct Options
+  {
+    std::vector<int> chunkSizes { 512, 3000 };
+    std::vector<int> blockSizes { 64, 512 };
+    std::vector<int> channels { 1, 2 };
+    std::vector<int> brainSeconds { 10, 60 };
+    std::vector<std::string> transformers; // UI ids; empty = all
+    std::vector<std::string> morphs;       // UI ids; empty = all
+    std::vector<int> autotune { 0, 1 };    // 0 = off, 1 = full blend
+    double seconds = 5.0;                  // audio processed per run
+    double sampleRate = 48000.0;
+    int repeats = 2;
+    int bufferWindow = 1;
+  };
+
+  struct CaseResult
+  {
+    double nsPerSample = 0.0;
+    double realtimeFactor = 0.0;
+    double meanBlockUs = 0.0;
+    double p99BlockUs = 0.0;
+    double worstBlockUs = 0.0;
+    double outputRms = 0.0;
+    int timedBlocks = 0;
+  };
+
+  struct BuiltBrain
+  {
+    std::unique_ptr<Window> window;
+    std::unique_ptr<Brain> brain;
+    int chunks = 0;
+    double buildSeconds = 0.0;
+  };
+
+  void PrintUsage()
+  {
+    fprintf(stderr,
+      "Usage: synaptic-bench [options] > results.json\n"
+      "  --chunk-sizes=512,3000     chunker/brain chunk sizes (samples)\n"
+      "  --block-sizes=64,512       host block sizes (samples)\n"
+      "  --channels=1,2             channel counts\n"
+      "  --brain-seconds=10,60      synthetic brain lengths (seconds)\n"
+      "  --transformers=ID,...      transformer ids (default: all)\n"
+      "  --morphs=ID,...            morph ids (default: all)\n"
+      "  --autotune=0,1             0 = off, 1 = full blend\n"
+      "  --seconds=5                audio processed per run\n"
+      "  --repeats=2                runs per case\n"
+      "  --sample-rate=48000\n"
+      "  --buffer-window=1          lookahead window size (chunks)\n");
+    std::string ids;
+    for (const auto& id : TransformerFactory::GetUiIds()) ids += " " + id;
+    fprintf(stderr, "Transformers:%s\n", ids.c_str());
+    ids.clear();
+    for (const auto& id : MorphFactory::GetUiIds()) ids += " " + id;
+    fprintf(stderr, "Morphs:%s\n", ids.c_str());
+  }
+
+  std::vector<std::string> SplitList(const std::string& value)
+  {
+    std::vector<std::string> items;
+    std::stringstream ss(value);
+    std::string item;
+    while (std::getline(ss, item, ','))
+      if (!item.empty()) items.push_back(item);
+    return items;
+  }
+
+  bool ParseIntList(const std::string& value, int minValue, std::vector<int>& out)
+  {
+    out.clear();
+    for (const auto& item : SplitList(value))
+    {
+      char* end = nullptr;
+      const long v = strtol(item.c_str(), &end, 10);
+      if (*end != '\0' || v < minValue) return false;
+      out.push_back((int) v);
+    }
+    return !out.empty();
+  }
+
+  bool ParseOptions(int argc, char** argv, Options& o)
+  {
+    for (int i = 1; i < argc; ++i)
+    {
+      const std::string arg = argv[i];
+      const size_t eq = arg.find('=');
+      const std::string name = arg.substr(0, eq);
+      const std::string value = eq == std::string::npos ? std::string() : arg.substr(eq + 1);
+      bool ok = true;
+      if (name == "--chunk-sizes") ok = ParseIntList(value, DSPDefaults::kMinChunkSize, o.chunkSizes);
+      else if (name == "--block-sizes") ok = ParseIntList(value, 1, o.blockSizes);
+      else if (name == "--channels") ok = ParseIntList(value, 1, o.channels);
+      else if (name == "--brain-seconds") ok = ParseIntList(value, 1, o.brainSeconds);
+      else if (name == "--autotune") ok = ParseIntList(value, 0, o.autotune);
+      else if (name == "--transformers") o.transformers = SplitList(value);
+      else if (name == "--morphs") o.morphs = SplitList(value);
+      else if (name == "--seconds") ok = (o.seconds = atof(value.c_str())) > kWarmupSeconds;
+      else if (name == "--repeats") ok = (o.repeats = atoi(value.c_str())) > 0;
+      else if (name == "--sample-rate") ok = (o.sampleRate = atof(value.c_str())) > 0.0;
+      else if (name == "--buffer-window") ok = (o.bufferWindow = atoi(value.c_str())) >= DSPDefaults::kMinBufferWindow;
+      else ok = false;
+      if (!ok)
+      {
+        fprintf(stderr, "Bad option: %s\n", arg.c_str());
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // UI indices for the requested ids (all entries if none were requested)
+  template <class Factory>
+  bool ResolveIds(const std::vector<std::string>& ids, std::vector<int>& indices)
+  {
+    indices.clear();
+    if (ids.empty())
+    {
+      for (int i = 0; i < Factory::GetUiCount(); ++i) indices.push_back(i);
+      return true;
+    }
+    for (const auto& id : ids)
+    {
+      const int index = Factory::IndexOfIdInUi(id);
+      if (index < 0)
+      {
+        fprintf(stderr, "Unknown id: %s\n", id.c_str());
+        return false;
+      }
+      indices.push_back(index);
+    }
+    return true;
+  }
+
+  // Host input: gliding partials under a note-like envelope, plus noise
+  std::vector<std::vector<iplug::sample>> MakeInput(int numChannels, int numFrames, double sampleRate)
+  {
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> noise(-1.0, 1.0);
+    std::vector<std::vector<iplug::sample>> input(numChannels, std::vector<iplug::sample>(numFrames));
+    const int noteFrames = std::max(1, (int) (0.25 * sampleRate));
+    double phase[3] = { 0.0, 0.0, 0.0 };
+    for (int s = 0; s < numFrames; ++s)
+    {
+      const double t = s / sampleRate;
+      const double base = 110.0 * std::pow(2.0, 2.0 * (0.5 + 0.5 * std::sin(kTwoPi * 0.05 * t)));
+      const double env = std::exp(-4.0 * (s % noteFrames) / (double) noteFrames);
+      double v = 0.0;
+      for (int p = 0; p < 3; ++p)
+      {
+        phase[p] += kTwoPi * base * (p + 1) / sampleRate;
+        v += std::sin(phase[p]) / (p + 1);
+      }
+      v = 0.4 * env * v + 0.02 * noise(rng);
+      for (int ch = 0; ch < numChannels; ++ch)
+        input[ch][s] = v * (1.0 - 0.1 * ch);
+    }
+    return input;
+  }
+
+  // Brain audio as a 32-bit float WAV: random notes of a scale with harmonics, some noise bursts
+  std::vector<uint8_t> MakeBrainWav(int numChannels, double seconds, double sampleRate)
+  {
+    const int numFrames = (int) (seconds * sampleRate);
+    std::vector<float> pcm((size_t) numFrames * numChannels);
+    std::mt19937 rng(2);
+    std::uniform_int_distribution<int> degree(0, 24);
+    std::uniform_real_distribution<double> uni(0.0, 1.0);
+    static const int kScale[7] = { 0, 2, 3, 5, 7, 8, 10 };
+
+    int s = 0;
+    while (s < numFrames)
+    {
+      const int len = std::min(numFrames - s, (int) ((0.1 + 0.4 * uni(rng)) * sampleRate));
+      const int d = degree(rng);
+      const double freq = 55.0 * std::pow(2.0, (12 * (d / 7) + kScale[d % 7]) / 12.0);
+      const bool burst = uni(rng) < 0.1;
+      for (int i = 0; i < len; ++i, ++s)
+      {
+        const double env = std::min(1.0, i / (0.005 * sampleRate)) * std::exp(-3.0 * i / len);
+        double v = 0.0;
+        if (burst)
+          v = 2.0 * uni(rng) - 1.0;
+        else
+          for (int h = 1; h <= 4; ++h)
+            v += std::sin(kTwoPi * freq * h * i / sampleRate) / h;
+        for (int ch = 0; ch < numChannels; ++ch)
+          pcm[(size_t) s * numChannels + ch] = (float) (0.3 * env * v);
+      }
+    }
+
+    auto put32 = [](std::vector<uint8_t>& b, uint32_t v) { for (int i = 0; i < 4; ++i) b.push_back((uint8_t) (v >> (8 * i))); };
+    auto put16 = [](std::vector<uint8_t>& b, uint16_t v) { b.push_back((uint8_t) v); b.push_back((uint8_t) (v >> 8)); };
+    const uint32_t dataBytes = (uint32_t) (pcm.size() * sizeof(float));
+    std::vector<uint8_t> wav;
+    wav.reserve(44 + dataBytes);
+    wav.insert(wav.end(), { 'R', 'I', 'F', 'F' });
+    put32(wav, 36 + dataBytes);
+    wav.insert(wav.end(), { 'W', 'A', 'V', 'E', 'f', 'm', 't', ' ' });
+    put32(wav, 16);
+    put16(wav, 3); // IEEE float
+    put16(wav, (uint16_t) numChannels);
+    put32(wav, (uint32_t) sampleRate);
+    put32(wav, (uint32_t) sampleRate * numChannels * sizeof(float));
+    put16(wav, (uint16_t) (numChannels * sizeof(float)));
+    put16(wav, 32);
+    wav.insert(wav.end(), { 'd', 'a', 't', 'a' });
+    put32(wav, dataBytes);
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(pcm.data());
+    wav.insert(wav.end(), bytes, bytes + dataBytes);
+    return wav;
+  }
+
+  BuiltBrain BuildBrain(int chunkSize, int numChannels, int seconds, const Options& o)
+  {
+    BuiltBrain b;
+    b.window = std::make_unique<Window>();
+    b.window->Set(Window::IntToType(DSPDefaults::kAnalysisWindowMode), chunkSize);
+    b.brain = std::make_unique<Brain>();
+    b.brain->SetWindow(b.window.get());
+
+    const std::vector<uint8_t> wav = MakeBrainWav(numChannels, seconds, o.sampleRate);
+    const auto t0 = std::chrono::steady_clock::now();
+    b.brain->AddAudioFileFromMemory(wav.data(), wav.size(), "synthetic.wav", (int) o.sampleRate, numChannels, chunkSize);
+    b.buildSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    b.chunks = b.brain->GetTotalChunks();
+    return b;
+  }
+
+  CaseResult RunCase(int chunkSize, int blockSize, int numChannels, int transformerIndex, int morphIndex, bool autotune,
+                     Brain* brain, const std::vector<std::vector<iplug::sample>>& input, const Options& o)
+  {
+    DSPConfig config;
+    config.chunkSize = chunkSize;
+    config.bufferWindowSize = o.bufferWindow;
+    config.algorithmId = transformerIndex;
+    config.Validate();
+
+    DSPContext dsp(numChannels);
+    dsp.Init(brain, config);
+    dsp.SetPendingMorph(MorphFactory::CreateByUiIndex(morphIndex));
+    dsp.SwapPendingComponents();
+
+    // Windowing as WindowCoordinator sets it up for the plugin
+    Window outputWindow;
+    outputWindow.Set(Window::IntToType(config.outputWindowMode), config.chunkSize);
+    Window analysisWindow;
+    analysisWindow.Set(Window::IntToType(config.analysisWindowMode), config.chunkSize);
+    auto prepare = [&]()
+    {
+      dsp.Prepare(o.sampleRate, numChannels, config);
+      AudioStreamChunker& chunker = dsp.GetChunker();
+      const IChunkBufferTransformer* transformer = dsp.GetTransformerRaw();
+      chunker.EnableOverlap(config.enableOverlapAdd && (!transformer || transformer->WantsOverlapAdd()));
+      chunker.SetOutputWindow(outputWindow);
+      chunker.SetInputAnalysisWindow(analysisWindow);
+      chunker.GetAutotuneProcessor().SetBlend(autotune ? 1.0f : 0.0f);
+    };
+
+    DSPContext::BlockParams params;
+    params.inChans = numChannels;
+    params.outChans = numChannels;
+
+    const int totalFrames = (int) input[0].size();
+    const int warmupFrames = (int) (kWarmupSeconds * o.sampleRate);
+    std::vector<std::vector<iplug::sample>> inBuf(numChannels, std::vector<iplug::sample>(blockSize));
+    std::vector<std::vector<iplug::sample>> outBuf(numChannels, std::vector<iplug::sample>(blockSize));
+    std::vector<iplug::sample*> inPtrs(numChannels), outPtrs(numChannels);
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+      inPtrs[ch] = inBuf[ch].data();
+      outPtrs[ch] = outBuf[ch].data();
+    }
+
+    CaseResult result;
+    std::vector<double> blockNs;
+    blockNs.reserve((size_t) o.repeats * (totalFrames / blockSize + 1));
+    double bestNs = -1.0;
+    int timedFrames = 0;
+    double sumSquares = 0.0;
+
+    for (int r = 0; r < o.repeats; ++r)
+    {
+      prepare();
+      double runNs = 0.0;
+      int runFrames = 0;
+      sumSquares = 0.0;
+      for (int pos = 0; pos < totalFrames; pos += blockSize)
+      {
+        const int n = std::min(blockSize, totalFrames - pos);
+        // ProcessBlock applies the input gain in place, like a host buffer
+        for (int ch = 0; ch < numChannels; ++ch)
+          std::memcpy(inPtrs[ch], input[ch].data() + pos, sizeof(iplug::sample) * n);
+
+        const auto t0 = std::chrono::steady_clock::now();
+        dsp.ProcessBlock(inPtrs.data(), outPtrs.data(), n, params);
+        const double ns = (double) std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+
+        if (pos < warmupFrames) continue;
+        runNs += ns;
+        runFrames += n;
+        blockNs.push_back(ns * blockSize / n); // a short last block counts at full-block rate
+        for (int ch = 0; ch < numChannels; ++ch)
+          for (int s = 0; s < n; ++s)
+            sumSquares += outPtrs[ch][s] * outPtrs[ch][s];
+      }
+      if (bestNs < 0.0 || runNs < bestNs)
+      {
+        bestNs = runNs;
+        timedFrames = runFrames;
+      }
+    }
+
+    if (timedFrames <= 0 || blockNs.empty()) return result;
+    std::sort(blockNs.begin(), blockNs.end());
+    double sumNs = 0.0;
+    for (double ns : blockNs) sumNs += ns;
+
+    result.nsPerSample = bestNs / timedFrames;
+    result.realtimeFactor = bestNs > 0.0 ? (timedFrames / o.sampleRate) / (bestNs * 1e-9) : 0.0;
+    result.meanBlockUs = sumNs / blockNs.size() * 1e-3;
+    result.p99BlockUs = blockNs[std::min(blockNs.size() - 1, (size_t) (0.99 * blockNs.size()))] * 1e-3;
+    result.worstBlockUs = blockNs.back() * 1e-3;
+    result.outputRms = std::sqrt(sumSquares / ((double) timedFrames * numChannels));
+    result.timedBlocks = (int) blockNs.size();
+    return result;
+  }
+
+  bool UsesBrain(int transformerIndex)
+  {
+    auto transformer = TransformerFactory::CreateByUiIndex(transformerIndex);
+    return dynamic_cast<BaseSampleBrainTransformer*>(transformer.get()) != nullptr;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  Options o;
+  for (int i = 1; i < argc; ++i)
+  {
+    if (!strcmp(argv[i], "--help") || !strcmp(argv[i], "-h"))
+    {
+      PrintUsage();
+      return 0;
+    }
+  }
+  std::vector<int> transformerIndices, morphIndices;
+  if (!ParseOptions(argc, argv, o)
+      || !ResolveIds<TransformerFactory>(o.transformers, transformerIndices)
+      || !ResolveIds<MorphFactory>(o.morphs, morphIndices))
+  {
+    PrintUsage();
+    return 2;
+  }
+
+  // Every brain is analyzed from scratch, and nothing is written to the user's cache
+  AnalysisCache::Instance().SetEnabled(false);
+  for (int chunkSize : o.chunkSizes)
+    FFTPlanner::Instance().Plan(chunkSize);
+
+  const int totalFrames = (int) (o.seconds * o.sampleRate);
+  std::map<std::tuple<int, int, int>, BuiltBrain> brains; // (chunk size, channels, seconds)
+  std::map<int, std::vector<std::vector<iplug::sample>>> inputs; // by channel count
+  for (int numChannels : o.channels)
+    inputs[numChannels] = MakeInput(numChannels, totalFrames, o.sampleRate);
+
+  const auto& transformerIds = TransformerFactory::GetUiIds();
+  const auto& morphIds = MorphFactory::GetUiIds();
+
+  printf("{\n  \"version\": 1,\n  \"sampleRate\": %.0f,\n  \"seconds\": %.3f,\n  \"repeats\": %d,\n  \"bufferWindow\": %d,\n",
+         o.sampleRate, o.seconds, o.repeats, o.bufferWindow);
+  printf("  \"cases\": [");
+  bool first = true;
+
+  for (int chunkSize : o.chunkSizes)
+  for (int numChannels : o.channels)
+  for (int transformerIndex : transformerIndices)
+  {
+    const bool usesBrain = UsesBrain(transformerIndex);
+    const std::vector<int> brainSeconds = usesBrain ? o.brainSeconds : std::vector<int> { 0 };
+    for (int seconds : brainSeconds)
+    {
+      BuiltBrain* built = nullptr;
+      if (usesBrain)
+      {
+        const auto key = std::make_tuple(chunkSize, numChannels, seconds);
+        auto it = brains.find(key);
+        if (it == brains.end())
+        {
+          fprintf(stderr, "Building brain: chunk %d, %d ch, %d s\n", chunkSize, numChannels, seconds);
+          it = brains.emplace(key, BuildBrain(chunkSize, numChannels, seconds, o)).first;
+        }
+        built = &it->second;
+      }
+
+      for (int blockSize : o.blockSizes)
+      for (int morphIndex : morphIndices)
+      for (int autotune : o.autotune)
+      {
+        fprintf(stderr, "%s / %s: chunk %d, block %d, %d ch, brain %d s%s\n",
+                transformerIds[transformerIndex].c_str(), morphIds[morphIndex].c_str(),
+                chunkSize, blockSize, numChannels, seconds, autotune ? ", autotune" : "");
+        const CaseResult r = RunCase(chunkSize, blockSize, numChannels, transformerIndex, morphIndex, autotune != 0,
+                                     built ? built->brain.get() : nullptr, inputs[numChannels], o);
+        printf("%s\n    { \"transformer\": \"%s\", \"morph\": \"%s\", \"chunkSize\": %d, \"blockSize\": %d, "
+               "\"channels\": %d, \"brainSeconds\": %d, \"brainChunks\": %d, \"autotune\": %s, "
+               "\"nsPerSample\": %.2f, \"realtimeFactor\": %.2f, \"meanBlockUs\": %.2f, \"p99BlockUs\": %.2f, "
+               "\"worstBlockUs\": %.2f, \"blockBudgetUs\": %.2f, \"timedBlocks\": %d, \"outputRms\": %.6f }",
+               first ? "" : ",", transformerIds[transformerIndex].c_str(), morphIds[morphIndex].c_str(), chunkSize,
+               blockSize, numChannels, seconds, built ? built->chunks : 0, autotune ? "true" : "false",
+               r.nsPerSample, r.realtimeFactor, r.meanBlockUs, r.p99BlockUs, r.worstBlockUs,
+               blockSize / o.sampleRate * 1e6, r.timedBlocks, r.outputRms);
+        first = false;
+        fflush(stdout);
+      }
+    }
+  }
+
+  printf("\n  ],\n  \"brains\": [");
+  first = true;
+  for (const auto& entry : brains)
+  {
+    const int seconds = std::get<2>(entry.first);
+    const double frames = seconds * o.sampleRate;
+    printf("%s\n    { \"chunkSize\": %d, \"channels\": %d, \"brainSeconds\": %d, \"chunks\": %d, "
+           "\"buildSeconds\": %.4f, \"nsPerSample\": %.2f }",
+           first ? "" : ",", std::get<0>(entry.first), std::get<1>(entry.first), seconds, entry.second.chunks,
+           entry.second.buildSeconds, entry.second.buildSeconds * 1e9 / frames);
+    first = false;
+  }
+  printf("\n  ]\n}\n");
+  return 0;
+}
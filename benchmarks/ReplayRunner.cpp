@@ -0,0 +1,535 @@
+/**
+ * @file ReplayRunner.cpp
+ * @brief Replays a recorded session headless, for regression and performance testing
+ *
+ * Loads a replay captured in the plugin (DSP tab, "Session Replay"; see ReplayFile.h) and the brain
+ * snapshot saved with it, and feeds the recorded blocks through DSPContext::ProcessBlock with the
+ * recorded parameter changes applied before each block, the way the plugin applies them. Replaying
+ * starts from a freshly reset context, so the output is a function of the replay file alone: two
+ * runs of the same build must match bit for bit, and a different build (or matching variant) can be
+ * compared against a reference output written by an earlier one.
+ *
+ * Prints one JSON document with block timings (as ProcessBlockBenchmark), a hash of the output,
+ * whether every repeat produced the same output, and, with --compare, where the output first
+ * differs from the reference and by how much.
+ *
+ * Builds like ProcessBlockBenchmark, from the project folder inside an iPlug2 checkout:
+ *
+ *   g++ -std=c++17 -O2 -DNDEBUG -DSYNAPTIC_HEADLESS -I. -I../../IPlug -I../../IPlug/Extras -I../../WDL \
+ *     benchmarks/ReplayRunner.cpp plugin_src/audio/DSPContext.cpp \
+ *     plugin_src/modules/AudioStreamChunker.cpp plugin_src/brain/Brain.cpp exdeps/pffft/pffft.c \
+ *     -lpthread -ldl -lm -o synaptic-replay
+ *
+ *   ./synaptic-replay session.sbrp --write-output=scalar.sbro > scalar.json
+ *   ./synaptic-replay session.sbrp --compare=scalar.sbro --set=matchCache=true > variant.json
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "plugin_src/audio/DSPContext.h"
+#include "plugin_src/audio/FFTPlanner.h"
+#include "plugin_src/audio/ReplayFile.h"
+#include "plugin_src/audio/Window.h"
+#include "plugin_src/brain/Brain.h"
+#include "plugin_src/brain/BrainRegistry.h"
+#include "plugin_src/common/MappedFile.h"
+#include "plugin_src/morph/MorphFactory.h"
+#include "plugin_src/params/ParameterIds.h"
+#include "plugin_src/transformers/TransformerFactory.h"
+
+using namespace synaptic;
+
+namespace
+{
+  constexpr uint32_t kOutputMagic = 0x4F524253; // 'SBRO' Synaptic Brain Replay Output
+  constexpr uint16_t kOutputVersion = 1;
+
+  struct Options
+  {
+    std::string replay;
+    std::string writeOutput; // reference output to write
+    std::string compare;     // reference output to compare against
+    int repeats = 3;
+    std::vector<std::pair<std::string, std::string>> overrides; // --set=id=value, held for the whole replay
+  };
+
+  void PrintUsage()
+  {
+    fprintf(stderr,
+      "Usage: synaptic-replay <session.sbrp> [options] > results.json\n"
+      "  --repeats=3                runs (timings are over all of them)\n"
+      "  --write-output=FILE        save the output as a reference\n"
+      "  --compare=FILE             compare the output with a saved reference\n"
+      "  --set=ID=VALUE             hold a transformer/morph parameter (repeatable)\n");
+  }
+
+  bool ParseOptions(int argc, char** argv, Options& o)
+  {
+    for (int i = 1; i < argc; ++i)
+    {
+      const std::string arg = argv[i];
+      if (arg.compare(0, 2, "--") != 0)
+      {
+        if (!o.replay.empty()) return false;
+        o.replay = arg;
+        continue;
+      }
+      const size_t eq = arg.find('=');
+      if (eq == std::string::npos)
+      {
+        fprintf(stderr, "Missing value: %s\n", arg.c_str());
+        return false;
+      }
+      const std::string name = arg.substr(0, eq);
+      const std::string value = arg.substr(eq + 1);
+      bool ok = true;
+      if (name == "--repeats") ok = (o.repeats = atoi(value.c_str())) > 0;
+      else if (name == "--write-output") o.writeOutput = value;
+      else if (name == "--compare") o.compare = value;
+      else if (name == "--set")
+      {
+        const size_t sep = value.find('=');
+        ok = sep != std::string::npos && sep > 0;
+        if (ok) o.overrides.emplace_back(value.substr(0, sep), value.substr(sep + 1));
+      }
+      else
+      {
+        fprintf(stderr, "Unknown option: %s\n", name.c_str());
+        return false;
+      }
+      if (!ok)
+      {
+        fprintf(stderr, "Bad value for %s: %s\n", name.c_str(), value.c_str());
+        return false;
+      }
+    }
+    return !o.replay.empty();
+  }
+
+  /**
+   * @brief The plugin around DSPContext, as far as a replay needs it
+   * Does what DSPContext::OnReset, ParameterManager and WindowCoordinator do in the plugin when
+   * the recorded parameters change, with the recorded values instead of IParams.
+   */
+  class ReplayPlayer
+  {
+  public:
+    ReplayPlayer(const ReplayHeader& header, Brain& brain, const Window& analysisWindow, const Options& o)
+      : mHeader(header), mBrain(brain), mAnalysisWindow(analysisWindow), mOptions(o), mConfig(header.config),
+        mValues((size_t) header.numParams, 0.0), mDSP(2)
+    {}
+
+    DSPContext& GetDSP() { return mDSP; }
+
+    /** @brief Set up as the plugin's OnReset does, with the parameters recorded before the first block */
+    void Start(const ReplayBlock& first)
+    {
+      for (const auto& c : first.changes)
+        if (c.first >= 0 && c.first < (int) mValues.size()) mValues[c.first] = c.second;
+      mConfig.algorithmId = (int) Value(kAlgorithm, mConfig.algorithmId);
+
+      // The FFT size the capture played at, not this machine's timing (older replays: smallest legal)
+      FFTPlanner::Instance().SetMeasurementEnabled(false);
+      if (mHeader.fftSize > 0)
+        FFTPlanner::Instance().ForcePlan(mConfig.chunkSize, mHeader.fftSize);
+
+      mDSP.Init(&mBrain, mConfig);
+      mDSP.SetPendingMorph(MorphFactory::CreateByUiIndex((int) Value(kMorphMode, 0)));
+      mDSP.SwapPendingComponents();
+      mDSP.Prepare(mHeader.sampleRate, mHeader.inChans, mConfig);
+      UpdateWindowing(mDSP.GetTransformerRaw());
+      ApplyAutotune(kAutotuneBlend);
+      ApplyAutotune(kAutotuneMode);
+      ApplyAutotune(kAutotuneToleranceOctaves);
+      ApplyBindings(mDSP.GetTransformerRaw(), mDSP.GetMorphRaw());
+    }
+
+    /** @brief Apply a block's parameter changes, then swap in pending components like the plugin's ProcessBlock */
+    void BeginBlock(const ReplayBlock& block)
+    {
+      for (const auto& c : block.changes)
+        if (c.first >= 0 && c.first < (int) mValues.size()) Apply(c.first, c.second);
+      if (!block.changes.empty())
+        ApplyOverrides();
+
+      const bool hadPending = mDSP.HasPendingTransformer() || mDSP.HasPendingMorph();
+      mDSP.SwapPendingComponents();
+      if (hadPending)
+        ApplyBindings(mDSP.GetTransformerRaw(), mDSP.GetMorphRaw());
+    }
+
+  private:
+    double Value(int paramIdx, double fallback) const
+    {
+      return paramIdx < (int) mValues.size() ? mValues[paramIdx] : fallback;
+    }
+
+    void Apply(int paramIdx, double value)
+    {
+      mValues[paramIdx] = value;
+      const int inChans = mHeader.inChans;
+      switch (paramIdx)
+      {
+        case kAlgorithm:
+        {
+          // ParameterManager::HandleAlgorithmChange
+          mConfig.algorithmId = (int) value;
+          auto transformer = TransformerFactory::CreateByUiIndex(mConfig.algorithmId);
+          if (!transformer)
+          {
+            mConfig.algorithmId = 0;
+            transformer = TransformerFactory::CreateByUiIndex(0);
+          }
+          if (auto sb = dynamic_cast<BaseSampleBrainTransformer*>(transformer.get()))
+            sb->SetBrain(&mBrain);
+          if (transformer)
+            transformer->OnReset(mHeader.sampleRate, mConfig.chunkSize, mConfig.bufferWindowSize, inChans);
+          ApplyBindings(transformer.get(), nullptr);
+          UpdateWindowing(transformer.get());
+          mDSP.SetPendingTransformer(transformer);
+          break;
+        }
+        case kMorphMode:
+        {
+          // ParameterManager::HandleMorphModeChange
+          auto morph = MorphFactory::CreateByUiIndex((int) value);
+          if (morph)
+            morph->OnReset(mHeader.sampleRate, mConfig.chunkSize, inChans);
+          ApplyBindings(nullptr, morph.get());
+          mDSP.SetPendingMorph(morph);
+          break;
+        }
+        case kAutotuneBlend:
+        case kAutotuneMode:
+        case kAutotuneToleranceOctaves:
+          ApplyAutotune(paramIdx);
+          break;
+        default:
+          // Dynamic parameters go to the current components, as ParameterManager::HandleDynamicParam
+          for (int i = 0; i < (int) mHeader.bindings.size(); ++i)
+          {
+            if (mHeader.bindings[i].paramIdx != paramIdx) continue;
+            ApplyBindingValue(mHeader.bindings, i, value, mDSP.GetTransformerRaw());
+            ApplyBindingValue(mHeader.bindings, i, value, mDSP.GetMorphRaw());
+            break;
+          }
+          break;
+      }
+    }
+
+    void ApplyAutotune(int paramIdx)
+    {
+      if (paramIdx >= (int) mValues.size()) return;
+      auto& autotune = mDSP.GetChunker().GetAutotuneProcessor();
+      const double v = mValues[paramIdx];
+      if (paramIdx == kAutotuneBlend) autotune.SetBlend((float) (v / 100.0));
+      else if (paramIdx == kAutotuneMode) autotune.SetMode((int) v == 1);
+      else if (paramIdx == kAutotuneToleranceOctaves) autotune.SetToleranceOctaves(std::clamp((int) v, 0, 4) + 1);
+    }
+
+    // ParameterManager::ApplyBindingsTo, then the overrides
+    void ApplyBindings(IChunkBufferTransformer* transformer, IMorph* morph)
+    {
+      auto value = [this](int paramIdx) { return Value(paramIdx, 0.0); };
+      synaptic::ApplyBindings(mHeader.bindings, transformer, value);
+      synaptic::ApplyBindings(mHeader.bindings, morph, value);
+      ApplyOverrides(transformer);
+      ApplyOverrides(morph);
+    }
+
+    void ApplyOverrides()
+    {
+      ApplyOverrides(mDSP.GetTransformerRaw());
+      ApplyOverrides(mDSP.GetMorphRaw());
+      ApplyOverrides(mDSP.GetPendingTransformerRaw());
+      ApplyOverrides(mDSP.GetPendingMorphRaw());
+    }
+
+    void ApplyOverrides(IDynamicParamOwner* owner)
+    {
+      if (!owner) return;
+      for (const auto& o : mOptions.overrides)
+      {
+        char* end = nullptr;
+        const double number = strtod(o.second.c_str(), &end);
+        if (o.second == "true" || o.second == "false")
+          owner->SetParamFromBool(o.first, o.second == "true");
+        else if (end && *end == '\0' && end != o.second.c_str())
+          owner->SetParamFromNumber(o.first, number);
+        else
+          owner->SetParamFromString(o.first, o.second);
+      }
+    }
+
+    // WindowCoordinator::UpdateChunkerWindowing
+    void UpdateWindowing(const IChunkBufferTransformer* transformer)
+    {
+      Window& outputWindow = mDSP.GetOutputWindow();
+      outputWindow.Set(Window::IntToType(mConfig.outputWindowMode), mConfig.chunkSize);
+      AudioStreamChunker& chunker = mDSP.GetChunker();
+      chunker.EnableOverlap(mConfig.enableOverlapAdd && (!transformer || transformer->WantsOverlapAdd()));
+      chunker.SetOutputWindow(outputWindow);
+      chunker.SetInputAnalysisWindow(mAnalysisWindow);
+    }
+
+    const ReplayHeader& mHeader;
+    Brain& mBrain;
+    const Window& mAnalysisWindow;
+    const Options& mOptions;
+    DSPConfig mConfig;
+    std::vector<double> mValues; // IParam::Value of every parameter
+    DSPContext mDSP;
+  };
+
+  struct RunResult
+  {
+    std::vector<double> output; // each block's output channels, one after the other
+    std::vector<double> blockNs;
+    double totalNs = 0.0;
+    int64_t frames = 0;
+  };
+
+  // Where each block's output starts in RunResult::output
+  struct BlockLayout
+  {
+    size_t offset;
+    int frames;
+    int outChans;
+    int64_t frame; // position in the session
+  };
+
+  bool RunOnce(ReplayReader& reader, Brain& brain, const Window& analysisWindow, const Options& o,
+               RunResult& result, std::vector<BlockLayout>* layout)
+  {
+    reader.Rewind();
+    ReplayPlayer player(reader.GetHeader(), brain, analysisWindow, o);
+    DSPContext& dsp = player.GetDSP();
+    std::vector<std::vector<iplug::sample>> inBuf, outBuf;
+    std::vector<iplug::sample*> inPtrs, outPtrs;
+    result.output.clear();
+    result.blockNs.clear();
+    result.totalNs = 0.0;
+    result.frames = 0;
+
+    ReplayBlock block;
+    bool first = true;
+    while (reader.Next(block))
+    {
+      if (first) player.Start(block);
+      else player.BeginBlock(block);
+      first = false;
+
+      const int n = block.frames;
+      const int inChans = block.params.inChans, outChans = block.params.outChans;
+      if ((int) inBuf.size() < inChans) inBuf.resize(inChans);
+      if ((int) outBuf.size() < outChans) outBuf.resize(outChans);
+      inPtrs.assign((size_t) inChans, nullptr);
+      outPtrs.assign((size_t) outChans, nullptr);
+      for (int ch = 0; ch < inChans; ++ch)
+      {
+        if ((int) inBuf[ch].size() < n) inBuf[ch].resize(n);
+        block.CopyInput(ch, inBuf[ch].data());
+        inPtrs[ch] = inBuf[ch].data();
+      }
+      for (int ch = 0; ch < outChans; ++ch)
+      {
+        if ((int) outBuf[ch].size() < n) outBuf[ch].resize(n);
+        outPtrs[ch] = outBuf[ch].data();
+      }
+
+      const auto t0 = std::chrono::steady_clock::now();
+      dsp.ProcessBlock(inPtrs.data(), outPtrs.data(), n, block.params);
+      const double ns = (double) std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+
+      if (layout) layout->push_back({ result.output.size(), n, outChans, result.frames });
+      for (int ch = 0; ch < outChans; ++ch)
+        result.output.insert(result.output.end(), outPtrs[ch], outPtrs[ch] + n);
+      result.blockNs.push_back(ns);
+      result.totalNs += ns;
+      result.frames += n;
+    }
+    return !first;
+  }
+
+  bool WriteOutput(const std::string& path, const std::vector<double>& output)
+  {
+    FILE* fp = fopen(path.c_str(), "wb");
+    if (!fp) return false;
+    const uint64_t count = output.size();
+    bool ok = fwrite(&kOutputMagic, sizeof(kOutputMagic), 1, fp) == 1 && fwrite(&kOutputVersion, sizeof(kOutputVersion), 1, fp) == 1
+      && fwrite(&count, sizeof(count), 1, fp) == 1 && (count == 0 || fwrite(output.data(), sizeof(double), output.size(), fp) == output.size());
+    ok = fclose(fp) == 0 && ok;
+    return ok;
+  }
+
+  struct Comparison
+  {
+    bool bitExact = false;
+    bool sameLength = false;
+    uint64_t mismatched = 0;
+    double maxAbsDiff = 0.0;
+    int64_t firstBlock = -1;
+    int64_t firstFrame = -1;
+    int firstChannel = -1;
+  };
+
+  bool Compare(const std::string& path, const std::vector<double>& output, const std::vector<BlockLayout>& layout, Comparison& c)
+  {
+    MappedFile file;
+    if (!file.Open(path)) return false;
+    SnapshotReader in(file.Data(), file.Size());
+    uint32_t magic = 0;
+    uint16_t ver = 0;
+    uint64_t count = 0;
+    if (!in.Get(&magic) || magic != kOutputMagic || !in.Get(&ver) || ver != kOutputVersion || !in.Get(&count)
+        || count > in.Remaining() / sizeof(double))
+      return false;
+    const uint8_t* reference = file.Data() + in.Position();
+
+    c.sameLength = count == output.size();
+    const size_t n = std::min<size_t>(count, output.size());
+    size_t firstIndex = n;
+    for (size_t i = 0; i < n; ++i)
+    {
+      double ref;
+      std::memcpy(&ref, reference + i * sizeof(double), sizeof(double));
+      if (std::memcmp(&ref, &output[i], sizeof(double)) == 0) continue;
+      ++c.mismatched;
+      c.maxAbsDiff = std::max(c.maxAbsDiff, std::fabs(ref - output[i]));
+      if (firstIndex == n) firstIndex = i;
+    }
+    c.bitExact = c.sameLength && c.mismatched == 0;
+
+    if (firstIndex < n)
+    {
+      auto it = std::upper_bound(layout.begin(), layout.end(), firstIndex,
+                                 [](size_t i, const BlockLayout& b) { return i < b.offset; });
+      if (it != layout.begin())
+      {
+        --it;
+        const size_t within = firstIndex - it->offset;
+        c.firstBlock = it - layout.begin();
+        c.firstChannel = it->frames > 0 ? (int) (within / it->frames) : 0;
+        c.firstFrame = it->frame + (it->frames > 0 ? (int64_t) (within % it->frames) : 0);
+      }
+    }
+    return true;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  Options o;
+  for (int i = 1; i < argc; ++i)
+  {
+    if (!strcmp(argv[i], "--help") || !strcmp(argv[i], "-h"))
+    {
+      PrintUsage();
+      return 0;
+    }
+  }
+  if (!ParseOptions(argc, argv, o))
+  {
+    PrintUsage();
+    return 2;
+  }
+
+  ReplayReader reader;
+  if (!reader.Open(o.replay))
+  {
+    fprintf(stderr, "Not a replay (or a different version): %s\n", o.replay.c_str());
+    return 1;
+  }
+  const ReplayHeader& header = reader.GetHeader();
+
+  // The brain, as saved next to the replay
+  MappedFile brainFile;
+  if (!brainFile.Open(reader.GetBrainPath())
+      || BrainRegistry::HashBytes(brainFile.Data(), brainFile.Size()) != header.brainHash)
+  {
+    fprintf(stderr, "Brain snapshot missing or modified: %s\n", reader.GetBrainPath().c_str());
+    return 1;
+  }
+  Window analysisWindow;
+  analysisWindow.Set(Window::IntToType(header.config.analysisWindowMode), header.config.chunkSize);
+  Brain brain;
+  brain.SetWindow(&analysisWindow);
+  if (!brain.DeserializeSnapshotFromMemory(brainFile.Data(), brainFile.Size()))
+  {
+    fprintf(stderr, "Could not load the brain snapshot: %s\n", reader.GetBrainPath().c_str());
+    return 1;
+  }
+  brainFile.Close();
+
+  RunResult firstRun, run;
+  std::vector<BlockLayout> layout;
+  std::vector<double> blockNs;
+  double bestNs = -1.0;
+  uint64_t hash = 0;
+  bool deterministic = true;
+  for (int r = 0; r < o.repeats; ++r)
+  {
+    RunResult& result = r == 0 ? firstRun : run;
+    fprintf(stderr, "Run %d/%d\n", r + 1, o.repeats);
+    if (!RunOnce(reader, brain, analysisWindow, o, result, r == 0 ? &layout : nullptr))
+    {
+      fprintf(stderr, "The replay has no blocks\n");
+      return 1;
+    }
+    const uint64_t runHash = BrainRegistry::HashBytes(result.output.data(), result.output.size() * sizeof(double));
+    if (r == 0) hash = runHash;
+    else deterministic = deterministic && runHash == hash;
+    blockNs.insert(blockNs.end(), result.blockNs.begin(), result.blockNs.end());
+    if (bestNs < 0.0 || result.totalNs < bestNs) bestNs = result.totalNs;
+  }
+
+  if (!o.writeOutput.empty() && !WriteOutput(o.writeOutput, firstRun.output))
+  {
+    fprintf(stderr, "Could not write %s\n", o.writeOutput.c_str());
+    return 1;
+  }
+  Comparison comparison;
+  if (!o.compare.empty() && !Compare(o.compare, firstRun.output, layout, comparison))
+  {
+    fprintf(stderr, "Not a replay output: %s\n", o.compare.c_str());
+    return 1;
+  }
+
+  const int64_t frames = firstRun.frames;
+  std::sort(blockNs.begin(), blockNs.end());
+  double sumNs = 0.0;
+  for (double ns : blockNs) sumNs += ns;
+  const double meanFrames = layout.empty() ? 0.0 : (double) frames / layout.size();
+
+  printf("{\n  \"version\": 1,\n  \"replay\": \"%s\",\n  \"complete\": %s,\n  \"endReason\": \"%s\",\n",
+         o.replay.c_str(), reader.IsComplete() ? "true" : "false",
+         reader.IsComplete() ? ReplayEndReasonName(reader.GetEndReason()) : "truncated");
+  printf("  \"sampleRate\": %.0f,\n  \"blocks\": %d,\n  \"seconds\": %.3f,\n  \"repeats\": %d,\n",
+         header.sampleRate, (int) layout.size(), frames / header.sampleRate, o.repeats);
+  printf("  \"nsPerSample\": %.2f,\n  \"realtimeFactor\": %.2f,\n  \"meanBlockUs\": %.2f,\n  \"p99BlockUs\": %.2f,\n"
+         "  \"worstBlockUs\": %.2f,\n  \"meanBlockBudgetUs\": %.2f,\n",
+         frames > 0 ? bestNs / frames : 0.0, bestNs > 0.0 ? (frames / header.sampleRate) / (bestNs * 1e-9) : 0.0,
+         sumNs / blockNs.size() * 1e-3, blockNs[std::min(blockNs.size() - 1, (size_t) (0.99 * blockNs.size()))] * 1e-3,
+         blockNs.back() * 1e-3, meanFrames / header.sampleRate * 1e6);
+  printf("  \"outputHash\": \"%016llx\",\n  \"deterministic\": %s", (unsigned long long) hash, deterministic ? "true" : "false");
+  if (!o.compare.empty())
+  {
+    printf(",\n  \"compare\": { \"reference\": \"%s\", \"bitExact\": %s, \"sameLength\": %s, \"mismatchedSamples\": %llu, "
+           "\"maxAbsDiff\": %.9g, \"firstMismatch\": { \"block\": %lld, \"frame\": %lld, \"channel\": %d } }",
+           o.compare.c_str(), comparison.bitExact ? "true" : "false", comparison.sameLength ? "true" : "false",
+           (unsigned long long) comparison.mismatched, comparison.maxAbsDiff, (long long) comparison.firstBlock,
+           (long long) comparison.firstFrame, comparison.firstChannel);
+  }
+  printf("\n}\n");
+  return deterministic && (o.compare.empty() || comparison.bitExact) ? 0 : 3;
+}
@@ -11,7 +11,7 @@
 #include <vector>
 #include <cstdint>
 
-#include "IPlug_include_in_plug_hdr.h"
+#include "IPlugConstants.h"
 #include "plugin_src/params/ParameterIds.h"
 
 namespace synaptic
@@ -3,9 +3,11 @@
 #include "../Structs.h" // for AudioChunk
 #include "FFT.h" // for FFTProcessor
 #include "FeatureAnalysis.h"
+#include "ParamRamp.h"
 #include <vector>
 #include <cmath>
 #include <cstring>
+#include <utility>
 
 namespace synaptic
 {
@@ -19,6 +21,28 @@ namespace synaptic
     int toleranceOctaves = 3;        // Range: 1-5 octaves
   };
 
+  /**
+   * @brief Autotune scratch for one FFT size, built off the audio thread when the chunk size changes
+   */
+  struct AutotuneScratch
+  {
+    int fftSize = 0;
+    int numChannels = 0;
+    std::vector<std::vector<float>> scratchSpectrum;
+    std::vector<std::vector<float>> shiftedSpectrum;
+
+    void Allocate(int fft, int channels)
+    {
+      fftSize = fft;
+      numChannels = channels;
+      if (fftSize > 0 && numChannels > 0)
+      {
+        scratchSpectrum.assign(numChannels, std::vector<float>(fftSize, 0.0f));
+        shiftedSpectrum.assign(numChannels, std::vector<float>(fftSize, 0.0f));
+      }
+    }
+  };
+
   /**
    * @brief Autotune processor that repitches output chunks to match input pitch
    *
@@ -41,6 +65,7 @@ namespace synaptic
       mSampleRate = (sampleRate > 0.0) ? sampleRate : 48000.0;
       mFFTSize = fftSize;
       mNumChannels = numChannels;
+      mBlendRamp.Reset(mSampleRate);
 
       // Preallocate scratch buffers to avoid runtime allocations
       if (mFFTSize > 0 && mNumChannels > 0)
@@ -53,12 +78,26 @@ namespace synaptic
       UpdateToleranceGuards();
     }
 
+    /**
+     * @brief Exchange scratch buffers with @p scratch (audio thread; no allocation)
+     *
+     * Afterwards @p scratch holds the previous buffers. Settings and the blend ramp are kept.
+     */
+    void SwapScratch(AutotuneScratch& scratch)
+    {
+      std::swap(mFFTSize, scratch.fftSize);
+      std::swap(mNumChannels, scratch.numChannels);
+      mScratchSpectrum.swap(scratch.scratchSpectrum);
+      mShiftedSpectrum.swap(scratch.shiftedSpectrum);
+    }
+
     /**
      * @brief Update autotune settings
      */
     void SetSettings(const AutotuneSettings& settings)
     {
       mSettings = settings;
+      mBlendRamp.SetTarget(mSettings.blend);
       UpdateToleranceGuards();
     }
 
@@ -68,9 +107,9 @@ namespace synaptic
     const AutotuneSettings& GetSettings() const { return mSettings; }
 
     /**
-     * @brief Check if autotune is active (blend > 0)
+     * @brief Check if autotune is active (blend > 0, or still ramping down to 0)
      */
-    bool IsActive() const { return mSettings.blend > 0.0001f; }
+    bool IsActive() const { return mSettings.blend > 0.0001f || mBlendRamp.GetValue() > 0.0001; }
 
     /**
      * @brief Get current sample rate
@@ -78,11 +117,12 @@ namespace synaptic
     double GetSampleRate() const { return mSampleRate; }
 
     /**
-     * @brief Set blend amount (0.0 = disabled, 1.0 = full autotune)
+     * @brief Set blend amount (0.0 = disabled, 1.0 = full autotune); chunks ramp to it
      */
     void SetBlend(float blend)
     {
       mSettings.blend = std::clamp(blend, 0.0f, 1.0f);
+      mBlendRamp.SetTarget(mSettings.blend);
     }
 
     /**
@@ -102,6 +142,14 @@ namespace synaptic
       UpdateToleranceGuards();
     }
 
+    /**
+     * @brief Advance the blend ramp by the input hop (in samples) of the chunk about to be processed
+     */
+    void AdvanceChunk(int hopSamples)
+    {
+      mChunkBlend = (float) mBlendRamp.Advance(hopSamples).Mid();
+    }
+
     /**
      * @brief Process autotune on input/output chunks
      *
@@ -114,7 +162,8 @@ namespace synaptic
      */
     void Process(const AudioChunk& inputChunk, AudioChunk& outputChunk, FFTProcessor& fft)
     {
-      if (mSettings.blend <= 0.0001f) return; // Skip if disabled
+      const float blend = mChunkBlend;
+      if (blend <= 0.0001f) return; // Skip if disabled
       if (mFFTSize <= 0 || mNumChannels <= 0) return;
       if (inputChunk.fftSize != mFFTSize || outputChunk.fftSize != mFFTSize) return;
 
@@ -126,7 +175,7 @@ namespace synaptic
 
       const float ratio = inputPitch / outputPitch;
 
-      if (mSettings.blend >= 0.9999f)
+      if (blend >= 0.9999f)
       {
         // Full autotune: directly shift output spectrum
         ApplyPitchShift(outputChunk, ratio);
@@ -158,8 +207,8 @@ namespace synaptic
           for (int i = 0; i < mFFTSize; ++i)
           {
             outputChunk.complexSpectrum[ch][i] =
-              (1.0f - mSettings.blend) * outputChunk.complexSpectrum[ch][i] +
-              mSettings.blend * tempChunk.complexSpectrum[ch][i];
+              (1.0f - blend) * outputChunk.complexSpectrum[ch][i] +
+              blend * tempChunk.complexSpectrum[ch][i];
           }
         }
       }
@@ -320,6 +369,8 @@ namespace synaptic
 
   private:
     AutotuneSettings mSettings;
+    ParamRamp mBlendRamp;
+    float mChunkBlend = 0.0f; // this chunk's blend, from AdvanceChunk
     double mSampleRate = 48000.0;
     int mFFTSize = 0;
     int mNumChannels = 0;
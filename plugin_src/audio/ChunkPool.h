@@ -11,7 +11,7 @@
 #include <vector>
 #include <algorithm>
 #include <cstring>
-#include "IPlug_include_in_plug_hdr.h"
+#include "IPlugConstants.h"
 #include "../Structs.h"
 
 namespace synaptic
@@ -4,7 +4,10 @@
  */
 
 #include "plugin_src/audio/DSPContext.h"
+#ifndef SYNAPTIC_HEADLESS
+#include "plugin_src/audio/ReplayCapture.h"
 #include "plugin_src/params/ParameterManager.h"
+#endif
 #include "plugin_src/params/ParameterIds.h"
 #include "plugin_src/transformers/TransformerFactory.h"
 #include "plugin_src/transformers/types/ExpandedSimpleSampleBrainTransformer.h"
@@ -17,9 +20,17 @@ namespace synaptic {
 DSPContext::DSPContext(int nChannels)
   : mChunker(nChannels)
 {
+#if SYNAPTIC_PROFILE
+  mChunker.SetProfiler(&mProfiler);
+#endif
+#ifndef SYNAPTIC_HEADLESS
+  mReplayCapture = std::make_unique<ReplayCapture>();
+#endif
 }
 
-void DSPContext::Init(iplug::Plugin* plugin, ParameterManager* paramManager, Brain* brain, DSPConfig& config)
+DSPContext::~DSPContext() = default;
+
+void DSPContext::Init(Brain* brain, const DSPConfig& config)
 {
   // Default transformer = first UI-visible entry
   mTransformer = TransformerFactory::CreateByUiIndex(config.algorithmId);
@@ -37,14 +48,29 @@ void DSPContext::Init(iplug::Plugin* plugin, ParameterManager* paramManager, Bra
 
 int DSPContext::ComputeLatencySamples(int chunkSize, int bufferWindowSize) const
 {
-  return chunkSize + (mTransformer ? mTransformer->GetAdditionalLatencySamples(chunkSize, bufferWindowSize) : 0);
+  if (!mTransformer) return chunkSize;
+  return ComputeChunkingLatencySamples(chunkSize, bufferWindowSize)
+    + mTransformer->GetAdditionalLatencySamples(chunkSize, bufferWindowSize);
 }
 
-void DSPContext::OnReset(double sampleRate, int blockSize, int nChans, 
-                         iplug::Plugin* plugin, DSPConfig& config, ParameterManager* paramManager, Brain* brain)
+int DSPContext::ComputeChunkingLatencySamples(int chunkSize, int bufferWindowSize) const
+{
+  if (!mTransformer) return chunkSize;
+  // Chunks held back for a lookahead decision delay output by one input hop each; output that
+  // leads its chunk comes out a hop sooner per hop it leads by
+  const int hop = mChunker.GetInputHopSize(chunkSize);
+  const int decisionDelay = mTransformer->GetDecisionDelayChunks(bufferWindowSize) * hop;
+  const int lead = hop < chunkSize ? mTransformer->GetOutputLeadChunks() * hop : 0;
+  return chunkSize + decisionDelay - lead;
+}
+
+void DSPContext::Prepare(double sampleRate, int nChans, const DSPConfig& config)
 {
   mInGainSmoother.SetSmoothTime(20., sampleRate);
   mOutGainSmoother.SetSmoothTime(20., sampleRate);
+#if SYNAPTIC_PROFILE
+  mProfiler.SetSampleRate(sampleRate);
+#endif
 
   mChunker.SetChunkSize(config.chunkSize);
   mChunker.SetBufferWindowSize(config.bufferWindowSize);
@@ -53,6 +79,53 @@ void DSPContext::OnReset(double sampleRate, int blockSize, int nChans,
   auto& autotune = mChunker.GetAutotuneProcessor();
   autotune.OnReset(sampleRate, mChunker.GetFFTSize(), mChunker.GetNumChannels());
   
+  mChunker.Reset();
+
+  if (mTransformer)
+    mTransformer->OnReset(sampleRate, config.chunkSize, config.bufferWindowSize, nChans);
+
+  if (mMorph)
+    mMorph->OnReset(sampleRate, config.chunkSize, nChans);
+    
+  mChunker.SetMorph(mMorph);
+}
+
+bool DSPContext::SwapPendingComponents()
+{
+  bool transformerSwapped = false;
+
+  // Thread-safe transformer swap
+  if (mPendingTransformer)
+  {
+    if (mTransformer)
+      mTransformer->Flush(mChunker);
+    mTransformer = std::move(mPendingTransformer);
+    mPendingTransformer.reset();
+    transformerSwapped = true;
+  }
+
+  // Thread-safe morph swap
+  if (mPendingMorph)
+  {
+    mMorph = std::move(mPendingMorph);
+    mPendingMorph.reset();
+    mChunker.SetMorph(mMorph);
+  }
+
+  return transformerSwapped;
+}
+
+#ifndef SYNAPTIC_HEADLESS
+void DSPContext::OnReset(double sampleRate, int blockSize, int nChans, 
+                         iplug::Plugin* plugin, DSPConfig& config, ParameterManager* paramManager, Brain* brain)
+{
+  // A replay starts from a reset context; it can't represent one in the middle
+  mReplayCapture->End(ReplayEndReason::Reset);
+
+  Prepare(sampleRate, nChans, config);
+
+  // Autotune settings survive the chunker reset, so they can be applied afterwards
+  auto& autotune = mChunker.GetAutotuneProcessor();
   const int autotuneBlendIdx = kAutotuneBlend;
   if (plugin->GetParam(autotuneBlendIdx))
   {
@@ -72,16 +145,6 @@ void DSPContext::OnReset(double sampleRate, int blockSize, int nChans,
       autotune.SetToleranceOctaves(enumIdx + 1);
     }
   }
-  
-  mChunker.Reset();
-
-  if (mTransformer)
-    mTransformer->OnReset(sampleRate, config.chunkSize, config.bufferWindowSize, nChans);
-
-  if (mMorph)
-    mMorph->OnReset(sampleRate, config.chunkSize, nChans);
-    
-  mChunker.SetMorph(mMorph);
 
   // Apply parameter bindings
   paramManager->ApplyBindingsTo(plugin, mTransformer.get(), mMorph.get());
@@ -90,34 +153,34 @@ void DSPContext::OnReset(double sampleRate, int blockSize, int nChans,
 void DSPContext::ProcessBlock(iplug::sample** inputs, iplug::sample** outputs, int nFrames, 
                               iplug::Plugin* plugin, DSPConfig& config, ParameterManager* paramManager)
 {
-  // Thread-safe transformer swap
-  if (mPendingTransformer)
-  {
-    mTransformer = std::move(mPendingTransformer);
-    mPendingTransformer.reset();
-    
-    int extraLatency = mTransformer ? mTransformer->GetAdditionalLatencySamples(config.chunkSize, config.bufferWindowSize) : 0;
-    plugin->SetLatency(config.chunkSize + extraLatency);
-
+  const bool hadPending = mPendingTransformer || mPendingMorph;
+  if (SwapPendingComponents())
+    plugin->SetLatency(ComputeLatencySamples(config.chunkSize, config.bufferWindowSize));
+  if (hadPending)
     paramManager->ApplyBindingsTo(plugin, mTransformer.get(), mMorph.get());
-  }
 
-  // Thread-safe morph swap
-  if (mPendingMorph)
-  {
-    mMorph = std::move(mPendingMorph);
-    mPendingMorph.reset();
-    mChunker.SetMorph(mMorph);
+  BlockParams params;
+  params.inGain = plugin->GetParam(kInGain)->DBToAmp();
+  params.outGain = plugin->GetParam(kOutGain)->DBToAmp();
+  params.agcEnabled = plugin->GetParam(kAGC)->Bool();
+  params.inChans = plugin->NInChansConnected();
+  params.outChans = plugin->NOutChansConnected();
+  if (mReplayCapture->IsRecording())
+    mReplayCapture->CaptureBlock(inputs, nFrames, params, [plugin](int paramIdx) { return plugin->GetParam(paramIdx)->Value(); });
+  ProcessBlock(inputs, outputs, nFrames, params);
+}
+#endif
 
-    paramManager->ApplyBindingsTo(plugin, mTransformer.get(), mMorph.get());
-  }
+void DSPContext::ProcessBlock(iplug::sample** inputs, iplug::sample** outputs, int nFrames, const BlockParams& params)
+{
+  SYNAPTIC_PROFILE_BLOCK(&mProfiler, nFrames);
 
-  const double inGain = plugin->GetParam(kInGain)->DBToAmp();
-  const double outGain = plugin->GetParam(kOutGain)->DBToAmp();
-  const bool agcEnabled = plugin->GetParam(kAGC)->Bool();
+  const double inGain = params.inGain;
+  const double outGain = params.outGain;
+  const bool agcEnabled = params.agcEnabled;
 
-  const int inChans = plugin->NInChansConnected();
-  const int outChans = plugin->NOutChansConnected();
+  const int inChans = params.inChans;
+  const int outChans = params.outChans;
   
   if (inChans <= 0 || outChans <= 0 || !inputs || !outputs)
   {
@@ -145,7 +208,10 @@ void DSPContext::ProcessBlock(iplug::sample** inputs, iplug::sample** outputs, i
   {
     const int required = mTransformer->GetRequiredLookaheadChunks();
     if (mChunker.GetWindowCount() >= required)
+    {
+      SYNAPTIC_PROFILE_SCOPE(&mProfiler, Matching);
       mTransformer->Process(mChunker);
+    }
   }
 
   // Render
@@ -4,18 +4,25 @@
  *
  * Handles audio buffering, chunking, transformation, gain, and
  * thread-safe component swapping between the audio thread and UI thread.
+ *
+ * The processing core (Prepare and the BlockParams overload of ProcessBlock) does not touch the
+ * plugin, so it also builds without a plugin API. Define SYNAPTIC_HEADLESS to leave out the
+ * plugin-facing overloads, as the benchmarks do.
  */
 
 #pragma once
 
+#ifndef SYNAPTIC_HEADLESS
 #include "IPlug_include_in_plug_hdr.h"
-#include "IPlugConstants.h"
 #include "IPlugMidi.h"
+#endif
+#include "IPlugConstants.h"
 #include "Smoothers.h"
 #include "plugin_src/modules/AudioStreamChunker.h"
 #include "plugin_src/transformers/BaseTransformer.h"
 #include "plugin_src/morph/IMorph.h"
 #include "plugin_src/audio/Window.h"
+#include "plugin_src/audio/StageProfiler.h"
 #include "plugin_src/modules/DSPConfig.h"
 #include <memory>
 #include <vector>
@@ -26,6 +33,9 @@ namespace synaptic {
 class ParameterManager;
 class Brain;
 struct IMorph;
+#ifndef SYNAPTIC_HEADLESS
+class ReplayCapture;
+#endif
 
 /**
  * @brief Encapsulates the real-time audio processing context
@@ -39,21 +49,45 @@ struct IMorph;
 class DSPContext
 {
 public:
+  /** @brief Host-side values for one block (gains as linear amplitude) */
+  struct BlockParams
+  {
+    double inGain = 1.0;
+    double outGain = 1.0;
+    bool agcEnabled = false;
+    int inChans = 0;
+    int outChans = 0;
+  };
+
   explicit DSPContext(int nChannels);
+  ~DSPContext();
 
   // Initialize components
-  void Init(iplug::Plugin* plugin, ParameterManager* paramManager, Brain* brain, DSPConfig& config);
-  
-  // Main audio processing
+  void Init(Brain* brain, const DSPConfig& config);
+
+#ifndef SYNAPTIC_HEADLESS
+  // Main audio processing: swaps in pending components, then runs the core with the plugin's params
   void ProcessBlock(iplug::sample** inputs, iplug::sample** outputs, int nFrames, 
                     iplug::Plugin* plugin, DSPConfig& config, ParameterManager* paramManager);
 
   // Reset state
   void OnReset(double sampleRate, int blockSize, int nChans, 
                iplug::Plugin* plugin, DSPConfig& config, ParameterManager* paramManager, Brain* brain);
+#endif
+
+  // Processing core: gain, chunking, transform and render of one block
+  void ProcessBlock(iplug::sample** inputs, iplug::sample** outputs, int nFrames, const BlockParams& params);
+
+  // Reset everything that does not depend on plugin parameters
+  void Prepare(double sampleRate, int nChans, const DSPConfig& config);
+
+  // Swap in the pending transformer/morph (audio thread); returns true if the transformer changed
+  bool SwapPendingComponents();
 
   // Latency calculation
   int ComputeLatencySamples(int chunkSize, int bufferWindowSize) const;
+  // The part of it that comes from chunking: accumulation, held decisions and output lead
+  int ComputeChunkingLatencySamples(int chunkSize, int bufferWindowSize) const;
 
   // === Component Accessors ===
   
@@ -62,6 +96,16 @@ public:
   
   Window& GetOutputWindow() { return mOutputWindow; }
   const Window& GetOutputWindow() const { return mOutputWindow; }
+
+#if SYNAPTIC_PROFILE
+  /** @brief Per-stage block timings */
+  StageProfiler& GetProfiler() { return mProfiler; }
+#endif
+
+#ifndef SYNAPTIC_HEADLESS
+  /** @brief Records the blocks the plugin processes for offline replay (ReplayCapture.h) */
+  ReplayCapture& GetReplayCapture() { return *mReplayCapture; }
+#endif
   
   // === Transformer Access ===
   
@@ -116,6 +160,12 @@ private:
   
   // Audio processing components
   AudioStreamChunker mChunker;
+#if SYNAPTIC_PROFILE
+  StageProfiler mProfiler;
+#endif
+#ifndef SYNAPTIC_HEADLESS
+  std::unique_ptr<ReplayCapture> mReplayCapture;
+#endif
   Window mOutputWindow;
   
   // Dynamic DSP objects with pending slots for thread-safe swapping
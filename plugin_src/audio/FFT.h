@@ -2,6 +2,8 @@
 
 #include <vector>
 #include <cmath>
+#include <algorithm>
+#include <utility>
 
 #include "Window.h"
 #include "../Structs.h" // for synaptic::AudioChunk
@@ -31,9 +33,20 @@ namespace synaptic
       {
         mSetup = pffft_new_setup(mFFTSize, PFFFT_REAL);
         mScratch.resize((size_t) mFFTSize, 0.0f);
+        mWork.resize((size_t) mFFTSize, 0.0f); // avoids PFFFT's per-call stack VLA
       }
     }
 
+    // Exchange plans with another processor without allocating (a plan built off the audio thread
+    // can be swapped in on it)
+    void Swap(FFTProcessor& other) noexcept
+    {
+      std::swap(mFFTSize, other.mFFTSize);
+      std::swap(mSetup, other.mSetup);
+      mScratch.swap(other.mScratch);
+      mWork.swap(other.mWork);
+    }
+
     // Compute spectral energy from ordered real spectrum (unique bins).
     // Uses DC^2 + Nyquist^2 + 2 * sum_{k=1..N/2-1} (Re^2 + Im^2)
     static double SpectrumEnergyOrdered(const float* ordered, int Nfft)
@@ -80,13 +93,8 @@ namespace synaptic
       if (!mSetup || !timeIn || !freqOut || N <= 0)
         return;
 
-      for (int i = 0; i < mFFTSize; ++i)
-      {
-        float x = (i < N) ? timeIn[i] : 0.0f;
-        if (w && i < M) x *= w[i];
-        mScratch[i] = x;
-      }
-      pffft_transform_ordered(mSetup, mScratch.data(), freqOut, nullptr, PFFFT_FORWARD);
+      LoadWindowed(timeIn, std::min(N, mFFTSize), w, M);
+      pffft_transform_ordered(mSetup, mScratch.data(), freqOut, mWork.data(), PFFFT_FORWARD);
     }
 
     // In-place inverse: freq[N] (ordered) -> time[Nout]
@@ -95,7 +103,7 @@ namespace synaptic
       if (!mSetup || !freqIn || !timeOut || Nfft != mFFTSize || Nout <= 0)
         return;
 
-      pffft_transform_ordered(mSetup, freqIn, mScratch.data(), nullptr, PFFFT_BACKWARD);
+      pffft_transform_ordered(mSetup, freqIn, mScratch.data(), mWork.data(), PFFFT_BACKWARD);
 
       // Copy out first Nout samples (PFFFT is not normalized; we divide by Nfft)
       const float invN = (mFFTSize > 0) ? (1.0f / (float)mFFTSize) : 1.0f;
@@ -106,40 +114,60 @@ namespace synaptic
         timeOut[i] = 0.0f;
     }
 
-    // Compute/ensure per-channel spectrum for chunk in-place
-    // Removed non-windowed spectrum API to avoid duplicated code paths
+    // Compute spectrum using a provided analysis window (Rectangular if empty).
+    // If magnitudesOut is given it receives |X[k]| for bins 0..N/2 per channel, taken in the
+    // same pass as the transform so callers don't have to walk the spectrum again.
+    void ComputeChunkSpectrum(AudioChunk& chunk, const Window& window,
+                              std::vector<std::vector<float>>* magnitudesOut = nullptr) const
+    {
+      AudioChunk* chunks[1] = { &chunk };
+      ComputeChunkSpectra(chunks, 1, window, magnitudesOut);
+    }
 
-    // Compute spectrum using a provided analysis window (Rectangular if empty)
-    void ComputeChunkSpectrum(AudioChunk& chunk, const Window& window) const
+    // Batched forward transform: every channel of every chunk goes through the same setup,
+    // aligned scratch and window without returning to the caller in between. Windowing is
+    // fused into the copy/convert into the scratch buffer. magnitudesOut, if non-null, holds
+    // numChunks entries (one per-channel magnitude set per chunk).
+    // PFFFT already vectorizes within a transform (all valid sizes are multiples of 32), so
+    // channels are processed back to back rather than interleaved across SIMD lanes.
+    void ComputeChunkSpectra(AudioChunk* const* chunks, int numChunks, const Window& window,
+                             std::vector<std::vector<float>>* magnitudesOut = nullptr) const
     {
-      const int chans = (int) chunk.channelSamples.size();
-      if (chans <= 0 || mFFTSize <= 0) return;
-      if (chunk.fftSize != mFFTSize)
-      {
-        chunk.fftSize = mFFTSize;
-        chunk.complexSpectrum.assign(chans, std::vector<float>(mFFTSize, 0.0f));
-      }
-      else
-      {
-        if ((int)chunk.complexSpectrum.size() != chans)
-          chunk.complexSpectrum.assign(chans, std::vector<float>(mFFTSize, 0.0f));
-      }
+      if (!chunks || numChunks <= 0 || mFFTSize <= 0) return;
 
       const auto& coeffs = window.Coeffs();
+      const float* w = coeffs.empty() ? nullptr : coeffs.data();
       const int M = (int) coeffs.size();
 
-      for (int ch = 0; ch < chans; ++ch)
+      for (int c = 0; c < numChunks; ++c)
       {
-        const auto& time = chunk.channelSamples[ch];
-        float* spec = chunk.complexSpectrum[ch].data();
-        const int N = std::min((int) time.size(), chunk.numFrames);
-        for (int i = 0; i < mFFTSize; ++i)
+        AudioChunk* chunk = chunks[c];
+        if (!chunk) continue;
+        const int chans = (int) chunk->channelSamples.size();
+        if (chans <= 0) continue;
+
+        if (chunk->fftSize != mFFTSize || (int) chunk->complexSpectrum.size() != chans)
+        {
+          chunk->fftSize = mFFTSize;
+          chunk->complexSpectrum.assign(chans, std::vector<float>(mFFTSize, 0.0f));
+        }
+
+        std::vector<std::vector<float>>* mags = magnitudesOut ? &magnitudesOut[c] : nullptr;
+        if (mags && ((int) mags->size() != chans || (chans > 0 && (int) (*mags)[0].size() != mFFTSize / 2 + 1)))
+          mags->assign(chans, std::vector<float>(mFFTSize / 2 + 1, 0.0f));
+
+        for (int ch = 0; ch < chans; ++ch)
         {
-          float x = (i < N) ? (float) time[i] : 0.0f;
-          if (M > 0 && i < M) x *= coeffs[i];
-          mScratch[i] = x;
+          const auto& time = chunk->channelSamples[ch];
+          const int N = std::min(std::min((int) time.size(), chunk->numFrames), mFFTSize);
+          LoadWindowed(time.data(), N, w, M);
+
+          float* spec = chunk->complexSpectrum[ch].data();
+          pffft_transform_ordered(mSetup, mScratch.data(), spec, mWork.data(), PFFFT_FORWARD);
+
+          if (mags)
+            MagnitudesFromOrdered(spec, mFFTSize, (*mags)[ch].data());
         }
-        pffft_transform_ordered(mSetup, mScratch.data(), spec, nullptr, PFFFT_FORWARD);
       }
     }
 
@@ -149,6 +177,7 @@ namespace synaptic
       const int chans = (int) chunk.channelSamples.size();
       if (chans <= 0 || mFFTSize <= 0) return;
 
+      const float invN = 1.0f / (float) mFFTSize;
       double sumSquares = 0.0;
       int totalCount = 0;
       for (int ch = 0; ch < chans; ++ch)
@@ -156,22 +185,37 @@ namespace synaptic
         const float* spec = (ch < (int)chunk.complexSpectrum.size())
           ? chunk.complexSpectrum[ch].data() : nullptr;
         if (!spec) continue;
-        // Inverse into temp float buffer, then copy/convert to sample type
-        std::vector<float> tmp((size_t) chunk.numFrames, 0.0f);
-        Inverse(spec, mFFTSize, tmp.data(), chunk.numFrames);
+        // Inverse into the shared scratch and convert straight to sample type (no temp buffer)
+        pffft_transform_ordered(mSetup, spec, mScratch.data(), mWork.data(), PFFFT_BACKWARD);
         auto& out = chunk.channelSamples[ch];
         const int N = std::min((int)out.size(), chunk.numFrames);
-        for (int i = 0; i < N; ++i)
+        const int copyN = std::min(N, mFFTSize);
+        for (int i = 0; i < copyN; ++i)
         {
-          const float v = tmp[i];
+          const float v = mScratch[i] * invN;
           out[i] = (iplug::sample) v;
           sumSquares += (double) v * (double) v;
         }
+        for (int i = copyN; i < N; ++i)
+          out[i] = 0.0;
         totalCount += N;
       }
       chunk.rms = (totalCount > 0) ? std::sqrt(sumSquares / (double) totalCount) : 0.0;
     }
 
+    // |X[k]| for k = 0..N/2 from an ordered spectrum (DC and Nyquist are packed in slot 0)
+    static void MagnitudesFromOrdered(const float* ordered, int Nfft, float* magsOut)
+    {
+      magsOut[0] = std::fabs(ordered[0]);
+      magsOut[Nfft/2] = std::fabs(ordered[1]);
+      for (int k = 1; k < Nfft/2; ++k)
+      {
+        const float re = ordered[2*k + 0];
+        const float im = ordered[2*k + 1];
+        magsOut[k] = std::sqrt(re * re + im * im);
+      }
+    }
+
     static double DominantFreqHzFromOrderedSpectrum(const float* ordered, int Nfft, double sampleRate)
     {
       if (!ordered || Nfft <= 0 || sampleRate <= 0.0) return 0.0;
@@ -199,6 +243,18 @@ namespace synaptic
     }
 
   private:
+    // Fill mScratch with time[0..N) * w[0..M) and zero padding, without per-sample branches
+    template <typename T>
+    void LoadWindowed(const T* time, int N, const float* w, int M) const
+    {
+      float* dst = mScratch.data();
+      const int windowed = w ? std::min(N, M) : 0;
+      int i = 0;
+      for (; i < windowed; ++i) dst[i] = (float) time[i] * w[i];
+      for (; i < N; ++i) dst[i] = (float) time[i];
+      for (; i < mFFTSize; ++i) dst[i] = 0.0f;
+    }
+
     void Destroy()
     {
       if (mSetup)
@@ -207,6 +263,7 @@ namespace synaptic
         mSetup = nullptr;
       }
       mScratch.clear();
+      mWork.clear();
       mFFTSize = 0;
     }
 
@@ -214,6 +271,7 @@ namespace synaptic
     int mFFTSize = 0;
     PFFFT_Setup* mSetup = nullptr;
     mutable std::vector<float> mScratch; // reused across calls
+    mutable std::vector<float> mWork;    // PFFFT work area, same size as mScratch
   };
 }
 
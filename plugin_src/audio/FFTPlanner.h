@@ -0,0 +1,248 @@
+/**
+ * @file FFTPlanner.h
+ * @brief Picks the cheapest PFFFT-legal transform size for a chunk size
+ *
+ * The smallest legal size (Window::NextValidFFTSize) is not always the fastest one: sizes with
+ * large factors of 3 and 5 can cost more than a slightly larger power of two. The planner times
+ * every legal candidate between the smallest legal size and the next power of two on the host
+ * CPU and keeps the cheapest. Timings are kept per process and can be persisted to a small text
+ * file so they are only measured once per machine.
+ *
+ * Plans differ between machines, so only the real-time path (chunker, morph band maps) uses
+ * them. Brain analysis and its caches stay on Window::NextValidFFTSize, so the same audio
+ * analyzes the same everywhere and saved brains match a re-analysis on another machine.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Window.h"
+#include "../common/CachePaths.h"
+#include "exdeps/pffft/pffft.h"
+
+namespace synaptic
+{
+  /**
+   * @brief Planned FFT size for one chunk size, with its overhead relative to the chunk
+   */
+  struct FFTPlanInfo
+  {
+    int chunkSize = 0;        // requested minimum transform length
+    int fftSize = 0;          // chosen transform length
+    int smallestLegal = 0;    // what plain zero-padding to the next legal size would use
+    double paddingRatio = 0.0; // (fftSize - chunkSize) / chunkSize
+    double costNs = 0.0;      // measured ns per forward transform (0 if unmeasured)
+  };
+
+  /**
+   * @brief Process-wide FFT size planner backed by a measured cost table
+   *
+   * Thread-safe. The first plan for a chunk size measures a handful of candidate sizes
+   * (a few milliseconds in total, skipped for sizes already in the on-disk table); the plugin
+   * plans its chunk size in OnReset so later lookups from Configure() are table hits.
+   */
+  class FFTPlanner
+  {
+  public:
+    static FFTPlanner& Instance()
+    {
+      static FFTPlanner sInstance;
+      return sInstance;
+    }
+
+    /** @brief Cheapest legal FFT size >= chunkSize */
+    int PlanSize(int chunkSize) { return Plan(chunkSize).fftSize; }
+
+    /** @brief Full plan (size, padding and cost) for a chunk size */
+    FFTPlanInfo Plan(int chunkSize)
+    {
+      const int minSize = std::max(1, chunkSize);
+      std::lock_guard<std::mutex> lock(mMutex);
+
+      auto it = mPlans.find(minSize);
+      if (it != mPlans.end()) return it->second;
+
+      FFTPlanInfo info;
+      info.chunkSize = minSize;
+      info.smallestLegal = Window::NextValidFFTSize(minSize);
+      info.fftSize = info.smallestLegal;
+
+      if (mMeasurementEnabled)
+      {
+        double bestCost = CostLocked(info.smallestLegal);
+        for (int n : Candidates(minSize))
+        {
+          const double c = CostLocked(n);
+          // Prefer the smaller size unless the larger one is clearly faster (timing noise)
+          if (c > 0.0 && c < bestCost * 0.95)
+          {
+            bestCost = c;
+            info.fftSize = n;
+          }
+        }
+        info.costNs = bestCost;
+      }
+
+      info.paddingRatio = (double) (info.fftSize - minSize) / (double) minSize;
+      mPlans[minSize] = info;
+      return info;
+    }
+
+    /**
+     * @brief Disable timing (always use the smallest legal size)
+     * Useful for deterministic offline runs. Clears previous plans.
+     */
+    void SetMeasurementEnabled(bool enabled)
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mMeasurementEnabled = enabled;
+      mPlans.clear();
+    }
+
+    /**
+     * @brief Use @p fftSize for @p chunkSize until plans are cleared
+     * For replaying a capture made on another machine with the size it played at. Ignored
+     * unless @p fftSize is a legal size of at least @p chunkSize.
+     */
+    void ForcePlan(int chunkSize, int fftSize)
+    {
+      const int minSize = std::max(1, chunkSize);
+      if (fftSize < minSize || Window::NextValidFFTSize(fftSize) != fftSize) return;
+      std::lock_guard<std::mutex> lock(mMutex);
+      FFTPlanInfo info;
+      info.chunkSize = minSize;
+      info.fftSize = fftSize;
+      info.smallestLegal = Window::NextValidFFTSize(minSize);
+      info.paddingRatio = (double) (fftSize - minSize) / (double) minSize;
+      mPlans[minSize] = info;
+    }
+
+    /**
+     * @brief Load a cost table written by SaveCostTable; later saves go to the same path
+     * The default table lives in the user cache directory; pass an empty path to disable persistence.
+     */
+    bool LoadCostTable(const std::string& path)
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mCachePath = path;
+      FILE* fp = path.empty() ? nullptr : fopen(path.c_str(), "r");
+      if (!fp) return false;
+
+      char header[64] = {};
+      bool ok = fgets(header, sizeof(header), fp) && std::string(header).rfind(kCacheHeader, 0) == 0;
+      if (ok)
+      {
+        int n = 0;
+        double ns = 0.0;
+        while (fscanf(fp, "%d %lf", &n, &ns) == 2)
+        {
+          if (n > 0 && ns > 0.0 && mCostNs.find(n) == mCostNs.end())
+            mCostNs[n] = ns;
+        }
+      }
+      fclose(fp);
+      return ok;
+    }
+
+    /** @brief Persist newly measured sizes (no-op if nothing changed or no path was set) */
+    bool SaveCostTable()
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      if (mCachePath.empty() || !mCostTableDirty) return false;
+      FILE* fp = fopen(mCachePath.c_str(), "w");
+      if (!fp) return false;
+      fprintf(fp, "%s\n", kCacheHeader);
+      for (const auto& kv : mCostNs)
+        fprintf(fp, "%d %.1f\n", kv.first, kv.second);
+      fclose(fp);
+      mCostTableDirty = false;
+      return true;
+    }
+
+  private:
+    static constexpr const char* kCacheHeader = "SynapticFFTCost v1";
+    static constexpr const char* kCacheFileName = "fft_costs.txt";
+
+    // Picks up this machine's previously measured costs, if any
+    FFTPlanner()
+    {
+      const std::string dir = cache::GetCacheDirectory();
+      if (!dir.empty())
+        LoadCostTable(dir + kCacheFileName);
+    }
+
+    // Legal sizes above the smallest legal one, up to the next power of two (worst case 2x)
+    static std::vector<int> Candidates(int minSize)
+    {
+      std::vector<int> out;
+      int pow2 = 32;
+      while (pow2 < minSize) pow2 <<= 1;
+      int n = Window::NextValidFFTSize(minSize);
+      while (true)
+      {
+        n = Window::NextValidFFTSize(n + 1);
+        if (n > pow2) break;
+        out.push_back(n);
+      }
+      return out;
+    }
+
+    double CostLocked(int n)
+    {
+      auto it = mCostNs.find(n);
+      if (it != mCostNs.end()) return it->second;
+      const double ns = Measure(n);
+      if (ns > 0.0)
+      {
+        mCostNs[n] = ns;
+        mCostTableDirty = true;
+      }
+      return ns;
+    }
+
+    // Warm up with a few untimed runs, then keep the best of three timed batches
+    static double Measure(int n)
+    {
+      PFFFT_Setup* setup = pffft_new_setup(n, PFFFT_REAL);
+      if (!setup) return 0.0;
+      float* in = (float*) pffft_aligned_malloc(sizeof(float) * n);
+      float* out = (float*) pffft_aligned_malloc(sizeof(float) * n);
+      float* work = (float*) pffft_aligned_malloc(sizeof(float) * n);
+      double best = 0.0;
+      if (in && out && work)
+      {
+        for (int i = 0; i < n; ++i) in[i] = (float) ((i * 7919) % 2003) / 2003.0f - 0.5f;
+        for (int i = 0; i < 4; ++i) pffft_transform_ordered(setup, in, out, work, PFFFT_FORWARD);
+
+        const int iters = std::max(4, 262144 / n);
+        for (int batch = 0; batch < 3; ++batch)
+        {
+          const auto t0 = std::chrono::steady_clock::now();
+          for (int i = 0; i < iters; ++i) pffft_transform_ordered(setup, in, out, work, PFFFT_FORWARD);
+          const auto t1 = std::chrono::steady_clock::now();
+          const double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / (double) iters;
+          if (best == 0.0 || ns < best) best = ns;
+        }
+      }
+      if (in) pffft_aligned_free(in);
+      if (out) pffft_aligned_free(out);
+      if (work) pffft_aligned_free(work);
+      pffft_destroy_setup(setup);
+      return best;
+    }
+
+    std::mutex mMutex;
+    std::map<int, double> mCostNs;       // legal size -> ns per forward transform
+    std::map<int, FFTPlanInfo> mPlans;   // chunk size -> chosen plan
+    std::string mCachePath;
+    bool mCostTableDirty = false;
+    bool mMeasurementEnabled = true;
+  };
+}
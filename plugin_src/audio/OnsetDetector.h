@@ -0,0 +1,132 @@
+/**
+ * @file OnsetDetector.h
+ * @brief Onset detection on the input spectra the chunker computes anyway
+ *
+ * Every input chunk is transformed for matching. The detector windows that spectrum once more
+ * (Hann, as a three-tap kernel across bins: leakage of a rectangular analysis window otherwise
+ * flickers from chunk to chunk on steady tones), sums it into a few log-spaced bands,
+ * log-compresses them and takes the rise from the chunk before (spectral flux, half-wave
+ * rectified). A chunk is an onset when its flux clears a running mean by a margin and
+ * kRefractorySeconds have passed since the last one: overlapping chunks see one attack several
+ * times, and a noisy decay keeps rising in some bands. Onsets feed a leaky rate in onsets per
+ * second: sustained material stays near zero, drums and picked or plucked passages climb to a few.
+ *
+ * Band edges are fractions of Nyquist and magnitudes are divided by the FFT size, so the state
+ * doesn't depend on the chunk size and carries over a chunk size change. Audio thread only; no
+ * allocation.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include "plugin_src/Structs.h"
+
+namespace synaptic
+{
+  class OnsetDetector
+  {
+  public:
+    static constexpr int kBands = 24;
+    static constexpr double kOctaves = 9.0;         // band range below Nyquist (~47 Hz up at 48 kHz)
+    static constexpr float kCompression = 100.0f;   // log(1 + k * magnitude)
+    static constexpr float kThresholdRatio = 1.6f;  // flux over the running mean that counts as an onset
+    static constexpr float kThresholdFloor = 0.05f; // keeps noise in near-silence from counting
+    static constexpr double kRefractorySeconds = 0.06; // shortest gap between two onsets
+    static constexpr double kMeanSeconds = 1.0;     // time constant of the running mean flux
+    static constexpr double kRateSeconds = 2.0;     // time constant of the onset rate
+
+    void Reset()
+    {
+      mPrev.fill(0.0f);
+      mPrimed = false;
+      mSinceOnset = kRefractorySeconds;
+      mMeanFlux = 0.0f;
+      mRate = 0.0;
+    }
+
+    /**
+     * @brief Feed the next input chunk (its complexSpectrum must be computed)
+     * @param hopSeconds Time since the chunk before
+     * @return True if the chunk starts an onset
+     */
+    bool Process(const AudioChunk& chunk, double hopSeconds)
+    {
+      const int n = chunk.fftSize;
+      const int nyquist = n / 2;
+      if (nyquist < 2 || chunk.complexSpectrum.empty()) return false;
+
+      std::array<float, kBands> bands {};
+      for (const auto& spec : chunk.complexSpectrum)
+      {
+        if ((int) spec.size() < n) continue;
+        int lo = 1;
+        for (int b = 0; b < kBands; ++b)
+        {
+          const int hi = std::min(nyquist, std::max(lo + 1, BandEdge(b + 1, nyquist)));
+          float sum = 0.0f;
+          for (int k = lo; k < hi; ++k)
+          {
+            // Bin 0 packs DC and Nyquist, both real
+            const float prevRe = k > 1 ? spec[2 * k - 2] : spec[0];
+            const float prevIm = k > 1 ? spec[2 * k - 1] : 0.0f;
+            const float nextRe = k + 1 < nyquist ? spec[2 * k + 2] : spec[1];
+            const float nextIm = k + 1 < nyquist ? spec[2 * k + 3] : 0.0f;
+            const float re = 0.5f * spec[2 * k] - 0.25f * (prevRe + nextRe);
+            const float im = 0.5f * spec[2 * k + 1] - 0.25f * (prevIm + nextIm);
+            sum += std::sqrt(re * re + im * im);
+          }
+          bands[b] += sum;
+          lo = hi;
+        }
+      }
+
+      float flux = 0.0f;
+      for (int b = 0; b < kBands; ++b)
+      {
+        const float level = std::log1p(kCompression * bands[b] / (float) n);
+        flux += std::max(0.0f, level - mPrev[b]);
+        mPrev[b] = level;
+      }
+      flux /= (float) kBands;
+
+      const double hop = std::max(0.0, hopSeconds);
+      bool onset = false;
+      if (!mPrimed)
+      {
+        // The first chunk has nothing to rise from
+        mPrimed = true;
+        mMeanFlux = flux;
+      }
+      else
+      {
+        mSinceOnset += hop;
+        onset = mSinceOnset >= kRefractorySeconds && flux > mMeanFlux * kThresholdRatio + kThresholdFloor;
+        mMeanFlux += (flux - mMeanFlux) * (float) (1.0 - std::exp(-hop / kMeanSeconds));
+      }
+      if (onset) mSinceOnset = 0.0;
+
+      mRate *= std::exp(-hop / kRateSeconds);
+      if (onset) mRate += 1.0 / kRateSeconds;
+      return onset;
+    }
+
+    /** @brief Recent onsets per second */
+    double GetRate() const { return mRate; }
+
+  private:
+    // First bin of band b (b = kBands: Nyquist), log-spaced over kOctaves
+    static int BandEdge(int b, int nyquist)
+    {
+      return (int) std::lround(nyquist * std::exp2(-kOctaves * (1.0 - (double) b / kBands)));
+    }
+
+    std::array<float, kBands> mPrev {};
+    bool mPrimed = false;
+    double mSinceOnset = kRefractorySeconds;
+    float mMeanFlux = 0.0f;
+    double mRate = 0.0;
+  };
+}
@@ -13,7 +13,7 @@
 #include <cmath>
 #include <cstring>
 #include <algorithm>
-#include "IPlug_include_in_plug_hdr.h"
+#include "IPlugConstants.h"
 #include "Window.h"
 #include "../Structs.h"
 
@@ -33,12 +33,14 @@ public:
    * @brief Configure the synthesizer
    * @param numChannels Number of audio channels
    * @param chunkSize Size of each chunk in samples
+   * @param capacity Buffered samples to allocate for (at least two chunks); more when output is
+   *                 held back longer than a chunk
    */
-  void Configure(int numChannels, int chunkSize)
+  void Configure(int numChannels, int chunkSize, int capacity = 0)
   {
     mNumChannels = std::max(1, numChannels);
     mChunkSize = std::max(1, chunkSize);
-    mOverlapBuffer.assign(mNumChannels, std::vector<iplug::sample>(mChunkSize * 2, 0.0));
+    mOverlapBuffer.assign(mNumChannels, std::vector<iplug::sample>(std::max(mChunkSize * 2, capacity), 0.0));
     Reset();
   }
 
@@ -130,6 +132,58 @@ public:
     return framesToCopy;
   }
 
+  /**
+   * @brief Append frames of a chunk after what is buffered, without overlap
+   *
+   * Never grows the buffer: frames that don't fit are dropped.
+   * @param offset First frame of @p chunk to append
+   * @param windowCoeffs Window coefficients of the whole chunk (nullptr for no windowing)
+   */
+  void Append(const AudioChunk& chunk, int offset, const std::vector<float>* windowCoeffs, float gain)
+  {
+    const int capacity = mOverlapBuffer.empty() ? 0 : static_cast<int>(mOverlapBuffer[0].size());
+    const int frames = std::min(chunk.numFrames - offset, capacity - mValidSamples);
+    if (offset < 0 || frames <= 0) return;
+
+    const int chans = std::min(mNumChannels, static_cast<int>(chunk.channelSamples.size()));
+    for (int ch = 0; ch < chans; ++ch)
+    {
+      const auto& src = chunk.channelSamples[ch];
+      auto& dst = mOverlapBuffer[ch];
+      for (int i = 0; i < frames && offset + i < static_cast<int>(src.size()); ++i)
+      {
+        const int j = offset + i;
+        const float w = (windowCoeffs && j < static_cast<int>(windowCoeffs->size())) ? (*windowCoeffs)[j] : 1.0f;
+        dst[mValidSamples + i] = src[j] * w * gain;
+      }
+    }
+    mValidSamples += frames;
+  }
+
+  /**
+   * @brief Add everything buffered to @p outputs, without latency control
+   *
+   * For the tail of a retired configuration, which no more chunks are added to.
+   * @param gainAt Gain of output frame i, gainAt(i)
+   * @return Number of frames mixed
+   */
+  template <class GainFn>
+  int MixOutput(iplug::sample** outputs, int nFrames, int outChans, float rescale, GainFn&& gainAt)
+  {
+    const int chansToWrite = std::min(outChans, mNumChannels);
+    const int framesToMix = std::min(nFrames, mValidSamples);
+    if (framesToMix <= 0) return 0;
+
+    for (int i = 0; i < framesToMix; ++i)
+    {
+      const double gain = rescale * gainAt(i);
+      for (int ch = 0; ch < chansToWrite; ++ch)
+        if (outputs[ch]) outputs[ch][i] += mOverlapBuffer[ch][i] * gain;
+    }
+    ShiftBuffer(framesToMix);
+    return framesToMix;
+  }
+
   int GetValidSamples() const { return mValidSamples; }
 
 private:
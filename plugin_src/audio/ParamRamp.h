@@ -0,0 +1,104 @@
+/**
+ * @file ParamRamp.h
+ * @brief Per-chunk ramps for continuous morph and autotune parameters
+ *
+ * Morphs and autotune process one spectrum per chunk, so their parameters can only change from one
+ * chunk to the next. Taken straight from the IParam, every automation step lands as a jump between
+ * two chunks that overlap-add only smears over a single hop, and fast automation zippers. A ramp
+ * takes the automated value as its target and moves there linearly over a fixed time: each chunk
+ * advances it by the input hop it spans, gets the start and end values of that span, and processes
+ * with the value at its centre.
+ *
+ * The target is set from any thread (parameter changes); Advance and the ramped value belong to
+ * the audio thread. After Reset (the owner was reset or just created) the next target is jumped
+ * to rather than ramped, so a fresh component starts at its bound values.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+namespace synaptic
+{
+  class ParamRamp
+  {
+  public:
+    static constexpr double kDefaultRampMs = 50.0;
+
+    /** @brief Start and end value of the span one chunk covers */
+    struct Span
+    {
+      double start = 0.0;
+      double end = 0.0;
+      double Mid() const { return 0.5 * (start + end); }
+    };
+
+    explicit ParamRamp(double value = 0.0) : mTarget(value), mValue(value) {}
+
+    /** @brief Ramp length at @p sampleRate, and jump to the next target (owner reset) */
+    void Reset(double sampleRate, double rampMs = kDefaultRampMs)
+    {
+      mRampSamples = std::max(0.0, sampleRate * rampMs / 1000.0);
+      mRemaining = 0.0;
+      mPrimed = false;
+    }
+
+    // === Any thread ===
+
+    void SetTarget(double target)
+    {
+      mTarget.store(target, std::memory_order_relaxed);
+      mTargetVersion.fetch_add(1, std::memory_order_release);
+    }
+
+    double GetTarget() const { return mTarget.load(std::memory_order_relaxed); }
+
+    // === Audio thread ===
+
+    /** @brief Move by one chunk's input hop; a new target restarts the full ramp from where it is */
+    Span Advance(int hopSamples)
+    {
+      const uint32_t version = mTargetVersion.load(std::memory_order_acquire);
+      const double target = mTarget.load(std::memory_order_relaxed);
+      if (version != mSeenVersion || !mPrimed)
+      {
+        mSeenVersion = version;
+        if (!mPrimed) mValue = target;
+        mRemaining = mPrimed ? mRampSamples : 0.0;
+        mPrimed = true;
+      }
+
+      Span span;
+      span.start = mValue;
+      const double hop = (double) std::max(0, hopSamples);
+      if (mRemaining <= hop)
+      {
+        mValue = target;
+        mRemaining = 0.0;
+      }
+      else
+      {
+        mValue += (target - mValue) * hop / mRemaining;
+        mRemaining -= hop;
+      }
+      span.end = mValue;
+      return span;
+    }
+
+    /** @brief Where the ramp is (the end of the last chunk) */
+    double GetValue() const { return mValue; }
+
+  private:
+    std::atomic<double> mTarget;
+    std::atomic<uint32_t> mTargetVersion { 0 };
+
+    // Audio thread
+    double mValue;
+    double mRampSamples = 48000.0 * kDefaultRampMs / 1000.0;
+    double mRemaining = 0.0;
+    uint32_t mSeenVersion = 0;
+    bool mPrimed = false;
+  };
+}
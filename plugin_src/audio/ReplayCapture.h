@@ -0,0 +1,314 @@
+/**
+ * @file ReplayCapture.h
+ * @brief Records the live session into a replay file (ReplayFile.h)
+ *
+ * Start() hands the brain snapshot to a writer thread, which saves it, writes the header and only
+ * then lets the audio thread record. The audio thread copies each block (input, BlockParams and the
+ * parameters that changed) into a lock-free single-producer/single-consumer byte ring; the writer
+ * thread streams the ring to "<name>.sbrp.tmp" and renames it into place when the capture ends.
+ *
+ * A capture covers a stretch in which the replay can reproduce what the plugin did: it ends on its
+ * own when the host resets the plugin, when a parameter that rechunks the brain or rebuilds the
+ * windows changes, when adaptive chunking switches the chunk size, when the brain is edited, or if
+ * the ring fills up. Transformer, morph, autotune
+ * and dynamic parameter changes, including switching transformer or morph, are recorded.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "plugin_src/audio/ReplayFile.h"
+#include "plugin_src/brain/Brain.h"
+#include "plugin_src/common/CachePaths.h"
+#include "plugin_src/params/ParameterIds.h"
+
+namespace synaptic
+{
+  class ReplayCapture
+  {
+  public:
+    static constexpr size_t kRingBytes = 16u << 20; // about 10 s of stereo input at 96 kHz
+
+    struct Status
+    {
+      bool active = false;    // a capture is being prepared, recorded or saved
+      bool recording = false; // the audio thread is recording
+      double seconds = 0.0;   // recorded so far (or in the last capture)
+      std::string path;       // current or last replay
+      bool lastSaved = false; // the last capture was saved (false: it failed to write)
+      ReplayEndReason lastEnd = ReplayEndReason::Stopped;
+    };
+
+    ReplayCapture() = default;
+    ReplayCapture(const ReplayCapture&) = delete;
+    ReplayCapture& operator=(const ReplayCapture&) = delete;
+
+    ~ReplayCapture()
+    {
+      End(ReplayEndReason::Stopped);
+      if (mWriter.joinable()) mWriter.join();
+    }
+
+    /** @brief "<cache dir>/replays/replay-<date>-<time>.sbrp", or empty if there is no cache directory */
+    static std::string NewPath()
+    {
+      const std::string base = cache::GetCacheDirectory();
+      if (base.empty()) return std::string();
+      const std::string dir = base + "replays";
+      if (!cache::MakeDirectory(dir)) return std::string();
+      char name[48];
+      const std::time_t now = std::time(nullptr);
+      std::strftime(name, sizeof(name), "replay-%Y%m%d-%H%M%S.sbrp", std::localtime(&now));
+      return dir + base.back() + name;
+    }
+
+    // === UI thread ===
+
+    /**
+     * @brief Begin capturing into @p path (with the brain snapshot next to it)
+     * @param header Everything but the brain fields, which the writer fills in
+     * @return false if a capture is still active
+     */
+    bool Start(const std::string& path, ReplayHeader header, const Brain& brain)
+    {
+      if (mActive.load() || path.empty() || header.numParams <= 0) return false;
+      if (mWriter.joinable()) mWriter.join();
+
+      if (mRing.empty()) mRing.resize(kRingBytes);
+      mLastValues.assign((size_t) header.numParams, std::numeric_limits<double>::quiet_NaN());
+      mChanged.assign((size_t) header.numParams, 0);
+      mHead.store(0);
+      mTail.store(0);
+      mFrames.store(0);
+      mEndReason.store(kNotEnded);
+      mSampleRate = header.sampleRate;
+      mBrain = &brain;
+      // Read before the snapshot: an edit in between ends the capture rather than going unnoticed
+      mBrainVersion = brain.GetContentVersion();
+      auto state = brain.GetStateSnapshot();
+      const int windowMode = brain.GetWindowMode();
+      {
+        std::lock_guard<std::mutex> lock(mStatusMutex);
+        mPath = path;
+      }
+      mActive.store(true);
+      mWriter = std::thread([this, path, header, state, windowMode]() mutable { Run(path, std::move(header), state, windowMode); });
+      return true;
+    }
+
+    /** @brief End the capture; the writer saves it in the background */
+    void Stop() { End(ReplayEndReason::Stopped); }
+
+    bool IsActive() const { return mActive.load(); }
+
+    Status GetStatus() const
+    {
+      Status s;
+      s.active = mActive.load();
+      s.recording = mRecording.load();
+      s.seconds = mSampleRate > 0.0 ? (double) mFrames.load() / mSampleRate : 0.0;
+      std::lock_guard<std::mutex> lock(mStatusMutex);
+      s.path = mPath;
+      s.lastSaved = mLastSaved;
+      s.lastEnd = mLastEnd;
+      return s;
+    }
+
+    // === Audio thread ===
+
+    bool IsRecording() const { return mRecording.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Record one block, before DSPContext processes it (it applies input gain in place)
+     * @param getParam Returns IParam::Value of a plugin parameter by index
+     */
+    template <class GetParamFn>
+    void CaptureBlock(iplug::sample** inputs, int nFrames, const DSPContext::BlockParams& params, GetParamFn&& getParam)
+    {
+      // Paired with the writer clearing mRecording and then waiting for mInBlock (both seq_cst)
+      mInBlock.store(true);
+      if (mRecording.load())
+        Record(inputs, nFrames, params, getParam);
+      mInBlock.store(false);
+    }
+
+    /** @brief End the capture for @p reason (any thread; the first reason given wins) */
+    void End(ReplayEndReason reason)
+    {
+      int expected = kNotEnded;
+      mEndReason.compare_exchange_strong(expected, (int) reason);
+      mRecording.store(false);
+    }
+
+  private:
+    static constexpr int kNotEnded = -1;
+
+    // Parameters the replay can't follow: they rechunk the brain or rebuild the windows
+    static bool EndsCapture(int paramIdx)
+    {
+      return paramIdx == kChunkSize || paramIdx == kBufferWindow || paramIdx == kOutputWindow
+        || paramIdx == kAnalysisWindow || paramIdx == kEnableOverlap;
+    }
+
+    // Writes into the ring at a running byte position (wrapping around)
+    struct RingSink
+    {
+      std::vector<uint8_t>& ring;
+      uint64_t pos;
+
+      template <class T> void Put(const T* value) { PutBytes(value, sizeof(T)); }
+
+      void PutBytes(const void* data, size_t size)
+      {
+        const size_t at = (size_t) (pos % ring.size());
+        const size_t first = std::min(size, ring.size() - at);
+        std::memcpy(ring.data() + at, data, first);
+        std::memcpy(ring.data(), static_cast<const uint8_t*>(data) + first, size - first);
+        pos += size;
+      }
+    };
+
+    template <class GetParamFn>
+    void Record(iplug::sample** inputs, int nFrames, const DSPContext::BlockParams& params, GetParamFn& getParam)
+    {
+      if (mBrain->GetContentVersion() != mBrainVersion)
+      {
+        End(ReplayEndReason::BrainChanged);
+        return;
+      }
+
+      const bool first = mHead.load(std::memory_order_relaxed) == 0;
+      int numChanged = 0;
+      for (int i = 0; i < (int) mLastValues.size(); ++i)
+      {
+        const double v = getParam(i);
+        if (v == mLastValues[i]) continue;
+        if (!first && EndsCapture(i))
+        {
+          End(ReplayEndReason::ConfigChanged);
+          return;
+        }
+        mLastValues[i] = v;
+        mChanged[numChanged++] = i;
+      }
+
+      // Null inputs are processed as silence; recorded as no input channels, which does the same
+      DSPContext::BlockParams recorded = params;
+      if (!inputs) recorded.inChans = 0;
+      const size_t size = ReplayFormat::BlockRecordSize(nFrames, recorded.inChans, numChanged);
+      const uint64_t head = mHead.load(std::memory_order_relaxed);
+      if (size > kRingBytes - (size_t) (head - mTail.load(std::memory_order_acquire)))
+      {
+        End(ReplayEndReason::Overflow);
+        return;
+      }
+      RingSink sink { mRing, head };
+      ReplayFormat::WriteBlock(sink, nFrames, recorded, mChanged.data(), numChanged, mLastValues.data(), inputs);
+      mHead.store(head + size, std::memory_order_release);
+      mFrames.fetch_add((uint64_t) std::max(0, nFrames), std::memory_order_relaxed);
+    }
+
+    // Everything the audio thread has published so far
+    void Drain(SnapshotWriter& out)
+    {
+      const uint64_t head = mHead.load(std::memory_order_acquire);
+      uint64_t tail = mTail.load(std::memory_order_relaxed);
+      while (tail != head)
+      {
+        const size_t at = (size_t) (tail % mRing.size());
+        const size_t n = (size_t) std::min<uint64_t>(head - tail, mRing.size() - at);
+        out.PutBytes(mRing.data() + at, n);
+        tail += n;
+      }
+      mTail.store(tail, std::memory_order_release);
+    }
+
+    void Run(const std::string& path, ReplayHeader header, std::shared_ptr<const BrainState> state, int windowMode)
+    {
+      const size_t dot = path.find_last_of('.');
+      const std::string brainPath = path.substr(0, dot) + ".sbrain";
+      const size_t slash = brainPath.find_last_of("/\\");
+      header.brainFile = slash == std::string::npos ? brainPath : brainPath.substr(slash + 1);
+
+      bool ok = false;
+      if (FILE* fp = fopen(brainPath.c_str(), "wb"))
+      {
+        ok = Brain::SerializeStateToFile(*state, false, windowMode, fp, header.brainHash);
+        ok = fclose(fp) == 0 && ok;
+      }
+      state.reset();
+
+      const std::string tmpPath = path + ".tmp";
+      FILE* fp = ok ? fopen(tmpPath.c_str(), "wb") : nullptr;
+      if (fp)
+      {
+        SnapshotWriter out(fp, nullptr);
+        ReplayFormat::WriteHeader(out, header);
+        if (mEndReason.load() == kNotEnded) mRecording.store(true);
+        while (mEndReason.load() == kNotEnded)
+        {
+          Drain(out);
+          std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        // Let a block being recorded finish before the last drain
+        mRecording.store(false);
+        while (mInBlock.load()) std::this_thread::yield();
+        Drain(out);
+        ReplayFormat::WriteEnd(out, (ReplayEndReason) mEndReason.load());
+        ok = out.Finish();
+        ok = fclose(fp) == 0 && ok;
+        std::remove(path.c_str());
+        ok = ok && std::rename(tmpPath.c_str(), path.c_str()) == 0;
+      }
+      else
+        ok = false;
+
+      if (!ok)
+      {
+        End(ReplayEndReason::WriteFailed);
+        std::remove(tmpPath.c_str());
+        std::remove(brainPath.c_str());
+      }
+      {
+        std::lock_guard<std::mutex> lock(mStatusMutex);
+        mLastSaved = ok;
+        mLastEnd = ok ? (ReplayEndReason) mEndReason.load() : ReplayEndReason::WriteFailed;
+      }
+      mActive.store(false);
+    }
+
+    // Audio thread (written by Start before the capture runs)
+    std::vector<uint8_t> mRing;
+    std::vector<double> mLastValues; // NaN until the first block, so it records every parameter
+    std::vector<int> mChanged;
+    const Brain* mBrain = nullptr;
+    uint32_t mBrainVersion = 0;
+    double mSampleRate = 0.0;
+
+    std::atomic<uint64_t> mHead { 0 }; // bytes written by the audio thread
+    std::atomic<uint64_t> mTail { 0 }; // bytes taken by the writer
+    std::atomic<uint64_t> mFrames { 0 };
+    std::atomic<bool> mRecording { false };
+    std::atomic<bool> mInBlock { false };
+    std::atomic<int> mEndReason { kNotEnded };
+    std::atomic<bool> mActive { false };
+    std::thread mWriter;
+
+    mutable std::mutex mStatusMutex;
+    std::string mPath;
+    bool mLastSaved = false;
+    ReplayEndReason mLastEnd = ReplayEndReason::Stopped;
+  };
+}
@@ -0,0 +1,290 @@
+/**
+ * @file ReplayFile.h
+ * @brief Recorded session for deterministic offline replay
+ *
+ * A replay holds what reached DSPContext during a stretch of a live session: each block's input
+ * audio (before input gain) and BlockParams, the plugin parameters that changed since the block
+ * before, the configuration, and a snapshot of the brain it ran against. Played back headless
+ * (benchmarks/ReplayRunner.cpp), the same blocks go through the same processing every time, so the
+ * output of two builds or two matching variants can be compared bit for bit, and timed.
+ *
+ * "<name>.sbrp" holds magic, version and the header (sample rate, channels, DSPConfig, FFT size,
+ * parameter count, dynamic parameter bindings, brain file name and hash), then one record per block and an
+ * end record with the reason the capture ended. The brain is a regular snapshot, "<name>.sbrain",
+ * in the same folder. Capturing is done by ReplayCapture.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "plugin_src/audio/DSPContext.h"
+#include "plugin_src/brain/SnapshotIO.h"
+#include "plugin_src/common/MappedFile.h"
+#include "plugin_src/modules/DSPConfig.h"
+#include "plugin_src/params/DynamicParamSchema.h"
+
+namespace synaptic
+{
+  enum class ReplayEndReason : int32_t
+  {
+    Stopped = 0,   // by the user
+    Reset,         // the host reset the plugin
+    ConfigChanged, // chunk size, buffer window, windows or overlap changed (needs a rechunk/reset)
+    BrainChanged,  // the brain was edited
+    Overflow,      // the writer fell behind the audio thread
+    WriteFailed
+  };
+
+  inline const char* ReplayEndReasonName(ReplayEndReason reason)
+  {
+    switch (reason)
+    {
+      case ReplayEndReason::Stopped: return "stopped";
+      case ReplayEndReason::Reset: return "host reset";
+      case ReplayEndReason::ConfigChanged: return "DSP configuration changed";
+      case ReplayEndReason::BrainChanged: return "brain changed";
+      case ReplayEndReason::Overflow: return "disk writer fell behind";
+      case ReplayEndReason::WriteFailed: return "write failed";
+    }
+    return "";
+  }
+
+  struct ReplayHeader
+  {
+    double sampleRate = 0.0;
+    int32_t inChans = 0;  // connected when the capture started (blocks carry their own)
+    int32_t outChans = 0;
+    DSPConfig config;
+    int32_t fftSize = 0;   // the chunker's planned FFT size (FFTPlanner); 0 in version 1 replays
+    int32_t numParams = 0; // plugin parameters, dynamic ones included
+    std::vector<TransformerParamBinding> bindings;
+    std::string brainFile; // name of the brain snapshot, in the replay's folder
+    uint64_t brainHash = 0; // BrainRegistry::HashBytes of the brain snapshot
+  };
+
+  /** @brief One recorded block; the samples point into the replay file */
+  struct ReplayBlock
+  {
+    int frames = 0;
+    DSPContext::BlockParams params;
+    std::vector<std::pair<int, double>> changes; // (parameter index, IParam::Value) changed before this block
+    const uint8_t* samples = nullptr;            // params.inChans planar channels of frames doubles
+
+    void CopyInput(int ch, iplug::sample* dst) const
+    {
+      std::memcpy(dst, samples + (size_t) ch * frames * sizeof(double), (size_t) frames * sizeof(double));
+    }
+  };
+
+  namespace ReplayFormat
+  {
+    constexpr uint32_t kMagic = 0x50524253; // 'SBRP' Synaptic Brain RePlay
+    constexpr uint16_t kVersion = 2; // 2: FFT size
+    constexpr uint16_t kMinVersion = 1;
+    constexpr uint8_t kEndTag = 0;
+    constexpr uint8_t kBlockTag = 1;
+
+    inline void WriteHeader(SnapshotWriter& out, const ReplayHeader& h)
+    {
+      out.Put(&kMagic);
+      out.Put(&kVersion);
+      out.Put(&h.sampleRate);
+      out.Put(&h.inChans);
+      out.Put(&h.outChans);
+      const int32_t config[5] = { h.config.chunkSize, h.config.bufferWindowSize, h.config.outputWindowMode,
+                                  h.config.analysisWindowMode, h.config.algorithmId };
+      out.PutBytes(config, sizeof(config));
+      const uint8_t overlap = h.config.enableOverlapAdd ? 1 : 0;
+      out.Put(&overlap);
+      out.Put(&h.fftSize);
+      out.Put(&h.numParams);
+      const int32_t numBindings = (int32_t) h.bindings.size();
+      out.Put(&numBindings);
+      for (const auto& b : h.bindings)
+      {
+        out.PutString(b.id);
+        const int32_t type = (int32_t) b.type;
+        const int32_t paramIdx = b.paramIdx;
+        out.Put(&type);
+        out.Put(&paramIdx);
+        const int32_t numValues = (int32_t) b.enumValues.size();
+        out.Put(&numValues);
+        for (const auto& v : b.enumValues) out.PutString(v);
+      }
+      out.PutString(h.brainFile);
+      out.Put(&h.brainHash);
+    }
+
+    inline bool ReadHeader(SnapshotReader& in, ReplayHeader& h)
+    {
+      uint32_t magic = 0;
+      uint16_t ver = 0;
+      int32_t config[5] = {};
+      uint8_t overlap = 0;
+      int32_t numBindings = 0;
+      h.fftSize = 0;
+      if (!in.Get(&magic) || magic != kMagic || !in.Get(&ver) || ver < kMinVersion || ver > kVersion
+          || !in.Get(&h.sampleRate) || !in.Get(&h.inChans) || !in.Get(&h.outChans) || !in.GetBytes(config, sizeof(config))
+          || !in.Get(&overlap) || (ver >= 2 && !in.Get(&h.fftSize))
+          || !in.Get(&h.numParams) || !in.Get(&numBindings) || numBindings < 0 || h.sampleRate <= 0.0)
+        return false;
+      h.config.chunkSize = config[0];
+      h.config.bufferWindowSize = config[1];
+      h.config.outputWindowMode = config[2];
+      h.config.analysisWindowMode = config[3];
+      h.config.algorithmId = config[4];
+      h.config.enableOverlapAdd = overlap != 0;
+
+      h.bindings.clear();
+      for (int i = 0; i < numBindings; ++i)
+      {
+        TransformerParamBinding b;
+        int32_t type = 0, paramIdx = -1, numValues = 0;
+        if (!in.GetString(b.id) || !in.Get(&type) || !in.Get(&paramIdx) || !in.Get(&numValues) || numValues < 0)
+          return false;
+        b.type = (ParamType) type;
+        b.paramIdx = paramIdx;
+        b.enumValues.resize((size_t) numValues);
+        for (auto& v : b.enumValues)
+          if (!in.GetString(v)) return false;
+        h.bindings.push_back(std::move(b));
+      }
+      return in.GetString(h.brainFile) && in.Get(&h.brainHash);
+    }
+
+    inline size_t BlockRecordSize(int frames, int inChans, int numChanges)
+    {
+      return sizeof(uint8_t) + sizeof(uint32_t) + 2 * sizeof(int32_t) + 2 * sizeof(double) + sizeof(uint8_t)
+        + sizeof(int32_t) + (size_t) numChanges * (sizeof(int32_t) + sizeof(double))
+        + (size_t) inChans * frames * sizeof(double);
+    }
+
+    /**
+     * @brief Write a block record to any sink with Put/PutBytes (SnapshotWriter or a ring)
+     * @param changed Indices of the parameters that changed; their values are values[index]
+     */
+    template <class Sink>
+    void WriteBlock(Sink& out, int frames, const DSPContext::BlockParams& params, const int* changed, int numChanged,
+                    const double* values, iplug::sample* const* inputs)
+    {
+      static_assert(sizeof(iplug::sample) == sizeof(double), "replays store double samples");
+      const uint32_t n = (uint32_t) frames;
+      const int32_t inChans = params.inChans, outChans = params.outChans, numChanges = numChanged;
+      const uint8_t agc = params.agcEnabled ? 1 : 0;
+      out.Put(&kBlockTag);
+      out.Put(&n);
+      out.Put(&inChans);
+      out.Put(&outChans);
+      out.Put(&params.inGain);
+      out.Put(&params.outGain);
+      out.Put(&agc);
+      out.Put(&numChanges);
+      for (int i = 0; i < numChanged; ++i)
+      {
+        const int32_t idx = changed[i];
+        out.Put(&idx);
+        out.Put(&values[idx]);
+      }
+      for (int ch = 0; ch < inChans; ++ch)
+        out.PutBytes(inputs[ch], (size_t) frames * sizeof(double));
+    }
+
+    inline void WriteEnd(SnapshotWriter& out, ReplayEndReason reason)
+    {
+      const int32_t r = (int32_t) reason;
+      out.Put(&kEndTag);
+      out.Put(&r);
+    }
+  }
+
+  class ReplayReader
+  {
+  public:
+    ReplayReader() = default;
+    ReplayReader(const ReplayReader&) = delete;
+    ReplayReader& operator=(const ReplayReader&) = delete;
+
+    /** @brief Map @p path and read its header; false if it isn't a replay */
+    bool Open(const std::string& path)
+    {
+      mFile.Close();
+      if (!mFile.Open(path)) return false;
+      SnapshotReader in(mFile.Data(), mFile.Size());
+      if (!ReplayFormat::ReadHeader(in, mHeader)) return false;
+      mBlocksStart = in.Position();
+      mPath = path;
+      Rewind();
+      return true;
+    }
+
+    const ReplayHeader& GetHeader() const { return mHeader; }
+
+    /** @brief Path of the brain snapshot (next to the replay) */
+    std::string GetBrainPath() const
+    {
+      const size_t slash = mPath.find_last_of("/\\");
+      return (slash == std::string::npos ? std::string() : mPath.substr(0, slash + 1)) + mHeader.brainFile;
+    }
+
+    void Rewind()
+    {
+      mIn = SnapshotReader(mFile.Data(), mFile.Size());
+      mIn.Skip(mBlocksStart);
+      mEnded = false;
+    }
+
+    /** @brief Read the next block; false at the end record, or if the file is cut short */
+    bool Next(ReplayBlock& block)
+    {
+      if (mEnded) return false;
+      uint8_t tag = 0;
+      if (!mIn.Get(&tag)) return false;
+      if (tag == ReplayFormat::kEndTag)
+      {
+        int32_t reason = 0;
+        mEnded = mIn.Get(&reason);
+        mEndReason = (ReplayEndReason) reason;
+        return false;
+      }
+      uint32_t frames = 0;
+      int32_t inChans = 0, outChans = 0, numChanges = 0;
+      uint8_t agc = 0;
+      if (tag != ReplayFormat::kBlockTag || !mIn.Get(&frames) || !mIn.Get(&inChans) || !mIn.Get(&outChans)
+          || !mIn.Get(&block.params.inGain) || !mIn.Get(&block.params.outGain) || !mIn.Get(&agc) || !mIn.Get(&numChanges)
+          || inChans < 0 || outChans < 0 || numChanges < 0)
+        return false;
+      block.frames = (int) frames;
+      block.params.inChans = inChans;
+      block.params.outChans = outChans;
+      block.params.agcEnabled = agc != 0;
+      block.changes.resize((size_t) numChanges);
+      for (auto& c : block.changes)
+      {
+        int32_t idx = 0;
+        if (!mIn.Get(&idx) || !mIn.Get(&c.second)) return false;
+        c.first = idx;
+      }
+      const size_t sampleBytes = (size_t) inChans * frames * sizeof(double);
+      block.samples = mFile.Data() + mIn.Position();
+      return mIn.Skip(sampleBytes);
+    }
+
+    /** @brief True once the end record was read, i.e. the capture was saved completely */
+    bool IsComplete() const { return mEnded; }
+    ReplayEndReason GetEndReason() const { return mEndReason; }
+
+  private:
+    MappedFile mFile;
+    ReplayHeader mHeader;
+    std::string mPath;
+    size_t mBlocksStart = 0;
+    SnapshotReader mIn { nullptr, 0 };
+    bool mEnded = false;
+    ReplayEndReason mEndReason = ReplayEndReason::Stopped;
+  };
+}
@@ -0,0 +1,275 @@
+/**
+ * @file StageProfiler.h
+ * @brief Per-stage timing of the audio thread
+ *
+ * A crackle report says only that some block missed its deadline. With profiling compiled in, the
+ * audio thread times each stage of a block (input chunking, matching, spectra, autotune, morph,
+ * IFFT, AGC, OLA) with steady_clock scopes, adds the times up per block, and pushes one record
+ * per block into a lock-free single-producer/single-consumer ring. A consumer on the UI/idle
+ * thread drains the ring into StageProfileStats, which reports for each stage the share of the
+ * block's real-time budget it used (p50, p99 and max).
+ *
+ * SYNAPTIC_PROFILE selects it: on in debug builds unless defined to 0, off in release builds
+ * unless defined to 1. When off, the scope macros expand to nothing, and the profiler, its consumers
+ * and the UI card are compiled out (#if SYNAPTIC_PROFILE at each).
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#ifndef SYNAPTIC_PROFILE
+  #if defined(_DEBUG)
+    #define SYNAPTIC_PROFILE 1
+  #else
+    #define SYNAPTIC_PROFILE 0
+  #endif
+#endif
+
+namespace synaptic
+{
+  // Stages other than Block don't overlap, so Block minus their sum is the untracked rest
+  enum class ProfileStage : int
+  {
+    Block,    // all of DSPContext::ProcessBlock
+    Input,    // AudioStreamChunker::PushAudio (chunking + input spectrum)
+    Matching, // transformer Process
+    Spectra,  // input/output spectra for spectral processing
+    Autotune,
+    Morph,
+    IFFT,     // back to time domain + edge polish
+    AGC,
+    OLA,      // overlap-add accumulation and output
+    Count
+  };
+
+  inline const char* ProfileStageName(ProfileStage stage)
+  {
+    static const char* kNames[] = { "Block", "Input", "Matching", "Spectra", "Autotune", "Morph", "IFFT", "AGC", "OLA" };
+    const int i = (int) stage;
+    return i >= 0 && i < (int) ProfileStage::Count ? kNames[i] : "";
+  }
+
+  class StageProfiler
+  {
+  public:
+    static constexpr int kNumStages = (int) ProfileStage::Count;
+
+    /** @brief Stage times of one processed block */
+    struct BlockRecord
+    {
+      uint32_t frames = 0;
+      float sampleRate = 0.f;
+      std::array<uint32_t, kNumStages> ns {};
+    };
+
+#if SYNAPTIC_PROFILE
+    static constexpr int kCapacity = 1024; // blocks; power of two
+
+    void SetSampleRate(double sampleRate) { mSampleRate = (float) sampleRate; }
+
+    // === Audio thread ===
+
+    void BeginBlock() { mCurrent.ns.fill(0); }
+
+    void Add(ProfileStage stage, uint64_t ns)
+    {
+      uint32_t& slot = mCurrent.ns[(int) stage];
+      slot = (uint32_t) std::min<uint64_t>((uint64_t) slot + ns, UINT32_MAX);
+    }
+
+    /** @brief Publish the block; dropped (and counted) if the consumer fell behind */
+    void EndBlock(int frames)
+    {
+      mCurrent.frames = (uint32_t) std::max(0, frames);
+      mCurrent.sampleRate = mSampleRate;
+      const uint32_t head = mHead.load(std::memory_order_relaxed);
+      if (head - mTail.load(std::memory_order_acquire) >= (uint32_t) kCapacity)
+      {
+        mDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+      mRing[head & (kCapacity - 1)] = mCurrent;
+      mHead.store(head + 1, std::memory_order_release);
+    }
+
+    // === Consumer thread ===
+
+    /** @brief Hand every published block to @p fn (oldest first) */
+    template <class Fn>
+    void Drain(Fn&& fn)
+    {
+      uint32_t tail = mTail.load(std::memory_order_relaxed);
+      const uint32_t head = mHead.load(std::memory_order_acquire);
+      for (; tail != head; ++tail)
+        fn(mRing[tail & (kCapacity - 1)]);
+      mTail.store(tail, std::memory_order_release);
+    }
+
+    /** @brief Blocks dropped because the ring was full, since the last call */
+    uint64_t TakeDroppedCount() { return mDropped.exchange(0, std::memory_order_relaxed); }
+
+  private:
+    std::array<BlockRecord, kCapacity> mRing;
+    std::atomic<uint32_t> mHead { 0 }; // written by the audio thread
+    std::atomic<uint32_t> mTail { 0 }; // written by the consumer
+    std::atomic<uint64_t> mDropped { 0 };
+    BlockRecord mCurrent;
+    float mSampleRate = 48000.f;
+#endif
+  };
+
+#if SYNAPTIC_PROFILE
+  /** @brief Adds the time until end of scope to one stage (no-op with a null profiler) */
+  class ProfileScope
+  {
+  public:
+    ProfileScope(StageProfiler* profiler, ProfileStage stage)
+      : mProfiler(profiler), mStage(stage), mStart(profiler ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point())
+    {}
+
+    ~ProfileScope()
+    {
+      if (mProfiler)
+        mProfiler->Add(mStage, (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - mStart).count());
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+  private:
+    StageProfiler* mProfiler;
+    ProfileStage mStage;
+    std::chrono::steady_clock::time_point mStart;
+  };
+
+  /** @brief Times a whole block and publishes it at end of scope */
+  class ProfileBlockScope
+  {
+  public:
+    ProfileBlockScope(StageProfiler* profiler, int frames) : mProfiler(profiler), mFrames(frames)
+    {
+      if (mProfiler) mProfiler->BeginBlock();
+      mStart = std::chrono::steady_clock::now();
+    }
+
+    ~ProfileBlockScope()
+    {
+      if (!mProfiler) return;
+      mProfiler->Add(ProfileStage::Block, (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - mStart).count());
+      mProfiler->EndBlock(mFrames);
+    }
+
+    ProfileBlockScope(const ProfileBlockScope&) = delete;
+    ProfileBlockScope& operator=(const ProfileBlockScope&) = delete;
+
+  private:
+    StageProfiler* mProfiler;
+    int mFrames;
+    std::chrono::steady_clock::time_point mStart;
+  };
+
+  #define SYNAPTIC_PROFILE_CONCAT_INNER(a, b) a##b
+  #define SYNAPTIC_PROFILE_CONCAT(a, b) SYNAPTIC_PROFILE_CONCAT_INNER(a, b)
+  #define SYNAPTIC_PROFILE_SCOPE(profiler, stage) \
+    ::synaptic::ProfileScope SYNAPTIC_PROFILE_CONCAT(synapticProfileScope, __LINE__)(profiler, ::synaptic::ProfileStage::stage)
+  #define SYNAPTIC_PROFILE_BLOCK(profiler, frames) \
+    ::synaptic::ProfileBlockScope SYNAPTIC_PROFILE_CONCAT(synapticProfileBlock, __LINE__)(profiler, frames)
+#else
+  #define SYNAPTIC_PROFILE_SCOPE(profiler, stage) ((void) 0)
+  #define SYNAPTIC_PROFILE_BLOCK(profiler, frames) ((void) 0)
+#endif
+
+  /**
+   * @brief Consumer-side histograms of the share of the block budget each stage used
+   * Budget = the block's duration at the sample rate. Resolution is 0.1% of the budget up to
+   * 100%; the maximum is exact.
+   */
+  class StageProfileStats
+  {
+  public:
+    static constexpr int kNumRows = StageProfiler::kNumStages + 1; // stages + "Other"
+    static constexpr int kBuckets = 1000;
+
+    struct Row
+    {
+      std::string name;
+      float p50 = 0.f; // fractions of the block budget
+      float p99 = 0.f;
+      float max = 0.f;
+    };
+
+    StageProfileStats() { Reset(); }
+
+    void Add(const StageProfiler::BlockRecord& record)
+    {
+      if (record.frames == 0 || record.sampleRate <= 0.f) return;
+      const double budgetNs = record.frames * 1e9 / record.sampleRate;
+      uint64_t tracked = 0;
+      for (int s = 0; s < StageProfiler::kNumStages; ++s)
+      {
+        if (s != (int) ProfileStage::Block) tracked += record.ns[s];
+        AddValue(s, (float) (record.ns[s] / budgetNs));
+      }
+      const uint64_t block = record.ns[(int) ProfileStage::Block];
+      AddValue(kNumRows - 1, (float) ((block > tracked ? block - tracked : 0) / budgetNs));
+      ++mBlocks;
+    }
+
+    int GetBlockCount() const { return mBlocks; }
+
+    /** @brief One row per stage, then "Other" (Block minus the stages) */
+    std::vector<Row> Summarize() const
+    {
+      std::vector<Row> rows(kNumRows);
+      for (int r = 0; r < kNumRows; ++r)
+      {
+        rows[r].name = r < StageProfiler::kNumStages ? ProfileStageName((ProfileStage) r) : "Other";
+        rows[r].p50 = Percentile(r, 0.50);
+        rows[r].p99 = Percentile(r, 0.99);
+        rows[r].max = mMax[r];
+      }
+      return rows;
+    }
+
+    void Reset()
+    {
+      for (auto& h : mHistogram) h.fill(0);
+      mMax.fill(0.f);
+      mBlocks = 0;
+    }
+
+  private:
+    void AddValue(int row, float fraction)
+    {
+      const int bucket = std::clamp((int) (fraction * kBuckets), 0, kBuckets);
+      ++mHistogram[row][bucket];
+      mMax[row] = std::max(mMax[row], fraction);
+    }
+
+    // Upper edge of the bucket holding the percentile (the last bucket is open-ended: max)
+    float Percentile(int row, double p) const
+    {
+      if (mBlocks <= 0) return 0.f;
+      const uint64_t target = (uint64_t) std::ceil(p * mBlocks);
+      uint64_t seen = 0;
+      for (int b = 0; b < kBuckets; ++b)
+      {
+        seen += mHistogram[row][b];
+        if (seen >= target) return std::min(mMax[row], (float) (b + 1) / kBuckets);
+      }
+      return mMax[row];
+    }
+
+    std::array<std::array<uint32_t, kBuckets + 1>, kNumRows> mHistogram;
+    std::array<float, kNumRows> mMax;
+    int mBlocks = 0;
+  };
+}
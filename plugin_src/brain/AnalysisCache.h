@@ -0,0 +1,251 @@
+/**
+ * @file AnalysisCache.h
+ * @brief Per-machine cache of chunk analysis for compact brains
+ *
+ * Compact .sbrain files store only audio, so every load used to re-run the FFT and feature
+ * extraction for every chunk. The cache keeps the analysis of each file on disk, keyed by a hash
+ * of the file's stored audio plus everything the analysis depends on (chunk size, window, FFT
+ * size, sample rate and kAnalysisVersion). A later load of the same audio with the same settings
+ * maps the entry and reads the chunks from it instead of analyzing them.
+ *
+ * Entries live in "<cache dir>/analysis/<key>.sba" and are regenerable: Trim() deletes the least
+ * recently used ones once the directory grows past the size budget.
+ *
+ * Only brains that opt in use it (Brain::SetAnalysisCacheEnabled, the Brain tab's "Analysis Cache",
+ * saved with the project), since it uses disk space. SetEnabled(false) turns it off for all of them.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "SnapshotIO.h"
+#include "../common/CachePaths.h"
+#include "../common/MappedFile.h"
+
+#if defined(_WIN32)
+  #include <io.h>
+  #include <sys/utime.h>
+#else
+  #include <dirent.h>
+  #include <utime.h>
+#endif
+
+namespace synaptic
+{
+  class AnalysisCache
+  {
+  public:
+    static constexpr uint32_t kMagic = 0x43414253; // 'SBAC' Synaptic Brain Analysis Cache
+    static constexpr uint16_t kVersion = 1;
+    // Bump whenever Brain::AnalyzeChunk produces different results, so stale entries miss
+    static constexpr uint32_t kAnalysisVersion = 1;
+    static constexpr uint64_t kDefaultBudgetBytes = 2ull << 30;
+
+    /** @brief Everything the analysis of one file depends on */
+    struct Key
+    {
+      uint64_t audioHash = 0; // BrainRegistry::HashBytes of the stored audio bytes
+      int32_t encoding = 0;
+      int32_t numChannels = 0;
+      int32_t numFrames = 0;
+      int32_t chunkSize = 0;
+      int32_t windowType = 0;
+      int32_t windowSize = 0;
+      int32_t fftSize = 0;
+      double sampleRate = 0.0;
+      uint32_t analysisVersion = kAnalysisVersion;
+
+      bool operator==(const Key& o) const
+      {
+        return audioHash == o.audioHash && encoding == o.encoding && numChannels == o.numChannels
+          && numFrames == o.numFrames && chunkSize == o.chunkSize && windowType == o.windowType
+          && windowSize == o.windowSize && fftSize == o.fftSize && sampleRate == o.sampleRate
+          && analysisVersion == o.analysisVersion;
+      }
+
+      void Write(SnapshotWriter& out) const
+      {
+        out.Put(&audioHash); out.Put(&encoding); out.Put(&numChannels); out.Put(&numFrames);
+        out.Put(&chunkSize); out.Put(&windowType); out.Put(&windowSize); out.Put(&fftSize);
+        out.Put(&sampleRate); out.Put(&analysisVersion);
+      }
+
+      bool Read(SnapshotReader& in)
+      {
+        return in.Get(&audioHash) && in.Get(&encoding) && in.Get(&numChannels) && in.Get(&numFrames)
+          && in.Get(&chunkSize) && in.Get(&windowType) && in.Get(&windowSize) && in.Get(&fftSize)
+          && in.Get(&sampleRate) && in.Get(&analysisVersion);
+      }
+
+      std::string FileName() const
+      {
+        uint8_t bytes[64];
+        SnapshotWriter out(bytes, sizeof(bytes));
+        Write(out);
+        char name[24];
+        snprintf(name, sizeof(name), "%016llx", (unsigned long long) BrainRegistry::HashBytes(bytes, out.Size()));
+        return std::string(name) + kExtension;
+      }
+    };
+
+    static AnalysisCache& Instance()
+    {
+      static AnalysisCache sInstance;
+      return sInstance;
+    }
+
+    void SetEnabled(bool enabled) { mEnabled = enabled; }
+    bool IsEnabled() const { return mEnabled; }
+
+    void SetBudgetBytes(uint64_t bytes) { mBudgetBytes = bytes; }
+    uint64_t GetBudgetBytes() const { return mBudgetBytes; }
+
+    /**
+     * @brief Map the entry for @p key and hand its body to @p parse
+     * @return false on a miss, or if the entry is damaged or @p parse rejects it
+     */
+    bool Load(const Key& key, const std::function<bool(SnapshotReader&)>& parse)
+    {
+      const std::string dir = Directory();
+      if (dir.empty()) return false;
+      const std::string path = dir + key.FileName();
+
+      MappedFile file;
+      if (!file.Open(path)) return false;
+      SnapshotReader in(file.Data(), file.Size());
+      uint32_t magic = 0;
+      uint16_t ver = 0;
+      Key stored;
+      if (!in.Get(&magic) || magic != kMagic || !in.Get(&ver) || ver != kVersion || !stored.Read(in) || !(stored == key))
+        return false;
+      if (!parse(in) || in.Remaining() != 0) return false;
+
+      // Used entries are the last to be evicted
+      Touch(path);
+      return true;
+    }
+
+    /**
+     * @brief Write the entry for @p key with the body produced by @p write
+     * The entry appears atomically (temporary file + rename). An existing entry is kept.
+     */
+    bool Store(const Key& key, const std::function<void(SnapshotWriter&)>& write)
+    {
+      const std::string dir = Directory();
+      if (dir.empty()) return false;
+      const std::string path = dir + key.FileName();
+      char suffix[32];
+      snprintf(suffix, sizeof(suffix), ".%zx.tmp", std::hash<std::thread::id>()(std::this_thread::get_id()));
+      const std::string tmpPath = path + suffix;
+
+      FILE* fp = fopen(tmpPath.c_str(), "wb");
+      if (!fp) return false;
+      SnapshotWriter out(fp, nullptr);
+      out.Put(&kMagic);
+      out.Put(&kVersion);
+      key.Write(out);
+      write(out);
+      const bool written = out.Finish();
+      const bool closed = fclose(fp) == 0;
+      // rename() keeps the existing file on Windows; either copy of the entry is as good
+      if (!(written && closed) || std::rename(tmpPath.c_str(), path.c_str()) != 0)
+      {
+        std::remove(tmpPath.c_str());
+        return false;
+      }
+      return true;
+    }
+
+    /** @brief Delete least recently used entries until the cache fits its budget */
+    void Trim()
+    {
+      const std::string dir = Directory();
+      if (dir.empty()) return;
+      std::lock_guard<std::mutex> lock(mTrimMutex);
+
+      struct Entry { std::string path; uint64_t size; int64_t mtime; };
+      std::vector<Entry> entries;
+      uint64_t total = 0;
+      ForEachEntry(dir, [&](const std::string& path)
+      {
+        Entry e { path, 0, 0 };
+        if (!BrainRegistry::StatFile(path, e.size, e.mtime)) return;
+        total += e.size;
+        entries.push_back(std::move(e));
+      });
+      if (total <= mBudgetBytes) return;
+
+      std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.mtime < b.mtime; });
+      for (const auto& e : entries)
+      {
+        if (total <= mBudgetBytes) break;
+        if (std::remove(e.path.c_str()) == 0)
+          total -= e.size;
+      }
+    }
+
+  private:
+    static constexpr const char* kExtension = ".sba";
+    static constexpr const char* kSubdirectory = "analysis";
+
+    AnalysisCache() = default;
+
+    static std::string Directory()
+    {
+      const std::string base = cache::GetCacheDirectory();
+      if (base.empty()) return std::string();
+      const std::string dir = base + kSubdirectory;
+      if (!cache::MakeDirectory(dir)) return std::string();
+      return dir + base.back();
+    }
+
+    static void Touch(const std::string& path)
+    {
+#if defined(_WIN32)
+      _utime(path.c_str(), nullptr);
+#else
+      utime(path.c_str(), nullptr);
+#endif
+    }
+
+    // Calls fn with the full path of every entry file in dir
+    template <class Fn>
+    static void ForEachEntry(const std::string& dir, Fn&& fn)
+    {
+      const std::string ext = kExtension;
+      auto isEntry = [&ext](const std::string& name)
+      {
+        return name.size() > ext.size() && name.compare(name.size() - ext.size(), ext.size(), ext) == 0;
+      };
+#if defined(_WIN32)
+      struct _finddata64_t data;
+      const intptr_t handle = _findfirst64((dir + "*" + ext).c_str(), &data);
+      if (handle == -1) return;
+      do
+      {
+        if (isEntry(data.name)) fn(dir + data.name);
+      } while (_findnext64(handle, &data) == 0);
+      _findclose(handle);
+#else
+      DIR* d = opendir(dir.c_str());
+      if (!d) return;
+      while (const dirent* ent = readdir(d))
+        if (isEntry(ent->d_name)) fn(dir + ent->d_name);
+      closedir(d);
+#endif
+    }
+
+    std::atomic<bool> mEnabled { true };
+    std::atomic<uint64_t> mBudgetBytes { kDefaultBudgetBytes };
+    std::mutex mTrimMutex;
+  };
+}
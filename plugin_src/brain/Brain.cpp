@@ -1,14 +1,16 @@
 #include "Brain.h"
+#include "BrainRegistry.h"
+#include "SnapshotIO.h"
+#include "AnalysisCache.h"
 
 #include <algorithm>
 #include <cmath>
 #include <cstring>
 #include <limits>
+#include <thread>
 
 #define MINIAUDIO_IMPLEMENTATION
 #include "../../exdeps/miniaudio/miniaudio.h"
-// Use PFFFT for FFT analysis
-#include "../../exdeps/pffft/pffft.h"
 #include "plugin_src/audio/Window.h"
 #include "plugin_src/audio/FeatureAnalysis.h"
 #include "plugin_src/audio/FFT.h"
@@ -17,30 +19,200 @@ namespace synaptic
 {
 
   static constexpr uint32_t kSnapshotMagic = 0x53424252; // 'SBBR' Synaptic Brain BRain
-  static constexpr uint16_t kSnapshotVersion = 3; // v3: added extended features
+  static constexpr uint16_t kSnapshotVersion = 4; // v3: added extended features; v4: file audio stored once, chunks as views
   static constexpr uint16_t kSnapshotVersionCompact = 100; // v100: compact format (metadata + reconstructed audio only, stored as iplug::sample)
   static constexpr uint16_t kSnapshotVersionCompactF32 = 101; // v101: compact format (metadata + reconstructed audio only, stored as float32)
 
-  static void PutString(iplug::IByteChunk& chunk, const std::string& s)
+  // File audio as stored in v4 snapshots and journal records (encoding, channels, frames, raw bytes)
+  static void PutFileAudio(SnapshotWriter& out, const std::shared_ptr<const BrainAudio>& audio)
   {
-    int32_t len = (int32_t) s.size();
-    chunk.Put(&len);
-    if (len > 0) chunk.PutBytes(s.data(), len);
+    uint8_t encoding = audio ? (uint8_t) audio->encoding : 0;
+    int32_t audioChans = audio ? audio->numChannels : 0;
+    int32_t audioFrames = audio ? audio->numFrames : 0;
+    out.Put(&encoding);
+    out.Put(&audioChans);
+    out.Put(&audioFrames);
+    if (audio && !audio->data.empty())
+      out.PutBytes(audio->data.data(), audio->data.size());
   }
 
-  static bool GetString(const iplug::IByteChunk& chunk, int& pos, std::string& out)
+  static bool GetFileAudio(SnapshotReader& in, std::shared_ptr<const BrainAudio>& out)
   {
-    int32_t len = 0;
-    pos = chunk.Get(&len, pos);
-    if (pos < 0 || len < 0) return false;
-    out.resize((size_t) len);
-    if (len > 0)
-    {
-      pos = chunk.GetBytes(out.data(), len, pos);
-      if (pos < 0) return false;
+    uint8_t encoding = 0; if (!in.Get(&encoding) || encoding > (uint8_t) BrainAudio::Encoding::PCM16) return false;
+    int32_t audioChans = 0; if (!in.Get(&audioChans) || audioChans < 0) return false;
+    int32_t audioFrames = 0; if (!in.Get(&audioFrames) || audioFrames < 0) return false;
+    out.reset();
+    if (audioChans == 0) return true;
+    const size_t bytes = (size_t) audioChans * (size_t) audioFrames * (size_t) BrainAudio::BytesPerSample((BrainAudio::Encoding) encoding);
+    if (bytes > in.Remaining()) return false;
+    auto audio = std::make_shared<BrainAudio>();
+    audio->encoding = (BrainAudio::Encoding) encoding;
+    audio->numChannels = audioChans;
+    audio->numFrames = audioFrames;
+    audio->data.resize(bytes);
+    if (!in.GetBytes(audio->data.data(), bytes)) return false;
+    out = std::move(audio);
+    return true;
+  }
+
+  // One chunk with its audio (a view offset, or owned samples) and analysis
+  static void PutChunk(SnapshotWriter& out, const BrainChunk& c)
+  {
+    out.Put(&c.fileId);
+    out.Put(&c.chunkIndexInFile);
+    // Audio: a view into the file audio (offset >= 0), or owned samples (offset -1)
+    int32_t chans = (int32_t) c.NumChannels();
+    out.Put(&chans);
+    out.Put(&c.audio.numFrames);
+    int32_t sourceOffset = c.source ? c.sourceOffset : -1;
+    out.Put(&sourceOffset);
+    for (int ch = 0; ch < chans && !c.source; ++ch)
+      out.PutVector(c.audio.channelSamples[ch]);
+    // Analysis
+    out.PutVector(c.rmsPerChannel);
+    out.PutVector(c.freqHzPerChannel);
+    int32_t fftSize = c.fftSize; out.Put(&fftSize);
+    int32_t fftc = (int32_t) c.magnitudeSpectrum.size(); out.Put(&fftc);
+    for (const auto& mag : c.magnitudeSpectrum)
+      out.PutVector(mag);
+    out.PutVector(c.fftDominantHzPerChannel);
+    out.Put(&c.avgRms);
+    out.Put(&c.avgFreqHz);
+    out.Put(&c.avgFftDominantHz);
+    // Extended features (v3)
+    int32_t extChans = (int32_t) c.extendedFeaturesPerChannel.size(); out.Put(&extChans);
+    for (const auto& features : c.extendedFeaturesPerChannel)
+      out.PutVector(features);
+    out.PutVector(c.avgExtendedFeatures);
+  }
+
+  // Read a chunk written by PutChunk (or an older snapshot version). A view's source audio is
+  // left to the caller: sourceOffset >= 0 means the chunk's samples live in its file's audio.
+  static bool GetChunk(SnapshotReader& in, uint16_t ver, BrainChunk& c, int32_t& sourceOffset)
+  {
+    if (!in.Get(&c.fileId) || !in.Get(&c.chunkIndexInFile)) return false;
+    int32_t chans = 0; if (!in.Get(&chans) || chans < 0) return false;
+    if (!in.Get(&c.audio.numFrames)) return false;
+    sourceOffset = -1;
+    if (ver >= 4 && !in.Get(&sourceOffset)) return false;
+    if (sourceOffset >= 0)
+      chans = 0; // no per-chunk samples follow
+    if ((size_t) chans > in.Remaining()) return false;
+    c.audio.channelSamples.assign(chans, std::vector<iplug::sample>());
+    for (auto& samples : c.audio.channelSamples)
+      if (!in.GetVector(samples)) return false;
+    if (!in.GetVector(c.rmsPerChannel) || !in.GetVector(c.freqHzPerChannel)) return false;
+    int32_t fftSize = 0; if (!in.Get(&fftSize)) return false;
+    c.fftSize = fftSize;
+    int32_t fftc = 0; if (!in.Get(&fftc) || fftc < 0 || (size_t) fftc > in.Remaining()) return false;
+    c.magnitudeSpectrum.resize(fftc);
+    for (auto& mag : c.magnitudeSpectrum)
+      if (!in.GetVector(mag)) return false;
+    if (!in.GetVector(c.fftDominantHzPerChannel)) return false;
+    if (!in.Get(&c.avgRms) || !in.Get(&c.avgFreqHz) || !in.Get(&c.avgFftDominantHz)) return false;
+    // Extended features (v3+)
+    if (ver >= 3)
+    {
+      int32_t extChans = 0; if (!in.Get(&extChans) || extChans < 0 || (size_t) extChans > in.Remaining()) return false;
+      c.extendedFeaturesPerChannel.resize(extChans);
+      for (auto& features : c.extendedFeaturesPerChannel)
+        if (!in.GetVector(features)) return false;
+      if (!in.GetVector(c.avgExtendedFeatures)) return false;
     }
     return true;
   }
+
+  // Analysis cache key for one file's audio analyzed with the given settings
+  static AnalysisCache::Key AnalysisCacheKey(const BrainAudio& audio, int chunkSize, const ChunkAnalysisSettings& analysis)
+  {
+    AnalysisCache::Key key;
+    key.audioHash = BrainRegistry::HashBytes(audio.data.data(), audio.data.size());
+    key.encoding = (int32_t) audio.encoding;
+    key.numChannels = audio.numChannels;
+    key.numFrames = audio.numFrames;
+    key.chunkSize = chunkSize;
+    key.windowType = analysis.windowType;
+    key.windowSize = analysis.windowSize;
+    key.fftSize = Window::NextValidFFTSize(std::max(1, chunkSize));
+    key.sampleRate = analysis.sampleRate;
+    return key;
+  }
+
+  static const BrainChunk& ChunkRef(const BrainChunk& c) { return c; }
+  static const BrainChunk& ChunkRef(const std::shared_ptr<BrainChunk>& c) { return *c; }
+
+  // Analysis cache body: a file's chunks, with the complex spectra that analysis leaves on them
+  template <class Chunks>
+  static void PutCachedChunks(SnapshotWriter& out, const Chunks& chunks)
+  {
+    int32_t nChunks = (int32_t) chunks.size();
+    out.Put(&nChunks);
+    for (const auto& chunk : chunks)
+    {
+      const BrainChunk& c = ChunkRef(chunk);
+      PutChunk(out, c);
+      int32_t fftSize = c.audio.fftSize; out.Put(&fftSize);
+      int32_t specChans = (int32_t) c.audio.complexSpectrum.size(); out.Put(&specChans);
+      for (const auto& spec : c.audio.complexSpectrum)
+        out.PutVector(spec);
+    }
+  }
+
+  // Read what PutCachedChunks wrote into chunks (sized for the file), as views into f's audio
+  static bool GetCachedChunks(SnapshotReader& in, const BrainFile& f, int chunkSize, std::vector<BrainChunk>& chunks)
+  {
+    int32_t nChunks = 0; if (!in.Get(&nChunks) || nChunks != (int32_t) chunks.size()) return false;
+    for (int i = 0; i < nChunks; ++i)
+    {
+      BrainChunk& c = chunks[i];
+      int32_t sourceOffset = -1;
+      if (!GetChunk(in, kSnapshotVersion, c, sourceOffset)) return false;
+      if (c.chunkIndexInFile != i || c.audio.numFrames != chunkSize || sourceOffset != i * chunkSize / 2) return false;
+      int32_t fftSize = 0; if (!in.Get(&fftSize)) return false;
+      c.audio.fftSize = fftSize;
+      int32_t specChans = 0; if (!in.Get(&specChans) || specChans < 0 || (size_t) specChans > in.Remaining()) return false;
+      c.audio.complexSpectrum.resize(specChans);
+      for (auto& spec : c.audio.complexSpectrum)
+        if (!in.GetVector(spec)) return false;
+      c.fileId = f.id;
+      c.source = f.audio;
+      c.sourceOffset = sourceOffset;
+    }
+    return true;
+  }
+
+  // Append what write(SnapshotWriter&) produces to a chunk: a counting pass, one resize, one bulk pass
+  template <class WriteFn>
+  static bool AppendToChunk(iplug::IByteChunk& out, WriteFn&& write)
+  {
+    SnapshotWriter counter;
+    write(counter);
+    const int start = out.Size();
+    if (counter.Size() > (size_t) (std::numeric_limits<int>::max() - start)) return false;
+    out.Resize(start + (int) counter.Size());
+    SnapshotWriter writer(out.GetData() + start, counter.Size());
+    write(writer);
+    return writer.Finish() && writer.Size() == counter.Size();
+  }
+
+  // Run fn(i) for every i in [0, count) on up to one thread per core (the caller included)
+  static void ParallelFor(int count, const std::function<void(int)>& fn)
+  {
+    const int workers = std::min(count, (int) std::max(1u, std::thread::hardware_concurrency()));
+    std::atomic<int> next { 0 };
+    auto run = [&]()
+    {
+      for (int i = next.fetch_add(1); i < count; i = next.fetch_add(1))
+        fn(i);
+    };
+    std::vector<std::thread> pool;
+    for (int t = 1; t < workers; ++t)
+      pool.emplace_back(run);
+    run();
+    for (auto& t : pool)
+      t.join();
+  }
+
   static void InterleaveToPlanar(const float* interleaved,
                                  int frames,
                                  int channels,
@@ -56,6 +228,45 @@ namespace synaptic
     }
   }
 
+  std::shared_ptr<const BrainAudio> BrainAudio::FromPlanar(const std::vector<std::vector<iplug::sample>>& planar, int frames, Encoding e)
+  {
+    auto audio = std::make_shared<BrainAudio>();
+    audio->encoding = e;
+    audio->numChannels = (int) planar.size();
+    audio->numFrames = std::max(0, frames);
+    const int bps = BytesPerSample(e);
+    audio->data.resize((size_t) audio->numChannels * (size_t) audio->numFrames * (size_t) bps);
+
+    uint8_t* dst = audio->data.data();
+    for (int ch = 0; ch < audio->numChannels; ++ch)
+    {
+      const auto& src = planar[ch];
+      const int n = std::min(audio->numFrames, (int) src.size());
+      for (int i = 0; i < audio->numFrames; ++i, dst += bps)
+      {
+        const double x = (i < n) ? (double) src[i] : 0.0;
+        if (e == Encoding::Float32)
+        {
+          const float v = (float) x;
+          std::memcpy(dst, &v, 4);
+        }
+        else if (e == Encoding::PCM24)
+        {
+          const int32_t v = (int32_t) std::lround(std::max(-1.0, std::min(1.0, x)) * 8388607.0);
+          dst[0] = (uint8_t) (v & 0xFF);
+          dst[1] = (uint8_t) ((v >> 8) & 0xFF);
+          dst[2] = (uint8_t) ((v >> 16) & 0xFF);
+        }
+        else
+        {
+          const int16_t v = (int16_t) std::lround(std::max(-1.0, std::min(1.0, x)) * 32767.0);
+          std::memcpy(dst, &v, 2);
+        }
+      }
+    }
+    return audio;
+  }
+
   float Brain::ComputeRMS(const std::vector<iplug::sample>& buffer, int offset, int count)
   {
     if (count <= 0 || offset < 0 || offset + count > (int) buffer.size())
@@ -90,7 +301,7 @@ namespace synaptic
     return freq;
   }
 
-  void Brain::AnalyzeChunk(BrainChunk& chunk, int validFrames, double sampleRate)
+  void Brain::AnalyzeChunk(BrainChunk& chunk, int validFrames, double sampleRate, const Window& window)
   {
     const int chCount = (int) chunk.audio.channelSamples.size();
     if (validFrames <= 0 || chCount <= 0)
@@ -119,99 +330,53 @@ namespace synaptic
     chunk.avgRms = (chCount > 0) ? (float) (rmsSum / (double) chCount) : 0.0f;
     chunk.avgFreqHz = (chCount > 0) ? (freqSum / (double) chCount) : 0.0;
 
-    // Use the chunk's nominal size for FFT (we zero-pad anyway) to match the chunker
+    // Use the chunk's nominal size for FFT (we zero-pad anyway). Always the smallest legal size,
+    // not FFTPlanner's: its choice depends on the machine, and saved analysis must not
     const int framesForFft = std::max(1, chunk.audio.numFrames);
     const int Nfft = Window::NextValidFFTSize(framesForFft);
     chunk.fftSize = Nfft;
-    chunk.magnitudeSpectrum.assign(chCount, std::vector<float>(Nfft/2 + 1, 0.0f));
     chunk.fftDominantHzPerChannel.assign(chCount, 0.0);
 
     // Initialize extended features
     chunk.extendedFeaturesPerChannel.assign(chCount, std::vector<float>(7, 0.0f));
     chunk.avgExtendedFeatures.assign(7, 0.0f);
 
-    // Prepare PFFFT setup once per chunk
-    PFFFT_Setup* setup = pffft_new_setup(Nfft, PFFFT_REAL);
-    if (setup)
+    // One FFT setup per analysis thread, reused across chunks (only rebuilt when Nfft changes).
+    // Windowing, transform and magnitudes run as one batched pass over all channels.
+    thread_local FFTProcessor fft;
+    fft.Configure(Nfft);
+    fft.ComputeChunkSpectrum(chunk.audio, window, &chunk.magnitudeSpectrum);
+
+    for (int ch = 0; ch < chCount; ++ch)
     {
-      // Aligned buffers
-      float* inAligned = (float*) pffft_aligned_malloc(sizeof(float) * Nfft);
-      float* outAligned = (float*) pffft_aligned_malloc(sizeof(float) * Nfft);
-      if (inAligned && outAligned)
+      const auto& mags = chunk.magnitudeSpectrum[ch];
+
+      // Dominant bin (exclude DC if desired; keep it simple and include all)
+      int bestK = 0;
+      float bestMag = -std::numeric_limits<float>::infinity();
+      for (int k = 0; k <= Nfft/2; ++k)
       {
-        for (int ch = 0; ch < chCount; ++ch)
+        if (mags[k] > bestMag)
         {
-          // Copy valid frames and zero-pad
-          for (int i = 0; i < Nfft; ++i)
-          {
-            float x = 0.0f;
-            if (i < framesForFft && i < (int) chunk.audio.channelSamples[ch].size())
-              x = (float) chunk.audio.channelSamples[ch][i];
-            inAligned[i] = x;
-          }
-
-          // Apply windowing before FFT
-          const Window& window = *mWindow;
-          window(inAligned);
-
-          // Ordered forward transform to get canonical interleaved output
-          pffft_transform_ordered(setup, inAligned, outAligned, nullptr, PFFFT_FORWARD);
-
-          // Extract magnitudes for bins 0..N/2
-          auto& mags = chunk.magnitudeSpectrum[ch];
-          if ((int) mags.size() != (Nfft/2 + 1)) mags.assign(Nfft/2 + 1, 0.0f);
-          // DC and Nyquist packed in first complex slot: out[0]=F0(real), out[1]=F(N/2)(real)
-          mags[0] = std::abs(outAligned[0]);
-          mags[Nfft/2] = std::abs(outAligned[1]);
-          for (int k = 1; k < Nfft/2; ++k)
-          {
-            float re = outAligned[2 * k + 0];
-            float im = outAligned[2 * k + 1];
-            mags[k] = std::sqrt(re * re + im * im);
-          }
-
-          // Dominant bin (exclude DC if desired; keep it simple and include all)
-          int bestK = 0;
-          float bestMag = -std::numeric_limits<float>::infinity();
-          for (int k = 0; k <= Nfft/2; ++k)
-          {
-            if (mags[k] > bestMag)
-            {
-              bestMag = mags[k];
-              bestK = k;
-            }
-          }
-          double domHz = (double) bestK * sampleRate / (double) Nfft;
-          // Clamp to [20, nyquist-20]
-          const double ny = 0.5 * sampleRate;
-          if (domHz < 20.0) domHz = 20.0;
-          if (domHz > ny - 20.0) domHz = ny - 20.0;
-          chunk.fftDominantHzPerChannel[ch] = domHz;
-
-          // Store full ordered spectrum into chunk.audio
-          if (chunk.audio.fftSize != Nfft)
-          {
-            chunk.audio.fftSize = Nfft;
-            chunk.audio.complexSpectrum.assign(chCount, std::vector<float>(Nfft, 0.0f));
-          }
-          if (ch < (int)chunk.audio.complexSpectrum.size())
-          {
-            std::memcpy(chunk.audio.complexSpectrum[ch].data(), outAligned, sizeof(float) * Nfft);
-          }
-
-          // Compute extended features using FeatureAnalysis (outAligned has ordered FFT output)
-          auto features = FeatureAnalysis::GetFeatures(outAligned, Nfft, (float)sampleRate);
-          if (features.size() >= 7)
-          {
-            chunk.extendedFeaturesPerChannel[ch] = features;
-            for (int f = 0; f < 7; ++f)
-              chunk.avgExtendedFeatures[f] += features[f];
-          }
+          bestMag = mags[k];
+          bestK = k;
         }
       }
-      if (inAligned) pffft_aligned_free(inAligned);
-      if (outAligned) pffft_aligned_free(outAligned);
-      pffft_destroy_setup(setup);
+      double domHz = (double) bestK * sampleRate / (double) Nfft;
+      // Clamp to [20, nyquist-20]
+      const double ny = 0.5 * sampleRate;
+      if (domHz < 20.0) domHz = 20.0;
+      if (domHz > ny - 20.0) domHz = ny - 20.0;
+      chunk.fftDominantHzPerChannel[ch] = domHz;
+
+      // Compute extended features from the ordered spectrum
+      auto features = FeatureAnalysis::GetFeatures(chunk.audio.complexSpectrum[ch].data(), Nfft, (float)sampleRate);
+      if (features.size() >= 7)
+      {
+        chunk.extendedFeaturesPerChannel[ch] = features;
+        for (int f = 0; f < 7; ++f)
+          chunk.avgExtendedFeatures[f] += features[f];
+      }
     }
 
     // Average FFT dominant Hz across channels
@@ -224,6 +389,73 @@ namespace synaptic
       chunk.avgExtendedFeatures[f] /= (chCount > 0) ? (float)chCount : 1.0f;
   }
 
+  BrainChunk Brain::MakeChunkView(const std::shared_ptr<const BrainAudio>& audio, int fileId, int chunkIndexInFile,
+                                  int chunkSize, double sampleRate, const Window* window)
+  {
+    BrainChunk chunk;
+    chunk.fileId = fileId;
+    chunk.chunkIndexInFile = chunkIndexInFile;
+    chunk.audio.numFrames = chunkSize;
+    chunk.source = audio;
+    chunk.sourceOffset = chunkIndexInFile * chunkSize / 2;
+
+    // Analysis runs on owned samples, decoded from the stored audio so features describe
+    // exactly what will be played back; they are dropped again afterwards.
+    if (window && audio)
+    {
+      const int validFrames = std::min(chunkSize, audio->numFrames - chunk.sourceOffset);
+      chunk.audio.channelSamples.assign(audio->numChannels, std::vector<sample>(chunkSize, 0.0));
+      for (int ch = 0; ch < audio->numChannels; ++ch)
+        audio->Read(ch, chunk.sourceOffset, chunkSize, chunk.audio.channelSamples[ch].data());
+      AnalyzeChunk(chunk, validFrames, sampleRate, *window);
+      std::vector<std::vector<sample>>().swap(chunk.audio.channelSamples);
+    }
+    return chunk;
+  }
+
+  int Brain::ReconstructFileAudio(const BrainFile& f, const BrainChunkTable& chunks, int chunkSize,
+                                  std::vector<std::vector<iplug::sample>>& planar)
+  {
+    planar.clear();
+    if (f.audio)
+    {
+      planar.assign(f.audio->numChannels, std::vector<sample>(f.audio->numFrames, 0.0));
+      for (int ch = 0; ch < f.audio->numChannels; ++ch)
+        f.audio->Read(ch, 0, f.audio->numFrames, planar[ch].data());
+      return f.audio->numFrames;
+    }
+
+    // Older brains keep samples per chunk: take channel count from the first chunk that has any
+    int numChannels = 0;
+    for (int gi : f.chunkIndices)
+    {
+      if (gi >= 0 && gi < (int) chunks.size() && chunks[gi].NumChannels() > 0)
+      {
+        numChannels = chunks[gi].NumChannels();
+        break;
+      }
+    }
+    if (numChannels <= 0 || f.chunkIndices.empty()) return 0;
+
+    // Chunks start every half chunk. Chunking stops before the end of the file (EstimateChunkCount),
+    // so the last chunk holds only source audio (or zeros, for files shorter than one chunk).
+    const int totalLen = std::max(0, ((int) f.chunkIndices.size() - 1) * chunkSize / 2 + chunkSize);
+    planar.assign(numChannels, std::vector<sample>(totalLen, 0.0));
+
+    for (int ord = 0; ord < (int) f.chunkIndices.size(); ++ord)
+    {
+      const int gi = f.chunkIndices[ord];
+      if (gi < 0 || gi >= (int) chunks.size()) continue;
+      const BrainChunk& bc = chunks[gi];
+      const int start = ord * chunkSize / 2;
+      const int copyN = std::min(chunkSize, totalLen - start);
+      if (copyN <= 0) continue;
+      for (int ch = 0; ch < numChannels; ++ch)
+        bc.ReadChannel(ch, planar[ch].data() + start, copyN);
+    }
+    return totalLen;
+  }
+
   int Brain::AddAudioFileFromMemory(const void* data,
                                     size_t dataSize,
                                     const std::string& displayName,
@@ -266,10 +498,16 @@ namespace synaptic
     const int totalFrames = (int) framesRead;
     const int expectedChunks = EstimateChunkCount(totalFrames, chunkSizeSamples);
 
+    // Store the decoded audio once; chunks are views into it
+    auto fileAudio = BrainAudio::FromPlanar(planar, totalFrames, mAudioEncoding);
+    std::vector<std::vector<iplug::sample>>().swap(planar);
+
     // Prepare file record (ID will be assigned on commit)
-    mChunkSize = chunkSizeSamples;
     BrainFile fileRec;
     fileRec.displayName = displayName;
+    fileRec.audio = fileAudio;
+    const auto window = GetAnalysisWindow();
+    fileRec.analysis = CurrentAnalysisSettings((double) targetSampleRate, window.get());
 
     // Chunking with progress reporting - build chunks first, commit at end
     int numChunks = expectedChunks;
@@ -284,27 +522,8 @@ namespace synaptic
       if (framesInChunk <= 0)
         break;
 
-      BrainChunk chunk;
-      chunk.fileId = 0;  // Will be set on commit
-      chunk.chunkIndexInFile = c;
-      chunk.audio.numFrames = chunkSizeSamples;
-      chunk.audio.channelSamples.assign(targetChannels, std::vector<sample>(chunkSizeSamples, 0.0));
-
-      // Copy audio frames (zero-pad tail)
-      for (int ch = 0; ch < targetChannels; ++ch)
-      {
-        for (int i = 0; i < framesInChunk; ++i)
-          chunk.audio.channelSamples[ch][i] = planar[ch][start + i];
-        for (int i = framesInChunk; i < chunkSizeSamples; ++i)
-          chunk.audio.channelSamples[ch][i] = 0.0f;
-      }
-
-      // Analyze metrics for this chunk over valid frames (no lock needed, working on local data)
-      if (mWindow) {
-        AnalyzeChunk(chunk, framesInChunk, (double) targetSampleRate);
-      }
-
-      newChunks.push_back(std::move(chunk));
+      // File ID will be set on commit; analysis works on local data, no lock needed
+      newChunks.push_back(MakeChunkView(fileAudio, 0, c, chunkSizeSamples, (double) targetSampleRate, window.get()));
 
       // Report progress per chunk (if callback provided)
       if (onProgress)
@@ -320,14 +539,17 @@ namespace synaptic
 
     // Only commit chunks and file record if not cancelled
     std::lock_guard<std::mutex> lock(mutex_);
-    const int fileId = nextFileId_++;
+    DetachStateLocked();
+    ++mContentVersion;
+    mState->chunkSize = chunkSizeSamples;
+    const int fileId = mState->nextFileId++;
     fileRec.id = fileId;
 
-    const int startGlobalIndex = (int) chunks_.size();
+    const int startGlobalIndex = (int) mState->chunks.size();
     for (int i = 0; i < (int)newChunks.size(); ++i)
     {
       newChunks[i].fileId = fileId;  // Set file ID now
-      chunks_.push_back(std::move(newChunks[i]));
+      mState->chunks.push_back(std::move(newChunks[i]));
       fileRec.chunkIndices.push_back(startGlobalIndex + i);
     }
 
@@ -343,47 +565,56 @@ namespace synaptic
       fileRec.tailPaddingFrames = 0;
     }
 
-    idToFileIndex_[fileId] = (int) files_.size();
-    files_.push_back(std::move(fileRec));
+    mState->idToFileIndex[fileId] = (int) mState->files.size();
+    mState->files.push_back(std::move(fileRec));
+    PublishLocked();
     return fileId;
   }
 
   void Brain::RemoveFile(int fileId)
   {
     std::lock_guard<std::mutex> lock(mutex_);
-    auto it = idToFileIndex_.find(fileId);
-    if (it == idToFileIndex_.end()) return;
+    if (RemoveFileLocked(fileId))
+      PublishLocked();
+  }
+
+  bool Brain::RemoveFileLocked(int fileId)
+  {
+    auto it = mState->idToFileIndex.find(fileId);
+    if (it == mState->idToFileIndex.end()) return false;
     const int fileIdx = it->second;
+    DetachStateLocked();
 
-    // Mark to remove: rebuild chunks_ compactly excluding this file's chunks
-    std::vector<int> toRemove = files_[fileIdx].chunkIndices;
-    std::vector<BrainChunk> newChunks;
-    newChunks.reserve(chunks_.size());
+    // Mark to remove: rebuild the chunk list compactly excluding this file's chunks
+    std::vector<int> toRemove = mState->files[fileIdx].chunkIndices;
+    BrainChunkTable newChunks;
+    newChunks.reserve(mState->chunks.size());
 
-    std::vector<int> indexMap(chunks_.size(), -1);
-    std::vector<char> isRemoved(chunks_.size(), 0);
+    std::vector<int> indexMap(mState->chunks.size(), -1);
+    std::vector<char> isRemoved(mState->chunks.size(), 0);
     for (int idx : toRemove)
       if (idx >= 0 && idx < (int) isRemoved.size()) isRemoved[idx] = 1;
 
-    for (int i = 0; i < (int) chunks_.size(); ++i)
+    for (int i = 0; i < (int) mState->chunks.size(); ++i)
     {
       if (!isRemoved[i])
       {
         indexMap[i] = (int) newChunks.size();
-        newChunks.push_back(std::move(chunks_[i]));
+        newChunks.push_back(mState->chunks.Shared(i));
       }
     }
-    chunks_.swap(newChunks);
+    mState->chunks.swap(newChunks);
+    ++mContentVersion;
 
     // Rebuild all files' chunkIndices using indexMap and drop the removed file
     std::vector<BrainFile> newFiles;
-    newFiles.reserve(files_.size());
-    idToFileIndex_.clear();
+    newFiles.reserve(mState->files.size());
+    mState->idToFileIndex.clear();
 
-    for (int i = 0; i < (int) files_.size(); ++i)
+    for (int i = 0; i < (int) mState->files.size(); ++i)
     {
       if (i == fileIdx) continue;
-      BrainFile f = std::move(files_[i]);
+      BrainFile f = std::move(mState->files[i]);
       std::vector<int> newIdxs;
       newIdxs.reserve(f.chunkIndices.size());
       for (int oldIdx : f.chunkIndices)
@@ -394,18 +625,22 @@ namespace synaptic
       f.chunkIndices.swap(newIdxs);
       f.chunkCount = (int) f.chunkIndices.size();
 
-      idToFileIndex_[f.id] = (int) newFiles.size();
+      mState->idToFileIndex[f.id] = (int) newFiles.size();
       newFiles.push_back(std::move(f));
     }
-    files_.swap(newFiles);
+    mState->files.swap(newFiles);
+    mChunkingCache.erase(std::remove_if(mChunkingCache.begin(), mChunkingCache.end(),
+                                        [fileId](const CachedChunking& c) { return c.fileId == fileId; }),
+                         mChunkingCache.end());
+    return true;
   }
 
   std::vector<Brain::FileSummary> Brain::GetSummary() const
   {
     std::lock_guard<std::mutex> lock(mutex_);
     std::vector<FileSummary> v;
-    v.reserve(files_.size());
-    for (const auto& f : files_)
+    v.reserve(mState->files.size());
+    for (const auto& f : mState->files)
       v.push_back({f.id, f.displayName, f.chunkCount});
     return v;
   }
@@ -414,158 +649,115 @@ namespace synaptic
   {
     RechunkStats stats;
     if (newChunkSizeSamples <= 0 || targetSampleRate <= 0) return stats;
+    const auto window = GetAnalysisWindow();
+    const ChunkAnalysisSettings analysis = CurrentAnalysisSettings((double) targetSampleRate, window.get());
 
     // Snapshot current state under lock, then perform heavy work without holding the mutex.
-    std::vector<BrainFile> filesSnapshot;
-    std::vector<BrainChunk> chunksSnapshot;
-    int oldChunkSize = 0;
+    std::shared_ptr<const BrainState> oldState;
     {
       std::unique_lock<std::mutex> lock(mutex_);
-      filesSnapshot = files_;
-      chunksSnapshot = chunks_;
-      oldChunkSize = (mChunkSize > 0) ? mChunkSize : newChunkSizeSamples;
+      oldState = mState;
     }
+    const int oldChunkSize = (oldState->chunkSize > 0) ? oldState->chunkSize : newChunkSizeSamples;
 
-    // Estimate total NEW chunks for progress tracking
-    // First, calculate total valid frames across all files
-    int totalValidFramesAllFiles = 0;
-    for (const auto& f : filesSnapshot)
+    // Each file's contiguous audio: stored once for current brains, rebuilt from the
+    // overlapping chunks for brains loaded from older snapshots
+    std::vector<BrainFile> newFiles = oldState->files; // will mutate per-file indices/counts/padding
+    for (auto& f : newFiles)
     {
-      const int hop = std::max(1, oldChunkSize / 2);
-      const int lastValidFrames = std::max(0, oldChunkSize - f.tailPaddingFrames);
-      const int fileLen = (int)f.chunkIndices.size() > 0
-        ? (int)((int)f.chunkIndices.size() - 1) * hop + lastValidFrames
-        : 0;
-      totalValidFramesAllFiles += fileLen;
+      if (f.audio) continue;
+      std::vector<std::vector<sample>> planar;
+      const int frames = ReconstructFileAudio(f, oldState->chunks, oldChunkSize, planar);
+      if (frames > 0)
+        f.audio = BrainAudio::FromPlanar(planar, frames, mAudioEncoding);
     }
 
-    // Use helper to estimate new chunk count
-    const int estimatedNewChunks = EstimateChunkCount(totalValidFramesAllFiles, newChunkSizeSamples);
-    int currentChunk = 0;
-
-    // Rebuild each file by concatenating its chunks' valid frames, then rechunk
-    std::vector<BrainFile> newFiles = filesSnapshot; // will mutate per-file indices/counts/padding
-    std::vector<BrainChunk> newChunks;
-    newChunks.reserve(chunksSnapshot.size());
-
-    for (auto& f : newFiles)
+    // Slice each file's audio into chunks of the new size (views, no sample copies). Files
+    // chunked this way before with the same analysis settings take their chunks from the cache,
+    // or from the checkpoint an earlier (cancelled or interrupted) run left on disk.
+    std::vector<std::vector<std::shared_ptr<BrainChunk>>> fileChunks(newFiles.size());
+    std::vector<int> missing;
     {
-      ++stats.filesProcessed;
-
-      // Concatenate valid frames across this file's chunks
-      int totalValidFrames = 0;
-      int numChannels = 0;
-      // Determine channels from first valid chunk
-      for (int gi : f.chunkIndices)
-      {
-        if (gi < 0 || gi >= (int)chunksSnapshot.size()) continue;
-        const BrainChunk& bc = chunksSnapshot[gi];
-        if ((int)bc.audio.channelSamples.size() > 0)
-        {
-          numChannels = (int)bc.audio.channelSamples.size();
-          break;
-        }
-      }
-      if (numChannels <= 0)
+      std::unique_lock<std::mutex> lock(mutex_);
+      for (size_t fi = 0; fi < newFiles.size(); ++fi)
       {
-        f.chunkCount = 0;
-        f.chunkIndices.clear();
-        continue;
+        const BrainFile& f = newFiles[fi];
+        if (!f.audio || f.audio->numChannels <= 0) continue;
+        if (!FindCachedChunkingLocked(f, newChunkSizeSamples, analysis, fileChunks[fi]))
+          missing.push_back((int) fi);
       }
+    }
+    std::vector<char> fromCheckpoint(newFiles.size(), 0);
+    ParallelFor((int) missing.size(), [&](int m)
+    {
+      const int fi = missing[m];
+      fromCheckpoint[fi] = LoadChunkingCheckpoint(newFiles[fi], newChunkSizeSamples, analysis, fileChunks[fi]) ? 1 : 0;
+    });
 
-      // Reconstruct a contiguous buffer via overlap-add using original hopSize = oldChunkSize/2
-      const int hop = std::max(1, oldChunkSize / 2);
-      const int lastValidFrames = std::max(0, oldChunkSize - f.tailPaddingFrames);
-      const int totalLen = (int) f.chunkIndices.size() > 0
-        ? (int) ((int) f.chunkIndices.size() - 1) * hop + lastValidFrames
-        : 0;
-      std::vector<std::vector<sample>> planar(numChannels, std::vector<sample>(std::max(0, totalLen), 0.0));
+    struct Range { int file; int begin; int end; };
+    std::vector<Range> ranges;
+    std::vector<std::atomic<int>> rangesLeft(newFiles.size());
+    int totalChunks = 0;
+    for (int fi : missing)
+    {
+      if (fromCheckpoint[fi]) continue;
+      const int numChunks = std::max(0, 2 * newFiles[fi].audio->numFrames / newChunkSizeSamples - 1);
+      fileChunks[fi].resize((size_t) numChunks);
+      totalChunks += numChunks;
+      for (int b = 0; b < numChunks; b += kLoadChunksPerRange)
+        ranges.push_back({ fi, b, std::min(numChunks, b + kLoadChunksPerRange) });
+      rangesLeft[fi] = (numChunks + kLoadChunksPerRange - 1) / kLoadChunksPerRange;
+    }
 
-      for (int ord = 0; ord < (int) f.chunkIndices.size(); ++ord)
-      {
-        const int gi = f.chunkIndices[ord];
-        if (gi < 0 || gi >= (int)chunksSnapshot.size()) continue;
-        const BrainChunk& bc = chunksSnapshot[gi];
-        const bool isLast = (bc.chunkIndexInFile == (f.chunkCount - 1));
-        const int valid = isLast ? lastValidFrames : oldChunkSize;
-        const int start = ord * hop;
-        const int srcChans = (int) bc.audio.channelSamples.size();
-        for (int ch = 0; ch < numChannels; ++ch)
-        {
-          const auto& src = (ch < srcChans) ? bc.audio.channelSamples[ch] : std::vector<sample>();
-          auto& dst = planar[ch];
-          const int copyN = std::min(valid, (int) src.size());
-          const int maxWrite = std::min(copyN, (int) dst.size() - start);
-          if (maxWrite > 0)
-          {
-            std::memcpy(dst.data() + start, src.data(), sizeof(sample) * maxWrite);
-          }
-        }
-      }
-      totalValidFrames = totalLen;
+    // Analysis only reads this operation's copy of the window
+    std::mutex progressMutex;
+    int chunksDone = 0;
+    std::atomic<bool> checkpointed { false };
+    ParallelFor((int) ranges.size(), [&](int r)
+    {
+      if (cancelFlag && cancelFlag->load()) return;
+      const Range& range = ranges[r];
+      const BrainFile& f = newFiles[range.file];
+      for (int c = range.begin; c < range.end; ++c)
+        fileChunks[range.file][c] = std::make_shared<BrainChunk>(
+          MakeChunkView(f.audio, f.id, c, newChunkSizeSamples, (double) targetSampleRate, window.get()));
+      if (rangesLeft[range.file].fetch_sub(1) == 1
+          && CheckpointChunking(f, newChunkSizeSamples, analysis, fileChunks[range.file]))
+        checkpointed = true;
+      std::lock_guard<std::mutex> lock(progressMutex);
+      chunksDone += range.end - range.begin;
+      if (onProgress)
+        onProgress(f.displayName, chunksDone, totalChunks);
+    });
+    if (checkpointed)
+      AnalysisCache::Instance().Trim();
+
+    // Cancelled: nothing has been committed, the brain keeps its current chunks (finished files
+    // stay checkpointed for the next attempt)
+    if (cancelFlag && cancelFlag->load())
+    {
+      stats.wasCancelled = true;
+      return stats;
+    }
 
-      // Rechunk the reconstructed buffer
+    BrainChunkTable newChunks;
+    newChunks.reserve((size_t) totalChunks);
+    for (size_t fi = 0; fi < newFiles.size(); ++fi)
+    {
+      auto& f = newFiles[fi];
+      ++stats.filesProcessed;
       f.chunkIndices.clear();
-      const int totalFrames = totalValidFrames;
-      const int numChunks = 2 * totalFrames / newChunkSizeSamples - 1;
-      for (int c = 0; c < numChunks; ++c)
+      for (auto& chunk : fileChunks[fi])
       {
-        const int start = c * newChunkSizeSamples / 2;
-        const int framesInChunk = std::min(newChunkSizeSamples, totalFrames - start);
-        if (framesInChunk <= 0) break;
-
-        BrainChunk out;
-        out.fileId = f.id;
-        out.chunkIndexInFile = c;
-        out.audio.numFrames = newChunkSizeSamples;
-        out.audio.channelSamples.assign(numChannels, std::vector<sample>(newChunkSizeSamples, 0.0));
-
-        // Copy audio
-        for (int ch = 0; ch < numChannels; ++ch)
-        {
-          auto& dst = out.audio.channelSamples[ch];
-          const auto& src = planar[ch];
-          const int copyN = framesInChunk;
-          if (start < (int)src.size())
-          {
-            const int clampedCopy = std::min(copyN, (int)src.size() - start);
-            std::memcpy(dst.data(), src.data() + start, sizeof(sample) * clampedCopy);
-          }
-        }
-
-        // Analyze metrics for this chunk over valid frames (use captured window pointer)
-          // Temporarily set the analysis window pointer (thread-local) by calling member that reads mWindow.
-          // Since AnalyzeChunk only reads mWindow, this is safe as we captured the pointer value.
-          AnalyzeChunk(out, framesInChunk, (double) targetSampleRate);
-
-        const int globalIdx = (int) newChunks.size();
-        newChunks.push_back(std::move(out));
-        f.chunkIndices.push_back(globalIdx);
-
-        // Report progress per chunk against estimated total
-        ++currentChunk;
-        if (onProgress)
-          onProgress(f.displayName, currentChunk, estimatedNewChunks);
-
-        // Check for cancellation after each chunk
-        if (cancelFlag && cancelFlag->load())
-        {
-          stats.wasCancelled = true;
-          return stats;  // Early exit without committing changes
-        }
+        f.chunkIndices.push_back((int) newChunks.size());
+        newChunks.push_back(std::move(chunk));
       }
-
       f.chunkCount = (int) f.chunkIndices.size();
+      f.analysis = analysis;
+
       // Recompute tail padding for new chunk size
-      if (f.chunkCount > 0)
-      {
-        const int totalFramesMod = totalFrames % newChunkSizeSamples;
-        f.tailPaddingFrames = (totalFramesMod == 0) ? 0 : (newChunkSizeSamples - totalFramesMod);
-      }
-      else
-      {
-        f.tailPaddingFrames = 0;
-      }
+      const int totalFramesMod = f.audio ? f.audio->numFrames % newChunkSizeSamples : 0;
+      f.tailPaddingFrames = (f.chunkCount > 0 && totalFramesMod != 0) ? (newChunkSizeSamples - totalFramesMod) : 0;
 
       if (f.chunkCount > 0) ++stats.filesRechunked;
       stats.newTotalChunks += f.chunkCount;
@@ -574,12 +766,16 @@ namespace synaptic
     // Commit new state under lock in one short critical section
     {
       std::unique_lock<std::mutex> lock(mutex_);
-      chunks_.swap(newChunks);
-      files_.swap(newFiles);
-      idToFileIndex_.clear();
-      for (int i = 0; i < (int) files_.size(); ++i)
-        idToFileIndex_[files_[i].id] = i;
-      mChunkSize = newChunkSizeSamples;
+      auto state = std::make_shared<BrainState>(BrainState { mState->nextFileId, std::move(newFiles), {}, std::move(newChunks),
+                                                             newChunkSizeSamples, mState->savedAnalysisWindowType, mState->lastLoadedWasCompact,
+                                                             mState->layoutEpoch + 1 });
+      for (int i = 0; i < (int) state->files.size(); ++i)
+        state->idToFileIndex[state->files[i].id] = i;
+      // The outgoing chunking stays available for switching back
+      if (mState == oldState)
+        CacheChunkingLocked(*oldState);
+      ReplaceStateLocked(std::move(state));
+      PublishLocked();
     }
 
     return stats;
@@ -592,32 +788,83 @@ namespace synaptic
 
     // Snapshot all chunks under lock to avoid committing partial changes on cancellation
     std::vector<BrainFile> filesSnapshot;
-    std::vector<BrainChunk> chunksSnapshot;
+    BrainChunkTable chunksSnapshot;
     int totalChunks = 0;
+    int chunkSize = 0;
     {
       std::unique_lock<std::mutex> lock(mutex_);
-      filesSnapshot = files_;
-      chunksSnapshot = chunks_;  // Deep copy all chunks
-      totalChunks = (int)chunks_.size();
+      filesSnapshot = mState->files;
+      chunksSnapshot = mState->chunks;  // Shares the chunks; each is copied when reanalyzed
+      totalChunks = (int)mState->chunks.size();
+      chunkSize = mState->chunkSize;
     }
+    const auto window = GetAnalysisWindow();
+    if (!window) return stats;
+    const ChunkAnalysisSettings analysis = CurrentAnalysisSettings((double) targetSampleRate, window.get());
 
     int currentChunk = 0;
+    bool checkpointed = false;
 
     // Iterate files and re-run analysis on their chunks (working on snapshot)
     for (const auto& f : filesSnapshot)
     {
       ++stats.filesProcessed;
+
+      // Files whose chunks are plain views of their audio can be checkpointed, and taken from the
+      // checkpoint of an earlier (cancelled or interrupted) reanalysis
+      bool views = f.audio != nullptr && chunkSize > 0;
+      for (int k = 0; views && k < (int) f.chunkIndices.size(); ++k)
+      {
+        const int gi = f.chunkIndices[k];
+        views = gi >= 0 && gi < (int) chunksSnapshot.size() && chunksSnapshot[gi].source == f.audio
+          && chunksSnapshot[gi].chunkIndexInFile == k && chunksSnapshot[gi].sourceOffset == k * chunkSize / 2;
+      }
+      if (views && !f.chunkIndices.empty())
+      {
+        std::vector<std::shared_ptr<BrainChunk>> done;
+        bool found = false;
+        {
+          std::unique_lock<std::mutex> lock(mutex_);
+          found = FindCachedChunkingLocked(f, chunkSize, analysis, done);
+        }
+        if (!found)
+          found = LoadChunkingCheckpoint(f, chunkSize, analysis, done);
+        if (found && done.size() == f.chunkIndices.size())
+        {
+          for (size_t k = 0; k < done.size(); ++k)
+            chunksSnapshot.Set(f.chunkIndices[k], std::move(done[k]));
+          stats.chunksProcessed += (int) done.size();
+          currentChunk += (int) done.size();
+          if (onProgress)
+            onProgress(f.displayName, currentChunk, totalChunks);
+          continue;
+        }
+      }
+
       // For each chunk index, reanalyze its audio
       std::vector<int> idxs = f.chunkIndices;
       for (int gi : idxs)
       {
         if (gi < 0 || gi >= (int)chunksSnapshot.size()) continue;
 
-        BrainChunk& chunk = chunksSnapshot[gi];
-        const int validFrames = std::min(chunk.audio.numFrames, (int) (chunk.audio.channelSamples.empty() ? 0 : chunk.audio.channelSamples[0].size()));
+        BrainChunk& chunk = chunksSnapshot.Mutable(gi);
 
         // Reanalyze directly on the snapshot (no lock needed as we're working on local copy)
-        AnalyzeChunk(chunk, validFrames, (double) targetSampleRate);
+        if (chunk.source)
+        {
+          // View chunk: decode its frames for the analysis pass only
+          const int validFrames = std::min(chunk.audio.numFrames, chunk.source->numFrames - chunk.sourceOffset);
+          chunk.audio.channelSamples.assign(chunk.source->numChannels, std::vector<sample>(chunk.audio.numFrames, 0.0));
+          for (int ch = 0; ch < chunk.source->numChannels; ++ch)
+            chunk.ReadChannel(ch, chunk.audio.channelSamples[ch].data(), chunk.audio.numFrames);
+          AnalyzeChunk(chunk, validFrames, (double) targetSampleRate, *window);
+          std::vector<std::vector<sample>>().swap(chunk.audio.channelSamples);
+        }
+        else
+        {
+          const int validFrames = std::min(chunk.audio.numFrames, (int) (chunk.audio.channelSamples.empty() ? 0 : chunk.audio.channelSamples[0].size()));
+          AnalyzeChunk(chunk, validFrames, (double) targetSampleRate, *window);
+        }
         ++stats.chunksProcessed;
 
         // Report progress per chunk
@@ -628,78 +875,513 @@ namespace synaptic
         // Check for cancellation after each chunk
         if (cancelFlag && cancelFlag->load())
         {
+          if (checkpointed)
+            AnalysisCache::Instance().Trim();
           stats.wasCancelled = true;
           return stats;  // Early exit - snapshot is discarded, original chunks unchanged
         }
       }
+
+      if (views && !f.chunkIndices.empty())
+      {
+        std::vector<std::shared_ptr<BrainChunk>> done;
+        done.reserve(f.chunkIndices.size());
+        for (int gi : f.chunkIndices)
+          done.push_back(chunksSnapshot.Shared(gi));
+        checkpointed = CheckpointChunking(f, chunkSize, analysis, done) || checkpointed;
+      }
     }
+    if (checkpointed)
+      AnalysisCache::Instance().Trim();
 
     // Only commit all changes if operation completed successfully (not cancelled)
     {
       std::unique_lock<std::mutex> lock(mutex_);
-      chunks_ = std::move(chunksSnapshot);
+      auto state = std::make_shared<BrainState>(BrainState { mState->nextFileId, mState->files, mState->idToFileIndex, std::move(chunksSnapshot),
+                                                             mState->chunkSize, mState->savedAnalysisWindowType, mState->lastLoadedWasCompact,
+                                                             mState->layoutEpoch + 1 });
+      for (auto& f : state->files)
+        f.analysis = analysis;
+      // Cached chunkings analyzed with the settings this reanalysis replaced can't be reused
+      mChunkingCache.erase(std::remove_if(mChunkingCache.begin(), mChunkingCache.end(), [&analysis](const CachedChunking& c)
+      {
+        return !(c.analysis == analysis);
+      }), mChunkingCache.end());
+      ReplaceStateLocked(std::move(state));
+      PublishLocked();
     }
 
     return stats;
   }
 
+  void Brain::DetachStateLocked()
+  {
+    // Shared: edit a copy, and the registered state keeps matching its file for other instances
+    if (mState.use_count() > 1)
+    {
+      mState = std::make_shared<BrainState>(*mState);
+      return;
+    }
+
+    // Edited in place, so it no longer matches the file it was loaded from. Another instance may
+    // have picked it up from the registry just before it was withdrawn; then copy after all.
+    BrainRegistry::Instance().Unpublish(mState.get());
+    if (mState.use_count() > 1)
+      mState = std::make_shared<BrainState>(*mState);
+  }
+
+  ChunkAnalysisSettings Brain::CurrentAnalysisSettings(double sampleRate, const Window* window)
+  {
+    ChunkAnalysisSettings s;
+    s.sampleRate = sampleRate;
+    if (window)
+    {
+      s.windowType = Window::TypeToInt(window->GetType());
+      s.windowSize = window->Size();
+    }
+    return s;
+  }
+
+  void Brain::SetWindow(const Window* window)
+  {
+    std::shared_ptr<const Window> copy = window ? std::make_shared<const Window>(*window) : nullptr;
+    std::lock_guard<std::mutex> lock(mWindowMutex);
+    mWindow.swap(copy);
+  }
+
+  std::shared_ptr<const Window> Brain::GetAnalysisWindow() const
+  {
+    std::lock_guard<std::mutex> lock(mWindowMutex);
+    return mWindow;
+  }
+
+  void Brain::CacheChunkingLocked(const BrainState& state)
+  {
+    for (const auto& f : state.files)
+    {
+      if (!f.audio || !f.analysis.IsKnown() || f.chunkIndices.empty()) continue;
+      CachedChunking entry;
+      entry.fileId = f.id;
+      entry.audio = f.audio;
+      entry.chunkSize = state.chunkSize;
+      entry.analysis = f.analysis;
+      entry.chunks.reserve(f.chunkIndices.size());
+      for (int gi : f.chunkIndices)
+        if (gi >= 0 && gi < (int) state.chunks.size())
+          entry.chunks.push_back(state.chunks.Shared(gi));
+      AddCachedChunkingLocked(std::move(entry));
+    }
+  }
+
+  void Brain::AddCachedChunkingLocked(CachedChunking entry)
+  {
+    mChunkingCache.erase(std::remove_if(mChunkingCache.begin(), mChunkingCache.end(), [&entry](const CachedChunking& c)
+    {
+      return c.fileId == entry.fileId && c.chunkSize == entry.chunkSize;
+    }), mChunkingCache.end());
+    mChunkingCache.insert(mChunkingCache.begin(), std::move(entry));
+
+    // Keep layers, and the most recently replaced other chunk sizes
+    std::vector<int> sizes;
+    size_t kept = 0;
+    for (auto& c : mChunkingCache)
+    {
+      const bool layer = std::find(mLayerChunkSizes.begin(), mLayerChunkSizes.end(), c.chunkSize) != mLayerChunkSizes.end();
+      const bool known = layer || std::find(sizes.begin(), sizes.end(), c.chunkSize) != sizes.end();
+      if (!known && (int) sizes.size() >= kMaxCachedChunkSizes) continue;
+      if (!known) sizes.push_back(c.chunkSize);
+      if (&c != &mChunkingCache[kept]) mChunkingCache[kept] = std::move(c);
+      ++kept;
+    }
+    mChunkingCache.resize(kept);
+  }
+
+  bool Brain::FindCachedChunkingLocked(const BrainFile& f, int chunkSize, const ChunkAnalysisSettings& analysis,
+                                       std::vector<std::shared_ptr<BrainChunk>>& chunks)
+  {
+    for (auto it = mChunkingCache.cbegin(); it != mChunkingCache.cend(); ++it)
+    {
+      if (it->fileId != f.id || it->audio != f.audio || it->chunkSize != chunkSize || !(it->analysis == analysis))
+        continue;
+      // The entry stays: if the rechunk is cancelled, or the brain switches away again, it is still valid
+      chunks = it->chunks;
+      return true;
+    }
+    return false;
+  }
+
+  bool Brain::CheckpointChunking(const BrainFile& f, int chunkSize, const ChunkAnalysisSettings& analysis,
+                                 const std::vector<std::shared_ptr<BrainChunk>>& chunks)
+  {
+    if (!f.audio) return false;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto fit = mState->idToFileIndex.find(f.id);
+      if (fit != mState->idToFileIndex.end() && mState->files[fit->second].audio == f.audio)
+      {
+        CachedChunking entry;
+        entry.fileId = f.id;
+        entry.audio = f.audio;
+        entry.chunkSize = chunkSize;
+        entry.analysis = analysis;
+        entry.chunks = chunks;
+        AddCachedChunkingLocked(std::move(entry));
+      }
+    }
+
+    AnalysisCache& cache = AnalysisCache::Instance();
+    if (analysis.windowSize <= 0 || !mUseAnalysisCache || !cache.IsEnabled()) return false;
+    const AnalysisCache::Key key = AnalysisCacheKey(*f.audio, chunkSize, analysis);
+    return cache.Store(key, [&chunks](SnapshotWriter& entry) { PutCachedChunks(entry, chunks); });
+  }
+
+  bool Brain::LoadChunkingCheckpoint(const BrainFile& f, int chunkSize, const ChunkAnalysisSettings& analysis,
+                                     std::vector<std::shared_ptr<BrainChunk>>& chunks) const
+  {
+    AnalysisCache& cache = AnalysisCache::Instance();
+    if (!f.audio || analysis.windowSize <= 0 || !mUseAnalysisCache || !cache.IsEnabled() || chunkSize <= 0) return false;
+    const int numChunks = std::max(0, 2 * f.audio->numFrames / chunkSize - 1);
+    if (numChunks == 0) return false;
+
+    std::vector<BrainChunk> loaded((size_t) numChunks);
+    const AnalysisCache::Key key = AnalysisCacheKey(*f.audio, chunkSize, analysis);
+    if (!cache.Load(key, [&](SnapshotReader& entry) { return GetCachedChunks(entry, f, chunkSize, loaded); }))
+      return false;
+    chunks.clear();
+    chunks.reserve(loaded.size());
+    for (auto& c : loaded)
+      chunks.push_back(std::make_shared<BrainChunk>(std::move(c)));
+    return true;
+  }
+
+  void Brain::SetLayerChunkSizes(std::vector<int> chunkSizes)
+  {
+    chunkSizes.erase(std::remove_if(chunkSizes.begin(), chunkSizes.end(), [](int cs) { return cs <= 0; }), chunkSizes.end());
+    std::sort(chunkSizes.begin(), chunkSizes.end());
+    chunkSizes.erase(std::unique(chunkSizes.begin(), chunkSizes.end()), chunkSizes.end());
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Dropped layers fall back to the recently-used rule: keep the newest other sizes only
+    std::vector<int> dropped;
+    for (int cs : mLayerChunkSizes)
+      if (!std::binary_search(chunkSizes.begin(), chunkSizes.end(), cs)) dropped.push_back(cs);
+    mLayerChunkSizes = std::move(chunkSizes);
+    if (!dropped.empty())
+    {
+      mChunkingCache.erase(std::remove_if(mChunkingCache.begin(), mChunkingCache.end(), [&dropped](const CachedChunking& c)
+      {
+        return std::find(dropped.begin(), dropped.end(), c.chunkSize) != dropped.end();
+      }), mChunkingCache.end());
+      // Readers stop seeing the dropped layers
+      PublishLocked();
+    }
+  }
+
+  std::vector<int> Brain::GetLayerChunkSizes() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return mLayerChunkSizes;
+  }
+
+  std::vector<int> Brain::GetReadyLayerChunkSizes() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return mReadyLayerChunkSizes;
+  }
+
+  bool Brain::BuildLayers(int targetSampleRate, std::atomic<bool>* cancelFlag)
+  {
+    if (targetSampleRate <= 0) return true;
+    const auto window = GetAnalysisWindow();
+    const ChunkAnalysisSettings analysis = CurrentAnalysisSettings((double) targetSampleRate, window.get());
+
+    // One job per file and layer that has no ready chunking yet
+    struct Job { int file; int chunkSize; };
+    std::shared_ptr<const BrainState> state;
+    std::vector<Job> jobs;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      state = mState;
+      std::vector<std::shared_ptr<BrainChunk>> existing;
+      for (int cs : mLayerChunkSizes)
+      {
+        if (cs == state->chunkSize) continue;
+        for (int fi = 0; fi < (int) state->files.size(); ++fi)
+        {
+          const BrainFile& f = state->files[fi];
+          if (f.audio && f.audio->numChannels > 0 && !FindCachedChunkingLocked(f, cs, analysis, existing))
+            jobs.push_back({ fi, cs });
+        }
+      }
+    }
+
+    std::atomic<int> added { 0 };
+    ParallelFor((int) jobs.size(), [&](int j)
+    {
+      if (cancelFlag && cancelFlag->load()) return;
+      const BrainFile& f = state->files[jobs[j].file];
+      CachedChunking entry;
+      entry.fileId = f.id;
+      entry.audio = f.audio;
+      entry.chunkSize = jobs[j].chunkSize;
+      entry.analysis = analysis;
+      const int numChunks = std::max(0, 2 * f.audio->numFrames / entry.chunkSize - 1);
+      entry.chunks.reserve((size_t) numChunks);
+      for (int c = 0; c < numChunks; ++c)
+      {
+        if (cancelFlag && cancelFlag->load()) return;
+        entry.chunks.push_back(std::make_shared<BrainChunk>(
+          MakeChunkView(f.audio, f.id, c, entry.chunkSize, (double) targetSampleRate, window.get())));
+      }
+
+      // Keep it only while the file and the layer are still there
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto fit = mState->idToFileIndex.find(f.id);
+      const bool fileKept = fit != mState->idToFileIndex.end() && mState->files[fit->second].audio == f.audio;
+      const bool layerKept = std::find(mLayerChunkSizes.begin(), mLayerChunkSizes.end(), entry.chunkSize) != mLayerChunkSizes.end();
+      if (fileKept && layerKept)
+      {
+        AddCachedChunkingLocked(std::move(entry));
+        ++added;
+      }
+    });
+
+    // Layers that are complete now become readable by the audio thread (cancelled or not)
+    if (added.load() > 0)
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      PublishLocked();
+    }
+    return !(cancelFlag && cancelFlag->load());
+  }
+
+  std::vector<Brain::LayerInfo> Brain::GetLayerInfo() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<LayerInfo> layers;
+    auto layerFor = [&layers](int chunkSize) -> LayerInfo&
+    {
+      for (auto& l : layers)
+        if (l.chunkSize == chunkSize) return l;
+      layers.push_back(LayerInfo());
+      layers.back().chunkSize = chunkSize;
+      return layers.back();
+    };
+
+    const int totalFiles = (int) mState->files.size();
+    if (mState->chunkSize > 0)
+    {
+      LayerInfo& active = layerFor(mState->chunkSize);
+      active.active = true;
+      active.filesReady = totalFiles;
+      for (const auto& c : mState->chunks)
+        active.memoryBytes += c.MemoryBytes();
+    }
+    for (int cs : mLayerChunkSizes)
+      layerFor(cs);
+    for (auto& l : layers)
+      l.totalFiles = totalFiles;
+
+    for (const auto& c : mChunkingCache)
+    {
+      if (c.chunkSize == mState->chunkSize) continue; // shares the current chunks
+      if (std::find(mLayerChunkSizes.begin(), mLayerChunkSizes.end(), c.chunkSize) == mLayerChunkSizes.end()) continue;
+      auto fit = mState->idToFileIndex.find(c.fileId);
+      if (fit == mState->idToFileIndex.end() || mState->files[fit->second].audio != c.audio) continue;
+      LayerInfo& l = layerFor(c.chunkSize);
+      ++l.filesReady;
+      for (const auto& chunk : c.chunks)
+        l.memoryBytes += chunk->MemoryBytes();
+    }
+
+    std::sort(layers.begin(), layers.end(), [](const LayerInfo& a, const LayerInfo& b) { return a.chunkSize < b.chunkSize; });
+    return layers;
+  }
+
+  void Brain::ReplaceStateLocked(std::shared_ptr<BrainState> state)
+  {
+    mState = std::move(state);
+    ++mContentVersion;
+  }
+
+  void Brain::PublishLocked()
+  {
+    // mState is shared with readers from here on, so the next edit copies it (DetachStateLocked)
+    auto published = std::make_shared<PublishedState>();
+    published->state = mState;
+    published->contentVersion = mContentVersion.load();
+
+    // Complete layers: every file has a cached chunking at that size, analyzed with the current
+    // window (and at the sample rate of the current chunking, where that is known)
+    mReadyLayerChunkSizes.clear();
+    const ChunkAnalysisSettings current = CurrentAnalysisSettings(0.0, GetAnalysisWindow().get());
+    for (int cs : mLayerChunkSizes)
+    {
+      if (cs == mState->chunkSize || mState->files.empty()) continue;
+      PublishedLayer layer;
+      layer.chunkSize = cs;
+      bool complete = true;
+      for (const auto& f : mState->files)
+      {
+        auto it = std::find_if(mChunkingCache.cbegin(), mChunkingCache.cend(), [&](const CachedChunking& c)
+        {
+          return c.fileId == f.id && c.audio == f.audio && c.chunkSize == cs
+            && c.analysis.windowType == current.windowType && c.analysis.windowSize == current.windowSize
+            && (!f.analysis.IsKnown() || c.analysis.sampleRate == f.analysis.sampleRate);
+        });
+        if (!f.audio || it == mChunkingCache.cend())
+        {
+          complete = false;
+          break;
+        }
+        for (const auto& chunk : it->chunks)
+          layer.chunks.push_back(chunk);
+      }
+      if (!complete) continue;
+      mReadyLayerChunkSizes.push_back(cs);
+      published->layers.push_back(std::move(layer));
+    }
+
+    mPublished.Publish(std::move(published));
+  }
+
+  bool Brain::AdoptShared(const std::string& path, uint64_t contentHash)
+  {
+    auto state = BrainRegistry::Instance().Find(path, contentHash);
+    if (!state) return false;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (state != mState)
+    {
+      ReplaceStateLocked(std::move(state));
+      mChunkingCache.clear();
+      PublishLocked();
+    }
+    return true;
+  }
+
+  void Brain::PublishShared(const std::string& path, uint64_t contentHash)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    BrainRegistry::Instance().Publish(path, contentHash, mState);
+  }
+
+  void Brain::PublishSharedIfCurrent(const std::string& path, uint64_t contentHash, const BrainState* state)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (mState.get() == state)
+      BrainRegistry::Instance().Publish(path, contentHash, mState);
+  }
+
+  bool Brain::IsShared() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return mState.use_count() > 1;
+  }
+
+  size_t Brain::GetAudioMemoryBytes() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t bytes = 0;
+    for (const auto& f : mState->files)
+      if (f.audio) bytes += f.audio->MemoryBytes();
+    for (const auto& c : mState->chunks)
+      for (const auto& ch : c.audio.channelSamples)
+        bytes += ch.size() * sizeof(sample);
+    return bytes;
+  }
+
   int Brain::GetTotalChunks() const
   {
     std::lock_guard<std::mutex> lock(mutex_);
-    return (int) chunks_.size();
+    return (int) mState->chunks.size();
   }
 
   const BrainChunk* Brain::GetChunkByGlobalIndex(int idx) const
   {
     std::lock_guard<std::mutex> lock(mutex_);
-    if (idx < 0 || idx >= (int) chunks_.size()) return nullptr;
-    return &chunks_[idx];
+    if (idx < 0 || idx >= (int) mState->chunks.size()) return nullptr;
+    return &mState->chunks[idx];
   }
 
-  bool Brain::SerializeSnapshotToChunk(iplug::IByteChunk& out) const
+  std::shared_ptr<const BrainState> Brain::GetStateSnapshot() const
   {
     std::lock_guard<std::mutex> lock(mutex_);
+    return mState;
+  }
+
+  int Brain::GetWindowMode() const
+  {
+    const auto window = GetAnalysisWindow();
+    return window ? Window::TypeToInt(window->GetType()) : 1;
+  }
+
+  bool Brain::SerializeSnapshotToChunk(iplug::IByteChunk& out) const
+  {
+    // The snapshot is immutable while we hold it (edits copy first), so no lock is needed below
+    const auto state = GetStateSnapshot();
+    return SerializeStateToChunk(*state, mUseCompactFormat, GetWindowMode(), out);
+  }
+
+  bool Brain::SerializeStateToChunk(const BrainState& state, bool compact, int windowMode, iplug::IByteChunk& out)
+  {
+    return AppendToChunk(out, [&](SnapshotWriter& w) { WriteState(w, state, compact, windowMode); });
+  }
+
+  bool Brain::SerializeStateToFile(const BrainState& state, bool compact, int windowMode, FILE* fp, uint64_t& contentHash)
+  {
+    // The hash of the file depends on its size, so measure before streaming
+    SnapshotWriter counter;
+    WriteState(counter, state, compact, windowMode);
+    BrainRegistry::Hasher hasher(counter.Size());
+    SnapshotWriter writer(fp, &hasher);
+    WriteState(writer, state, compact, windowMode);
+    if (!writer.Finish() || writer.Size() != counter.Size()) return false;
+    contentHash = hasher.Final();
+    return true;
+  }
+
+  void Brain::WriteState(SnapshotWriter& out, const BrainState& state, bool compact, int windowMode)
+  {
     out.Put(&kSnapshotMagic);
 
     // Check if we should use compact format
-    if (mUseCompactFormat)
+    if (compact)
     {
       // Compact format: save only metadata + reconstructed original audio
       // New writes use float32 for audio payload to reduce size; we keep v100 reader for backwards compatibility.
       out.Put(&kSnapshotVersionCompactF32);
-      int32_t chunkSize = mChunkSize;
+      int32_t chunkSize = state.chunkSize;
       out.Put(&chunkSize);
-      int32_t winMode = mWindow ? Window::TypeToInt(mWindow->GetType()) : 1;
+      int32_t winMode = windowMode;
       out.Put(&winMode);
 
       // Save file count
-      int32_t nFiles = (int32_t)files_.size();
+      int32_t nFiles = (int32_t)state.files.size();
       out.Put(&nFiles);
 
-      // For each file, reconstruct original audio and save it
-      for (const auto& f : files_)
+      // For each file, save its original audio
+      for (const auto& f : state.files)
       {
         // File metadata
         int32_t fid = f.id;
         out.Put(&fid);
-        PutString(out, f.displayName);
+        out.PutString(f.displayName);
 
-        // Determine channel count from first valid chunk
-        int numChannels = 0;
-        for (int gi : f.chunkIndices)
+        // Original audio: the stored file audio, or rebuilt from chunks of older brains
+        std::vector<std::vector<sample>> planar;
+        int numChannels = 0, totalLen = 0;
+        if (f.audio)
         {
-          if (gi >= 0 && gi < (int)chunks_.size())
-          {
-            const BrainChunk& bc = chunks_[gi];
-            if (!bc.audio.channelSamples.empty())
-            {
-              numChannels = (int)bc.audio.channelSamples.size();
-              break;
-            }
-          }
+          numChannels = f.audio->numChannels;
+          totalLen = f.audio->numFrames;
+        }
+        else
+        {
+          totalLen = ReconstructFileAudio(f, state.chunks, state.chunkSize, planar);
+          numChannels = (int) planar.size();
         }
 
-        if (numChannels <= 0)
+        if (numChannels <= 0 || totalLen <= 0)
         {
           // Empty file - save zero channels and frames
           int32_t zero = 0;
@@ -708,447 +1390,462 @@ namespace synaptic
           continue;
         }
 
-        // Reconstruct original audio from overlapping chunks
-        const int hop = std::max(1, mChunkSize / 2);
-        const int lastValidFrames = std::max(0, mChunkSize - f.tailPaddingFrames);
-        const int totalLen = f.chunkIndices.empty() ? 0 :
-                             (int)((int)f.chunkIndices.size() - 1) * hop + lastValidFrames;
-
-        std::vector<std::vector<sample>> planar(numChannels, std::vector<sample>(std::max(0, totalLen), 0.0));
-
-        // Reconstruct via overlap-add (same logic as rechunking)
-        for (int ord = 0; ord < (int)f.chunkIndices.size(); ++ord)
-        {
-          const int gi = f.chunkIndices[ord];
-          if (gi < 0 || gi >= (int)chunks_.size()) continue;
-          const BrainChunk& bc = chunks_[gi];
-          const bool isLast = (bc.chunkIndexInFile == (f.chunkCount - 1));
-          const int valid = isLast ? lastValidFrames : mChunkSize;
-          const int start = ord * hop;
-          const int srcChans = (int)bc.audio.channelSamples.size();
-
-          for (int ch = 0; ch < numChannels; ++ch)
-          {
-            const auto& src = (ch < srcChans) ? bc.audio.channelSamples[ch] : std::vector<sample>();
-            auto& dst = planar[ch];
-            const int copyN = std::min(valid, (int)src.size());
-            const int maxWrite = std::min(copyN, (int)dst.size() - start);
-            if (maxWrite > 0)
-            {
-              std::memcpy(dst.data() + start, src.data(), sizeof(sample) * maxWrite);
-            }
-          }
-        }
-
-        // Save reconstructed audio
         int32_t chans = numChannels;
         out.Put(&chans);
         int32_t frames = totalLen;
         out.Put(&frames);
 
         // Store audio as float32 to avoid 64-bit sample inflation in compact mode.
-        std::vector<float> tmp;
-        tmp.resize((size_t) frames);
-        for (int ch = 0; ch < numChannels; ++ch)
+        const size_t channelBytes = sizeof(float) * (size_t) frames;
+        if (out.IsCounting())
+        {
+          out.Skip(channelBytes * (size_t) numChannels);
+        }
+        else if (f.audio && f.audio->encoding == BrainAudio::Encoding::Float32)
         {
-          if (frames > 0)
+          // Already planar float32: one copy
+          out.PutBytes(f.audio->data.data(), channelBytes * (size_t) numChannels);
+        }
+        else
+        {
+          std::vector<sample> decoded;
+          std::vector<float> tmp((size_t) frames);
+          for (int ch = 0; ch < numChannels; ++ch)
           {
-            for (int f = 0; f < frames; ++f)
-              tmp[f] = (float) planar[ch][f];
-            out.PutBytes(tmp.data(), (int)(sizeof(float) * frames));
+            const sample* src = nullptr;
+            if (f.audio)
+            {
+              decoded.resize((size_t) frames);
+              f.audio->Read(ch, 0, frames, decoded.data());
+              src = decoded.data();
+            }
+            else
+            {
+              src = planar[ch].data();
+            }
+            for (int i = 0; i < frames; ++i)
+              tmp[i] = (float) src[i];
+            out.PutBytes(tmp.data(), channelBytes);
           }
         }
       }
-
-      return true;
+      return;
     }
 
     // Standard format: save full chunked data with analysis
     out.Put(&kSnapshotVersion);
-    int32_t chunkSize = mChunkSize;
+    int32_t chunkSize = state.chunkSize;
     out.Put(&chunkSize);
     // Window type for analysis (store as int for simplicity)
-    int32_t winMode = mWindow ? Window::TypeToInt(mWindow->GetType()) : 1;
+    int32_t winMode = windowMode;
     out.Put(&winMode);
 
-    int32_t nFiles = (int32_t) files_.size();
+    int32_t nFiles = (int32_t) state.files.size();
     out.Put(&nFiles);
     // We store per-file name and number of chunks referencing it to rebuild mapping
-    for (const auto& f : files_)
+    for (const auto& f : state.files)
     {
       int32_t fid = f.id;
       out.Put(&fid);
-      PutString(out, f.displayName);
+      out.PutString(f.displayName);
       int32_t tailPad = f.tailPaddingFrames;
       out.Put(&tailPad);
-      int32_t nIdx = (int32_t) f.chunkIndices.size();
-      out.Put(&nIdx);
-      for (int32_t gi : f.chunkIndices)
-        out.Put(&gi);
+      out.PutVector(f.chunkIndices);
+      // File audio (v4), written once in its stored encoding; chunks reference it
+      PutFileAudio(out, f.audio);
     }
 
     // Store all chunks with audio and analysis
-    int32_t nChunks = (int32_t) chunks_.size();
+    int32_t nChunks = (int32_t) state.chunks.size();
     out.Put(&nChunks);
-    for (const auto& c : chunks_)
-    {
-      out.Put(&c.fileId);
-      out.Put(&c.chunkIndexInFile);
-      // Audio
-      int32_t chans = (int32_t) c.audio.channelSamples.size();
-      out.Put(&chans);
-      out.Put(&c.audio.numFrames);
-      for (int ch = 0; ch < chans; ++ch)
-      {
-        int32_t frames = (int32_t) c.audio.channelSamples[ch].size();
-        out.Put(&frames);
-        if (frames > 0)
-          out.PutBytes(c.audio.channelSamples[ch].data(), (int) (sizeof(iplug::sample) * frames));
-      }
-      // Analysis
-      int32_t rmsc = (int32_t) c.rmsPerChannel.size(); out.Put(&rmsc);
-      for (int i = 0; i < rmsc; ++i) out.Put(&c.rmsPerChannel[i]);
-      int32_t fzc = (int32_t) c.freqHzPerChannel.size(); out.Put(&fzc);
-      for (int i = 0; i < fzc; ++i) out.Put(&c.freqHzPerChannel[i]);
-      int32_t fftSize = c.fftSize; out.Put(&fftSize);
-      int32_t fftc = (int32_t)c.magnitudeSpectrum.size();
-      out.Put(&fftc);
-      for (int ch = 0; ch < fftc; ++ch)
-      {
-        int32_t bins = (int32_t)c.magnitudeSpectrum[ch].size();
-        out.Put(&bins);
-        if (bins > 0)
-          out.PutBytes(c.magnitudeSpectrum[ch].data(), (int)(sizeof(float) * bins));
-      }
-      int32_t domc = (int32_t) c.fftDominantHzPerChannel.size(); out.Put(&domc);
-      for (int i = 0; i < domc; ++i) out.Put(&c.fftDominantHzPerChannel[i]);
-      out.Put(&c.avgRms);
-      out.Put(&c.avgFreqHz);
-      out.Put(&c.avgFftDominantHz);
-      // Extended features (v3)
-      int32_t extChans = (int32_t) c.extendedFeaturesPerChannel.size(); out.Put(&extChans);
-      for (int ch = 0; ch < extChans; ++ch)
+    for (const auto& c : state.chunks)
+      PutChunk(out, c);
+  }
+
+  bool Brain::SerializeFileRecord(const BrainState& state, int fileId, iplug::IByteChunk& out)
+  {
+    auto it = state.idToFileIndex.find(fileId);
+    if (it == state.idToFileIndex.end()) return false;
+    const BrainFile& f = state.files[it->second];
+
+    return AppendToChunk(out, [&](SnapshotWriter& w)
+    {
+      int32_t chunkSize = state.chunkSize;
+      w.Put(&chunkSize);
+      int32_t fid = f.id;
+      w.Put(&fid);
+      w.PutString(f.displayName);
+      int32_t tailPad = f.tailPaddingFrames;
+      w.Put(&tailPad);
+      PutFileAudio(w, f.audio);
+      int32_t nChunks = (int32_t) f.chunkIndices.size();
+      w.Put(&nChunks);
+      for (int gi : f.chunkIndices)
+        PutChunk(w, state.chunks[gi]);
+    });
+  }
+
+  int Brain::ApplyFileRecord(const iplug::IByteChunk& in, int startPos)
+  {
+    if (startPos < 0 || startPos > in.Size()) return -1;
+    SnapshotReader reader(in.GetData() + startPos, (size_t) (in.Size() - startPos));
+
+    // Parse everything before touching the brain, so a damaged record changes nothing
+    int32_t chunkSize = 0; if (!reader.Get(&chunkSize)) return -1;
+    BrainFile f;
+    if (!reader.Get(&f.id) || !reader.GetString(f.displayName) || !reader.Get(&f.tailPaddingFrames)) return -1;
+    if (!GetFileAudio(reader, f.audio)) return -1;
+    int32_t nChunks = 0; if (!reader.Get(&nChunks) || nChunks < 0 || (size_t) nChunks > reader.Remaining()) return -1;
+    std::vector<BrainChunk> chunks((size_t) nChunks);
+    for (auto& c : chunks)
+    {
+      int32_t sourceOffset = -1;
+      if (!GetChunk(reader, kSnapshotVersion, c, sourceOffset) || c.fileId != f.id) return -1;
+      if (sourceOffset >= 0)
       {
-        int32_t numFeatures = (int32_t) c.extendedFeaturesPerChannel[ch].size();
-        out.Put(&numFeatures);
-        if (numFeatures > 0)
-          out.PutBytes(c.extendedFeaturesPerChannel[ch].data(), (int)(sizeof(float) * numFeatures));
+        if (!f.audio) return -1;
+        c.source = f.audio;
+        c.sourceOffset = sourceOffset;
       }
-      int32_t avgFeatCount = (int32_t) c.avgExtendedFeatures.size(); out.Put(&avgFeatCount);
-      if (avgFeatCount > 0)
-        out.PutBytes(c.avgExtendedFeatures.data(), (int)(sizeof(float) * avgFeatCount));
     }
 
-    return true;
+    // Checked, replaced and published in one step: readers never see the file missing
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (mState->chunkSize != chunkSize && !mState->chunks.empty()) return -1;
+    RemoveFileLocked(f.id);
+    DetachStateLocked();
+    mState->chunkSize = chunkSize;
+    AppendFileLocked(std::move(f), std::move(chunks));
+    PublishLocked();
+    return startPos + (int) reader.Position();
   }
 
   int Brain::DeserializeSnapshotFromChunk(const iplug::IByteChunk& in, int startPos, ProgressFn onProgress)
   {
-    std::lock_guard<std::mutex> lock(mutex_);
-    int pos = startPos;
-    uint32_t magic = 0; pos = in.Get(&magic, pos); if (pos < 0 || magic != kSnapshotMagic) return -1;
-    uint16_t ver = 0; pos = in.Get(&ver, pos); if (pos < 0) return -1;
-
-    // Check for compact formats (v100 = native sample type, v101 = float32)
-    if (ver == kSnapshotVersionCompact || ver == kSnapshotVersionCompactF32)
-    {
-      // Mark that we loaded a compact format brain
-      mLastLoadedWasCompact = true;
-
-      // Compact format: load metadata + reconstructed audio, then re-chunk
-      int32_t chunkSize = 0; pos = in.Get(&chunkSize, pos); if (pos < 0) return -1;
-      int32_t winMode = 1; pos = in.Get(&winMode, pos); if (pos < 0) return -1;
-      mSavedAnalysisWindowType = Window::IntToType(winMode);
-
-      // Load file count
-      int32_t nFiles = 0; pos = in.Get(&nFiles, pos); if (pos < 0 || nFiles < 0) return -1;
-
-      // Clear existing data
-      files_.clear();
-      idToFileIndex_.clear();
-      chunks_.clear();
-      mChunkSize = chunkSize;
-      nextFileId_ = 1;
-
-      // Pre-scan to calculate total chunks for progress reporting
-      int totalEstimatedChunks = 0;
-      int scanPos = pos;
-      for (int i = 0; i < nFiles; ++i)
-      {
-        int32_t fid = 0;
-        scanPos = in.Get(&fid, scanPos); if (scanPos < 0) break;
-
-        std::string name;
-        int32_t len = 0;
-        scanPos = in.Get(&len, scanPos); if (scanPos < 0 || len < 0) break;
-        if (len > 0) scanPos += len; // skip name bytes
+    if (startPos < 0 || startPos > in.Size()) return -1;
+    SnapshotReader reader(in.GetData() + startPos, (size_t) (in.Size() - startPos));
+    if (!ReadState(reader, onProgress)) return -1;
+    return startPos + (int) reader.Position();
+  }
 
-        int32_t chans = 0;
-        scanPos = in.Get(&chans, scanPos); if (scanPos < 0 || chans < 0) break;
+  bool Brain::DeserializeSnapshotFromMemory(const void* data, size_t size, ProgressFn onProgress)
+  {
+    SnapshotReader reader(data, size);
+    return ReadState(reader, onProgress);
+  }
 
-        int32_t frames = 0;
-        scanPos = in.Get(&frames, scanPos); if (scanPos < 0 || frames < 0) break;
+  bool Brain::ReadCompactState(SnapshotReader& in, uint16_t ver, ProgressFn onProgress)
+  {
+    // Compact format: load metadata + reconstructed audio, then re-chunk and re-analyze
+    int32_t chunkSize = 0; if (!in.Get(&chunkSize)) return false;
+    int32_t winMode = 1; if (!in.Get(&winMode)) return false;
+    int32_t nFiles = 0; if (!in.Get(&nFiles) || nFiles < 0) return false;
+    const size_t bytesPerSample = (ver == kSnapshotVersionCompact) ? sizeof(iplug::sample) : sizeof(float);
+
+    // A file whose chunks are being analyzed; committed to the brain once all its ranges are done
+    struct PendingFile
+    {
+      BrainFile rec;
+      std::vector<BrainChunk> chunks;
+      std::atomic<int> rangesLeft { 0 };
+      bool cached = false; // chunks came from the analysis cache
+    };
+    std::vector<std::unique_ptr<PendingFile>> pending;
+
+    // Read every file's audio first (no lock held, nothing analyzed yet)
+    for (int i = 0; i < nFiles; ++i)
+    {
+      int32_t fid = 0; if (!in.Get(&fid)) return false;
+      std::string name; if (!in.GetString(name)) return false;
+      int32_t chans = 0; if (!in.Get(&chans) || chans < 0) return false;
+      int32_t frames = 0; if (!in.Get(&frames) || frames < 0) return false;
 
-        if (chans > 0 && frames > 0)
-        {
-          totalEstimatedChunks += EstimateChunkCount(frames, chunkSize);
-          // Skip audio data
-          size_t bytesToSkip = (size_t)chans * (size_t)frames * (ver == kSnapshotVersionCompact ? sizeof(iplug::sample) : sizeof(float));
-          scanPos += (int)bytesToSkip;
-        }
+      if (chans == 0 || frames == 0)
+      {
+        // Empty file - skip
+        continue;
       }
 
-      int currentChunk = 0;
+      const size_t audioBytes = (size_t) chans * (size_t) frames * bytesPerSample;
+      if (audioBytes > in.Remaining()) return false;
 
-      // Load each file and re-chunk it
-      for (int i = 0; i < nFiles; ++i)
+      auto file = std::make_unique<PendingFile>();
+      BrainFile& fileRec = file->rec;
+      fileRec.id = fid;
+      fileRec.displayName = name;
+      if (ver == kSnapshotVersionCompactF32 && mAudioEncoding == BrainAudio::Encoding::Float32)
+      {
+        // v101 payload is already planar float32: read it as the file audio in one copy
+        auto audio = std::make_shared<BrainAudio>();
+        audio->encoding = BrainAudio::Encoding::Float32;
+        audio->numChannels = chans;
+        audio->numFrames = frames;
+        audio->data.resize(audioBytes);
+        if (!in.GetBytes(audio->data.data(), audioBytes)) return false;
+        fileRec.audio = std::move(audio);
+      }
+      else
       {
-        int32_t fid = 0;
-        pos = in.Get(&fid, pos); if (pos < 0) return -1;
-
-        std::string name;
-        if (!GetString(in, pos, name)) return -1;
-
-        int32_t chans = 0;
-        pos = in.Get(&chans, pos); if (pos < 0 || chans < 0) return -1;
-
-        int32_t frames = 0;
-        pos = in.Get(&frames, pos); if (pos < 0 || frames < 0) return -1;
-
-        if (chans == 0 || frames == 0)
-        {
-          // Empty file - skip
-          continue;
-        }
-
-        // Load reconstructed audio
         std::vector<std::vector<iplug::sample>> planar(chans, std::vector<iplug::sample>(frames, 0.0));
         if (ver == kSnapshotVersionCompact)
         {
           // v100: audio stored in native sample type (iplug::sample)
           for (int ch = 0; ch < chans; ++ch)
-          {
-            if (frames > 0)
-            {
-              pos = in.GetBytes(planar[ch].data(), (int)(sizeof(iplug::sample) * frames), pos);
-              if (pos < 0) return -1;
-            }
-          }
+            if (!in.GetBytes(planar[ch].data(), sizeof(iplug::sample) * (size_t) frames)) return false;
         }
         else // v101: audio stored as float32
         {
-          std::vector<float> tmp;
-          tmp.resize((size_t) frames);
+          std::vector<float> tmp((size_t) frames);
           for (int ch = 0; ch < chans; ++ch)
           {
-            if (frames > 0)
-            {
-              pos = in.GetBytes(tmp.data(), (int)(sizeof(float) * frames), pos);
-              if (pos < 0) return -1;
-              for (int f = 0; f < frames; ++f)
-                planar[ch][f] = (iplug::sample) tmp[f];
-            }
+            if (!in.GetBytes(tmp.data(), sizeof(float) * (size_t) frames)) return false;
+            for (int f = 0; f < frames; ++f)
+              planar[ch][f] = (iplug::sample) tmp[f];
           }
         }
+        fileRec.audio = BrainAudio::FromPlanar(planar, frames, mAudioEncoding);
+      }
 
-        // Re-chunk the audio (similar to AddAudioFileFromMemory but from PCM data)
-        const int totalFrames = frames;
-        const int expectedChunks = EstimateChunkCount(totalFrames, chunkSize);
+      // Chunks start every half chunk and stop before the end of the file
+      int numChunks = 0;
+      const int expectedChunks = EstimateChunkCount(frames, chunkSize);
+      while (numChunks < expectedChunks && numChunks * chunkSize / 2 < frames)
+        ++numChunks;
+      file->chunks.resize((size_t) numChunks);
+
+      // Compute tail padding for last chunk
+      const int totalFramesMod = chunkSize > 0 ? frames % chunkSize : 0;
+      fileRec.tailPaddingFrames = (numChunks > 0 && totalFramesMod != 0) ? (chunkSize - totalFramesMod) : 0;
+      pending.push_back(std::move(file));
+    }
 
-        BrainFile fileRec;
-        fileRec.id = fid;
-        fileRec.displayName = name;
-        fileRec.chunkIndices.reserve(expectedChunks);
+    // Start from an empty brain with the saved settings; files appear as soon as they are analyzed
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto fresh = std::make_shared<BrainState>();
+      // Mark that we loaded a compact format brain
+      fresh->lastLoadedWasCompact = true;
+      fresh->chunkSize = chunkSize;
+      fresh->savedAnalysisWindowType = Window::IntToType(winMode);
+      ReplaceStateLocked(std::move(fresh));
+      mChunkingCache.clear();
+      PublishLocked();
+    }
 
-        int numChunks = expectedChunks;
-        for (int c = 0; c < numChunks; ++c)
+    // Use a sample rate of 44100 as default (will be re-analyzed if needed)
+    const double sampleRate = 44100.0;
+    const auto window = GetAnalysisWindow();
+    for (auto& file : pending)
+      file->rec.analysis = CurrentAnalysisSettings(sampleRate, window.get());
+
+    // Files analyzed before with the same audio and settings are read from the analysis cache
+    AnalysisCache& cache = AnalysisCache::Instance();
+    const bool useCache = window && mUseAnalysisCache && cache.IsEnabled();
+    std::vector<AnalysisCache::Key> cacheKeys(useCache ? pending.size() : 0);
+    if (useCache)
+    {
+      ParallelFor((int) pending.size(), [&](int i)
+      {
+        PendingFile& file = *pending[i];
+        if (file.chunks.empty()) return;
+        cacheKeys[i] = AnalysisCacheKey(*file.rec.audio, chunkSize, file.rec.analysis);
+        file.cached = cache.Load(cacheKeys[i], [&](SnapshotReader& entry)
         {
-          const int start = c * chunkSize / 2;
-          const int framesInChunk = std::min(chunkSize, totalFrames - start);
-          if (framesInChunk <= 0) break;
-
-          BrainChunk chunk;
-          chunk.fileId = fid;
-          chunk.chunkIndexInFile = c;
-          chunk.audio.numFrames = chunkSize;
-          chunk.audio.channelSamples.assign(chans, std::vector<sample>(chunkSize, 0.0));
+          return GetCachedChunks(entry, file.rec, chunkSize, file.chunks);
+        });
+        if (!file.cached)
+          file.chunks.assign(file.chunks.size(), BrainChunk());
+      });
+    }
 
-          // Copy audio frames (zero-pad tail)
-          for (int ch = 0; ch < chans; ++ch)
-          {
-            for (int f = 0; f < framesInChunk; ++f)
-              chunk.audio.channelSamples[ch][f] = planar[ch][start + f];
-            for (int f = framesInChunk; f < chunkSize; ++f)
-              chunk.audio.channelSamples[ch][f] = 0.0f;
-          }
+    // Work items are ranges of chunks, so one long file still spreads over all workers
+    struct Range { int file; int begin; int end; };
+    std::vector<Range> ranges;
+    int totalChunks = 0;
+    for (int i = 0; i < (int) pending.size(); ++i)
+    {
+      if (pending[i]->cached) continue;
+      const int n = (int) pending[i]->chunks.size();
+      totalChunks += n;
+      for (int b = 0; b < n; b += kLoadChunksPerRange)
+        ranges.push_back({ i, b, std::min(n, b + kLoadChunksPerRange) });
+      pending[i]->rangesLeft = (n + kLoadChunksPerRange - 1) / kLoadChunksPerRange;
+    }
 
-          // Analyze metrics for this chunk over valid frames
-          // Note: mWindow should be set by caller before deserialization
-          if (mWindow)
-          {
-            // Use a sample rate of 44100 as default (will be re-analyzed if needed)
-            AnalyzeChunk(chunk, framesInChunk, 44100.0);
-          }
+    // Files are committed in their saved order, so the result matches a sequential load
+    std::mutex commitMutex;
+    std::vector<char> analyzed(pending.size(), 0);
+    int nextCommit = 0;
+    int chunksDone = 0;
+    auto commitReady = [&]()
+    {
+      while (nextCommit < (int) pending.size() && analyzed[nextCommit])
+      {
+        PendingFile& file = *pending[nextCommit++];
+        std::lock_guard<std::mutex> lock(mutex_);
+        DetachStateLocked();
+        AppendFileLocked(std::move(file.rec), std::move(file.chunks));
+        PublishLocked();
+      }
+    };
 
-          const int chunkGlobalIndex = (int)chunks_.size();
-          chunks_.push_back(std::move(chunk));
-          fileRec.chunkIndices.push_back(chunkGlobalIndex);
+    {
+      std::lock_guard<std::mutex> lock(commitMutex);
+      for (int i = 0; i < (int) pending.size(); ++i)
+        analyzed[i] = (pending[i]->chunks.empty() || pending[i]->cached) ? 1 : 0;
+      commitReady();
+    }
 
-          // Report progress per chunk
-          ++currentChunk;
-          if (onProgress && totalEstimatedChunks > 0)
-            onProgress(name, currentChunk, totalEstimatedChunks);
-        }
+    ParallelFor((int) ranges.size(), [&](int r)
+    {
+      const Range& range = ranges[r];
+      PendingFile& file = *pending[range.file];
+      for (int c = range.begin; c < range.end; ++c)
+        file.chunks[c] = MakeChunkView(file.rec.audio, file.rec.id, c, chunkSize, sampleRate, window.get());
+
+      const bool fileDone = file.rangesLeft.fetch_sub(1) == 1;
+      if (fileDone && useCache)
+        cache.Store(cacheKeys[range.file], [&](SnapshotWriter& entry) { PutCachedChunks(entry, file.chunks); });
+      std::lock_guard<std::mutex> lock(commitMutex);
+      chunksDone += range.end - range.begin;
+      if (onProgress && totalChunks > 0)
+        onProgress(file.rec.displayName, chunksDone, totalChunks);
+      if (fileDone)
+      {
+        analyzed[range.file] = 1;
+        commitReady();
+      }
+    });
 
-        fileRec.chunkCount = (int)fileRec.chunkIndices.size();
+    if (useCache && !ranges.empty())
+      cache.Trim();
+    return true;
+  }
 
-        // Compute tail padding for last chunk
-        const int totalFramesMod = totalFrames % chunkSize;
-        if (fileRec.chunkCount > 0)
-        {
-          fileRec.tailPaddingFrames = (totalFramesMod == 0) ? 0 : (chunkSize - totalFramesMod);
-        }
-        else
-        {
-          fileRec.tailPaddingFrames = 0;
-        }
+  void Brain::AppendFileLocked(BrainFile f, std::vector<BrainChunk> chunks)
+  {
+    f.chunkIndices.clear();
+    f.chunkIndices.reserve(chunks.size());
+    mState->chunks.reserve(mState->chunks.size() + chunks.size());
+    for (auto& c : chunks)
+    {
+      f.chunkIndices.push_back((int) mState->chunks.size());
+      mState->chunks.push_back(std::move(c));
+    }
+    f.chunkCount = (int) f.chunkIndices.size();
+    if (f.id >= mState->nextFileId)
+      mState->nextFileId = f.id + 1;
+    mState->idToFileIndex[f.id] = (int) mState->files.size();
+    mState->files.push_back(std::move(f));
+    ++mContentVersion;
+  }
 
-        idToFileIndex_[fid] = (int)files_.size();
-        files_.push_back(std::move(fileRec));
+  bool Brain::ReadState(SnapshotReader& in, ProgressFn onProgress)
+  {
+    uint32_t magic = 0; if (!in.Get(&magic) || magic != kSnapshotMagic) return false;
+    uint16_t ver = 0; if (!in.Get(&ver)) return false;
 
-        // Update nextFileId_ to prevent ID conflicts
-        if (fid >= nextFileId_)
-          nextFileId_ = fid + 1;
-      }
+    // Check for compact formats (v100 = native sample type, v101 = float32)
+    if (ver == kSnapshotVersionCompact || ver == kSnapshotVersionCompactF32)
+      return ReadCompactState(in, ver, onProgress);
 
-      return pos;
-    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++mContentVersion; // contents are replaced below while the lock is held
+    // Readers see the result (complete or, on a parse error, partial) once we return
+    struct PublishOnReturn { Brain& brain; ~PublishOnReturn() { brain.PublishLocked(); } } publishOnReturn { *this };
 
     // Standard format deserialization
-    if (ver > kSnapshotVersion) return -1;
+    if (ver > kSnapshotVersion) return false;
+    ReplaceStateLocked(std::make_shared<BrainState>());
+    mChunkingCache.clear();
 
     // Mark that we loaded a standard format brain
-    mLastLoadedWasCompact = false;
+    mState->lastLoadedWasCompact = false;
 
-    int32_t chunkSize = 0; pos = in.Get(&chunkSize, pos); if (pos < 0) return -1; mChunkSize = chunkSize;
+    int32_t chunkSize = 0; if (!in.Get(&chunkSize)) return false;
+    mState->chunkSize = chunkSize;
 
     // Handle window type: v1 used string, v2 uses int
     if (ver == 1)
     {
       // Version 1: read string
       std::string win;
-      if (!GetString(in, pos, win)) return -1;
+      if (!in.GetString(win)) return false;
       // Convert string to window type
-      if (win == "hann") mSavedAnalysisWindowType = Window::Type::Hann;
-      else if (win == "hamming") mSavedAnalysisWindowType = Window::Type::Hamming;
-      else if (win == "blackman") mSavedAnalysisWindowType = Window::Type::Blackman;
-      else if (win == "rectangular") mSavedAnalysisWindowType = Window::Type::Rectangular;
-      else mSavedAnalysisWindowType = Window::Type::Hann; // default fallback
+      if (win == "hann") mState->savedAnalysisWindowType = Window::Type::Hann;
+      else if (win == "hamming") mState->savedAnalysisWindowType = Window::Type::Hamming;
+      else if (win == "blackman") mState->savedAnalysisWindowType = Window::Type::Blackman;
+      else if (win == "rectangular") mState->savedAnalysisWindowType = Window::Type::Rectangular;
+      else mState->savedAnalysisWindowType = Window::Type::Hann; // default fallback
     }
     else
     {
       // Version 2: read int
       int32_t winMode = 1;
-      pos = in.Get(&winMode, pos);
-      if (pos < 0) return -1;
-      mSavedAnalysisWindowType = Window::IntToType(winMode);
+      if (!in.Get(&winMode)) return false;
+      mState->savedAnalysisWindowType = Window::IntToType(winMode);
     }
 
-    files_.clear(); idToFileIndex_.clear(); chunks_.clear();
+    mState->files.clear(); mState->idToFileIndex.clear(); mState->chunks.clear();
 
-    int32_t nFiles = 0; pos = in.Get(&nFiles, pos); if (pos < 0 || nFiles < 0) return -1;
-    files_.reserve(nFiles);
+    int32_t nFiles = 0; if (!in.Get(&nFiles) || nFiles < 0 || (size_t) nFiles > in.Remaining()) return false;
+    mState->files.reserve(nFiles);
     for (int i = 0; i < nFiles; ++i)
     {
       BrainFile f;
-      pos = in.Get(&f.id, pos); if (pos < 0) return -1;
-      std::string name; if (!GetString(in, pos, name)) return -1; f.displayName = name;
-      pos = in.Get(&f.tailPaddingFrames, pos); if (pos < 0) return -1;
-      int32_t nIdx = 0; pos = in.Get(&nIdx, pos); if (pos < 0 || nIdx < 0) return -1;
-      f.chunkIndices.resize(nIdx, -1);
-      for (int k = 0; k < nIdx; ++k) pos = in.Get(&f.chunkIndices[k], pos);
-      f.chunkCount = nIdx;
-      idToFileIndex_[f.id] = (int) files_.size();
-      files_.push_back(std::move(f));
+      if (!in.Get(&f.id) || !in.GetString(f.displayName) || !in.Get(&f.tailPaddingFrames)) return false;
+      if (!in.GetVector(f.chunkIndices)) return false;
+      f.chunkCount = (int) f.chunkIndices.size();
+      if (ver >= 4 && !GetFileAudio(in, f.audio)) return false;
+      mState->idToFileIndex[f.id] = (int) mState->files.size();
+      mState->files.push_back(std::move(f));
     }
 
-    int32_t nChunks = 0; pos = in.Get(&nChunks, pos); if (pos < 0 || nChunks < 0) return -1;
-    chunks_.resize(nChunks);
+    int32_t nChunks = 0; if (!in.Get(&nChunks) || nChunks < 0 || (size_t) nChunks > in.Remaining()) return false;
+    mState->chunks.resize(nChunks);
     for (int i = 0; i < nChunks; ++i)
     {
-      auto& c = chunks_[i];
-      pos = in.Get(&c.fileId, pos); if (pos < 0) return -1;
-      pos = in.Get(&c.chunkIndexInFile, pos); if (pos < 0) return -1;
-      int32_t chans = 0; pos = in.Get(&chans, pos); if (pos < 0 || chans < 0) return -1;
-      pos = in.Get(&c.audio.numFrames, pos); if (pos < 0) return -1;
-      c.audio.channelSamples.assign(chans, std::vector<iplug::sample>());
-      for (int ch = 0; ch < chans; ++ch)
-      {
-        int32_t frames = 0; pos = in.Get(&frames, pos); if (pos < 0 || frames < 0) return -1;
-        c.audio.channelSamples[ch].resize(frames);
-        if (frames > 0)
-        {
-          pos = in.GetBytes(c.audio.channelSamples[ch].data(), (int) (sizeof(iplug::sample) * frames), pos);
-          if (pos < 0) return -1;
-        }
-      }
-      int32_t rmsc = 0; pos = in.Get(&rmsc, pos); if (pos < 0 || rmsc < 0) return -1;
-      c.rmsPerChannel.resize(rmsc); for (int k = 0; k < rmsc; ++k) pos = in.Get(&c.rmsPerChannel[k], pos);
-      int32_t fzc = 0; pos = in.Get(&fzc, pos); if (pos < 0 || fzc < 0) return -1;
-      c.freqHzPerChannel.resize(fzc); for (int k = 0; k < fzc; ++k) pos = in.Get(&c.freqHzPerChannel[k], pos);
-      int32_t fftSize = 0; pos = in.Get(&fftSize, pos); c.fftSize = fftSize; if (pos < 0) return -1;
-      int32_t fftc = 0; pos = in.Get(&fftc, pos); if (pos < 0 || fftc < 0) return -1;
-      c.magnitudeSpectrum.resize(fftc);
-      for (int ch = 0; ch < fftc; ++ch)
+      auto& c = mState->chunks.Mutable(i);
+      int32_t sourceOffset = -1;
+      if (!GetChunk(in, ver, c, sourceOffset)) return false;
+      if (sourceOffset >= 0)
       {
-        int32_t bins = 0; pos = in.Get(&bins, pos); if (pos < 0 || bins < 0) return -1;
-        c.magnitudeSpectrum[ch].resize(bins);
-        if (bins > 0)
-        {
-          pos = in.GetBytes(c.magnitudeSpectrum[ch].data(), (int)(sizeof(float) * bins), pos);
-          if (pos < 0) return -1;
-        }
+        auto fit = mState->idToFileIndex.find(c.fileId);
+        if (fit == mState->idToFileIndex.end() || !mState->files[fit->second].audio) return false;
+        c.source = mState->files[fit->second].audio;
+        c.sourceOffset = sourceOffset;
       }
-      int32_t domc = 0; pos = in.Get(&domc, pos); if (pos < 0 || domc < 0) return -1;
-      c.fftDominantHzPerChannel.resize(domc); for (int k = 0; k < domc; ++k) pos = in.Get(&c.fftDominantHzPerChannel[k], pos);
-      pos = in.Get(&c.avgRms, pos); if (pos < 0) return -1;
-      pos = in.Get(&c.avgFreqHz, pos); if (pos < 0) return -1;
-      pos = in.Get(&c.avgFftDominantHz, pos); if (pos < 0) return -1;
-      // Extended features (v3+)
-      if (ver >= 3)
+    }
+
+    // Snapshots before v4 keep samples per chunk: store each file's audio once instead
+    // and turn its chunks into views (float32 is exact for audio that was decoded to f32)
+    for (auto& f : mState->files)
+    {
+      if (f.audio) continue;
+      std::vector<std::vector<sample>> planar;
+      const int frames = ReconstructFileAudio(f, mState->chunks, mState->chunkSize, planar);
+      if (frames <= 0) continue;
+      f.audio = BrainAudio::FromPlanar(planar, frames, BrainAudio::Encoding::Float32);
+      for (int gi : f.chunkIndices)
       {
-        int32_t extChans = 0; pos = in.Get(&extChans, pos); if (pos < 0 || extChans < 0) return -1;
-        c.extendedFeaturesPerChannel.resize(extChans);
-        for (int ch = 0; ch < extChans; ++ch)
-        {
-          int32_t numFeatures = 0; pos = in.Get(&numFeatures, pos); if (pos < 0 || numFeatures < 0) return -1;
-          c.extendedFeaturesPerChannel[ch].resize(numFeatures);
-          if (numFeatures > 0)
-          {
-            pos = in.GetBytes(c.extendedFeaturesPerChannel[ch].data(), (int)(sizeof(float) * numFeatures), pos);
-            if (pos < 0) return -1;
-          }
-        }
-        int32_t avgFeatCount = 0; pos = in.Get(&avgFeatCount, pos); if (pos < 0 || avgFeatCount < 0) return -1;
-        c.avgExtendedFeatures.resize(avgFeatCount);
-        if (avgFeatCount > 0)
-        {
-          pos = in.GetBytes(c.avgExtendedFeatures.data(), (int)(sizeof(float) * avgFeatCount), pos);
-          if (pos < 0) return -1;
-        }
+        if (gi < 0 || gi >= (int) mState->chunks.size()) continue;
+        BrainChunk& c = mState->chunks.Mutable(gi);
+        c.source = f.audio;
+        c.sourceOffset = c.chunkIndexInFile * mState->chunkSize / 2;
+        std::vector<std::vector<sample>>().swap(c.audio.channelSamples);
       }
     }
 
-    // Update nextFileId_ to be one more than the maximum file ID we just loaded
+    // Update nextFileId to be one more than the maximum file ID we just loaded
     // This prevents duplicate IDs when adding new files after import
-    nextFileId_ = 1;
-    for (const auto& f : files_)
+    mState->nextFileId = 1;
+    for (const auto& f : mState->files)
     {
-      if (f.id >= nextFileId_)
-        nextFileId_ = f.id + 1;
+      if (f.id >= mState->nextFileId)
+        mState->nextFileId = f.id + 1;
     }
 
-    return pos;
+    return true;
   }
 }
 
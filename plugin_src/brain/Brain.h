@@ -5,8 +5,15 @@
 #include <unordered_map>
 #include <mutex>
 #include <functional>
+#include <atomic>
+#include <memory>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <cstdio>
 
 #include "plugin_src/modules/AudioStreamChunker.h"
+#include "plugin_src/common/EpochPublisher.h"
 #include "IPlugStructs.h"
 
 // Forward declare miniaudio types to avoid including the large header here.
@@ -14,6 +21,64 @@
 
 namespace synaptic
 {
+  /**
+   * @brief One source file's audio, stored once, channel-major, in a compact sample encoding
+   *
+   * Brain chunks overlap by half a chunk, so keeping samples per chunk stores every source
+   * frame twice at full iplug::sample precision. Chunks instead read their frames from the
+   * file's BrainAudio. Float32 is lossless for decoded audio (miniaudio decodes to f32);
+   * PCM24/PCM16 trade precision for a further 25%/50% saving.
+   */
+  struct BrainAudio
+  {
+    enum class Encoding : uint8_t { Float32 = 0, PCM24 = 1, PCM16 = 2 };
+
+    Encoding encoding = Encoding::Float32;
+    int numChannels = 0;
+    int numFrames = 0;
+    std::vector<uint8_t> data; // numChannels blocks of numFrames * BytesPerSample(encoding)
+
+    static int BytesPerSample(Encoding e) { return e == Encoding::PCM16 ? 2 : (e == Encoding::PCM24 ? 3 : 4); }
+
+    size_t MemoryBytes() const { return data.size(); }
+
+    /** @brief Decode frames [start, start + count) of one channel; frames outside the file read as 0 */
+    void Read(int ch, int start, int count, iplug::sample* dst) const
+    {
+      int i = 0;
+      if (ch < 0 || ch >= numChannels)
+      {
+        for (; i < count; ++i) dst[i] = 0.0;
+        return;
+      }
+      for (; i < count && start + i < 0; ++i) dst[i] = 0.0;
+      const int end = std::min(count, numFrames - start);
+      const int bps = BytesPerSample(encoding);
+      const uint8_t* base = data.data() + ((size_t) ch * (size_t) numFrames + (size_t) start) * (size_t) bps;
+      switch (encoding)
+      {
+        case Encoding::Float32:
+          for (; i < end; ++i) { float v; std::memcpy(&v, base + (size_t) i * 4, 4); dst[i] = (iplug::sample) v; }
+          break;
+        case Encoding::PCM24:
+          for (; i < end; ++i)
+          {
+            const uint8_t* p = base + (size_t) i * 3;
+            const int32_t v = (int32_t) ((uint32_t) p[0] << 8 | (uint32_t) p[1] << 16 | (uint32_t) p[2] << 24) >> 8;
+            dst[i] = (iplug::sample) v * (1.0 / 8388608.0);
+          }
+          break;
+        case Encoding::PCM16:
+          for (; i < end; ++i) { int16_t v; std::memcpy(&v, base + (size_t) i * 2, 2); dst[i] = (iplug::sample) v * (1.0 / 32768.0); }
+          break;
+      }
+      for (; i < count; ++i) dst[i] = 0.0;
+    }
+
+    /** @brief Encode planar audio (first @p frames of each channel) */
+    static std::shared_ptr<const BrainAudio> FromPlanar(const std::vector<std::vector<iplug::sample>>& planar, int frames, Encoding e);
+  };
+
   /**
    * @brief A chunk of audio stored in the Brain with analysis metadata
    *
@@ -25,7 +90,7 @@ namespace synaptic
    */
   struct BrainChunk
   {
-    AudioChunk audio;  ///< Audio data with optional full FFT spectrum
+    AudioChunk audio;  ///< Audio data with optional full FFT spectrum (samples empty when source is set)
     int fileId = -1;
     int chunkIndexInFile = -1;
 
@@ -50,6 +115,142 @@ namespace synaptic
     // Extended feature analysis (per channel)
     std::vector<std::vector<float>> extendedFeaturesPerChannel; // 7 features per channel: [f0, affinity, sharpness, harmonicity, monotony, meanAffinity, meanContrast]
     std::vector<float> avgExtendedFeatures; // averaged across channels
+
+    // Samples as a view into the file's audio: audio.numFrames frames from frame sourceOffset.
+    // Null for chunks that own their samples in audio.channelSamples.
+    std::shared_ptr<const BrainAudio> source;
+    int sourceOffset = 0;
+
+    int NumChannels() const { return source ? source->numChannels : (int) audio.channelSamples.size(); }
+
+    // Heap bytes held by this chunk's samples and analysis (not its shared source audio)
+    size_t MemoryBytes() const
+    {
+      auto nested = [](const auto& v)
+      {
+        size_t bytes = 0;
+        for (const auto& inner : v) bytes += inner.capacity() * sizeof(inner[0]);
+        return bytes;
+      };
+      return sizeof(BrainChunk) + nested(audio.channelSamples) + nested(audio.complexSpectrum)
+        + nested(magnitudeSpectrum) + nested(extendedFeaturesPerChannel)
+        + rmsPerChannel.capacity() * sizeof(float) + freqHzPerChannel.capacity() * sizeof(double)
+        + fftDominantHzPerChannel.capacity() * sizeof(double) + avgExtendedFeatures.capacity() * sizeof(float);
+    }
+
+    /** @brief Copy the first @p count samples of channel @p ch into dst (zero past the chunk's data) */
+    void ReadChannel(int ch, iplug::sample* dst, int count) const
+    {
+      if (source)
+      {
+        source->Read(ch, sourceOffset, std::min(count, audio.numFrames), dst);
+        for (int i = std::max(0, audio.numFrames); i < count; ++i) dst[i] = 0.0;
+        return;
+      }
+      const int n = (ch >= 0 && ch < (int) audio.channelSamples.size()) ? std::min(count, (int) audio.channelSamples[ch].size()) : 0;
+      for (int i = 0; i < n; ++i) dst[i] = audio.channelSamples[ch][i];
+      for (int i = std::max(0, n); i < count; ++i) dst[i] = 0.0;
+    }
+
+    /**
+     * @brief Like ReadChannel, but from @p lead frames into the chunk and on past its end
+     *
+     * A view reads on into its file (zero past the file's end); a chunk owning its samples has
+     * nothing after them and reads zeros there.
+     */
+    void ReadChannelAhead(int ch, int lead, iplug::sample* dst, int count) const
+    {
+      if (source)
+      {
+        source->Read(ch, sourceOffset + lead, count, dst);
+        return;
+      }
+      const int size = (ch >= 0 && ch < (int) audio.channelSamples.size()) ? (int) audio.channelSamples[ch].size() : 0;
+      const int n = std::max(0, std::min(count, size - lead));
+      for (int i = 0; i < n; ++i) dst[i] = audio.channelSamples[ch][lead + i];
+      for (int i = n; i < count; ++i) dst[i] = 0.0;
+    }
+  };
+
+  /**
+   * @brief The chunks of a brain, each held through a shared_ptr
+   *
+   * Copying a table copies pointers, not chunks, so a BrainState can be copied for every edit
+   * while earlier copies are still being read. Mutable() gives write access to one chunk,
+   * cloning it first if another table still refers to it.
+   */
+  class BrainChunkTable
+  {
+  public:
+    class const_iterator
+    {
+    public:
+      explicit const_iterator(std::vector<std::shared_ptr<BrainChunk>>::const_iterator it) : mIt(it) {}
+      const BrainChunk& operator*() const { return **mIt; }
+      const BrainChunk* operator->() const { return mIt->get(); }
+      const_iterator& operator++() { ++mIt; return *this; }
+      bool operator!=(const const_iterator& o) const { return mIt != o.mIt; }
+      bool operator==(const const_iterator& o) const { return mIt == o.mIt; }
+
+    private:
+      std::vector<std::shared_ptr<BrainChunk>>::const_iterator mIt;
+    };
+
+    BrainChunkTable() = default;
+    explicit BrainChunkTable(std::vector<BrainChunk> chunks)
+    {
+      mChunks.reserve(chunks.size());
+      for (auto& c : chunks) push_back(std::move(c));
+    }
+
+    size_t size() const { return mChunks.size(); }
+    bool empty() const { return mChunks.empty(); }
+    const BrainChunk& operator[](size_t i) const { return *mChunks[i]; }
+    const_iterator begin() const { return const_iterator(mChunks.begin()); }
+    const_iterator end() const { return const_iterator(mChunks.end()); }
+
+    void reserve(size_t n) { mChunks.reserve(n); }
+    void clear() { mChunks.clear(); }
+    void swap(BrainChunkTable& o) { mChunks.swap(o.mChunks); }
+    // New chunks are default-constructed
+    void resize(size_t n)
+    {
+      const size_t old = mChunks.size();
+      mChunks.resize(n);
+      for (size_t i = old; i < n; ++i) mChunks[i] = std::make_shared<BrainChunk>();
+    }
+    void push_back(BrainChunk&& c) { mChunks.push_back(std::make_shared<BrainChunk>(std::move(c))); }
+    void push_back(std::shared_ptr<BrainChunk> c) { mChunks.push_back(std::move(c)); }
+
+    /** @brief The chunk itself, for moving it to another table without a copy */
+    const std::shared_ptr<BrainChunk>& Shared(size_t i) const { return mChunks[i]; }
+    /** @brief Put an existing chunk at i, sharing it */
+    void Set(size_t i, std::shared_ptr<BrainChunk> c) { mChunks[i] = std::move(c); }
+
+    /** @brief Write access to chunk i (copy-on-write) */
+    BrainChunk& Mutable(size_t i)
+    {
+      auto& p = mChunks[i];
+      if (p.use_count() > 1) p = std::make_shared<BrainChunk>(*p);
+      return *p;
+    }
+
+  private:
+    std::vector<std::shared_ptr<BrainChunk>> mChunks;
+  };
+
+  /** @brief What a chunk's analysis depends on besides its audio and the chunk size */
+  struct ChunkAnalysisSettings
+  {
+    double sampleRate = 0.0; // 0 = unknown (e.g. chunks read from a full snapshot)
+    int windowType = -1;
+    int windowSize = 0;
+
+    bool IsKnown() const { return sampleRate > 0.0; }
+    bool operator==(const ChunkAnalysisSettings& o) const
+    {
+      return sampleRate == o.sampleRate && windowType == o.windowType && windowSize == o.windowSize;
+    }
   };
 
   struct BrainFile
@@ -59,6 +260,34 @@ namespace synaptic
     int chunkCount = 0;
     std::vector<int> chunkIndices; // indices into mChunks
     int tailPaddingFrames = 0; // number of padded frames in the final chunk
+    std::shared_ptr<const BrainAudio> audio; // the whole decoded file; chunks are views into it
+    ChunkAnalysisSettings analysis; // how its chunks were analyzed (not saved)
+  };
+
+  /**
+   * @brief Contents of a brain: files, chunks and the settings they were built with
+   *
+   * Held through a shared_ptr so several Brain instances that loaded the same .sbrain file
+   * can share one copy (see BrainRegistry), and so the audio thread can keep reading a
+   * published state while the next one is built. A shared state is never modified in place;
+   * Brain copies it first (chunks themselves are copied only when modified).
+   */
+  class SnapshotWriter;
+  class SnapshotReader;
+
+  struct BrainState
+  {
+    int nextFileId = 1;
+    std::vector<BrainFile> files;
+    std::unordered_map<int, int> idToFileIndex;
+    BrainChunkTable chunks;
+    int chunkSize = 0;
+    // Saved in snapshot for import; defaults to Hann if unknown
+    Window::Type savedAnalysisWindowType = Window::Type::Hann;
+    // Track if the last loaded brain was in compact format (for UI sync)
+    bool lastLoadedWasCompact = false;
+    // Bumped when every chunk is rebuilt (rechunk, reanalyze); journaled saves can't describe that
+    uint32_t layoutEpoch = 0;
   };
 
   class Brain
@@ -81,18 +310,39 @@ namespace synaptic
     bool GetUseCompactFormat() const { return mUseCompactFormat; }
     void SetUseCompactFormat(bool compact) { mUseCompactFormat = compact; }
 
+    /**
+     * @brief Sample encoding for audio of files added or rechunked from now on
+     * Float32 (default) is lossless for decoded files; PCM24/PCM16 use less memory and disk.
+     */
+    BrainAudio::Encoding GetAudioEncoding() const { return mAudioEncoding; }
+    void SetAudioEncoding(BrainAudio::Encoding e) { mAudioEncoding = e; }
+
+    /**
+     * @brief Read and write this brain's analysis in the on-disk AnalysisCache
+     * Off by default (it uses disk space); saved with the project. The cache's own switch still
+     * turns it off for every instance.
+     */
+    bool IsAnalysisCacheEnabled() const { return mUseAnalysisCache.load(); }
+    void SetAnalysisCacheEnabled(bool enabled) { mUseAnalysisCache.store(enabled); }
+
+    // Bytes held by stored file audio (chunks reference it rather than copying)
+    size_t GetAudioMemoryBytes() const;
+
     void Reset()
     {
       std::lock_guard<std::mutex> lock(mutex_);
-      nextFileId_ = 1;
-      files_.clear();
-      idToFileIndex_.clear();
-      chunks_.clear();
-      mLastLoadedWasCompact = false; // Reset format tracking
+      ReplaceStateLocked(std::make_shared<BrainState>());
+      mChunkingCache.clear();
+      PublishLocked();
     }
 
-    // Set the window to use for FFT analysis
-    void SetWindow(const class Window* window) { mWindow = window; }
+    /**
+     * @brief Set the window to use for FFT analysis
+     * The brain keeps its own copy, so call again after changing the window. Never waits for
+     * analysis: each operation (imports included) works with the copy current when it started.
+     */
+    void SetWindow(const class Window* window);
+    std::shared_ptr<const class Window> GetAnalysisWindow() const;
 
     // Progress callback: (fileName, currentChunk, totalChunks)
     using ProgressFn = std::function<void(const std::string& /*fileName*/, int /*current*/, int /*total*/)>;
@@ -116,16 +366,120 @@ namespace synaptic
     struct FileSummary { int id; std::string name; int chunkCount; };
     std::vector<FileSummary> GetSummary() const;
 
-    // Read-only access for transformers
+    // Locked read access (UI and worker threads); the audio thread uses ReadScope
     int GetTotalChunks() const;
     const BrainChunk* GetChunkByGlobalIndex(int idx) const;
 
-    // Re-chunk all files to a new chunk size
+    // Incremented whenever chunks are added, removed, rechunked or reanalyzed.
+    // Lets the audio thread drop results derived from older contents without locking.
+    uint32_t GetContentVersion() const { return mContentVersion.load(std::memory_order_acquire); }
+
+  private:
+    // A layer with every file analyzed, in the same file order as the current chunking
+    struct PublishedLayer
+    {
+      int chunkSize = 0;
+      BrainChunkTable chunks;
+    };
+
+    struct PublishedState
+    {
+      std::shared_ptr<const BrainState> state;
+      uint32_t contentVersion = 0;
+      std::vector<PublishedLayer> layers;
+    };
+
+  public:
+    /**
+     * @brief Lock-free, wait-free view of the brain for the audio thread
+     *
+     * Every edit publishes the resulting contents as an immutable snapshot. A ReadScope pins the
+     * snapshot that was current when it opened: chunk pointers stay valid and indices stay stable
+     * until the scope closes, however the brain is edited meanwhile. Opening and closing a scope
+     * never locks or frees memory; replaced snapshots are freed by later edits and ReclaimSnapshots().
+     *
+     * Given a chunk size, the scope reads the layer of that size instead of the current chunking,
+     * if the layer is complete; otherwise (or with 0) it reads the current chunking.
+     */
+    class ReadScope
+    {
+    public:
+      explicit ReadScope(const Brain& brain, int chunkSize = 0) : mScope(brain.mPublished)
+      {
+        if (!mScope.Get()) return;
+        mChunks = &mScope->state->chunks;
+        mChunkSize = mScope->state->chunkSize;
+        if (chunkSize <= 0 || chunkSize == mChunkSize) return;
+        for (const auto& layer : mScope->layers)
+        {
+          if (layer.chunkSize != chunkSize) continue;
+          mChunks = &layer.chunks;
+          mChunkSize = chunkSize;
+          break;
+        }
+      }
+
+      int TotalChunks() const { return mChunks ? (int) mChunks->size() : 0; }
+      const BrainChunk* Chunk(int idx) const
+      {
+        if (!mChunks || idx < 0 || idx >= (int) mChunks->size()) return nullptr;
+        return &(*mChunks)[idx];
+      }
+      // GetContentVersion() as of this snapshot
+      uint32_t ContentVersion() const { return mScope.Get() ? mScope->contentVersion : 0; }
+      // Chunk size of the chunks read (the layer's, if one was selected)
+      int ChunkSize() const { return mChunkSize; }
+
+    private:
+      EpochPublisher<PublishedState>::ReadScope mScope;
+      const BrainChunkTable* mChunks = nullptr;
+      int mChunkSize = 0;
+    };
+
+    // Free snapshots replaced by edits once no ReadScope uses them (call periodically, not on the audio thread)
+    void ReclaimSnapshots() { mPublished.Reclaim(); }
+
+    /**
+     * @brief Re-chunk all files to a new chunk size
+     * Slices each file's stored audio and analyzes the new chunks in parallel. The chunkings of the
+     * last kMaxCachedChunkSizes chunk sizes (and of every layer, see below) are kept, so switching
+     * back to one of them (with the same sample rate and analysis window) reuses its analyzed chunks
+     * instead of recomputing them.
+     * Each file is checkpointed as soon as it is analyzed (see CheckpointChunking), so a cancelled,
+     * superseded or interrupted rechunk resumes from the files it had finished.
+     */
     struct RechunkStats { int filesProcessed = 0; int filesRechunked = 0; int newTotalChunks = 0; bool wasCancelled = false; };
     RechunkStats RechunkAllFiles(int newChunkSizeSamples, int targetSampleRate, ProgressFn onProgress = nullptr, std::atomic<bool>* cancelFlag = nullptr);
-    int GetChunkSize() const { return mChunkSize; }
+    int GetChunkSize() const { std::lock_guard<std::mutex> lock(mutex_); return mState->chunkSize; }
+
+    /**
+     * @brief Multi-resolution brain: chunkings kept ready at other chunk sizes ("layers")
+     *
+     * BuildLayers analyzes every file at each layer chunk size in the background, next to the
+     * current chunking. Rechunking to a layer's size then only swaps in the ready chunks. Layers
+     * cost memory for their analysis (file audio is shared); GetLayerInfo reports it per layer.
+     * Once every file is analyzed at a layer's size, the layer is published to ReadScope too, so
+     * the audio thread can match at that size without the brain being rechunked.
+     */
+    void SetLayerChunkSizes(std::vector<int> chunkSizes);
+    std::vector<int> GetLayerChunkSizes() const;
+    // Layers published to ReadScope (complete for the current files), ascending
+    std::vector<int> GetReadyLayerChunkSizes() const;
+    // Analyze what the layers are missing for the current files; returns false if cancelled
+    bool BuildLayers(int targetSampleRate, std::atomic<bool>* cancelFlag = nullptr);
+    struct LayerInfo
+    {
+      int chunkSize = 0;
+      bool active = false;  // the brain's current chunking
+      int filesReady = 0;   // files analyzed at this size
+      int totalFiles = 0;
+      size_t memoryBytes = 0;
+    };
+    // The current chunking and every layer, by chunk size
+    std::vector<LayerInfo> GetLayerInfo() const;
 
     // Re-analyze all existing chunks (no rechunking). Uses current window (SetWindow) and provided sampleRate.
+    // Checkpoints and resumes per file like RechunkAllFiles.
     struct ReanalyzeStats { int filesProcessed = 0; int chunksProcessed = 0; bool wasCancelled = false; };
     ReanalyzeStats ReanalyzeAllChunks(int targetSampleRate, ProgressFn onProgress = nullptr, std::atomic<bool>* cancelFlag = nullptr);
 
@@ -139,34 +493,125 @@ namespace synaptic
 
     // Snapshot serialization (unified for project state and .sbrain files)
     bool SerializeSnapshotToChunk(iplug::IByteChunk& out) const;
+
+    /**
+     * @brief Current contents, safe to read on another thread while this brain keeps changing
+     * Edits made after the call copy the state first, so the snapshot never changes under the reader.
+     */
+    std::shared_ptr<const BrainState> GetStateSnapshot() const;
+    // Snapshot serialization of a given state (same format as SerializeSnapshotToChunk)
+    static bool SerializeStateToChunk(const BrainState& state, bool compact, int windowMode, iplug::IByteChunk& out);
+    // Same snapshot streamed to an open file; contentHash receives BrainRegistry::HashBytes of what was written
+    static bool SerializeStateToFile(const BrainState& state, bool compact, int windowMode, FILE* fp, uint64_t& contentHash);
+    // Analysis window recorded in snapshots (Window::TypeToInt of the current window)
+    int GetWindowMode() const;
     int DeserializeSnapshotFromChunk(const iplug::IByteChunk& in, int startPos, ProgressFn onProgress = nullptr);
+    // Load a snapshot from memory (e.g. a whole .sbrain file) without copying it into a chunk first
+    bool DeserializeSnapshotFromMemory(const void* data, size_t size, ProgressFn onProgress = nullptr);
+
+    /**
+     * @brief Single-file records for the .sbrain journal (BrainJournal.h)
+     * SerializeFileRecord writes one file with its audio and analyzed chunks. ApplyFileRecord adds
+     * such a file to this brain, replacing a file with the same id; it fails (-1) if the record was
+     * chunked with a different chunk size. Returns the position after the record.
+     */
+    static bool SerializeFileRecord(const BrainState& state, int fileId, iplug::IByteChunk& out);
+    int ApplyFileRecord(const iplug::IByteChunk& in, int startPos);
 
     // Accessor for saved analysis window type as stored in snapshot
-    Window::Type GetSavedAnalysisWindowType() const { return mSavedAnalysisWindowType; }
+    Window::Type GetSavedAnalysisWindowType() const { std::lock_guard<std::mutex> lock(mutex_); return mState->savedAnalysisWindowType; }
 
     // Check if the last loaded brain was in compact format
-    bool WasLastLoadedInCompactFormat() const { return mLastLoadedWasCompact; }
+    bool WasLastLoadedInCompactFormat() const { std::lock_guard<std::mutex> lock(mutex_); return mState->lastLoadedWasCompact; }
+
+    /**
+     * @brief Sharing of brains loaded from .sbrain files between plugin instances
+     *
+     * A file is identified by its path plus a hash of its bytes (BrainRegistry::HashBytes).
+     * AdoptShared() replaces this brain's contents with an already-loaded copy of that file,
+     * if another instance holds one. PublishShared() offers this brain's current contents
+     * as the loaded copy of that file. Editing a shared brain detaches it first.
+     */
+    bool AdoptShared(const std::string& path, uint64_t contentHash);
+    void PublishShared(const std::string& path, uint64_t contentHash);
+    // Publish only if this brain still holds @p state (for writes that finish after further edits)
+    void PublishSharedIfCurrent(const std::string& path, uint64_t contentHash, const BrainState* state);
+
+    // True if other Brain instances currently hold the same contents
+    bool IsShared() const;
 
   private:
     static float ComputeRMS(const std::vector<iplug::sample>& buffer, int offset, int count);
     static double ComputeZeroCrossingFreq(const std::vector<iplug::sample>& buffer, int offset, int count, double sampleRate);
     // Analyze the provided chunk over validFrames (<= chunk.audio.numFrames) and fill per-channel and average metrics
-    void AnalyzeChunk(BrainChunk& chunk, int validFrames, double sampleRate);
+    void AnalyzeChunk(BrainChunk& chunk, int validFrames, double sampleRate, const class Window& window);
+    // Build chunk chunkIndexInFile of a file as a view into its audio (analyzed if there is a window)
+    BrainChunk MakeChunkView(const std::shared_ptr<const BrainAudio>& audio, int fileId, int chunkIndexInFile,
+                             int chunkSize, double sampleRate, const class Window* window);
+    // Rebuild a file's contiguous audio from its (overlapping) chunks; returns the frame count
+    static int ReconstructFileAudio(const BrainFile& f, const BrainChunkTable& chunks, int chunkSize,
+                                    std::vector<std::vector<iplug::sample>>& planar);
+
+    // Snapshot body shared by the chunk, file and counting writers (SnapshotIO.h)
+    static void WriteState(SnapshotWriter& out, const BrainState& state, bool compact, int windowMode);
+    bool ReadState(SnapshotReader& in, ProgressFn onProgress);
+    // Compact snapshots: audio is read first, then chunks are analyzed in parallel and each file
+    // becomes visible to matching as soon as it (and every file before it) is done
+    bool ReadCompactState(SnapshotReader& in, uint16_t ver, ProgressFn onProgress);
+    static constexpr int kLoadChunksPerRange = 32;
+    // Add a file and its chunks at the end of the brain (mutex_ held, state detached)
+    void AppendFileLocked(BrainFile f, std::vector<BrainChunk> chunks);
+    // Remove a file and its chunks without publishing (mutex_ held); false if there is no such file
+    bool RemoveFileLocked(int fileId);
+
+    // Copy-on-write: make mState exclusively ours before modifying it in place (mutex_ held)
+    void DetachStateLocked();
+    static ChunkAnalysisSettings CurrentAnalysisSettings(double sampleRate, const class Window* window);
+    // Chunking cache for RechunkAllFiles (mutex_ held)
+    void CacheChunkingLocked(const BrainState& state);
+    bool FindCachedChunkingLocked(const BrainFile& f, int chunkSize, const ChunkAnalysisSettings& analysis,
+                                  std::vector<std::shared_ptr<BrainChunk>>& chunks);
+    /**
+     * Per-file checkpoints of rechunk and reanalysis: a finished file's chunks go to the chunking
+     * cache (while the file is still in the brain) and to the on-disk AnalysisCache, which also
+     * outlives a crash or a closed host. Returns true if the disk entry was written.
+     */
+    bool CheckpointChunking(const BrainFile& f, int chunkSize, const ChunkAnalysisSettings& analysis,
+                            const std::vector<std::shared_ptr<BrainChunk>>& chunks);
+    // Read a file's on-disk checkpoint (chunks sized as RechunkAllFiles slices the file)
+    bool LoadChunkingCheckpoint(const BrainFile& f, int chunkSize, const ChunkAnalysisSettings& analysis,
+                                std::vector<std::shared_ptr<BrainChunk>>& chunks) const;
+    // Install new contents wholesale, leaving any shared copy untouched (mutex_ held)
+    void ReplaceStateLocked(std::shared_ptr<BrainState> state);
+    // Hand the current contents to ReadScope readers; ends every edit (mutex_ held)
+    void PublishLocked();
 
   private:
     mutable std::mutex mutex_;
-    int nextFileId_ = 1;
-    std::vector<BrainFile> files_;
-    std::unordered_map<int, int> idToFileIndex_;
-    std::vector<BrainChunk> chunks_;
-    int mChunkSize = 0;
-    const class Window* mWindow = nullptr;
-    // Saved in snapshot for import; defaults to Hann if unknown
-    Window::Type mSavedAnalysisWindowType = Window::Type::Hann;
-    // Track if the last loaded brain was in compact format (for UI sync)
-    bool mLastLoadedWasCompact = false;
+    std::shared_ptr<BrainState> mState = std::make_shared<BrainState>();
+    std::atomic<uint32_t> mContentVersion { 0 };
+    EpochPublisher<PublishedState> mPublished;
+
+    // One file's chunks from a chunking that RechunkAllFiles replaced, most recent first (mutex_)
+    struct CachedChunking
+    {
+      int fileId = -1;
+      std::shared_ptr<const BrainAudio> audio;
+      int chunkSize = 0;
+      ChunkAnalysisSettings analysis;
+      std::vector<std::shared_ptr<BrainChunk>> chunks;
+    };
+    void AddCachedChunkingLocked(CachedChunking entry);
+    static constexpr int kMaxCachedChunkSizes = 2; // besides layers, which are always kept
+    std::vector<CachedChunking> mChunkingCache;
+    std::vector<int> mLayerChunkSizes; // mutex_
+    std::vector<int> mReadyLayerChunkSizes; // mutex_, as of the last PublishLocked
+    mutable std::mutex mWindowMutex;
+    std::shared_ptr<const class Window> mWindow; // mWindowMutex; replaced, never modified
     // Per-instance compact format setting (default: true for smaller files)
     bool mUseCompactFormat = true;
+    BrainAudio::Encoding mAudioEncoding = BrainAudio::Encoding::Float32;
+    std::atomic<bool> mUseAnalysisCache { false };
   };
 }
 
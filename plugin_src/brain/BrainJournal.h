@@ -0,0 +1,235 @@
+/**
+ * @file BrainJournal.h
+ * @brief Append-only edit log next to an external .sbrain file
+ *
+ * Adding or removing one file used to rewrite the whole .sbrain on the next save. A journaled
+ * brain is the .sbrain (the base snapshot) plus "<path>.journal", a log of add-file and
+ * remove-file records appended since the base was written. Loading replays the journal over the
+ * base; saving appends only what changed. Edits the log can't express (rechunk, reanalyze, a
+ * different format or window) and a log grown past a fraction of the base fall back to a full
+ * rewrite of the base, which also empties the journal (compaction).
+ *
+ * Journal layout: magic, version, hash of the base bytes it applies to, then records of
+ * { u8 op, i32 payload size, u64 payload hash, payload }. A journal written for a different
+ * base is ignored, and replay stops at the first incomplete or damaged record.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "Brain.h"
+#include "BrainRegistry.h"
+
+namespace synaptic
+{
+  class BrainJournal
+  {
+  public:
+    static constexpr uint32_t kMagic = 0x4C4A4253; // 'SBJL' Synaptic Brain JournaL
+    static constexpr uint16_t kVersion = 1;
+    static constexpr int kHeaderBytes = 4 + 2 + 8;
+    // Compact once the journal would exceed this share of the base (but always allow a few MB)
+    static constexpr uint64_t kCompactDivisor = 4;
+    static constexpr uint64_t kMinCompactBytes = 4ull << 20;
+
+    enum class Op : uint8_t { AddFile = 1, RemoveFile = 2 };
+
+    static std::string PathFor(const std::string& brainPath) { return brainPath + ".journal"; }
+
+    /**
+     * @brief What a .sbrain plus its journal on disk currently contain
+     * Files are remembered by the identity of their stored audio, which every edit of a file
+     * replaces, so saving only needs to compare against the live state.
+     */
+    struct Manifest
+    {
+      std::string path;          // empty: unknown, the next save rewrites the base
+      uint64_t baseHash = 0;
+      uint64_t baseBytes = 0;
+      uint64_t journalBytes = 0; // valid journal bytes (0: no journal)
+      uint64_t contentHash = 0;  // base hash chained with every journal record
+      int chunkSize = 0;
+      uint32_t layoutEpoch = 0;
+      bool compact = true;
+      int windowMode = 1;
+      std::map<int, std::weak_ptr<const BrainAudio>> files;
+
+      void Describe(const BrainState& state)
+      {
+        chunkSize = state.chunkSize;
+        layoutEpoch = state.layoutEpoch;
+        files.clear();
+        for (const auto& f : state.files)
+          files[f.id] = f.audio;
+      }
+    };
+
+    static uint64_t Chain(uint64_t hash, Op op, uint64_t payloadHash)
+    {
+      hash ^= payloadHash + 0x9e3779b97f4a7c15ull + (uint64_t) op;
+      hash *= 1099511628211ull;
+      return hash ^ (hash >> 31);
+    }
+
+    /**
+     * @brief Records that turn what @p from describes into @p state
+     * @param next Receives the manifest after appending them
+     * @return false if only a full rewrite can do it (or the journal is due for compaction)
+     */
+    static bool BuildRecords(const Manifest& from, const std::string& path, const BrainState& state, bool compact,
+                             int windowMode, iplug::IByteChunk& records, Manifest& next)
+    {
+      if (from.path.empty() || from.path != path || from.compact != compact || from.windowMode != windowMode
+          || from.chunkSize != state.chunkSize || from.layoutEpoch != state.layoutEpoch)
+        return false;
+
+      next = from;
+      auto append = [&](Op op, const iplug::IByteChunk& payload)
+      {
+        const uint64_t payloadHash = BrainRegistry::HashBytes(payload.GetData(), (size_t) payload.Size());
+        uint8_t opByte = (uint8_t) op;
+        int32_t size = payload.Size();
+        records.Put(&opByte);
+        records.Put(&size);
+        records.Put(&payloadHash);
+        records.PutBytes(payload.GetData(), size);
+        next.contentHash = Chain(next.contentHash, op, payloadHash);
+      };
+
+      // Removals first, so a file id that was reused replays as remove + add
+      for (const auto& entry : from.files)
+      {
+        auto it = state.idToFileIndex.find(entry.first);
+        if (it != state.idToFileIndex.end() && !Changed(entry.second, state.files[it->second]))
+          continue;
+        iplug::IByteChunk payload;
+        int32_t fid = entry.first;
+        payload.Put(&fid);
+        append(Op::RemoveFile, payload);
+      }
+      for (const auto& f : state.files)
+      {
+        auto it = from.files.find(f.id);
+        if (it != from.files.end() && !Changed(it->second, f))
+          continue;
+        iplug::IByteChunk payload;
+        if (!Brain::SerializeFileRecord(state, f.id, payload)) return false;
+        append(Op::AddFile, payload);
+      }
+
+      const uint64_t limit = std::max(kMinCompactBytes, from.baseBytes / kCompactDivisor);
+      const uint64_t header = from.journalBytes ? 0 : (uint64_t) kHeaderBytes;
+      if (from.journalBytes + header + (uint64_t) records.Size() > limit)
+        return false;
+      next.journalBytes = records.Size() ? from.journalBytes + header + (uint64_t) records.Size() : from.journalBytes;
+      next.Describe(state);
+      return true;
+    }
+
+    /**
+     * @brief Append records to the journal of @p m (starting a new journal if it has none)
+     * @return false if the journal on disk isn't the one @p m describes or the write failed
+     */
+    static bool Append(const Manifest& m, const iplug::IByteChunk& records)
+    {
+      if (records.Size() == 0) return true;
+      const std::string journalPath = PathFor(m.path);
+      FILE* fp = nullptr;
+      if (m.journalBytes == 0)
+      {
+        iplug::IByteChunk header;
+        header.Put(&kMagic);
+        header.Put(&kVersion);
+        header.Put(&m.baseHash);
+        fp = fopen(journalPath.c_str(), "wb");
+        if (!fp) return false;
+        if (fwrite(header.GetData(), 1, (size_t) header.Size(), fp) != (size_t) header.Size())
+        {
+          fclose(fp);
+          return false;
+        }
+      }
+      else
+      {
+        // A torn tail (crash mid-append) or foreign writer: let a full rewrite sort it out
+        uint64_t size = 0;
+        int64_t mtime = 0;
+        if (!BrainRegistry::StatFile(journalPath, size, mtime) || size != m.journalBytes) return false;
+        fp = fopen(journalPath.c_str(), "ab");
+        if (!fp) return false;
+      }
+      const bool written = fwrite(records.GetData(), 1, (size_t) records.Size(), fp) == (size_t) records.Size();
+      const bool flushed = fflush(fp) == 0;
+      const bool closed = fclose(fp) == 0;
+      return written && flushed && closed;
+    }
+
+    /**
+     * @brief Check a journal against the base it should apply to
+     * @param contentHash Receives the base hash chained with every valid record
+     * @return Bytes of the journal that are valid (0 if it belongs to another base)
+     */
+    static int Scan(const iplug::IByteChunk& journal, uint64_t baseHash, uint64_t& contentHash)
+    {
+      contentHash = baseHash;
+      int pos = 0;
+      uint32_t magic = 0; pos = journal.Get(&magic, pos); if (pos < 0 || magic != kMagic) return 0;
+      uint16_t ver = 0; pos = journal.Get(&ver, pos); if (pos < 0 || ver > kVersion) return 0;
+      uint64_t forBase = 0; pos = journal.Get(&forBase, pos); if (pos < 0 || forBase != baseHash) return 0;
+
+      int valid = pos;
+      uint64_t hash = baseHash;
+      while (pos < journal.Size())
+      {
+        uint8_t op = 0; pos = journal.Get(&op, pos); if (pos < 0) break;
+        int32_t size = 0; pos = journal.Get(&size, pos); if (pos < 0 || size < 0) break;
+        uint64_t payloadHash = 0; pos = journal.Get(&payloadHash, pos); if (pos < 0) break;
+        if (size > journal.Size() - pos) break;
+        if (op != (uint8_t) Op::AddFile && op != (uint8_t) Op::RemoveFile) break;
+        if (BrainRegistry::HashBytes(journal.GetData() + pos, (size_t) size) != payloadHash) break;
+        pos += size;
+        hash = Chain(hash, (Op) op, payloadHash);
+        valid = pos;
+        contentHash = hash;
+      }
+      return valid;
+    }
+
+    /** @brief Apply the first @p validBytes of a journal (as returned by Scan) to @p brain */
+    static bool Replay(Brain& brain, const iplug::IByteChunk& journal, int validBytes)
+    {
+      int pos = kHeaderBytes;
+      while (pos < validBytes)
+      {
+        uint8_t op = 0; pos = journal.Get(&op, pos);
+        int32_t size = 0; pos = journal.Get(&size, pos);
+        uint64_t payloadHash = 0; pos = journal.Get(&payloadHash, pos);
+        if (pos < 0) return false;
+        if (op == (uint8_t) Op::RemoveFile)
+        {
+          int32_t fid = 0;
+          if (journal.Get(&fid, pos) < 0) return false;
+          brain.RemoveFile(fid);
+        }
+        else if (brain.ApplyFileRecord(journal, pos) != pos + size)
+        {
+          return false;
+        }
+        pos += size;
+      }
+      return true;
+    }
+
+  private:
+    static bool Changed(const std::weak_ptr<const BrainAudio>& known, const BrainFile& f)
+    {
+      return known.lock() != f.audio;
+    }
+  };
+}
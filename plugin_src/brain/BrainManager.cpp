@@ -1,4 +1,5 @@
 #include "BrainManager.h"
+#include "BrainRegistry.h"
 #include "plugin_src/PlatformFileDialogs.h"
 #include "SynapticResynthesis.h"
 #include "IPlugStructs.h"
@@ -9,31 +10,18 @@
 
 namespace synaptic
 {
-  BrainManager::BrainManager(Brain* brain, Window* analysisWindow)
+  BrainManager::BrainManager(Brain* brain)
     : mBrain(brain)
-    , mAnalysisWindow(analysisWindow)
   {
   }
 
   BrainManager::~BrainManager()
   {
-    // Ensure all background threads are joined before destruction
-    RequestCancellation();
-
-    std::lock_guard<std::mutex> lock(mThreadMutex);
-    for (auto& t : mActiveThreads)
-    {
-      if (t.joinable())
-        t.join();
-    }
-  }
-
-  void BrainManager::LaunchThread(std::function<void()> task)
-  {
-    std::lock_guard<std::mutex> lock(mThreadMutex);
+    // Pending saves must reach disk; their completion callbacks still use this object
+    mWriter.Flush();
 
-    // Store the task in the active threads vector to avoid unbounded growth
-    mActiveThreads.emplace_back(std::move(task));
+    // Stop running operations early; mTasks drops queued ones and joins its workers
+    RequestCancellation();
   }
 
   void BrainManager::RemoveFile(int fileId)
@@ -49,10 +37,10 @@ namespace synaptic
     if (!mBrain) return;
 
     mBrain->Reset();
-    mBrain->SetWindow(mAnalysisWindow);
     mUseExternalBrain = false;
     mExternalBrainPath.clear();
     mBrainDirty = false;
+    OpenResumableImport(std::string());
   }
 
   void BrainManager::Detach()
@@ -65,10 +53,11 @@ namespace synaptic
     if (mBrain)
     {
       mBrain->Reset();
-      mBrain->SetWindow(mAnalysisWindow);
     }
+    OpenResumableImport(std::string());
 
     mBrainDirty = false;
+    mExternalChanged = false;
   }
 
   void BrainManager::SetExternalRef(const std::string& path, bool useExternal)
@@ -89,49 +78,8 @@ namespace synaptic
       return;
     }
 
-    // Check if already running
-    if (mOperationInProgress.exchange(true))
-    {
-      DBGMSG("Rechunk request ignored: already running.\n");
-      return;
-    }
-
-    // Reset cancellation flag before starting
-    ResetCancellationFlag();
-
-    LaunchThread([this, newChunkSize, sampleRate, onProgress, onComplete]()
-    {
-      // Brain's RechunkAllFiles now reports per-chunk progress with (fileName, currentChunk, totalChunks)
-      auto stats = mBrain->RechunkAllFiles(newChunkSize, sampleRate,
-        [onProgress](const std::string& displayName, int current, int total)
-        {
-          if (onProgress)
-            onProgress(displayName, current, total);
-        },
-        &mCancellationRequested);
-
-      if (stats.wasCancelled)
-      {
-        DBGMSG("Brain Rechunk: CANCELLED by user\n");
-      }
-      else
-      {
-        DBGMSG("Brain Rechunk: processed=%d, rechunked=%d, totalChunks=%d\n",
-               stats.filesProcessed, stats.filesRechunked, stats.newTotalChunks);
-      }
-
-      if (!stats.wasCancelled)
-      {
-        mBrainDirty = true;
-      }
-
-      // Call completion callback with cancellation status
-      // Note: Keep mOperationInProgress true during callback to prevent OnParamChange from retriggering operations during rollback
-      if (onComplete)
-        onComplete(stats.wasCancelled);
-
-      mOperationInProgress = false;  // Clear flag AFTER callback completes
-    });
+    mRequestedChunkSize = newChunkSize;
+    SubmitAnalysis(sampleRate, std::move(onProgress), std::move(onComplete));
   }
 
   void BrainManager::ReanalyzeAllChunksAsync(int sampleRate, ProgressFn onProgress, CompletionFn onComplete)
@@ -146,56 +94,73 @@ namespace synaptic
       return;
     }
 
-    // Check if already running
-    if (mOperationInProgress.exchange(true))
-    {
-      DBGMSG("Reanalyze request ignored: already running.\n");
-      return;
-    }
+    SubmitAnalysis(sampleRate, std::move(onProgress), std::move(onComplete));
+  }
+
+  void BrainManager::SubmitAnalysis(int sampleRate, ProgressFn onProgress, CompletionFn onComplete)
+  {
+    mTasks.Submit(kAnalysisTaskKey, BrainTaskQueue::Priority::High, true,
+      [this, sampleRate, onProgress](std::atomic<bool>& cancel)
+      {
+        return RunAnalysis(sampleRate, onProgress, cancel);
+      },
+      [this, onComplete](bool wasCancelled)
+      {
+        // The brain kept its chunk size; the callback rolls the parameter back
+        if (wasCancelled)
+          mRequestedChunkSize = -1;
 
-    // Reset cancellation flag before starting
-    ResetCancellationFlag();
+        // Note: IsCompletingOperation() is true during the callback, so OnParamChange doesn't retrigger operations during rollback
+        if (onComplete)
+          onComplete(wasCancelled);
+      });
+  }
 
-    LaunchThread([this, sampleRate, onProgress, onComplete]()
+  bool BrainManager::RunAnalysis(int sampleRate, const ProgressFn& onProgress, std::atomic<bool>& cancel)
+  {
+    auto progress = [&onProgress](const std::string& displayName, int current, int total)
     {
-      // Brain's ReanalyzeAllChunks now reports per-chunk progress with (fileName, currentChunk, totalChunks)
-      auto stats = mBrain->ReanalyzeAllChunks(sampleRate,
-        [onProgress](const std::string& displayName, int current, int total)
-        {
-          if (onProgress)
-            onProgress(displayName, current, total);
-        },
-        &mCancellationRequested);
+      if (onProgress)
+        onProgress(displayName, current, total);
+    };
 
+    // A rechunk also reanalyzes every chunk with the current window, so it covers both requests
+    int chunkSize = mRequestedChunkSize.load();
+    if (chunkSize > 0 && chunkSize != mBrain->GetChunkSize())
+    {
+      // Brain's RechunkAllFiles reports per-chunk progress with (fileName, currentChunk, totalChunks)
+      auto stats = mBrain->RechunkAllFiles(chunkSize, sampleRate, progress, &cancel);
       if (stats.wasCancelled)
       {
-        DBGMSG("Brain Reanalyze: CANCELLED by user\n");
-      }
-      else
-      {
-        DBGMSG("Brain Reanalyze: files=%d chunks=%d\n", stats.filesProcessed, stats.chunksProcessed);
+        DBGMSG("Brain Rechunk: stopped (cancelled or superseded)\n");
+        return true;
       }
+      DBGMSG("Brain Rechunk: processed=%d, rechunked=%d, totalChunks=%d\n",
+             stats.filesProcessed, stats.filesRechunked, stats.newTotalChunks);
+      mBrainDirty = true;
+      BuildLayersAsync();
+      mRequestedChunkSize.compare_exchange_strong(chunkSize, -1); // unless a newer size was requested
+      return false;
+    }
 
-      if (!stats.wasCancelled)
-      {
-        mBrainDirty = true;
-      }
-
-      // Call completion callback with cancellation status
-      // Note: Keep mOperationInProgress true during callback to prevent OnParamChange from retriggering operations during rollback
-      if (onComplete)
-        onComplete(stats.wasCancelled);
-
-      mOperationInProgress = false;  // Clear flag AFTER callback completes
-    });
+    auto stats = mBrain->ReanalyzeAllChunks(sampleRate, progress, &cancel);
+    if (stats.wasCancelled)
+    {
+      DBGMSG("Brain Reanalyze: stopped (cancelled or superseded)\n");
+      return true;
+    }
+    DBGMSG("Brain Reanalyze: files=%d chunks=%d\n", stats.filesProcessed, stats.chunksProcessed);
+    mBrainDirty = true;
+    BuildLayersAsync();
+    return false;
   }
 
   void BrainManager::ExportToFileAsync(ProgressFn onProgress, CompletionFn onComplete)
   {
     if (!mBrain) return;
 
-    // Move to background thread to avoid blocking the UI thread with native dialogs
-    LaunchThread([this, onProgress, onComplete]()
+    // Run on a worker to avoid blocking the UI thread with native dialogs (reads the brain only, so not exclusive)
+    mTasks.Submit(std::string(), BrainTaskQueue::Priority::High, false, [this, onProgress, onComplete](std::atomic<bool>&)
     {
       // Show initial progress (0 of 2) - waiting for file selection
       if (onProgress)
@@ -210,24 +175,16 @@ namespace synaptic
         // User cancelled - call completion without progress
         if (onComplete)
           onComplete(false);
-        return;
+        return false;
       }
 
       // File selected - update progress (1 of 2 = 50%)
       if (onProgress)
         onProgress("Exporting brain...", 1, 2);
 
-      // Serialize brain to chunk
-      iplug::IByteChunk blob;
-      mBrain->SerializeSnapshotToChunk(blob);
-
-      // Write to file
-      FILE* fp = fopen(savePath.c_str(), "wb");
-      if (fp)
+      // Serialize brain and write to file
+      if (SaveExternalFile(savePath))
       {
-        fwrite(blob.GetData(), 1, (size_t)blob.Size(), fp);
-        fclose(fp);
-
         mExternalBrainPath = savePath;
         mUseExternalBrain = true;
         mBrainDirty = false;
@@ -235,16 +192,228 @@ namespace synaptic
 
       if (onComplete)
         onComplete(false);  // Export doesn't support cancellation yet
-
+      return false;
     });
   }
 
+  static bool ReadWholeFile(const std::string& path, std::vector<char>& data)
+  {
+    FILE* fp = fopen(path.c_str(), "rb");
+    if (!fp) return false;
+
+    fseek(fp, 0, SEEK_END);
+    long sz = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    data.resize((size_t) std::max(0L, sz));
+    const size_t got = fread(data.data(), 1, data.size(), fp);
+    fclose(fp);
+    data.resize(got);
+    return true;
+  }
+
+  bool BrainManager::LoadExternalFile(const std::string& path, Brain::ProgressFn onProgress)
+  {
+    if (!mBrain || path.empty()) return false;
+    auto& registry = BrainRegistry::Instance();
+
+    // A save of this file may still be in flight; read what it writes, not the old file
+    mWriter.Flush(path);
+
+    // Unchanged since we last hashed them: match without reading the files
+    const std::string journalPath = BrainJournal::PathFor(path);
+    uint64_t size = 0, journalSize = 0, baseHash = 0, hash = 0;
+    int64_t mtime = 0, journalMtime = 0;
+    const bool haveStat = BrainRegistry::StatFile(path, size, mtime);
+    const bool haveJournal = BrainRegistry::StatFile(journalPath, journalSize, journalMtime);
+    if (haveStat && registry.LookupFileHash(path, size, mtime, baseHash))
+    {
+      hash = baseHash;
+      const bool known = !haveJournal || registry.LookupFileHash(journalPath, journalSize, journalMtime, hash);
+      if (known && mBrain->AdoptShared(path, hash))
+      {
+        SetOnDisk(path, baseHash, size, haveJournal ? journalSize : 0, hash);
+        BuildLayersAsync();
+        OpenResumableImport(path);
+        return true;
+      }
+    }
+
+    std::vector<char> data;
+    if (!ReadWholeFile(path, data)) return false;
+    const uint64_t baseBytes = data.size();
+    baseHash = BrainRegistry::HashBytes(data.data(), data.size());
+    if (haveStat)
+      registry.RememberFileHash(path, size, mtime, baseHash);
+
+    // Edits journaled since the base was written (ignored if written for another base)
+    iplug::IByteChunk journal;
+    int journalValid = 0;
+    hash = baseHash;
+    std::vector<char> journalData;
+    if (haveJournal && ReadWholeFile(journalPath, journalData))
+    {
+      journal.PutBytes(journalData.data(), (int) journalData.size());
+      std::vector<char>().swap(journalData);
+      journalValid = BrainJournal::Scan(journal, baseHash, hash);
+      // Only a journal that is valid to the end can be matched by size and mtime later
+      if (journalValid > 0 && journalValid == journal.Size())
+        registry.RememberFileHash(journalPath, journalSize, journalMtime, hash);
+    }
+
+    if (!mBrain->AdoptShared(path, hash))
+    {
+      if (!mBrain->DeserializeSnapshotFromMemory(data.data(), data.size(), onProgress))
+        return false;
+
+      if (journalValid > 0 && !BrainJournal::Replay(*mBrain, journal, journalValid))
+      {
+        // Records that passed their checks but don't fit the base: keep the base alone
+        DBGMSG("Brain journal for %s could not be applied; using the base file only\n", path.c_str());
+        if (!mBrain->DeserializeSnapshotFromMemory(data.data(), data.size(), onProgress))
+          return false;
+        journalValid = 0;
+        hash = baseHash;
+      }
+      mBrain->PublishShared(path, hash);
+    }
+
+    SetOnDisk(path, baseHash, baseBytes, (uint64_t) journalValid, hash);
+    BuildLayersAsync();
+    OpenResumableImport(path);
+    return true;
+  }
+
+  void BrainManager::SetOnDisk(const std::string& path, uint64_t baseHash, uint64_t baseBytes, uint64_t journalBytes,
+                               uint64_t contentHash)
+  {
+    const auto state = mBrain->GetStateSnapshot();
+    {
+      std::lock_guard<std::mutex> lock(mOnDiskMutex);
+      mOnDisk = BrainJournal::Manifest();
+      mOnDisk.path = path;
+      mOnDisk.baseHash = baseHash;
+      mOnDisk.baseBytes = baseBytes;
+      mOnDisk.journalBytes = journalBytes;
+      mOnDisk.contentHash = contentHash;
+      mOnDisk.compact = state->lastLoadedWasCompact;
+      mOnDisk.windowMode = Window::TypeToInt(state->savedAnalysisWindowType);
+      mOnDisk.Describe(*state);
+    }
+    mExternalContentHash = contentHash;
+    mExternalChanged = false;
+  }
+
+  bool BrainManager::SaveExternalFile(const std::string& path)
+  {
+    if (!mBrain || path.empty()) return false;
+
+    // Keep writes to one file in order: an older background save must not land after this one
+    mWriter.Flush(path);
+
+    const auto state = mBrain->GetStateSnapshot();
+    uint64_t hash = 0;
+    {
+      std::lock_guard<std::mutex> lock(mOnDiskMutex);
+      if (!WriteExternalBaseLocked(path, *state, mBrain->GetUseCompactFormat(), mBrain->GetWindowMode(), hash))
+        return false;
+    }
+
+    OnExternalFileWritten(path, hash, state.get());
+    return true;
+  }
+
+  void BrainManager::SaveExternalFileAsync(const std::string& path)
+  {
+    if (!mBrain || path.empty()) return;
+
+    const auto state = mBrain->GetStateSnapshot();
+    const BrainState* written = state.get();
+    const bool compact = mBrain->GetUseCompactFormat();
+    const int windowMode = mBrain->GetWindowMode();
+    mBrainDirty = false;
+    mWriter.Enqueue(path,
+      [this, path, state, compact, windowMode](uint64_t& hash)
+      {
+        return WriteExternalState(path, *state, compact, windowMode, hash);
+      },
+      [this, path, written](bool ok, uint64_t hash)
+      {
+        if (ok)
+          OnExternalFileWritten(path, hash, written);
+        else
+          mBrainDirty = true; // retry on the next project save
+      });
+  }
+
+  bool BrainManager::WriteExternalState(const std::string& path, const BrainState& state, bool compact, int windowMode,
+                                        uint64_t& hash)
+  {
+    std::lock_guard<std::mutex> lock(mOnDiskMutex);
+
+    // Diffed here rather than when queued, so it builds on every earlier write of this path
+    iplug::IByteChunk records;
+    BrainJournal::Manifest next;
+    if (BrainJournal::BuildRecords(mOnDisk, path, state, compact, windowMode, records, next)
+        && BrainJournal::Append(mOnDisk, records))
+    {
+      if (records.Size() > 0)
+      {
+        const std::string journalPath = BrainJournal::PathFor(path);
+        uint64_t size = 0;
+        int64_t mtime = 0;
+        if (BrainRegistry::StatFile(journalPath, size, mtime))
+          BrainRegistry::Instance().RememberFileHash(journalPath, size, mtime, next.contentHash);
+      }
+      mOnDisk = std::move(next);
+      hash = mOnDisk.contentHash;
+      return true;
+    }
+
+    // Not expressible as a journal, journal due for compaction, or the append failed
+    return WriteExternalBaseLocked(path, state, compact, windowMode, hash);
+  }
+
+  bool BrainManager::WriteExternalBaseLocked(const std::string& path, const BrainState& state, bool compact,
+                                             int windowMode, uint64_t& hash)
+  {
+    if (!BrainWriter::WriteState(path, state, compact, windowMode, hash))
+      return false;
+
+    // The old journal names the old base's hash, so even if removal fails it is never replayed
+    std::remove(BrainJournal::PathFor(path).c_str());
+
+    mOnDisk = BrainJournal::Manifest();
+    mOnDisk.path = path;
+    mOnDisk.baseHash = hash;
+    mOnDisk.contentHash = hash;
+    mOnDisk.compact = compact;
+    mOnDisk.windowMode = windowMode;
+    mOnDisk.Describe(state);
+
+    uint64_t size = 0;
+    int64_t mtime = 0;
+    if (BrainRegistry::StatFile(path, size, mtime))
+    {
+      mOnDisk.baseBytes = size;
+      BrainRegistry::Instance().RememberFileHash(path, size, mtime, hash);
+    }
+    return true;
+  }
+
+  void BrainManager::OnExternalFileWritten(const std::string& path, uint64_t hash, const BrainState* state)
+  {
+    // What is on disk now is exactly that state, so later loads of this file can share it
+    mBrain->PublishSharedIfCurrent(path, hash, state);
+    mExternalContentHash = hash;
+    mExternalChanged = false;
+  }
+
   void BrainManager::ImportFromFileAsync(ProgressFn onProgress, CompletionFn onComplete)
   {
     if (!mBrain) return;
 
-    // Native Open dialog; C++ reads file directly
-    LaunchThread([this, onProgress, onComplete]()
+    // Native Open dialog; C++ reads file directly (replaces the brain, so exclusive)
+    mTasks.Submit(std::string(), BrainTaskQueue::Priority::High, true, [this, onProgress, onComplete](std::atomic<bool>&)
     {
       // Show initial progress (0 of 2) - waiting for file selection
       if (onProgress)
@@ -256,45 +425,28 @@ namespace synaptic
         // User cancelled
         if (onComplete)
           onComplete(false);
-        return;
+        return false;
       }
 
       // File selected - update progress (1 of 3 = ~33%)
       if (onProgress)
         onProgress("Reading brain file...", 1, 3);
 
-      // Read file
-      FILE* fp = fopen(openPath.c_str(), "rb");
-      if (!fp)
-      {
-        if (onComplete)
-          onComplete(false);
-        return;
-      }
-
-      fseek(fp, 0, SEEK_END);
-      long sz = ftell(fp);
-      fseek(fp, 0, SEEK_SET);
-      std::vector<char> data;
-      data.resize((size_t)sz);
-      fread(data.data(), 1, (size_t)sz, fp);
-      fclose(fp);
-
-      // Show initial loading progress
-      if (onProgress)
-        onProgress("Loading brain data...", 2, 3);
-
-      // Deserialize with progress callback for compact brain rechunking/analysis
-      iplug::IByteChunk in;
-      in.PutBytes(data.data(), (int)data.size());
-      mBrain->DeserializeSnapshotFromChunk(in, 0,
+      // Read and deserialize (or adopt another instance's copy of the same file),
+      // with progress callback for compact brain rechunking/analysis
+      const bool loaded = LoadExternalFile(openPath,
         [onProgress](const std::string& fileName, int current, int total)
         {
           // For compact brains, this shows rechunking and analysis progress
           if (onProgress)
             onProgress("Rechunking & Analyzing: " + fileName, current, total);
         });
-      mBrain->SetWindow(mAnalysisWindow);
+      if (!loaded)
+      {
+        if (onComplete)
+          onComplete(false);
+        return false;
+      }
 
       mExternalBrainPath = openPath;
       mUseExternalBrain = true;
@@ -309,7 +461,7 @@ namespace synaptic
 
       if (onComplete)
         onComplete(false);  // Import doesn't support cancellation yet
-
+      return false;
     });
   }
 
@@ -317,8 +469,8 @@ namespace synaptic
   {
     if (!mBrain) return;
 
-    // Move to background thread to avoid blocking the UI thread with native dialogs
-    LaunchThread([this, onProgress, onComplete]()
+    // Run on a worker to avoid blocking the UI thread with native dialogs (replaces the brain, so exclusive)
+    mTasks.Submit(std::string(), BrainTaskQueue::Priority::High, true, [this, onProgress, onComplete](std::atomic<bool>&)
     {
       // Show initial progress (0 of 2) - waiting for file selection
       if (onProgress)
@@ -333,7 +485,7 @@ namespace synaptic
         // User cancelled - call completion without progress
         if (onComplete)
           onComplete(false);
-        return;
+        return false;
       }
 
       // File selected - update progress (1 of 2 = 50%)
@@ -342,19 +494,11 @@ namespace synaptic
 
       // Reset brain to empty state (clear all files and chunks)
       mBrain->Reset();
-      mBrain->SetWindow(mAnalysisWindow);
+      OpenResumableImport(std::string());
 
-      // Serialize empty brain to chunk
-      iplug::IByteChunk blob;
-      mBrain->SerializeSnapshotToChunk(blob);
-
-      // Write to file
-      FILE* fp = fopen(savePath.c_str(), "wb");
-      if (fp)
+      // Serialize empty brain and write to file
+      if (SaveExternalFile(savePath))
       {
-        fwrite(blob.GetData(), 1, (size_t)blob.Size(), fp);
-        fclose(fp);
-
         mExternalBrainPath = savePath;
         mUseExternalBrain = true;
         mBrainDirty = false;
@@ -362,7 +506,7 @@ namespace synaptic
 
       if (onComplete)
         onComplete(false);  // Create new doesn't support cancellation yet
-
+      return false;
     });
   }
 
@@ -371,101 +515,216 @@ namespace synaptic
   {
     if (!mBrain) return;
 
-    const int totalFiles = (int)files.size();
-    if (totalFiles == 0)
+    if (files.empty())
     {
       if (onComplete) onComplete(false);
       return;
     }
 
-    // Check if already running
-    if (mOperationInProgress.exchange(true))
+    auto job = std::make_shared<ImportJob>();
+    job->files = std::move(files);
+    job->brainPath = mUseExternalBrain ? mExternalBrainPath : std::string();
     {
-      DBGMSG("AddMultipleFiles request ignored: already running.\n");
-      return;
+      // A new import replaces what was left of the previous one
+      std::lock_guard<std::mutex> lock(mImportMutex);
+      if (mResumableImport)
+        mResumableImport->checkpoint.Remove();
+      mResumableImport.reset();
     }
+    SubmitImport(std::move(job), sampleRate, channels, chunkSize, std::move(onProgress), std::move(onComplete));
+  }
+
+  int BrainManager::GetResumableImportCount() const
+  {
+    std::lock_guard<std::mutex> lock(mImportMutex);
+    return mResumableImport ? (int) (mResumableImport->files.size() - mResumableImport->next) : 0;
+  }
 
-    // Reset cancellation flag before starting
-    ResetCancellationFlag();
+  void BrainManager::ResumeImportAsync(int sampleRate, int channels, int chunkSize, ProgressFn onProgress,
+                                       CompletionFn onComplete)
+  {
+    std::shared_ptr<ImportJob> job;
+    {
+      std::lock_guard<std::mutex> lock(mImportMutex);
+      job = std::move(mResumableImport);
+    }
+    if (!mBrain || !job)
+    {
+      if (onComplete) onComplete(false);
+      return;
+    }
+    SubmitImport(std::move(job), sampleRate, channels, chunkSize, std::move(onProgress), std::move(onComplete));
+  }
 
-    LaunchThread([this, files = std::move(files), sampleRate, channels, chunkSize, totalFiles, onProgress, onComplete]() mutable
+  void BrainManager::OpenResumableImport(const std::string& brainPath)
+  {
+    std::shared_ptr<ImportJob> job;
+    if (!brainPath.empty())
     {
-      // Pre-scan files to estimate total chunks for cumulative progress tracking
-      int estimatedTotalChunks = 0;
+      job = std::make_shared<ImportJob>();
+      job->brainPath = brainPath;
+      if (!job->checkpoint.Open(brainPath, job->files))
+        job.reset();
+    }
 
-      for (auto& fileData : files)
+    std::lock_guard<std::mutex> lock(mImportMutex);
+    // The previous brain's leftovers stay on disk for when it is loaded again
+    if (mResumableImport)
+      mResumableImport->checkpoint.Close();
+    mResumableImport = std::move(job);
+  }
+
+  void BrainManager::SubmitImport(std::shared_ptr<ImportJob> job, int sampleRate, int channels, int chunkSize,
+                                  ProgressFn onProgress, CompletionFn onComplete)
+  {
+    // Queued behind any running operation; RequestCancellation also stops it before it starts
+    mTasks.Submit(std::string(), BrainTaskQueue::Priority::Normal, true,
+      [this, job, sampleRate, channels, chunkSize, onProgress](std::atomic<bool>& cancel)
       {
-        // Decode to get length without full processing
-        ma_decoder_config config = ma_decoder_config_init(ma_format_f32, (ma_uint32)channels, (ma_uint32)sampleRate);
-        ma_decoder decoder;
-        ma_uint64 frameCount = 0;
+        return RunImport(job, sampleRate, channels, chunkSize, onProgress, cancel);
+      }, std::move(onComplete));
+  }
 
-        if (ma_decoder_init_memory(fileData.data.data(), fileData.data.size(), &config, &decoder) == MA_SUCCESS)
+  bool BrainManager::RunImport(const std::shared_ptr<ImportJob>& jobPtr, int sampleRate, int channels, int chunkSize,
+                               const ProgressFn& onProgress, std::atomic<bool>& cancel)
+  {
+    ImportJob& job = *jobPtr;
+    // Files not in the brain yet are checkpointed until they are (external brains only: an
+    // inline brain only reaches disk with the project, so its leftovers can't outlive the session)
+    if (!job.brainPath.empty() && !job.checkpoint.IsOpen() && job.next == 0)
+      job.checkpoint.Create(job.brainPath, job.files);
+
+    // Pre-scan files to estimate total chunks for cumulative progress tracking
+    int estimatedTotalChunks = 0;
+
+    for (size_t i = job.next; i < job.files.size(); ++i)
+    {
+      auto& fileData = job.files[i];
+      // Decode to get length without full processing
+      ma_decoder_config config = ma_decoder_config_init(ma_format_f32, (ma_uint32)channels, (ma_uint32)sampleRate);
+      ma_decoder decoder;
+      ma_uint64 frameCount = 0;
+
+      if (ma_decoder_init_memory(fileData.data.data(), fileData.data.size(), &config, &decoder) == MA_SUCCESS)
+      {
+        if (ma_decoder_get_length_in_pcm_frames(&decoder, &frameCount) == MA_SUCCESS)
         {
-          if (ma_decoder_get_length_in_pcm_frames(&decoder, &frameCount) == MA_SUCCESS)
-          {
-            estimatedTotalChunks += Brain::EstimateChunkCount((int)frameCount, chunkSize);
-          }
-          else
-          {
-            estimatedTotalChunks += 10; // fallback estimate if frame count unavailable
-          }
-          ma_decoder_uninit(&decoder);
+          estimatedTotalChunks += Brain::EstimateChunkCount((int)frameCount, chunkSize);
         }
         else
         {
-          estimatedTotalChunks += 10; // fallback estimate if decode fails
+          estimatedTotalChunks += 10; // fallback estimate if frame count unavailable
         }
+        ma_decoder_uninit(&decoder);
       }
+      else
+      {
+        estimatedTotalChunks += 10; // fallback estimate if decode fails
+      }
+    }
 
-      int cumulativeChunks = 0;
+    int cumulativeChunks = 0;
 
-      // Import files with cumulative progress tracking
-      for (auto& fileData : files)
+    // Import files with cumulative progress tracking
+    for (; job.next < job.files.size(); ++job.next)
+    {
+      // Check for cancellation before processing each file
+      if (cancel.load())
       {
-        // Check for cancellation before processing each file
-        if (mCancellationRequested.load())
-        {
-          DBGMSG("Multi-file import CANCELLED by user after %d files\n", (int)(&fileData - &files[0]));
-          break;
-        }
+        DBGMSG("Multi-file import CANCELLED by user, %d files left\n", (int)(job.files.size() - job.next));
+        break;
+      }
 
-        // Import file with per-chunk progress callback that reports cumulative progress
-        int newId = mBrain->AddAudioFileFromMemory(
-          fileData.data.data(),
-          fileData.data.size(),
-          fileData.name,
-          sampleRate,
-          channels,
-          chunkSize,
-          [&fileData, &cumulativeChunks, estimatedTotalChunks, onProgress](const std::string& fileName, int currentChunk, int totalChunksInFile)
+      auto& fileData = job.files[job.next];
+
+      // Import file with per-chunk progress callback that reports cumulative progress
+      int newId = mBrain->AddAudioFileFromMemory(
+        fileData.data.data(),
+        fileData.data.size(),
+        fileData.name,
+        sampleRate,
+        channels,
+        chunkSize,
+        [&fileData, &cumulativeChunks, estimatedTotalChunks, onProgress](const std::string& fileName, int currentChunk, int totalChunksInFile)
+        {
+          // Report cumulative progress across all files
+          if (onProgress)
           {
-            // Report cumulative progress across all files
-            if (onProgress)
-            {
-              ++cumulativeChunks;
-              onProgress(fileData.name, cumulativeChunks, estimatedTotalChunks);
-            }
-          },
-          &mCancellationRequested
-        );
-
-        if (newId >= 0)
+            ++cumulativeChunks;
+            onProgress(fileData.name, cumulativeChunks, estimatedTotalChunks);
+          }
+        },
+        &cancel
+      );
+
+      // Stopped inside this file: it stays in the job
+      if (newId < 0 && cancel.load())
+        break;
+
+      if (newId >= 0)
+      {
+        mBrainDirty = true;
+        // Commit the file to the external brain (a journal append) before dropping its checkpoint
+        if (!job.brainPath.empty())
         {
-          mBrainDirty = true;
+          SaveExternalFileAsync(job.brainPath);
+          mWriter.Flush(job.brainPath);
         }
-
-        DBGMSG("Imported file: %s (id=%d)\n", fileData.name.c_str(), newId);
       }
 
-      // Check if any file was cancelled (if we broke out of loop early due to cancellation)
-      bool wasCancelled = mCancellationRequested.load();
+      // Files that failed to decode are dropped too; retrying them would fail again
+      job.checkpoint.MarkImported((int) job.next);
+      std::vector<uint8_t>().swap(fileData.data);
+      DBGMSG("Imported file: %s (id=%d)\n", fileData.name.c_str(), newId);
+    }
 
-      // Call completion callback with cancellation status
-      if (onComplete)
-        onComplete(wasCancelled);
+    // Files that did get added are layered even if the rest was cancelled
+    BuildLayersAsync();
 
-      mOperationInProgress = false;
-    });
+    const bool finished = job.next >= job.files.size();
+    if (finished)
+      job.checkpoint.Remove();
+    {
+      std::lock_guard<std::mutex> lock(mImportMutex);
+      if (!finished && !mResumableImport)
+        mResumableImport = jobPtr;
+    }
+
+    // Check if any file was cancelled (if we broke out of loop early due to cancellation)
+    return cancel.load();
+  }
+
+  void BrainManager::SetLayerChunkSizes(std::vector<int> chunkSizes)
+  {
+    if (!mBrain) return;
+    mBrain->SetLayerChunkSizes(std::move(chunkSizes));
+    BuildLayersAsync();
+  }
+
+  void BrainManager::SetLayerEnabled(int chunkSize, bool enabled)
+  {
+    auto sizes = GetLayerChunkSizes();
+    sizes.erase(std::remove(sizes.begin(), sizes.end(), chunkSize), sizes.end());
+    if (enabled) sizes.push_back(chunkSize);
+    SetLayerChunkSizes(std::move(sizes));
+  }
+
+  void BrainManager::SetAnalysisSampleRate(int sampleRate)
+  {
+    if (mLayerSampleRate.exchange(sampleRate) != sampleRate)
+      BuildLayersAsync();
+  }
+
+  void BrainManager::BuildLayersAsync()
+  {
+    const int sampleRate = mLayerSampleRate.load();
+    if (!mBrain || sampleRate <= 0 || mBrain->GetLayerChunkSizes().empty()) return;
+
+    // Not exclusive: it only adds to the brain's chunking cache, so edits and imports needn't wait
+    mTasks.Submit(kLayersTaskKey, BrainTaskQueue::Priority::Low, false,
+      [this, sampleRate](std::atomic<bool>& cancel)
+      {
+        return !mBrain->BuildLayers(sampleRate, &cancel);
+      });
   }
 }
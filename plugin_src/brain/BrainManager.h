@@ -1,10 +1,15 @@
 #pragma once
 
 #include "plugin_src/brain/Brain.h"
+#include "plugin_src/brain/BrainJournal.h"
+#include "plugin_src/brain/BrainTaskQueue.h"
+#include "plugin_src/brain/BrainWriter.h"
+#include "plugin_src/brain/ImportCheckpoint.h"
 #include "plugin_src/audio/Window.h"
 #include <atomic>
 #include <string>
 #include <functional>
+#include <memory>
 #include <vector>
 #include <thread>
 #include <mutex>
@@ -15,8 +20,9 @@ namespace synaptic
    * @brief Manages all brain-related operations
    *
    * Handles brain add/remove/export/import/rechunk/reanalyze operations,
-   * manages external brain file references, and coordinates background threading
-   * for long-running operations.
+   * manages external brain file references, and runs long-running operations on a
+   * shared worker pool (BrainTaskQueue.h). Rechunk and reanalyze requests coalesce:
+   * a newer one replaces a queued one and restarts a running one.
    */
   class BrainManager
   {
@@ -24,12 +30,11 @@ namespace synaptic
     /**
      * @brief Construct BrainManager
      * @param brain Reference to brain instance (owned by plugin)
-     * @param analysisWindow Reference to analysis window (owned by plugin)
      */
-    explicit BrainManager(Brain* brain, Window* analysisWindow);
+    explicit BrainManager(Brain* brain);
 
     /**
-     * @brief Destructor - ensures all background threads are joined
+     * @brief Destructor - cancels queued operations and waits for running ones
      */
     ~BrainManager();
 
@@ -57,7 +62,8 @@ namespace synaptic
     using ProgressFn = std::function<void(const std::string& message, int current, int total)>;
 
     /**
-     * @brief Rechunk all brain files to new chunk size (background thread)
+     * @brief Rechunk all brain files to new chunk size (background worker)
+     * Supersedes a queued or running rechunk/reanalysis; its callbacks run when this one finishes.
      * @param newChunkSize New chunk size in samples
      * @param sampleRate Sample rate for analysis
      * @param onProgress Progress callback (message, current, total)
@@ -66,7 +72,8 @@ namespace synaptic
     void RechunkAllFilesAsync(int newChunkSize, int sampleRate, ProgressFn onProgress, CompletionFn onComplete);
 
     /**
-     * @brief Reanalyze all chunks with current window (background thread)
+     * @brief Reanalyze all chunks with current window (background worker)
+     * Supersedes like RechunkAllFilesAsync; a superseded rechunk's new chunk size is still applied.
      * @param sampleRate Sample rate for analysis
      * @param onProgress Progress callback (message, current, total)
      * @param onComplete Callback when reanalysis completes (on main thread via OnIdle)
@@ -125,24 +132,78 @@ namespace synaptic
     void SetExternalRef(const std::string& path, bool useExternal);
 
     /**
-     * @brief Check if background operation is in progress
+     * @brief Load a .sbrain file into the brain, sharing contents with other instances
+     *
+     * If another plugin instance already holds this file (same path and bytes), its brain
+     * contents are adopted instead of decoding the file again. Otherwise the file is
+     * deserialized, its journal (BrainJournal.h) replayed, and the result published.
+     * @return true if the file could be read and loaded
      */
-    bool IsOperationInProgress() const { return mOperationInProgress; }
+    bool LoadExternalFile(const std::string& path, Brain::ProgressFn onProgress = nullptr);
 
     /**
-     * @brief Request cancellation of current operation
+     * @brief Write the current brain to a .sbrain file and publish it as that file's contents
+     * Always writes a complete file and discards its journal.
+     * @return true if the file was written
      */
-    void RequestCancellation() { mCancellationRequested = true; }
+    bool SaveExternalFile(const std::string& path);
 
     /**
-     * @brief Check if cancellation has been requested
+     * @brief Save the current brain to a .sbrain file in the background
+     *
+     * Takes a copy-on-write snapshot and returns immediately; the brain is marked clean now
+     * and dirty again if the write fails. A newer save of the same path supersedes a queued one.
+     * If the file on disk differs only by added or removed files, just those are appended to
+     * its journal; otherwise (or once the journal grows too large) the whole file is rewritten.
      */
-    bool IsCancellationRequested() const { return mCancellationRequested; }
+    void SaveExternalFileAsync(const std::string& path);
 
     /**
-     * @brief Reset cancellation flag before starting new operation
+     * @brief Block until all background saves have reached disk (called on close)
      */
-    void ResetCancellationFlag() { mCancellationRequested = false; }
+    void FlushPendingWrites() { mWriter.Flush(); }
+
+    /**
+     * @brief Check if a background save has not reached disk yet
+     */
+    bool IsSavePending() const { return mWriter.IsBusy(); }
+
+    /**
+     * @brief Hash of the external file's contents (bytes plus journal) as last loaded or written (0 if unknown)
+     */
+    uint64_t ExternalContentHash() const { return mExternalContentHash.load(); }
+
+    /**
+     * @brief Note that the external file differs from the one a restored project state was saved with
+     * Cleared when the file is loaded or written again.
+     */
+    void MarkExternalChanged() { mExternalChanged = true; }
+    bool IsExternalChanged() const { return mExternalChanged.load(); }
+
+    /**
+     * @brief Check if an operation that modifies the brain is queued or running
+     */
+    bool IsOperationInProgress() const { return mTasks.HasExclusiveWork(); }
+
+    /**
+     * @brief Check if an operation's completion callback is running (e.g. rolling back parameters)
+     */
+    bool IsCompletingOperation() const { return mTasks.IsCompleting(); }
+
+    /**
+     * @brief Check if an operation other than rechunk/reanalysis (import, add files) is running
+     */
+    bool IsFileOperationRunning() const { return mTasks.IsExclusiveRunning(kAnalysisTaskKey); }
+
+    /**
+     * @brief Request cancellation of running and queued operations
+     */
+    void RequestCancellation() { mTasks.CancelAll(); }
+
+    /**
+     * @brief Number of workers running brain operations
+     */
+    void SetNumWorkers(int numWorkers) { mTasks.SetNumWorkers(numWorkers); }
 
     /**
      * @brief Get pending imported chunk size (for UI param sync)
@@ -156,19 +217,57 @@ namespace synaptic
      */
     int GetPendingImportedAnalysisWindow() { return mPendingImportedAnalysisWindow.exchange(-1); }
 
+    // === Multi-Resolution Layers (Brain::BuildLayers) ===
+
+    // Chunk sizes the UI offers as layers
+    static constexpr int kLayerPresetSizes[] = { 512, 1024, 2048, 4096, 8192 };
+
+    /**
+     * @brief Choose the chunk sizes kept analyzed next to the current one
+     * Missing layers are analyzed in the background at low priority; dropped ones are freed.
+     */
+    void SetLayerChunkSizes(std::vector<int> chunkSizes);
+    void SetLayerEnabled(int chunkSize, bool enabled);
+    std::vector<int> GetLayerChunkSizes() const { return mBrain ? mBrain->GetLayerChunkSizes() : std::vector<int>(); }
+
+    /**
+     * @brief Host sample rate, which layers are analyzed at (so they match what a rechunk produces)
+     * Rebuilds the layers if it changed.
+     */
+    void SetAnalysisSampleRate(int sampleRate);
+
+    /**
+     * @brief Analyze whatever the layers are missing (after files were added, loaded or rechunked)
+     */
+    void BuildLayersAsync();
+
+    /**
+     * @brief Adaptive chunk size: play percussive passages at a shorter ready layer
+     * (AdaptiveChunkController; saved with the layers)
+     */
+    void SetAdaptiveChunking(bool enabled) { mAdaptiveChunking.store(enabled); }
+    bool IsAdaptiveChunkingEnabled() const { return mAdaptiveChunking.load(); }
+
+    /**
+     * @brief Keep the analysis of this brain in the per-machine AnalysisCache (saved with the layers)
+     */
+    void SetAnalysisCacheEnabled(bool enabled) { if (mBrain) mBrain->SetAnalysisCacheEnabled(enabled); }
+    bool IsAnalysisCacheEnabled() const { return mBrain && mBrain->IsAnalysisCacheEnabled(); }
+
     // === Multi-File Import ===
 
     /**
      * @brief Data for a single file to import
      */
-    struct FileData
-    {
-      std::vector<uint8_t> data;
-      std::string name;
-    };
+    using FileData = ImportFile;
 
     /**
      * @brief Add multiple files asynchronously with progress reporting
+     *
+     * Each file is committed to the brain as soon as it is analyzed; with an external brain it is
+     * also appended to the .sbrain journal before the next one starts. The files still to go are
+     * checkpointed (ImportCheckpoint.h), so a cancelled or interrupted import can be resumed with
+     * ResumeImportAsync. Starting an import drops whatever was left of the previous one.
      * @param files Vector of file data to import
      * @param sampleRate Target sample rate
      * @param channels Target channel count
@@ -179,30 +278,92 @@ namespace synaptic
     void AddMultipleFilesAsync(std::vector<FileData> files, int sampleRate, int channels,
                                int chunkSize, ProgressFn onProgress, CompletionFn onComplete);
 
+    /**
+     * @brief Number of files a cancelled or interrupted import did not get to (0 if none)
+     * An import into an external brain that was interrupted (host closed, crash) is found again
+     * when that brain is loaded.
+     */
+    int GetResumableImportCount() const;
+
+    /**
+     * @brief Import the files left over by the last import, like AddMultipleFilesAsync
+     */
+    void ResumeImportAsync(int sampleRate, int channels, int chunkSize, ProgressFn onProgress, CompletionFn onComplete);
+
   private:
     // Core references (not owned)
     Brain* mBrain;
-    Window* mAnalysisWindow;
 
     // External brain state
     bool mUseExternalBrain = false;
     std::string mExternalBrainPath;
-    bool mBrainDirty = false;
+    std::atomic<bool> mBrainDirty{false}; // cleared/set again by background saves
+    std::atomic<uint64_t> mExternalContentHash{0};
+    std::atomic<bool> mExternalChanged{false};
 
-    // Threading coordination
-    std::atomic<bool> mOperationInProgress{false};
-    std::atomic<bool> mCancellationRequested{false};
+    // Chunk size the latest rechunk asked for (-1: none pending); read when the analysis task runs
+    std::atomic<int> mRequestedChunkSize{-1};
 
     // Import coordination (for param sync)
     std::atomic<int> mPendingImportedChunkSize{-1};
     std::atomic<int> mPendingImportedAnalysisWindow{-1};
 
-    // Thread management
-    std::vector<std::thread> mActiveThreads;
-    std::mutex mThreadMutex;
+    // Background .sbrain writes (project saves)
+    BrainWriter mWriter;
+
+    // What the external file and its journal hold, for journaled saves (written by mWriter)
+    std::mutex mOnDiskMutex;
+    BrainJournal::Manifest mOnDisk;
 
-    // Helper to queue a thread safely
-    void LaunchThread(std::function<void()> task);
+    // Coalescing key shared by rechunk and reanalysis
+    static constexpr const char* kAnalysisTaskKey = "analysis";
+    // Coalescing key of layer building (low priority, runs alongside other operations)
+    static constexpr const char* kLayersTaskKey = "layers";
+    // Sample rate layers are analyzed at (0 until known)
+    std::atomic<int> mLayerSampleRate{0};
+    std::atomic<bool> mAdaptiveChunking{false};
+
+    // An import and how far it got; the files before `next` are in the brain
+    struct ImportJob
+    {
+      std::vector<FileData> files;
+      size_t next = 0;
+      std::string brainPath; // external brain the files are committed to (empty: inline brain)
+      ImportCheckpoint checkpoint;
+    };
+    // What is left of the last import (see GetResumableImportCount)
+    mutable std::mutex mImportMutex;
+    std::shared_ptr<ImportJob> mResumableImport;
+
+    // Queue the import of the rest of @p job
+    void SubmitImport(std::shared_ptr<ImportJob> job, int sampleRate, int channels, int chunkSize,
+                      ProgressFn onProgress, CompletionFn onComplete);
+    // Import the rest of @p job, committing file by file; keeps what is left as resumable (worker thread)
+    bool RunImport(const std::shared_ptr<ImportJob>& job, int sampleRate, int channels, int chunkSize, const ProgressFn& onProgress,
+                   std::atomic<bool>& cancel);
+    // Make the import left over for @p brainPath resumable (or none, for an empty path); keeps it on disk
+    void OpenResumableImport(const std::string& brainPath);
+
+    // Queue the (coalescing) rechunk/reanalysis task
+    void SubmitAnalysis(int sampleRate, ProgressFn onProgress, CompletionFn onComplete);
+    // Rechunk to mRequestedChunkSize if the brain isn't at it yet, else reanalyze (worker thread)
+    bool RunAnalysis(int sampleRate, const ProgressFn& onProgress, std::atomic<bool>& cancel);
+
+    // Bookkeeping after a successful .sbrain write (sharing, content hash)
+    void OnExternalFileWritten(const std::string& path, uint64_t hash, const BrainState* state);
+
+    // Append the changes to the journal of @p path, or rewrite it in full (writer thread)
+    bool WriteExternalState(const std::string& path, const BrainState& state, bool compact, int windowMode,
+                            uint64_t& hash);
+    // Rewrite @p path in full and drop its journal (mOnDiskMutex held)
+    bool WriteExternalBaseLocked(const std::string& path, const BrainState& state, bool compact, int windowMode,
+                                 uint64_t& hash);
+    // Record what @p path and its journal hold after loading them
+    void SetOnDisk(const std::string& path, uint64_t baseHash, uint64_t baseBytes, uint64_t journalBytes,
+                   uint64_t contentHash);
+
+    // Brain operations (declared last: destroyed, and its workers joined, first)
+    BrainTaskQueue mTasks;
   };
 }
 
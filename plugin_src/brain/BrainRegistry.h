@@ -0,0 +1,193 @@
+/**
+ * @file BrainRegistry.h
+ * @brief Process-wide table of loaded .sbrain files, so plugin instances can share them
+ *
+ * Projects often use the same external brain on many tracks. Each instance used to decode and
+ * keep its own copy; with the registry the first instance publishes its loaded BrainState and
+ * later instances opening the same file (same path and same bytes) adopt it instead.
+ *
+ * The registry only holds weak references: a state is freed when the last Brain using it lets
+ * go, and entries for modified or freed states disappear. A small memo from (path, size, mtime)
+ * to content hash lets an unchanged file be matched without reading it again.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "Brain.h"
+
+namespace synaptic
+{
+  class BrainRegistry
+  {
+  public:
+    static BrainRegistry& Instance()
+    {
+      static BrainRegistry sInstance;
+      return sInstance;
+    }
+
+    /**
+     * @brief HashBytes over data that arrives in pieces (e.g. while streaming a file out)
+     * The total size must be known up front; the result equals HashBytes of all pieces joined.
+     */
+    class Hasher
+    {
+    public:
+      explicit Hasher(size_t totalSize) : mHash(1469598103934665603ull ^ (uint64_t) totalSize) {}
+
+      void Update(const void* data, size_t size)
+      {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        while (size > 0 && mPending > 0)
+        {
+          mWord[mPending++] = *p++;
+          --size;
+          if (mPending == 8)
+          {
+            Mix(mWord);
+            mPending = 0;
+          }
+        }
+        for (; size >= 8; p += 8, size -= 8)
+          Mix(p);
+        for (; size > 0; --size)
+          mWord[mPending++] = *p++;
+      }
+
+      uint64_t Final() const
+      {
+        uint64_t h = mHash;
+        for (size_t i = 0; i < mPending; ++i)
+        {
+          h ^= mWord[i];
+          h *= 1099511628211ull;
+        }
+        return h ^ (h >> 29);
+      }
+
+    private:
+      void Mix(const unsigned char* p)
+      {
+        uint64_t w;
+        std::memcpy(&w, p, 8);
+        mHash ^= w;
+        mHash *= 1099511628211ull;
+        mHash ^= mHash >> 32;
+      }
+
+      uint64_t mHash;
+      unsigned char mWord[8] = {};
+      size_t mPending = 0;
+    };
+
+    /** @brief 64-bit hash of a file's bytes (FNV-1a style, 8 bytes per step) */
+    static uint64_t HashBytes(const void* data, size_t size)
+    {
+      Hasher h(size);
+      h.Update(data, size);
+      return h.Final();
+    }
+
+    /** @brief Size and modification time of a file; false if it cannot be stat'ed */
+    static bool StatFile(const std::string& path, uint64_t& size, int64_t& mtime)
+    {
+#if defined(_WIN32)
+      struct _stat64 st;
+      if (_stat64(path.c_str(), &st) != 0) return false;
+#else
+      struct stat st;
+      if (stat(path.c_str(), &st) != 0) return false;
+#endif
+      size = (uint64_t) st.st_size;
+      mtime = (int64_t) st.st_mtime;
+      return true;
+    }
+
+    /** @brief Loaded contents for (path, hash), or nullptr if no instance holds them */
+    std::shared_ptr<BrainState> Find(const std::string& path, uint64_t contentHash)
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      auto it = mStates.find(Key(path, contentHash));
+      if (it == mStates.end()) return nullptr;
+      auto state = it->second.lock();
+      if (!state) mStates.erase(it);
+      return state;
+    }
+
+    void Publish(const std::string& path, uint64_t contentHash, const std::shared_ptr<BrainState>& state)
+    {
+      if (!state || path.empty()) return;
+      std::lock_guard<std::mutex> lock(mMutex);
+      PruneLocked();
+      mStates[Key(path, contentHash)] = state;
+    }
+
+    /** @brief Withdraw a state that is about to be modified (and drop expired entries) */
+    void Unpublish(const BrainState* state)
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      for (auto it = mStates.begin(); it != mStates.end();)
+      {
+        auto sp = it->second.lock();
+        if (!sp || sp.get() == state) it = mStates.erase(it);
+        else ++it;
+      }
+    }
+
+    /** @brief Hash remembered for a file with this exact size and mtime, if any */
+    bool LookupFileHash(const std::string& path, uint64_t size, int64_t mtime, uint64_t& contentHash)
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      auto it = mFileHashes.find(path);
+      if (it == mFileHashes.end() || it->second.size != size || it->second.mtime != mtime) return false;
+      contentHash = it->second.hash;
+      return true;
+    }
+
+    void RememberFileHash(const std::string& path, uint64_t size, int64_t mtime, uint64_t contentHash)
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mFileHashes[path] = FileStamp { size, mtime, contentHash };
+    }
+
+  private:
+    struct FileStamp
+    {
+      uint64_t size = 0;
+      int64_t mtime = 0;
+      uint64_t hash = 0;
+    };
+
+    BrainRegistry() = default;
+
+    static std::string Key(const std::string& path, uint64_t contentHash)
+    {
+      char hex[20];
+      snprintf(hex, sizeof(hex), "%016llx", (unsigned long long) contentHash);
+      return path + '|' + hex;
+    }
+
+    void PruneLocked()
+    {
+      for (auto it = mStates.begin(); it != mStates.end();)
+      {
+        if (it->second.expired()) it = mStates.erase(it);
+        else ++it;
+      }
+    }
+
+    std::mutex mMutex;
+    std::map<std::string, std::weak_ptr<BrainState>> mStates; // "path|hash" -> loaded contents
+    std::map<std::string, FileStamp> mFileHashes;             // path -> last known hash
+  };
+}
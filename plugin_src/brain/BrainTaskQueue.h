@@ -0,0 +1,359 @@
+/**
+ * @file BrainTaskQueue.h
+ * @brief Persistent, prioritized worker pool for brain operations
+ *
+ * BrainManager used to start a new thread per operation and ignore a request while another
+ * one was running. Operations are now queued here and run on a small set of long-lived workers
+ * at reduced thread priority, so they give way to the audio thread.
+ *
+ * - Exclusive tasks (anything that modifies the brain) run one at a time, highest priority
+ *   first, in submission order within a priority.
+ * - Tasks with the same key coalesce: a queued one is replaced by the newer request, and a
+ *   running one is cancelled and restarted as the newer request. The replaced requests'
+ *   completion callbacks are not lost; they run (newest first) when the task that absorbed
+ *   them finishes, with its outcome.
+ * - Pause(key) stops a key from running (cancelling and requeueing a running task) until
+ *   Resume, so the caller can change state the task reads without racing it.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+  #ifndef NOMINMAX
+    #define NOMINMAX
+  #endif
+  #include <windows.h>
+#elif defined(__APPLE__)
+  #include <pthread.h>
+  #include <sys/qos.h>
+#endif
+
+namespace synaptic
+{
+  class BrainTaskQueue
+  {
+  public:
+    enum class Priority : int { Low = 0, Normal = 1, High = 2 };
+
+    // Called once a task finished (wasCancelled: stopped by Cancel, not by being superseded)
+    using CompletionFn = std::function<void(bool wasCancelled)>;
+    // The work; polls cancel and returns whether it stopped early
+    using RunFn = std::function<bool(std::atomic<bool>& cancel)>;
+
+    static constexpr int kDefaultWorkers = 2;
+
+    explicit BrainTaskQueue(int numWorkers = kDefaultWorkers) : mNumWorkers(std::max(1, numWorkers)) {}
+    BrainTaskQueue(const BrainTaskQueue&) = delete;
+    BrainTaskQueue& operator=(const BrainTaskQueue&) = delete;
+
+    /** @brief Cancel everything, drop queued tasks (without their callbacks) and join the workers */
+    ~BrainTaskQueue()
+    {
+      {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+        mQueue.clear();
+        for (auto& r : mRunning)
+          r->cancel = true;
+      }
+      mWake.notify_all();
+      for (auto& t : mThreads)
+        if (t.joinable()) t.join();
+    }
+
+    /**
+     * @brief Queue a task
+     * @param key Tasks with the same non-empty key coalesce (see file comment)
+     * @param exclusive Run only while no other exclusive task is running
+     */
+    void Submit(const std::string& key, Priority priority, bool exclusive, RunFn run, CompletionFn onComplete = nullptr)
+    {
+      auto task = std::make_shared<Task>();
+      task->key = key;
+      task->priority = priority;
+      task->exclusive = exclusive;
+      task->run = std::move(run);
+      if (onComplete) task->onComplete.push_back(std::move(onComplete));
+      {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (!key.empty())
+        {
+          for (auto it = mQueue.begin(); it != mQueue.end();)
+          {
+            if ((*it)->key == key)
+            {
+              Absorb(*task, **it);
+              it = mQueue.erase(it);
+            }
+            else ++it;
+          }
+          for (auto& r : mRunning)
+            if (r->task->key == key) Supersede(*r);
+        }
+        Insert(std::move(task));
+        StartWorkersLocked();
+      }
+      mWake.notify_all();
+    }
+
+    /** @brief Cancel running and queued tasks; each still completes, with wasCancelled = true */
+    void CancelAll()
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      for (auto& r : mRunning)
+      {
+        r->cancel = true;
+        r->task->cancelled = true; // stays cancelled if it is restarted
+      }
+      for (auto& t : mQueue)
+        t->cancelled = true;
+    }
+
+    /**
+     * @brief Keep tasks with @p key from running until Resume(key)
+     * A running one is cancelled and requeued; returns once it has stopped (unless called from
+     * that task itself, e.g. from its completion callback).
+     */
+    void Pause(const std::string& key)
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      ++mPaused[key];
+      for (auto& r : mRunning)
+        if (r->task->key == key) Supersede(*r);
+      const auto self = std::this_thread::get_id();
+      mIdle.wait(lock, [this, &key, self]()
+      {
+        for (const auto& r : mRunning)
+          if (r->task->key == key && r->thread != self) return false;
+        return true;
+      });
+    }
+
+    void Resume(const std::string& key)
+    {
+      {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto it = mPaused.find(key);
+        if (it == mPaused.end()) return;
+        if (--it->second <= 0) mPaused.erase(it);
+      }
+      mWake.notify_all();
+    }
+
+    /** @brief Pause(key) for each key, for the lifetime of this object */
+    class ScopedPause
+    {
+    public:
+      ScopedPause(BrainTaskQueue& queue, std::string key) : ScopedPause(queue, std::vector<std::string> { std::move(key) }) {}
+      ScopedPause(BrainTaskQueue& queue, std::vector<std::string> keys) : mQueue(queue), mKeys(std::move(keys))
+      {
+        for (const auto& key : mKeys) mQueue.Pause(key);
+      }
+      ~ScopedPause()
+      {
+        for (const auto& key : mKeys) mQueue.Resume(key);
+      }
+      ScopedPause(const ScopedPause&) = delete;
+      ScopedPause& operator=(const ScopedPause&) = delete;
+
+    private:
+      BrainTaskQueue& mQueue;
+      std::vector<std::string> mKeys;
+    };
+
+    /** @brief Change how many workers run tasks (extra idle workers are started on demand) */
+    void SetNumWorkers(int numWorkers)
+    {
+      {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mNumWorkers = std::max(1, numWorkers);
+        if (!mQueue.empty()) StartWorkersLocked();
+      }
+      mWake.notify_all();
+    }
+
+    int GetNumWorkers() const
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      return mNumWorkers;
+    }
+
+    /** @brief True while an exclusive task is queued or running */
+    bool HasExclusiveWork() const
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      for (const auto& t : mQueue)
+        if (t->exclusive) return true;
+      for (const auto& r : mRunning)
+        if (r->task->exclusive) return true;
+      return false;
+    }
+
+    /** @brief True while an exclusive task is running whose key isn't @p exceptKey */
+    bool IsExclusiveRunning(const std::string& exceptKey = std::string()) const
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      for (const auto& r : mRunning)
+        if (r->task->exclusive && (exceptKey.empty() || r->task->key != exceptKey)) return true;
+      return false;
+    }
+
+    /** @brief True while a completion callback runs */
+    bool IsCompleting() const { return mCompleting.load() > 0; }
+
+    /** @brief Block until nothing is queued or running */
+    void WaitIdle()
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      mIdle.wait(lock, [this]() { return mQueue.empty() && mRunning.empty(); });
+    }
+
+  private:
+    struct Task
+    {
+      std::string key;
+      Priority priority = Priority::Normal;
+      bool exclusive = true;
+      bool cancelled = false; // cancelled while queued: runs with the cancel flag already set
+      RunFn run;
+      std::vector<CompletionFn> onComplete; // newest request first
+    };
+
+    struct Running
+    {
+      std::shared_ptr<Task> task;
+      std::thread::id thread;
+      std::atomic<bool> cancel { false };
+      bool superseded = false;
+    };
+
+    // The newer task takes over the callbacks of one it replaces
+    static void Absorb(Task& newer, Task& older)
+    {
+      for (auto& fn : older.onComplete)
+        newer.onComplete.push_back(std::move(fn));
+      newer.priority = std::max(newer.priority, older.priority);
+    }
+
+    static void Supersede(Running& r)
+    {
+      r.superseded = true;
+      r.cancel = true;
+    }
+
+    // Keep the queue ordered by priority, FIFO within a priority
+    void Insert(std::shared_ptr<Task> task)
+    {
+      auto it = std::find_if(mQueue.begin(), mQueue.end(), [&task](const std::shared_ptr<Task>& t)
+      {
+        return t->priority < task->priority;
+      });
+      mQueue.insert(it, std::move(task));
+    }
+
+    void StartWorkersLocked()
+    {
+      while ((int) mThreads.size() < mNumWorkers)
+      {
+        const int index = (int) mThreads.size();
+        mThreads.emplace_back([this, index]() { Run(index); });
+      }
+    }
+
+    // Next runnable task, or the end of the queue
+    std::deque<std::shared_ptr<Task>>::iterator NextLocked()
+    {
+      bool exclusiveRunning = false;
+      for (const auto& r : mRunning)
+        exclusiveRunning = exclusiveRunning || r->task->exclusive;
+      return std::find_if(mQueue.begin(), mQueue.end(), [this, exclusiveRunning](const std::shared_ptr<Task>& t)
+      {
+        return !(t->exclusive && exclusiveRunning) && mPaused.find(t->key) == mPaused.end();
+      });
+    }
+
+    void Run(int index)
+    {
+      LowerThreadPriority();
+      std::unique_lock<std::mutex> lock(mMutex);
+      while (true)
+      {
+        auto it = mQueue.end();
+        mWake.wait(lock, [this, index, &it]()
+        {
+          if (mStop) return true;
+          if (index >= mNumWorkers) return false;
+          it = NextLocked();
+          return it != mQueue.end();
+        });
+        if (mStop) return;
+
+        auto running = std::make_shared<Running>();
+        running->task = std::move(*it);
+        running->thread = std::this_thread::get_id();
+        running->cancel = running->task->cancelled;
+        mQueue.erase(it);
+        mRunning.push_back(running);
+        lock.unlock();
+
+        const bool wasCancelled = running->task->run(running->cancel);
+
+        lock.lock();
+        if (running->superseded && !mStop)
+        {
+          // Restart as the request that replaced it (or as itself, if it was only paused)
+          auto queued = std::find_if(mQueue.begin(), mQueue.end(), [&running](const std::shared_ptr<Task>& t)
+          {
+            return t->key == running->task->key;
+          });
+          if (queued != mQueue.end()) Absorb(**queued, *running->task);
+          else Insert(running->task);
+        }
+        else
+        {
+          ++mCompleting;
+          lock.unlock();
+          for (auto& fn : running->task->onComplete)
+            if (fn) fn(wasCancelled);
+          lock.lock();
+          --mCompleting;
+        }
+        mRunning.erase(std::find(mRunning.begin(), mRunning.end(), running));
+        mIdle.notify_all();
+        mWake.notify_all();
+      }
+    }
+
+    static void LowerThreadPriority()
+    {
+#if defined(_WIN32)
+      SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+#elif defined(__APPLE__)
+      pthread_set_qos_class_self_np(QOS_CLASS_UTILITY, 0);
+#endif
+    }
+
+    mutable std::mutex mMutex;
+    std::condition_variable mWake;
+    std::condition_variable mIdle;
+    std::deque<std::shared_ptr<Task>> mQueue;
+    std::vector<std::shared_ptr<Running>> mRunning;
+    std::map<std::string, int> mPaused;
+    std::vector<std::thread> mThreads;
+    std::atomic<int> mCompleting { 0 };
+    int mNumWorkers;
+    bool mStop = false;
+  };
+}
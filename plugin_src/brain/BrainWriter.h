@@ -0,0 +1,224 @@
+/**
+ * @file BrainWriter.h
+ * @brief Background writer for external .sbrain files
+ *
+ * Saving a large brain used to serialize and fwrite it inside the host's state save, blocking
+ * the DAW. The writer takes an immutable snapshot of the brain contents (Brain::GetStateSnapshot)
+ * and does the serialization and file I/O on its own thread. Files are written to a temporary
+ * name next to the target and renamed over it, so a crash or full disk never leaves a
+ * half-written brain behind.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "Brain.h"
+#include "BrainRegistry.h"
+
+#if defined(_WIN32)
+  #ifndef NOMINMAX
+    #define NOMINMAX
+  #endif
+  #include <windows.h>
+#endif
+
+namespace synaptic
+{
+  class BrainWriter
+  {
+  public:
+    // Called on the writer thread once a job finished (ok == false if it could not be written)
+    using CompletionFn = std::function<void(bool ok, uint64_t contentHash)>;
+    // Custom write run on the writer thread; returns success and the hash of what is now on disk
+    using WriteFn = std::function<bool(uint64_t& contentHash)>;
+
+    BrainWriter() = default;
+    BrainWriter(const BrainWriter&) = delete;
+    BrainWriter& operator=(const BrainWriter&) = delete;
+
+    ~BrainWriter()
+    {
+      Flush();
+      {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+      }
+      mWake.notify_all();
+      if (mThread.joinable())
+        mThread.join();
+    }
+
+    /**
+     * @brief Queue a save of @p state to @p path
+     * A queued save for the same path that has not started yet is replaced (only the newest
+     * contents matter). Returns immediately.
+     */
+    void Enqueue(const std::string& path, std::shared_ptr<const BrainState> state, bool compact, int windowMode,
+                 CompletionFn onDone = nullptr)
+    {
+      if (path.empty() || !state) return;
+      Enqueue(path, [path, state = std::move(state), compact, windowMode](uint64_t& contentHash)
+      {
+        return WriteState(path, *state, compact, windowMode, contentHash);
+      }, std::move(onDone));
+    }
+
+    /**
+     * @brief Queue a custom write of @p path (e.g. a journal append), superseding like a save
+     * Jobs for one path run in order, so @p write sees the result of every earlier job.
+     */
+    void Enqueue(const std::string& path, WriteFn write, CompletionFn onDone = nullptr)
+    {
+      if (path.empty() || !write) return;
+      {
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (auto it = mQueue.begin(); it != mQueue.end();)
+        {
+          if (it->path == path) it = mQueue.erase(it);
+          else ++it;
+        }
+        mQueue.push_back(Job { path, std::move(write), std::move(onDone) });
+        if (!mThread.joinable())
+          mThread = std::thread([this]() { Run(); });
+      }
+      mWake.notify_all();
+    }
+
+    /** @brief Block until every queued save has been written (or has failed) */
+    void Flush()
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      mIdle.wait(lock, [this]() { return mQueue.empty() && !mWriting; });
+    }
+
+    /** @brief Block until no save for @p path is queued or in progress */
+    void Flush(const std::string& path)
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      mIdle.wait(lock, [this, &path]() { return !HasPendingLocked(path); });
+    }
+
+    bool IsBusy() const
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      return !mQueue.empty() || mWriting;
+    }
+
+    /**
+     * @brief Write bytes to @p path via a temporary file and an atomic rename
+     * @return false (leaving any existing file untouched) if anything fails
+     */
+    static bool WriteFileAtomically(const std::string& path, const void* data, size_t size)
+    {
+      return WriteFileAtomically(path, [data, size](FILE* fp) { return size == 0 || fwrite(data, 1, size, fp) == size; });
+    }
+
+    /** @brief As above, with the contents produced by @p fill writing to the open temporary file */
+    static bool WriteFileAtomically(const std::string& path, const std::function<bool(FILE*)>& fill)
+    {
+      const std::string tmpPath = path + ".tmp";
+      FILE* fp = fopen(tmpPath.c_str(), "wb");
+      if (!fp) return false;
+      const bool written = fill(fp);
+      const bool flushed = fflush(fp) == 0;
+      const bool closed = fclose(fp) == 0;
+      if (!(written && flushed && closed) || !RenameOver(tmpPath, path))
+      {
+        std::remove(tmpPath.c_str());
+        return false;
+      }
+      return true;
+    }
+
+    /** @brief Stream @p state to @p path atomically (blocking), without building it in memory first */
+    static bool WriteState(const std::string& path, const BrainState& state, bool compact, int windowMode,
+                           uint64_t& contentHash)
+    {
+      return WriteFileAtomically(path, [&](FILE* fp)
+      {
+        return Brain::SerializeStateToFile(state, compact, windowMode, fp, contentHash);
+      });
+    }
+
+  private:
+    struct Job
+    {
+      std::string path;
+      WriteFn write;
+      CompletionFn onDone;
+    };
+
+    // Rename replacing an existing target in one step (paths are UTF-8)
+    static bool RenameOver(const std::string& from, const std::string& to)
+    {
+#if defined(_WIN32)
+      auto widen = [](const std::string& s)
+      {
+        const int len = MultiByteToWideChar(CP_UTF8, 0, s.c_str(), -1, nullptr, 0);
+        std::wstring w(len > 0 ? (size_t) len : 0, L'\0');
+        if (len > 0) MultiByteToWideChar(CP_UTF8, 0, s.c_str(), -1, &w[0], len);
+        return w;
+      };
+      return MoveFileExW(widen(from).c_str(), widen(to).c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+      return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+    }
+
+    bool HasPendingLocked(const std::string& path) const
+    {
+      if (mWriting && mWritingPath == path) return true;
+      for (const auto& job : mQueue)
+        if (job.path == path) return true;
+      return false;
+    }
+
+    void Run()
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      while (true)
+      {
+        mWake.wait(lock, [this]() { return mStop || !mQueue.empty(); });
+        if (mQueue.empty())
+        {
+          if (mStop) return;
+          continue;
+        }
+
+        Job job = std::move(mQueue.front());
+        mQueue.pop_front();
+        mWriting = true;
+        mWritingPath = job.path;
+        lock.unlock();
+
+        uint64_t hash = 0;
+        const bool ok = job.write(hash);
+        if (job.onDone)
+          job.onDone(ok, hash);
+        job.write = nullptr; // drop the snapshot so later edits stop copying as soon as possible
+
+        lock.lock();
+        mWriting = false;
+        mWritingPath.clear();
+        mIdle.notify_all();
+      }
+    }
+
+    mutable std::mutex mMutex;
+    std::condition_variable mWake;
+    std::condition_variable mIdle;
+    std::deque<Job> mQueue;
+    std::thread mThread;
+    std::string mWritingPath;
+    bool mWriting = false;
+    bool mStop = false;
+  };
+}
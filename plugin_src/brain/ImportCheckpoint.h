@@ -0,0 +1,248 @@
+/**
+ * @file ImportCheckpoint.h
+ * @brief On-disk record of a multi-file import that has not finished
+ *
+ * A multi-file import lived only in memory, so quitting the host (or a crash) in the middle lost
+ * every file not imported yet. The checkpoint keeps a copy of each of those source files until it
+ * is in the brain, in "<cache dir>/imports/<key>/", where the key is a hash of the external
+ * .sbrain path. Loading that brain again finds the job and offers to resume it (with the host's
+ * current sample rate and chunk size, like any import).
+ *
+ * "job.sbi" holds magic, version, brain path and file count;
+ * "<n>.sbi" holds file n's name and bytes and is deleted once the file is imported. job.sbi is
+ * written last, so a job that was interrupted while being recorded is ignored.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "SnapshotIO.h"
+#include "../common/CachePaths.h"
+#include "../common/MappedFile.h"
+
+#if !defined(_WIN32)
+  #include <unistd.h>
+#endif
+
+namespace synaptic
+{
+  /** @brief A source file to import into the brain */
+  struct ImportFile
+  {
+    std::vector<uint8_t> data;
+    std::string name;
+  };
+
+  class ImportCheckpoint
+  {
+  public:
+    static constexpr uint32_t kJobMagic = 0x4A494253;   // 'SBIJ' Synaptic Brain Import Job
+    static constexpr uint32_t kEntryMagic = 0x46494253; // 'SBIF' Synaptic Brain Import File
+    static constexpr uint16_t kVersion = 1;
+
+    ImportCheckpoint() = default;
+    ImportCheckpoint(const ImportCheckpoint&) = delete;
+    ImportCheckpoint& operator=(const ImportCheckpoint&) = delete;
+    ImportCheckpoint(ImportCheckpoint&&) = default;
+    ImportCheckpoint& operator=(ImportCheckpoint&&) = default;
+
+    bool IsOpen() const { return !mDir.empty(); }
+
+    /**
+     * @brief Record a job importing @p files into the brain at @p brainPath (replacing any older one)
+     * @return false if it could not be written; the import then runs without a checkpoint
+     */
+    bool Create(const std::string& brainPath, const std::vector<ImportFile>& files)
+    {
+      Remove();
+      // Leftovers of an older job for this brain
+      const std::string old = Directory(brainPath, false);
+      if (!old.empty()) RemoveJobFiles(old);
+      const std::string dir = Directory(brainPath, true);
+      if (dir.empty()) return false;
+
+      for (int i = 0; i < (int) files.size(); ++i)
+      {
+        const ImportFile& file = files[i];
+        const bool ok = WriteFile(EntryPath(dir, i), [&file](SnapshotWriter& out)
+        {
+          out.Put(&kEntryMagic);
+          out.Put(&kVersion);
+          out.PutString(file.name);
+          out.PutVector(file.data);
+        });
+        if (!ok)
+        {
+          RemoveJobFiles(dir);
+          return false;
+        }
+      }
+
+      const int32_t count = (int32_t) files.size();
+      const bool ok = WriteFile(dir + kJobFile, [&](SnapshotWriter& out)
+      {
+        out.Put(&kJobMagic);
+        out.Put(&kVersion);
+        out.PutString(brainPath);
+        out.Put(&count);
+      });
+      if (!ok)
+      {
+        RemoveJobFiles(dir);
+        return false;
+      }
+
+      mDir = dir;
+      mCount = count;
+      mEntries.clear();
+      for (int i = 0; i < count; ++i) mEntries.push_back(i);
+      return true;
+    }
+
+    /**
+     * @brief Open the job recorded for @p brainPath
+     * @param files Receives the files not imported yet, in their original order
+     * @return false if there is no job (or nothing left in it)
+     */
+    bool Open(const std::string& brainPath, std::vector<ImportFile>& files)
+    {
+      Close();
+      files.clear();
+      const std::string dir = Directory(brainPath, false);
+      if (dir.empty()) return false;
+
+      std::string path;
+      int32_t count = 0;
+      if (!ReadJob(dir, path, count) || path != brainPath) return false;
+
+      for (int i = 0; i < count; ++i)
+      {
+        MappedFile entry;
+        if (!entry.Open(EntryPath(dir, i))) continue; // imported already
+        SnapshotReader in(entry.Data(), entry.Size());
+        uint32_t magic = 0;
+        uint16_t ver = 0;
+        ImportFile file;
+        if (!in.Get(&magic) || magic != kEntryMagic || !in.Get(&ver) || ver != kVersion || !in.GetString(file.name)
+            || !in.GetVector(file.data) || in.Remaining() != 0)
+          continue;
+        files.push_back(std::move(file));
+        mEntries.push_back(i);
+      }
+
+      mDir = dir;
+      mCount = count;
+      if (files.empty())
+      {
+        Remove();
+        return false;
+      }
+      return true;
+    }
+
+    /** @brief File @p index (of the list passed to Create or returned by Open) is in the brain now */
+    void MarkImported(int index)
+    {
+      if (!IsOpen() || index < 0 || index >= (int) mEntries.size()) return;
+      std::remove(EntryPath(mDir, mEntries[index]).c_str());
+    }
+
+    /** @brief Delete the whole job (finished or discarded) */
+    void Remove()
+    {
+      if (IsOpen())
+        RemoveJobFiles(mDir, mCount);
+      Close();
+    }
+
+    /** @brief Forget the job without deleting it (it stays on disk for a later Open) */
+    void Close()
+    {
+      mDir.clear();
+      mEntries.clear();
+      mCount = 0;
+    }
+
+  private:
+    static constexpr const char* kSubdirectory = "imports";
+    static constexpr const char* kJobFile = "job.sbi";
+
+    // "<cache dir>/imports/<hash of brainPath>/", or empty if there is no cache directory
+    static std::string Directory(const std::string& brainPath, bool create)
+    {
+      const std::string base = cache::GetCacheDirectory();
+      if (base.empty() || brainPath.empty()) return std::string();
+      const char sep = base.back();
+      const std::string imports = base + kSubdirectory;
+      char key[24];
+      snprintf(key, sizeof(key), "%016llx", (unsigned long long) BrainRegistry::HashBytes(brainPath.data(), brainPath.size()));
+      const std::string dir = imports + sep + key;
+      if (create && !(cache::MakeDirectory(imports) && cache::MakeDirectory(dir))) return std::string();
+      return dir + sep;
+    }
+
+    static std::string EntryPath(const std::string& dir, int index)
+    {
+      return dir + std::to_string(index) + ".sbi";
+    }
+
+    // Written to a temporary file and renamed into place
+    static bool WriteFile(const std::string& path, const std::function<void(SnapshotWriter&)>& write)
+    {
+      const std::string tmpPath = path + ".tmp";
+      FILE* fp = fopen(tmpPath.c_str(), "wb");
+      if (!fp) return false;
+      SnapshotWriter out(fp, nullptr);
+      write(out);
+      const bool written = out.Finish();
+      const bool closed = fclose(fp) == 0;
+      std::remove(path.c_str());
+      if (!(written && closed) || std::rename(tmpPath.c_str(), path.c_str()) != 0)
+      {
+        std::remove(tmpPath.c_str());
+        return false;
+      }
+      return true;
+    }
+
+    static bool ReadJob(const std::string& dir, std::string& brainPath, int32_t& count)
+    {
+      MappedFile job;
+      if (!job.Open(dir + kJobFile)) return false;
+      SnapshotReader in(job.Data(), job.Size());
+      uint32_t magic = 0;
+      uint16_t ver = 0;
+      return in.Get(&magic) && magic == kJobMagic && in.Get(&ver) && ver == kVersion && in.GetString(brainPath)
+        && in.Get(&count) && count >= 0;
+    }
+
+    // The job file first, so a partly removed job is never opened again (count < 0: as recorded)
+    static void RemoveJobFiles(const std::string& dir, int count = -1)
+    {
+      if (count < 0)
+      {
+        std::string path;
+        int32_t recorded = 0;
+        count = ReadJob(dir, path, recorded) ? recorded : 0;
+      }
+      std::remove((dir + kJobFile).c_str());
+      for (int i = 0; i < count; ++i)
+        std::remove(EntryPath(dir, i).c_str());
+      std::string trimmed = dir.substr(0, dir.size() - 1);
+#if defined(_WIN32)
+      _rmdir(trimmed.c_str());
+#else
+      rmdir(trimmed.c_str());
+#endif
+    }
+
+    std::string mDir;
+    std::vector<int> mEntries; // entry number of each file in the list handed out
+    int mCount = 0;
+  };
+}
@@ -0,0 +1,169 @@
+/**
+ * @file SnapshotIO.h
+ * @brief Bulk writer and reader for brain snapshots
+ *
+ * Snapshots used to be built with one IByteChunk::Put per value, growing the chunk each time.
+ * SnapshotWriter writes whole vectors with a single copy, either into memory sized beforehand by
+ * a counting pass over the same code, or straight to a file through a large buffer.
+ * SnapshotReader reads from plain memory with bulk copies. Both use the byte layout of
+ * IByteChunk::Put/Get (native scalars, int32 counts), so existing files are unaffected.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "BrainRegistry.h"
+
+namespace synaptic
+{
+  class SnapshotWriter
+  {
+  public:
+    static constexpr size_t kFileBufferBytes = 4u << 20;
+
+    /** @brief Counting writer: only measures how many bytes the same calls would write */
+    SnapshotWriter() = default;
+
+    /** @brief Write into @p capacity bytes at @p dst (fails rather than overrun) */
+    SnapshotWriter(uint8_t* dst, size_t capacity) : mDst(dst), mCapacity(capacity) {}
+
+    /** @brief Stream to @p fp in large writes, feeding @p hasher (optional) with every byte */
+    SnapshotWriter(FILE* fp, BrainRegistry::Hasher* hasher) : mFile(fp), mHasher(hasher)
+    {
+      mBuffer.reserve(kFileBufferBytes);
+    }
+
+    SnapshotWriter(const SnapshotWriter&) = delete;
+    SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+    bool IsCounting() const { return !mDst && !mFile; }
+
+    template <class T> void Put(const T* value) { PutBytes(value, sizeof(T)); }
+
+    void PutBytes(const void* data, size_t size)
+    {
+      if (mDst)
+      {
+        if (size > mCapacity - mPos) { mFailed = true; return; }
+        std::memcpy(mDst + mPos, data, size);
+      }
+      else if (mFile)
+      {
+        if (mBuffer.size() + size > kFileBufferBytes)
+          FlushBuffer();
+        if (size >= kFileBufferBytes)
+          WriteThrough(data, size);
+        else
+          mBuffer.insert(mBuffer.end(), static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + size);
+      }
+      mPos += size;
+    }
+
+    /** @brief int32 element count followed by the elements in one copy */
+    template <class T> void PutVector(const std::vector<T>& v)
+    {
+      int32_t n = (int32_t) v.size();
+      Put(&n);
+      if (n > 0) PutBytes(v.data(), sizeof(T) * v.size());
+    }
+
+    void PutString(const std::string& s)
+    {
+      int32_t n = (int32_t) s.size();
+      Put(&n);
+      if (n > 0) PutBytes(s.data(), s.size());
+    }
+
+    /** @brief Account for @p size bytes without producing them (counting writers only) */
+    void Skip(size_t size)
+    {
+      if (!IsCounting()) mFailed = true;
+      mPos += size;
+    }
+
+    /** @brief Write out anything buffered; false if any write failed */
+    bool Finish()
+    {
+      if (mFile) FlushBuffer();
+      return !mFailed;
+    }
+
+    size_t Size() const { return mPos; }
+
+  private:
+    void FlushBuffer()
+    {
+      if (mBuffer.empty()) return;
+      WriteThrough(mBuffer.data(), mBuffer.size());
+      mBuffer.clear();
+    }
+
+    void WriteThrough(const void* data, size_t size)
+    {
+      if (fwrite(data, 1, size, mFile) != size) mFailed = true;
+      if (mHasher) mHasher->Update(data, size);
+    }
+
+    uint8_t* mDst = nullptr;
+    size_t mCapacity = 0;
+    FILE* mFile = nullptr;
+    BrainRegistry::Hasher* mHasher = nullptr;
+    std::vector<uint8_t> mBuffer;
+    size_t mPos = 0;
+    bool mFailed = false;
+  };
+
+  class SnapshotReader
+  {
+  public:
+    SnapshotReader(const void* data, size_t size) : mData(static_cast<const uint8_t*>(data)), mSize(size) {}
+
+    template <class T> bool Get(T* value) { return GetBytes(value, sizeof(T)); }
+
+    bool GetBytes(void* dst, size_t size)
+    {
+      if (size > Remaining()) return false;
+      if (size > 0) std::memcpy(dst, mData + mPos, size);
+      mPos += size;
+      return true;
+    }
+
+    /** @brief Read a PutVector; rejects counts larger than the remaining data */
+    template <class T> bool GetVector(std::vector<T>& v)
+    {
+      int32_t n = 0;
+      if (!Get(&n) || n < 0 || (size_t) n > Remaining() / sizeof(T)) return false;
+      v.resize((size_t) n);
+      return n == 0 || GetBytes(v.data(), sizeof(T) * v.size());
+    }
+
+    bool GetString(std::string& s)
+    {
+      int32_t n = 0;
+      if (!Get(&n) || n < 0 || (size_t) n > Remaining()) return false;
+      s.assign(reinterpret_cast<const char*>(mData + mPos), (size_t) n);
+      mPos += (size_t) n;
+      return true;
+    }
+
+    bool Skip(size_t size)
+    {
+      if (size > Remaining()) return false;
+      mPos += size;
+      return true;
+    }
+
+    size_t Position() const { return mPos; }
+    size_t Remaining() const { return mSize - mPos; }
+
+  private:
+    const uint8_t* mData;
+    size_t mSize;
+    size_t mPos = 0;
+  };
+}
@@ -0,0 +1,73 @@
+/**
+ * @file CachePaths.h
+ * @brief Per-user cache directory for regenerable, machine-specific data
+ *
+ * Anything written here can be deleted at any time; it only saves work on the next run.
+ */
+
+#pragma once
+
+#include <cerrno>
+#include <cstdlib>
+#include <string>
+
+#if defined(_WIN32)
+  #include <direct.h>
+#else
+  #include <sys/stat.h>
+  #include <sys/types.h>
+#endif
+
+namespace synaptic
+{
+namespace cache
+{
+  inline bool MakeDirectory(const std::string& path)
+  {
+#if defined(_WIN32)
+    return _mkdir(path.c_str()) == 0 || errno == EEXIST;
+#else
+    return mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+#endif
+  }
+
+  /**
+   * @brief Get (and create if needed) the plugin's cache directory, with trailing separator
+   *
+   * Windows: %LOCALAPPDATA%\SynapticResynthesis\
+   * macOS:   ~/Library/Caches/SynapticResynthesis/
+   * Other:   $XDG_CACHE_HOME/SynapticResynthesis/ (or ~/.cache/...)
+   *
+   * @return Directory path, or empty string if no suitable location exists
+   */
+  inline std::string GetCacheDirectory()
+  {
+#if defined(_WIN32)
+    const char* base = std::getenv("LOCALAPPDATA");
+    if (!base || !*base) return std::string();
+    std::string dir = std::string(base) + "\\SynapticResynthesis";
+    const char sep = '\\';
+#else
+    std::string root;
+    const char* home = std::getenv("HOME");
+  #if defined(__APPLE__)
+    if (!home || !*home) return std::string();
+    root = std::string(home) + "/Library/Caches";
+  #else
+    const char* xdg = std::getenv("XDG_CACHE_HOME");
+    if (xdg && *xdg) root = xdg;
+    else if (home && *home)
+    {
+      root = std::string(home) + "/.cache";
+      MakeDirectory(root);
+    }
+    else return std::string();
+  #endif
+    std::string dir = root + "/SynapticResynthesis";
+    const char sep = '/';
+#endif
+    if (!MakeDirectory(dir)) return std::string();
+    return dir + sep;
+  }
+} // namespace cache
+} // namespace synaptic
@@ -0,0 +1,161 @@
+/**
+ * @file EpochPublisher.h
+ * @brief Single-writer publication of immutable values to lock-free readers
+ *
+ * The writer publishes a new immutable value with Publish(); readers open a ReadScope and see the
+ * value that was current when the scope opened, for as long as the scope lives. Readers never lock,
+ * allocate or free: they announce the epoch they started in, in a fixed slot, and the writer keeps
+ * every replaced value until no slot still holds an epoch from before its replacement (RCU with
+ * epoch-based reclamation). Replaced values are freed by Publish() and Reclaim(), never by a reader.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace synaptic
+{
+  template <class T>
+  class EpochPublisher
+  {
+  public:
+    // Concurrent read scopes with their own slot; more still work but hold up reclamation
+    static constexpr int kMaxReaders = 32;
+
+    EpochPublisher() = default;
+    EpochPublisher(const EpochPublisher&) = delete;
+    EpochPublisher& operator=(const EpochPublisher&) = delete;
+
+    /** @brief Make @p value the current one; the previous value is freed once no reader can see it */
+    void Publish(std::shared_ptr<const T> value)
+    {
+      std::lock_guard<std::mutex> lock(mWriteMutex);
+      if (value != mOwned)
+      {
+        mCurrent.store(value.get());
+        // Readers announcing this epoch or later can only have loaded the new value
+        const uint64_t retiredAt = mEpoch.fetch_add(1) + 1;
+        if (mOwned) mRetired.push_back({ std::move(mOwned), retiredAt });
+        mOwned = std::move(value);
+      }
+      ReclaimLocked();
+    }
+
+    /** @brief Free replaced values that no reader can still see */
+    void Reclaim()
+    {
+      std::lock_guard<std::mutex> lock(mWriteMutex);
+      ReclaimLocked();
+    }
+
+    /** @brief Replaced values still waiting for readers (diagnostics) */
+    size_t GetRetiredCount() const
+    {
+      std::lock_guard<std::mutex> lock(mWriteMutex);
+      return mRetired.size();
+    }
+
+    /** @brief The current value, pinned until destruction; Get() may be null if nothing was published */
+    class ReadScope
+    {
+    public:
+      explicit ReadScope(const EpochPublisher& publisher) : mPublisher(publisher)
+      {
+        mSlot = publisher.ClaimSlot();
+        if (mSlot)
+        {
+          // Announce the epoch; retry if it moved before the announcement became visible
+          uint64_t e = publisher.mEpoch.load();
+          for (;;)
+          {
+            mSlot->epoch.store(e);
+            const uint64_t now = publisher.mEpoch.load();
+            if (now == e) break;
+            e = now;
+          }
+        }
+        else
+          publisher.mOverflowReaders.fetch_add(1);
+        mValue = publisher.mCurrent.load();
+      }
+
+      ~ReadScope()
+      {
+        if (mSlot)
+        {
+          mSlot->epoch.store(0);
+          mSlot->used.store(false, std::memory_order_release);
+        }
+        else
+          mPublisher.mOverflowReaders.fetch_sub(1);
+      }
+
+      ReadScope(const ReadScope&) = delete;
+      ReadScope& operator=(const ReadScope&) = delete;
+
+      const T* Get() const { return mValue; }
+      const T* operator->() const { return mValue; }
+
+    private:
+      const EpochPublisher& mPublisher;
+      typename EpochPublisher::Slot* mSlot = nullptr;
+      const T* mValue = nullptr;
+    };
+
+  private:
+    struct Slot
+    {
+      std::atomic<bool> used { false };
+      std::atomic<uint64_t> epoch { 0 }; // 0 = not reading
+    };
+
+    struct Retired
+    {
+      std::shared_ptr<const T> value;
+      uint64_t retiredAt;
+    };
+
+    Slot* ClaimSlot() const
+    {
+      for (auto& s : mSlots)
+      {
+        bool expected = false;
+        if (!s.used.load(std::memory_order_relaxed)
+            && s.used.compare_exchange_strong(expected, true, std::memory_order_acquire))
+          return &s;
+      }
+      return nullptr;
+    }
+
+    void ReclaimLocked()
+    {
+      if (mRetired.empty() || mOverflowReaders.load() > 0) return;
+      uint64_t oldest = UINT64_MAX;
+      for (const auto& s : mSlots)
+      {
+        const uint64_t e = s.epoch.load();
+        if (e != 0 && e < oldest) oldest = e;
+      }
+      // A value retired at epoch r is unreachable once every active reader started at r or later
+      size_t kept = 0;
+      for (auto& r : mRetired)
+        if (r.retiredAt > oldest)
+          mRetired[kept++] = std::move(r);
+      mRetired.resize(kept);
+    }
+
+    mutable std::array<Slot, kMaxReaders> mSlots;
+    mutable std::atomic<int> mOverflowReaders { 0 };
+    std::atomic<uint64_t> mEpoch { 1 };
+    std::atomic<const T*> mCurrent { nullptr };
+
+    mutable std::mutex mWriteMutex;
+    std::shared_ptr<const T> mOwned;
+    std::vector<Retired> mRetired;
+  };
+}
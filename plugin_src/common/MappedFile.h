@@ -0,0 +1,100 @@
+/**
+ * @file MappedFile.h
+ * @brief Read-only memory mapping of a whole file
+ *
+ * Lets cache readers parse a file in place instead of reading it into a buffer first.
+ * Paths are UTF-8.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#if defined(_WIN32)
+  #ifndef NOMINMAX
+    #define NOMINMAX
+  #endif
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+namespace synaptic
+{
+  class MappedFile
+  {
+  public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { Close(); }
+
+    /** @brief Map @p path; false if it can't be opened or is empty */
+    bool Open(const std::string& path)
+    {
+      Close();
+#if defined(_WIN32)
+      const int len = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, nullptr, 0);
+      if (len <= 0) return false;
+      std::wstring wide((size_t) len, L'\0');
+      MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, &wide[0], len);
+      HANDLE file = CreateFileW(wide.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                                FILE_ATTRIBUTE_NORMAL, nullptr);
+      if (file == INVALID_HANDLE_VALUE) return false;
+      LARGE_INTEGER size;
+      if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0)
+      {
+        CloseHandle(file);
+        return false;
+      }
+      HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      CloseHandle(file);
+      if (!mapping) return false;
+      void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+      CloseHandle(mapping);
+      if (!view) return false;
+      mData = static_cast<const uint8_t*>(view);
+      mSize = (size_t) size.QuadPart;
+#else
+      const int fd = open(path.c_str(), O_RDONLY);
+      if (fd < 0) return false;
+      struct stat st;
+      if (fstat(fd, &st) != 0 || st.st_size <= 0)
+      {
+        close(fd);
+        return false;
+      }
+      void* view = mmap(nullptr, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      close(fd);
+      if (view == MAP_FAILED) return false;
+      mData = static_cast<const uint8_t*>(view);
+      mSize = (size_t) st.st_size;
+#endif
+      return true;
+    }
+
+    void Close()
+    {
+      if (!mData) return;
+#if defined(_WIN32)
+      UnmapViewOfFile(mData);
+#else
+      munmap(const_cast<uint8_t*>(mData), mSize);
+#endif
+      mData = nullptr;
+      mSize = 0;
+    }
+
+    const uint8_t* Data() const { return mData; }
+    size_t Size() const { return mSize; }
+
+  private:
+    const uint8_t* mData = nullptr;
+    size_t mSize = 0;
+  };
+}
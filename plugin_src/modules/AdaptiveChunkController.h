@@ -0,0 +1,114 @@
+/**
+ * @file AdaptiveChunkController.h
+ * @brief Switches the chunker to a shorter chunk size while the input is percussive
+ *
+ * Long chunks suit sustained material (smoother matches, less CPU); short ones keep attacks from
+ * smearing across a whole chunk. With adaptive chunking on, the chunker reports the rate of onsets
+ * in its input (OnsetDetector) and this controller moves it between the Chunk Size ("steady") and
+ * a shorter brain layer ("transient"): in at kEnterRate onsets per second, back out below
+ * kLeaveRate, and never sooner than kMinDwellSeconds after the last switch.
+ *
+ * Only complete brain layers are used (Brain::GetReadyLayerChunkSizes): the transformer then
+ * matches against that layer at the same size (Brain::ReadScope), and the brain is never
+ * rechunked. The switch itself is AudioStreamChunker::RequestChunkSize, built here and crossfaded
+ * on the audio thread. Output is held back to the steady size's latency whatever size plays
+ * (held decisions and Low Latency's lead count in hops of the steady size), so latency stays what
+ * the host was told. The Chunk Size parameter is not touched.
+ *
+ * Main thread (UISyncManager::OnIdle).
+ */
+
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+#include "plugin_src/brain/Brain.h"
+#include "plugin_src/modules/AudioStreamChunker.h"
+
+namespace synaptic
+{
+  class AdaptiveChunkController
+  {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr double kEnterRate = 2.0;      // onsets per second that switch to the transient size
+    static constexpr double kLeaveRate = 0.75;     // ... and back to the steady size
+    static constexpr double kMinDwellSeconds = 1.5;
+
+    /**
+     * @brief Follow the onset rate; call periodically
+     * @param steadyChunkSize The Chunk Size parameter
+     * @param steadyLatency Chunking latency at the steady size (DSPContext::ComputeChunkingLatencySamples)
+     * @param outputLeadHops The transformer's IChunkBufferTransformer::GetOutputLeadChunks
+     * @return True if a chunk size change was requested
+     */
+    bool Update(bool enabled, int steadyChunkSize, int steadyLatency, int outputLeadHops,
+                AudioStreamChunker& chunker, const Brain& brain, Clock::time_point now = Clock::now())
+    {
+      if (!enabled || steadyChunkSize <= 0)
+      {
+        if (!mActive) return false;
+        mActive = false;
+        chunker.EnableOnsetDetection(false);
+        const bool switched = chunker.GetRequestedChunkSize() != mSteadyChunkSize;
+        if (switched) chunker.RequestChunkSize(mSteadyChunkSize);
+        chunker.SetMinimumLatency(0);
+        return switched;
+      }
+
+      if (!mActive || steadyChunkSize != mSteadyChunkSize)
+      {
+        // Started, or the Chunk Size changed (the parameter already requested it)
+        mActive = true;
+        mSteadyChunkSize = steadyChunkSize;
+        mTransient = false;
+        mLastSwitch = now;
+        mSteadyLatency = -1;
+        chunker.EnableOnsetDetection(true);
+      }
+
+      if (steadyLatency != mSteadyLatency || outputLeadHops != mOutputLeadHops)
+      {
+        // Set on start, and again when the window, Buffer Window or Low Latency moved it
+        mSteadyLatency = steadyLatency;
+        mOutputLeadHops = outputLeadHops;
+        chunker.SetMinimumLatency(steadyLatency, outputLeadHops);
+      }
+
+      const double rate = chunker.GetOnsetRate();
+      const bool dwelled = now - mLastSwitch >= std::chrono::duration<double>(kMinDwellSeconds);
+      if (dwelled && (mTransient ? rate < kLeaveRate : rate >= kEnterRate))
+      {
+        mTransient = !mTransient;
+        mLastSwitch = now;
+      }
+
+      const int target = mTransient ? PickTransientChunkSize(steadyChunkSize, brain.GetReadyLayerChunkSizes())
+                                    : steadyChunkSize;
+      if (target == chunker.GetRequestedChunkSize()) return false;
+      chunker.RequestChunkSize(target);
+      return true;
+    }
+
+    /** @brief The largest ready layer at most half the steady size, or the steady size if none is */
+    static int PickTransientChunkSize(int steadyChunkSize, const std::vector<int>& readyLayers)
+    {
+      int best = 0;
+      for (int cs : readyLayers)
+        if (cs > best && cs * 2 <= steadyChunkSize) best = cs;
+      return best > 0 ? best : steadyChunkSize;
+    }
+
+    bool IsTransient() const { return mActive && mTransient; }
+
+  private:
+    bool mActive = false;
+    bool mTransient = false;
+    int mSteadyChunkSize = 0;
+    int mSteadyLatency = -1;
+    int mOutputLeadHops = 0;
+    Clock::time_point mLastSwitch {};
+  };
+}
@@ -4,6 +4,7 @@
  */
 
 #include "AudioStreamChunker.h"
+#include "plugin_src/audio/FFTPlanner.h"
 #include <algorithm>
 #include <cstring>
 #include <cmath>
@@ -21,12 +22,26 @@ AudioStreamChunker::AudioStreamChunker(int numChannels)
   Configure(mNumChannels, mChunkSize, mBufferWindowSize);
 }
 
+AudioStreamChunker::~AudioStreamChunker()
+{
+  delete mPendingLayout.exchange(nullptr);
+  delete mRetiredLayout.exchange(nullptr);
+}
+
 void AudioStreamChunker::Configure(int numChannels, int chunkSize, int windowSize)
 {
   const int newNumChannels = std::max(1, numChannels);
   const int newChunkSize = std::max(1, chunkSize);
   const int newBufferWindowSize = std::max(1, windowSize);
 
+  // Configured here directly: a requested layout is stale now
+  mLayoutNumChannels.store(newNumChannels, std::memory_order_relaxed);
+  mLayoutBufferWindowSize.store(newBufferWindowSize, std::memory_order_relaxed);
+  delete mPendingLayout.exchange(nullptr, std::memory_order_acq_rel);
+  mRequestedChunkSize.store(newChunkSize, std::memory_order_relaxed);
+  mLayoutWindowsStale.store(false, std::memory_order_relaxed);
+  ReclaimRetiredLayout();
+
   // Check if accumulation buffer needs reallocation
   // Note: Also check if mAccumulation is empty (first-time initialization)
   const bool needsReallocation = (newNumChannels != mNumChannels ||
@@ -36,9 +51,11 @@ void AudioStreamChunker::Configure(int numChannels, int chunkSize, int windowSiz
   mNumChannels = newNumChannels;
   mChunkSize = newChunkSize;
   mBufferWindowSize = newBufferWindowSize;
+  ++mConfigGeneration;
 
   // Configure chunk pool
-  mPool.Configure(mNumChannels, mChunkSize, mBufferWindowSize, kExtraPoolCapacity);
+  const int renderDelay = ComputeRenderDelay(mChunkSize);
+  mPool.Configure(mNumChannels, mChunkSize, mBufferWindowSize, ComputeExtraPoolCapacity(mChunkSize, renderDelay));
 
   if (needsReallocation)
   {
@@ -47,17 +64,21 @@ void AudioStreamChunker::Configure(int numChannels, int chunkSize, int windowSiz
   }
 
   // Configure OLA synthesizer
-  mOLASynthesizer.Configure(mNumChannels, mChunkSize);
+  mOLASynthesizer.Configure(mNumChannels, mChunkSize, ComputeOLACapacity(mChunkSize, renderDelay));
 
   // Reset state
   ResetState();
 
-  // Configure FFT
-  mFFTSize = Window::NextValidFFTSize(mChunkSize);
+  // Configure FFT (cheapest legal size for this chunk size on this machine)
+  mFFTSize = FFTPlanner::Instance().PlanSize(mChunkSize);
   mFFT.Configure(mFFTSize);
 
-  // Keep analysis window in sync
-  mInputAnalysisWindow.Set(mInputAnalysisWindow.GetType(), mChunkSize);
+  // Keep analysis window in sync (and both windows on the latest types, should an adopted layout
+  // have been built with older ones)
+  mInputAnalysisWindow.Set(mAnalysisWindowType.load(std::memory_order_relaxed), mChunkSize);
+  const Window::Type outputType = mOutputWindowType.load(std::memory_order_relaxed);
+  if (mOutputWindow.GetType() != outputType)
+    mOutputWindow.Set(outputType, mChunkSize);
   UpdateSpectralRescale();
 
   // Initialize autotune processor
@@ -71,12 +92,12 @@ void AudioStreamChunker::SetChunkSize(int chunkSize)
 
 void AudioStreamChunker::SetBufferWindowSize(int windowSize)
 {
-  Configure(mNumChannels, mChunkSize, windowSize);
+  Configure(mNumChannels, GetRequestedChunkSize(), windowSize);
 }
 
 void AudioStreamChunker::SetNumChannels(int numChannels)
 {
-  Configure(numChannels, mChunkSize, mBufferWindowSize);
+  Configure(numChannels, GetRequestedChunkSize(), mBufferWindowSize);
 }
 
 void AudioStreamChunker::EnableOverlap(bool enable)
@@ -88,15 +109,34 @@ void AudioStreamChunker::EnableOverlap(bool enable)
   }
 }
 
+// Windows sized for a requested chunk size the audio thread hasn't adopted yet only pass on their
+// type; a requested layout is rebuilt with the new type
+
 void AudioStreamChunker::SetOutputWindow(const Window& w)
 {
+  if (mOutputWindowType.exchange(w.GetType(), std::memory_order_relaxed) != w.GetType())
+    RebuildPendingLayout();
   if (mOutputWindow.GetType() != w.GetType())
     mOLASynthesizer.Reset();
-  mOutputWindow = w;
+  if (w.Size() == mChunkSize)
+    mOutputWindow = w;
+  else if (mOutputWindow.GetType() != w.GetType() || mOutputWindow.Size() != mChunkSize)
+    mOutputWindow.Set(w.GetType(), mChunkSize);
 }
 
 void AudioStreamChunker::SetInputAnalysisWindow(const Window& w)
 {
+  if (mAnalysisWindowType.exchange(w.GetType(), std::memory_order_relaxed) != w.GetType())
+    RebuildPendingLayout();
+  if (w.Size() != mChunkSize)
+  {
+    if (mInputAnalysisWindow.GetType() != w.GetType())
+    {
+      mInputAnalysisWindow.Set(w.GetType(), mChunkSize);
+      UpdateSpectralRescale();
+    }
+    return;
+  }
   if (mInputAnalysisWindow.GetType() != w.GetType() || mInputAnalysisWindow.Size() != w.Size())
   {
     mInputAnalysisWindow = w;
@@ -111,7 +151,204 @@ void AudioStreamChunker::ResetOverlapBuffer()
 
 void AudioStreamChunker::Reset()
 {
-  Configure(mNumChannels, mChunkSize, mBufferWindowSize);
+  Configure(mNumChannels, GetRequestedChunkSize(), mBufferWindowSize);
+}
+
+// ============================================================================
+// Chunk Size Changes During Playback
+// ============================================================================
+
+void AudioStreamChunker::RequestChunkSize(int chunkSize)
+{
+  ReclaimRetiredLayout();
+  const int newChunkSize = std::max(1, chunkSize);
+  if (newChunkSize == GetRequestedChunkSize()) return;
+  mRequestedChunkSize.store(newChunkSize, std::memory_order_relaxed);
+  QueueLayout(newChunkSize);
+}
+
+void AudioStreamChunker::ReclaimRetiredLayout()
+{
+  delete mRetiredLayout.exchange(nullptr, std::memory_order_acq_rel);
+  // The audio thread adopted a layout built before a window type changed
+  if (mLayoutWindowsStale.exchange(false, std::memory_order_relaxed))
+    QueueLayout(GetRequestedChunkSize());
+}
+
+void AudioStreamChunker::QueueLayout(int chunkSize)
+{
+  auto layout = std::make_unique<Layout>();
+  BuildLayout(*layout, chunkSize);
+  // The audio thread never touches a layout it hasn't taken, so one it didn't take can be freed here
+  delete mPendingLayout.exchange(layout.release(), std::memory_order_acq_rel);
+}
+
+void AudioStreamChunker::RebuildPendingLayout()
+{
+  // Taken back, so it's ours to free; the audio thread keeps the current layout meanwhile
+  std::unique_ptr<Layout> stale(mPendingLayout.exchange(nullptr, std::memory_order_acq_rel));
+  if (stale) QueueLayout(stale->chunkSize);
+}
+
+void AudioStreamChunker::BuildLayout(Layout& layout, int chunkSize) const
+{
+  // The audio thread may be swapping the live windows and sizes meanwhile: build only from what the
+  // setters publish atomically
+  const int numChannels = mLayoutNumChannels.load(std::memory_order_relaxed);
+  const int bufferWindowSize = mLayoutBufferWindowSize.load(std::memory_order_relaxed);
+  layout.chunkSize = chunkSize;
+  layout.outputWindow.Set(mOutputWindowType.load(std::memory_order_relaxed), chunkSize);
+  layout.inputAnalysisWindow.Set(mAnalysisWindowType.load(std::memory_order_relaxed), chunkSize);
+
+  // Which window sets the hop depends on whether spectral processing is on once the layout plays,
+  // so size for the longer render delay of the two
+  int renderDelay = ComputeRenderDelay(chunkSize, chunkSize);
+  for (const Window* w : { &layout.outputWindow, &layout.inputAnalysisWindow })
+    renderDelay = std::max(renderDelay, ComputeRenderDelay(chunkSize, ComputeHopSize(chunkSize, w->GetOverlap())));
+
+  layout.pool.Configure(numChannels, chunkSize, bufferWindowSize, ComputeExtraPoolCapacity(chunkSize, renderDelay));
+  layout.ola.Configure(numChannels, chunkSize, ComputeOLACapacity(chunkSize, renderDelay));
+  layout.accumulation.assign(numChannels, std::vector<iplug::sample>(chunkSize, 0.0));
+  layout.fftSize = FFTPlanner::Instance().PlanSize(chunkSize);
+  layout.fft.Configure(layout.fftSize);
+  layout.spectralOLARescale = ComputeSpectralRescale(layout.inputAnalysisWindow, chunkSize);
+  layout.autotuneScratch.Allocate(layout.fftSize, numChannels);
+  layout.morphScratch.Allocate(layout.fftSize);
+}
+
+void AudioStreamChunker::AdoptPendingLayout()
+{
+  // One crossfade at a time: a newer request waits for the current one to finish
+  if (mFadingLayout) return;
+  Layout* next = mPendingLayout.exchange(nullptr, std::memory_order_acq_rel);
+  if (!next) return;
+
+  // A window type changed while the layout was being built (rare): play it as built, and
+  // ReclaimRetiredLayout queues one with the current types
+  if (next->outputWindow.GetType() != mOutputWindowType.load(std::memory_order_relaxed) ||
+      next->inputAnalysisWindow.GetType() != mAnalysisWindowType.load(std::memory_order_relaxed))
+    mLayoutWindowsStale.store(true, std::memory_order_relaxed);
+
+  // What the old layout still has to play: its OLA buffer, or the rest of the chunk being played
+  const bool spectralActive = IsSpectralProcessingActive();
+  if (ShouldUseOverlapAdd(spectralActive))
+  {
+    next->tailRescale = spectralActive ? mSpectralOLARescale : mOutputWindow.GetOverlapRescale();
+  }
+  else
+  {
+    next->tailRescale = 1.0f;
+    mOLASynthesizer.Reset();
+    int idx = -1, frame = 0;
+    if (PeekCurrentOutput(idx, frame) && frame > 0)
+    {
+      const bool windowed = !spectralActive && mOutputWindow.GetOverlap() > 0.0f;
+      mOLASynthesizer.Append(mPool.GetEntry(idx)->outputChunk, frame, windowed ? &mOutputWindow.Coeffs() : nullptr,
+                             ComputeAGC(idx, mAGCEnabled));
+    }
+  }
+
+  // The newest input carries over, so the new layout completes its first chunk sooner
+  const int carried = std::min(mAccumulatedFrames, next->chunkSize);
+  for (int ch = 0; ch < mNumChannels; ++ch)
+    std::memcpy(next->accumulation[ch].data(), mAccumulation[ch].data() + mAccumulatedFrames - carried,
+                sizeof(iplug::sample) * carried);
+
+  SwapLayout(*next);
+  mFadingLayout.reset(next);
+  ++mConfigGeneration;
+
+  // Same timeline as a fresh start that had already pushed the carried frames
+  mAccumulatedFrames = carried;
+  mOutputFrontFrameIndex = 0;
+  mTotalOutputSamplesRendered = mTotalInputSamplesPushed - carried;
+  mCrossfadePos = 0;
+  mCrossfadeLength = mChunkSize;
+}
+
+void AudioStreamChunker::SwapLayout(Layout& layout)
+{
+  std::swap(mChunkSize, layout.chunkSize);
+  std::swap(mPool, layout.pool);
+  std::swap(mOLASynthesizer, layout.ola);
+  mAccumulation.swap(layout.accumulation);
+  std::swap(mFFTSize, layout.fftSize);
+  mFFT.Swap(layout.fft);
+  std::swap(mOutputWindow, layout.outputWindow);
+  std::swap(mInputAnalysisWindow, layout.inputAnalysisWindow);
+  std::swap(mSpectralOLARescale, layout.spectralOLARescale);
+  mAutotuneProcessor.SwapScratch(layout.autotuneScratch);
+  if (mMorph) mMorph->SwapScratch(layout.morphScratch);
+}
+
+void AudioStreamChunker::MixRetiredLayout(iplug::sample** outputs, int nFrames, int chansToWrite, int newFrames)
+{
+  // The new output fades in from its first rendered frame; until then the old tail plays at full
+  // level. Frames after the new output ran out in this block keep the fade where it stopped.
+  const double length = (double) std::max(1, mCrossfadeLength);
+  auto fadeIn = [&](int s) { return std::min(1.0, (mCrossfadePos + std::min(s, newFrames)) / length); };
+
+  for (int s = 0; s < newFrames && mCrossfadePos + s < mCrossfadeLength; ++s)
+  {
+    const double gain = fadeIn(s);
+    for (int ch = 0; ch < chansToWrite; ++ch)
+      if (outputs[ch]) outputs[ch][s] *= gain;
+  }
+
+  if (mCrossfadePos < mCrossfadeLength)
+  {
+    Layout& old = *mFadingLayout;
+    old.ola.MixOutput(outputs, nFrames, chansToWrite, old.tailRescale, [&](int s) { return 1.0 - fadeIn(s); });
+  }
+
+  mCrossfadePos = std::min(mCrossfadePos + newFrames, mCrossfadeLength);
+  if (mCrossfadePos >= mCrossfadeLength)
+  {
+    // Freed off the audio thread; if the previous one wasn't reclaimed yet, try again next block
+    Layout* expected = nullptr;
+    if (mRetiredLayout.compare_exchange_strong(expected, mFadingLayout.get(), std::memory_order_acq_rel))
+      mFadingLayout.release();
+  }
+}
+
+int AudioStreamChunker::ComputeRenderDelay(int chunkSize, int hop) const
+{
+  const int latency = GetMinimumLatency();
+  if (latency <= 0) return chunkSize;
+  // Leading output only plays early while chunks overlap
+  const int lead = hop < chunkSize ? mMinLatencyLeadHops.load(std::memory_order_relaxed) * hop : 0;
+  return std::max(chunkSize, latency + lead);
+}
+
+int AudioStreamChunker::ComputeExtraPoolCapacity(int chunkSize, int renderDelay) const
+{
+  // Output waiting out a render delay longer than a chunk holds on to more chunks
+  const int delayed = (renderDelay + chunkSize - 1) / std::max(1, chunkSize);
+  return kExtraPoolCapacity + std::max(0, delayed - 1);
+}
+
+void AudioStreamChunker::EnableOnsetDetection(bool enable)
+{
+  mDetectOnsets.store(enable, std::memory_order_relaxed);
+  if (!enable) mOnsetRate.store(0.0f, std::memory_order_relaxed);
+}
+
+void AudioStreamChunker::DetectOnset(const AudioChunk& inputChunk, int hopSize)
+{
+  if (!mDetectOnsets.load(std::memory_order_relaxed))
+  {
+    mOnsetDetectorLive = false;
+    return;
+  }
+  // Turned on again: what the detector saw before is stale
+  if (!mOnsetDetectorLive)
+  {
+    mOnsetDetector.Reset();
+    mOnsetDetectorLive = true;
+  }
+  const double sampleRate = mAutotuneProcessor.GetSampleRate();
+  mOnsetDetector.Process(inputChunk, sampleRate > 0.0 ? hopSize / sampleRate : 0.0);
+  mOnsetRate.store((float) mOnsetDetector.GetRate(), std::memory_order_relaxed);
 }
 
 void AudioStreamChunker::SetMorph(std::shared_ptr<IMorph> morph)
@@ -126,6 +363,9 @@ void AudioStreamChunker::SetMorph(std::shared_ptr<IMorph> morph)
 void AudioStreamChunker::PushAudio(iplug::sample** inputs, int nFrames)
 {
   if (!inputs || nFrames <= 0 || mNumChannels <= 0) return;
+  SYNAPTIC_PROFILE_SCOPE(mProfiler, Input);
+
+  AdoptPendingLayout();
 
   mTotalInputSamplesPushed += nFrames;
 
@@ -148,7 +388,7 @@ void AudioStreamChunker::PushAudio(iplug::sample** inputs, int nFrames)
     frameIndex += framesToCopy;
 
     // Determine hop size
-    const int inputHopSize = ComputeInputHopSize();
+    const int inputHopSize = ComputeInputHopSize(mChunkSize);
 
     // Process complete chunks
     while (mAccumulatedFrames >= mChunkSize)
@@ -176,6 +416,16 @@ bool AudioStreamChunker::PopPendingInputChunkIndex(int& outIdx)
   return true;
 }
 
+bool AudioStreamChunker::TakePendingInputChunkIndex(int& outIdx)
+{
+  return mPool.Pending().Pop(outIdx);
+}
+
+void AudioStreamChunker::ReleaseChunk(int idx)
+{
+  mPool.DecRefAndMaybeFree(idx);
+}
+
 const AudioChunk* AudioStreamChunker::GetInputChunk(int idx) const
 {
   return mPool.GetInputChunk(idx);
@@ -224,6 +474,8 @@ void AudioStreamChunker::RenderOutput(iplug::sample** outputs, int nFrames, int
   const int chansToWrite = std::min(outChans, mNumChannels);
   const bool spectralActive = IsSpectralProcessingActive();
   const bool useOverlapAdd = ShouldUseOverlapAdd(spectralActive);
+  const int64_t renderedBefore = mTotalOutputSamplesRendered;
+  mAGCEnabled = agcEnabled;
 
   if (useOverlapAdd)
   {
@@ -233,6 +485,9 @@ void AudioStreamChunker::RenderOutput(iplug::sample** outputs, int nFrames, int
   {
     RenderSequential(outputs, nFrames, chansToWrite, outChans, spectralActive, agcEnabled);
   }
+
+  if (mFadingLayout)
+    MixRetiredLayout(outputs, nFrames, chansToWrite, (int) (mTotalOutputSamplesRendered - renderedBefore));
 }
 
 // ============================================================================
@@ -294,21 +549,38 @@ void AudioStreamChunker::SpectralProcessing(int poolIdx)
   auto* entry = mPool.GetEntry(poolIdx);
   if (!entry) return;
 
+  // Ramped morph/autotune parameters move by the input hop of every chunk, processed or not,
+  // so a ramp that starts while they are idle starts from where they were
+  const int hopSize = ComputeInputHopSize(mChunkSize);
+  mAutotuneProcessor.AdvanceChunk(hopSize);
+  if (mMorph) mMorph->AdvanceChunk(hopSize);
+
   const bool autotuneActive = mAutotuneProcessor.IsActive();
   const bool morphActive = mMorph && mMorph->IsActive();
   const bool spectralActive = morphActive || autotuneActive;
 
   if (spectralActive)
   {
-    // Ensure spectra are computed
-    EnsureChunkSpectrum(entry->inputChunk);
-    EnsureChunkSpectrum(entry->outputChunk);
+    // Ensure spectra are computed (input and output go through one batched FFT pass)
+    {
+      SYNAPTIC_PROFILE_SCOPE(mProfiler, Spectra);
+      AudioChunk* chunks[2] = { &entry->inputChunk, &entry->outputChunk };
+      mFFT.ComputeChunkSpectra(chunks, 2, mInputAnalysisWindow);
+    }
 
     if (autotuneActive)
+    {
+      SYNAPTIC_PROFILE_SCOPE(mProfiler, Autotune);
       mAutotuneProcessor.Process(entry->inputChunk, entry->outputChunk, mFFT);
+    }
 
     if (morphActive)
+    {
+      SYNAPTIC_PROFILE_SCOPE(mProfiler, Morph);
       mMorph->Process(entry->inputChunk, entry->outputChunk, mFFT);
+    }
+
+    SYNAPTIC_PROFILE_SCOPE(mProfiler, IFFT);
 
     // Synthesize back to time domain
     mFFT.ComputeChunkIFFT(entry->outputChunk);
@@ -334,9 +606,12 @@ void AudioStreamChunker::ResetState()
 
 void AudioStreamChunker::UpdateSpectralRescale()
 {
-  const float ovl = mInputAnalysisWindow.GetOverlap();
-  const int hop = std::max(1, static_cast<int>(std::lround(mChunkSize * (1.0 - ovl))));
-  mSpectralOLARescale = ComputeOLARescale(mInputAnalysisWindow, mChunkSize, hop);
+  mSpectralOLARescale = ComputeSpectralRescale(mInputAnalysisWindow, mChunkSize);
+}
+
+float AudioStreamChunker::ComputeSpectralRescale(const Window& analysisWindow, int chunkSize)
+{
+  return ComputeOLARescale(analysisWindow, chunkSize, ComputeHopSize(chunkSize, analysisWindow.GetOverlap()));
 }
 
 bool AudioStreamChunker::IsSpectralProcessingActive() const
@@ -352,17 +627,22 @@ bool AudioStreamChunker::ShouldUseOverlapAdd(bool spectralActive) const
     : (mOutputWindow.GetOverlap() > 0.0f);
 }
 
-int AudioStreamChunker::ComputeInputHopSize() const
+int AudioStreamChunker::ComputeInputHopSize(int chunkSize) const
 {
   const bool spectralActive = IsSpectralProcessingActive();
   const bool overlapActive = mEnableOverlap && (spectralActive
     ? (mInputAnalysisWindow.GetOverlap() > 0.0f)
     : (mOutputWindow.GetOverlap() > 0.0f));
 
-  if (!overlapActive) return mChunkSize;
+  if (!overlapActive) return chunkSize;
 
   const float ovl = spectralActive ? mInputAnalysisWindow.GetOverlap() : mOutputWindow.GetOverlap();
-  return std::max(1, static_cast<int>(std::lround(mChunkSize * (1.0 - ovl))));
+  return ComputeHopSize(chunkSize, ovl);
+}
+
+int AudioStreamChunker::ComputeHopSize(int chunkSize, float overlap)
+{
+  return std::max(1, static_cast<int>(std::lround(chunkSize * (1.0 - overlap))));
 }
 
 bool AudioStreamChunker::ProcessAccumulatedChunk(int hopSize)
@@ -392,7 +672,10 @@ bool AudioStreamChunker::ProcessAccumulatedChunk(int hopSize)
 
   // Compute input spectrum
   if (mFFTSize > 0)
+  {
     mFFT.ComputeChunkSpectrum(entry->inputChunk, mInputAnalysisWindow);
+    DetectOnset(entry->inputChunk, hopSize);
+  }
 
   return true;
 }
@@ -459,17 +742,6 @@ double AudioStreamChunker::ComputeChunkRMS(const AudioChunk& chunk, int numFrame
   return totalSamples > 0 ? std::sqrt(sumSquares / totalSamples) : 0.0;
 }
 
-void AudioStreamChunker::EnsureChunkSpectrum(AudioChunk& chunk)
-{
-  if (mFFTSize <= 0) return;
-  if (chunk.fftSize != mFFTSize ||
-      static_cast<int>(chunk.complexSpectrum.size()) != static_cast<int>(chunk.channelSamples.size()))
-  {
-    chunk.fftSize = 0;  // Signal to recompute
-  }
-  mFFT.ComputeChunkSpectrum(chunk, mInputAnalysisWindow);
-}
-
 float AudioStreamChunker::ComputeAGC(int outputIdx, bool agcEnabled) const
 {
   if (!agcEnabled) return 1.0f;
@@ -523,7 +795,11 @@ void AudioStreamChunker::RenderWithOverlapAdd(iplug::sample** outputs, int nFram
     if (entry && entry->outputChunk.numFrames > 0)
     {
       SpectralProcessing(idx);
-      const float agc = ComputeAGC(idx, agcEnabled);
+      float agc = 1.0f;
+      {
+        SYNAPTIC_PROFILE_SCOPE(mProfiler, AGC);
+        agc = ComputeAGC(idx, agcEnabled);
+      }
 
       // Get window coefficients for non-spectral path
       const std::vector<float>* windowCoeffs = nullptr;
@@ -535,6 +811,7 @@ void AudioStreamChunker::RenderWithOverlapAdd(iplug::sample** outputs, int nFram
       }
 
       // Add to OLA buffer
+      SYNAPTIC_PROFILE_SCOPE(mProfiler, OLA);
       mOLASynthesizer.AddChunk(entry->outputChunk, windowCoeffs, agc, hopSize);
     }
 
@@ -542,10 +819,14 @@ void AudioStreamChunker::RenderWithOverlapAdd(iplug::sample** outputs, int nFram
   }
 
   // Render output with latency control
-  const int64_t samplesAvailableToRender = mTotalInputSamplesPushed - mChunkSize - mTotalOutputSamplesRendered;
+  const int64_t samplesAvailableToRender = mTotalInputSamplesPushed - ComputeRenderDelay(mChunkSize) - mTotalOutputSamplesRendered;
   const int64_t maxToRender = std::max(static_cast<int64_t>(0), samplesAvailableToRender);
 
-  int rendered = mOLASynthesizer.RenderOutput(outputs, nFrames, chansToWrite, rescale, maxToRender);
+  int rendered = 0;
+  {
+    SYNAPTIC_PROFILE_SCOPE(mProfiler, OLA);
+    rendered = mOLASynthesizer.RenderOutput(outputs, nFrames, chansToWrite, rescale, maxToRender);
+  }
   mTotalOutputSamplesRendered += rendered;
 
   // Zero remainder if needed
@@ -560,10 +841,11 @@ void AudioStreamChunker::RenderSequential(iplug::sample** outputs, int nFrames,
                                           int outChans, bool spectralActive, bool agcEnabled)
 {
   auto& output = mPool.Output();
+  const int renderDelay = ComputeRenderDelay(mChunkSize);
 
   for (int s = 0; s < nFrames; ++s)
   {
-    const bool canOutput = (mTotalOutputSamplesRendered < mTotalInputSamplesPushed - mChunkSize);
+    const bool canOutput = (mTotalOutputSamplesRendered < mTotalInputSamplesPushed - renderDelay);
 
     // Zero output first
     for (int ch = 0; ch < outChans; ++ch)
@@ -9,20 +9,38 @@
  * 4. Output synthesis via overlap-add or sequential playback
  *
  * Uses ChunkPool for memory management and OverlapAddSynthesizer for OLA.
+ *
+ * Chunk size changes during playback go through RequestChunkSize: everything sized by the chunk
+ * size (pool, accumulation and OLA buffers, FFT plan, window tables) is built on the calling thread
+ * and handed over through an atomic slot. The audio thread swaps it in at the start of its next
+ * block, keeps the old layout long enough to play out what its OLA buffer already holds, and
+ * crossfades that tail into the new output over one chunk. The old layout goes back through a
+ * second slot and is freed off the audio thread (ReclaimRetiredLayout).
+ *
+ * For adaptive chunk sizes (AdaptiveChunkController) the chunker also detects onsets in its input
+ * spectra and publishes their rate, and can hold output back to a minimum latency: a short
+ * chunk size swapped in for a percussive passage then keeps the latency of the long one, so the
+ * timeline stays put across the switch and the host's latency compensation stays right. Output
+ * that leads its input chunk by a hop (a transformer's Low Latency) is held back by that hop of
+ * whichever size plays.
  */
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <vector>
 #include <memory>
 #include <cstdint>
 
-#include "IPlug_include_in_plug_hdr.h"
+#include "IPlugConstants.h"
 #include "../audio/Window.h"
 #include "../audio/FFT.h"
 #include "../audio/AutotuneProcessor.h"
 #include "../audio/ChunkPool.h"
 #include "../audio/OverlapAddSynthesizer.h"
+#include "../audio/OnsetDetector.h"
+#include "../audio/StageProfiler.h"
 #include "../Structs.h"
 #include "../morph/IMorph.h"
 
@@ -36,6 +54,10 @@ class AudioStreamChunker
 {
 public:
   explicit AudioStreamChunker(int numChannels);
+  ~AudioStreamChunker();
+
+  AudioStreamChunker(const AudioStreamChunker&) = delete;
+  AudioStreamChunker& operator=(const AudioStreamChunker&) = delete;
 
   // === Configuration ===
 
@@ -49,11 +71,55 @@ public:
   void ResetOverlapBuffer();
   void Reset();
 
+  // === Chunk Size Changes During Playback (not the audio thread) ===
+
+  /**
+   * @brief Build the layout for @p chunkSize here and have the audio thread swap it in
+   *
+   * Replaces a requested layout the audio thread hasn't taken yet. Configure() drops a pending
+   * request; the other setters reconfigure at the requested size.
+   */
+  void RequestChunkSize(int chunkSize);
+
+  /** @brief Latest chunk size asked for (by Configure or RequestChunkSize), adopted or not */
+  int GetRequestedChunkSize() const { return mRequestedChunkSize.load(std::memory_order_relaxed); }
+
+  /** @brief Free a layout the audio thread has finished crossfading out */
+  void ReclaimRetiredLayout();
+
+  /**
+   * @brief Output lags input by at least @p frames at every chunk size (0: one chunk, as always)
+   * @param outputLeadHops Input hops the transformer's output runs ahead of its input chunk
+   *   (IChunkBufferTransformer::GetOutputLeadChunks): rendering waits that many hops longer
+   *
+   * Layouts built from here on are sized for the delay; set it before requesting the chunk sizes
+   * it is meant for.
+   */
+  void SetMinimumLatency(int frames, int outputLeadHops = 0)
+  {
+    mMinLatencyLeadHops.store(std::max(0, outputLeadHops), std::memory_order_relaxed);
+    mMinLatency.store(std::max(0, frames), std::memory_order_relaxed);
+  }
+  int GetMinimumLatency() const { return mMinLatency.load(std::memory_order_relaxed); }
+
+  // === Onset Detection (any thread) ===
+
+  /** @brief Run OnsetDetector on every input chunk; off by default */
+  void EnableOnsetDetection(bool enable);
+  /** @brief Recent onsets per second in the input (0 while detection is off) */
+  float GetOnsetRate() const { return mOnsetRate.load(std::memory_order_relaxed); }
+
   // === Accessors ===
 
   int GetChunkSize() const { return mChunkSize; }
   int GetFFTSize() const { return mFFTSize; }
   int GetNumChannels() const { return mNumChannels; }
+  int GetInputHopSize() const { return ComputeInputHopSize(mChunkSize); }
+  /** @brief The input hop a layout at @p chunkSize would advance by with the current windows */
+  int GetInputHopSize(int chunkSize) const { return ComputeInputHopSize(chunkSize); }
+
+  /** @brief Bumped by every Configure(); pool indices from an older generation are invalid */
+  uint32_t GetConfigGeneration() const { return mConfigGeneration; }
 
   void SetMorph(std::shared_ptr<IMorph> morph);
 
@@ -67,6 +133,10 @@ public:
   // === Transformer API ===
 
   bool PopPendingInputChunkIndex(int& outIdx);
+  // Like PopPendingInputChunkIndex, but the caller keeps the pending reference and must
+  // ReleaseChunk() once done (lets a transformer hold chunks across blocks for lookahead)
+  bool TakePendingInputChunkIndex(int& outIdx);
+  void ReleaseChunk(int idx);
   const AudioChunk* GetInputChunk(int idx) const;
   AudioChunk* GetOutputChunk(int idx);
   void CommitOutputChunk(int idx, int numFrames);
@@ -94,22 +164,56 @@ public:
 
   void SpectralProcessing(int poolIdx);
 
+#if SYNAPTIC_PROFILE
+  /** @brief Stage timings go to @p profiler (null: none) */
+  void SetProfiler(StageProfiler* profiler) { mProfiler = profiler; }
+#endif
+
 private:
   static constexpr int kExtraPoolCapacity = 8;
 
+  /** @brief Everything sized by the chunk size, swapped in as a whole by AdoptPendingLayout */
+  struct Layout
+  {
+    int chunkSize = 0;
+    ChunkPool pool;
+    OverlapAddSynthesizer ola;
+    std::vector<std::vector<iplug::sample>> accumulation;
+    int fftSize = 0;
+    FFTProcessor fft;
+    Window outputWindow;
+    Window inputAnalysisWindow;
+    float spectralOLARescale = 1.0f;
+    AutotuneScratch autotuneScratch;
+    MorphScratch morphScratch;
+    float tailRescale = 1.0f; // once retired: rescale of what is left in ola
+  };
+
   // === Private Helper Methods ===
 
   void ResetState();
   void UpdateSpectralRescale();
+  static float ComputeSpectralRescale(const Window& analysisWindow, int chunkSize);
+  void QueueLayout(int chunkSize);
+  void RebuildPendingLayout();
+  void BuildLayout(Layout& layout, int chunkSize) const;
+  void AdoptPendingLayout();
+  void SwapLayout(Layout& layout);
+  void MixRetiredLayout(iplug::sample** outputs, int nFrames, int chansToWrite, int newFrames);
+  int ComputeRenderDelay(int chunkSize, int hop) const;
+  int ComputeRenderDelay(int chunkSize) const { return ComputeRenderDelay(chunkSize, ComputeInputHopSize(chunkSize)); }
+  static int ComputeOLACapacity(int chunkSize, int renderDelay) { return chunkSize + renderDelay; }
+  int ComputeExtraPoolCapacity(int chunkSize, int renderDelay) const;
+  void DetectOnset(const AudioChunk& inputChunk, int hopSize);
   bool IsSpectralProcessingActive() const;
   bool ShouldUseOverlapAdd(bool spectralActive) const;
-  int ComputeInputHopSize() const;
+  int ComputeInputHopSize(int chunkSize) const;
+  static int ComputeHopSize(int chunkSize, float overlap);
   bool ProcessAccumulatedChunk(int hopSize);
   void AddToWindow(int poolIdx);
   void AddToPending(int poolIdx);
   void ShiftAccumulationBuffer(int hopSize);
   double ComputeChunkRMS(const AudioChunk& chunk, int numFrames) const;
-  void EnsureChunkSpectrum(AudioChunk& chunk);
   float ComputeAGC(int outputIdx, bool agcEnabled) const;
   void RenderWithOverlapAdd(iplug::sample** outputs, int nFrames, int chansToWrite,
                             int outChans, bool spectralActive, bool agcEnabled);
@@ -123,6 +227,7 @@ private:
   int mChunkSize = 3000;
   int mBufferWindowSize = 1;
   bool mEnableOverlap = true;
+  uint32_t mConfigGeneration = 0;
 
   // Pool and synthesis
   ChunkPool mPool;
@@ -147,6 +252,33 @@ private:
   int64_t mTotalInputSamplesPushed = 0;
   int64_t mTotalOutputSamplesRendered = 0;
   int mOutputFrontFrameIndex = 0;
+  bool mAGCEnabled = false; // as of the last RenderOutput
+
+  // Chunk size changes during playback
+  std::atomic<int> mRequestedChunkSize { 0 };
+  std::atomic<Layout*> mPendingLayout { nullptr };  // built by RequestChunkSize, taken by the audio thread
+  std::atomic<Layout*> mRetiredLayout { nullptr };  // crossfaded out, freed by ReclaimRetiredLayout
+  std::unique_ptr<Layout> mFadingLayout;            // audio thread: old layout whose tail is playing out
+  int mCrossfadePos = 0;
+  int mCrossfadeLength = 0;
+  std::atomic<int> mMinLatency { 0 };
+  std::atomic<int> mMinLatencyLeadHops { 0 };
+  // What BuildLayout builds from, as last configured or set: the audio thread swaps the live ones
+  std::atomic<int> mLayoutNumChannels { 2 };
+  std::atomic<int> mLayoutBufferWindowSize { 1 };
+  std::atomic<Window::Type> mOutputWindowType { Window::Type::Hann };
+  std::atomic<Window::Type> mAnalysisWindowType { Window::Type::Hann };
+  std::atomic<bool> mLayoutWindowsStale { false }; // adopted a layout built with older window types
+
+  // Onset detection
+  std::atomic<bool> mDetectOnsets { false };
+  std::atomic<float> mOnsetRate { 0.0f };
+  OnsetDetector mOnsetDetector;   // audio thread
+  bool mOnsetDetectorLive = false; // audio thread: detector state is from the current run
+
+#if SYNAPTIC_PROFILE
+  StageProfiler* mProfiler = nullptr;
+#endif
 };
 
 } // namespace synaptic
@@ -8,6 +8,8 @@
 #include "plugin_src/ui/core/ProgressOverlayManager.h"
 #include "plugin_src/ui/core/UIConstants.h"
 #include "plugin_src/audio/DSPContext.h"
+#include "plugin_src/audio/FFTPlanner.h"
+#include "plugin_src/audio/ReplayCapture.h"
 #include "plugin_src/brain/Brain.h"
 #include "plugin_src/brain/BrainManager.h"
 #include "plugin_src/params/ParameterManager.h"
@@ -22,6 +24,9 @@
 #include "plugin_src/Structs.h"
 #include "plugin_src/ui/controls/UIControls.h"
 
+#include <algorithm>
+#include <cstdlib>
+
 namespace synaptic {
 
 UISyncManager::UISyncManager(iplug::Plugin* plugin,
@@ -61,6 +66,7 @@ void UISyncManager::OnUIClose()
     overlayMgr->SetSynapticUI(nullptr);
   mUI = nullptr;
   mNeedsInitialUIRebuild = true;
+  mReportedFFTPlanChunkSize = 0;
 }
 
 void UISyncManager::OnRestoreState()
@@ -106,7 +112,7 @@ void UISyncManager::SyncBrainUIState()
   }
   mUI->updateBrainFileList(uiEntries);
 
-  mUI->updateBrainState(mBrainManager->UseExternal(), mBrainManager->ExternalPath());
+  mUI->updateBrainState(mBrainManager->UseExternal(), mBrainManager->ExternalPath(), mBrainManager->IsExternalChanged());
 
   auto* compactToggle = mUI->getCompactModeToggle();
   if (compactToggle)
@@ -114,6 +120,139 @@ void UISyncManager::SyncBrainUIState()
     compactToggle->SetValue(mBrain->GetUseCompactFormat() ? 1.0 : 0.0);
     compactToggle->SetDirty(false);
   }
+
+  const std::vector<int> layers = mBrainManager->GetLayerChunkSizes();
+  const auto& layerToggles = mUI->getBrainLayerToggles();
+  for (size_t i = 0; i < layerToggles.size(); ++i)
+  {
+    const int layerSize = BrainManager::kLayerPresetSizes[i];
+    const bool kept = std::find(layers.begin(), layers.end(), layerSize) != layers.end();
+    layerToggles[i]->SetValue(kept ? 1.0 : 0.0);
+    layerToggles[i]->SetDirty(false);
+  }
+  if (auto* adaptiveToggle = mUI->getAdaptiveChunkingToggle())
+  {
+    adaptiveToggle->SetValue(mBrainManager->IsAdaptiveChunkingEnabled() ? 1.0 : 0.0);
+    adaptiveToggle->SetDirty(false);
+  }
+  if (auto* cacheToggle = mUI->getAnalysisCacheToggle())
+  {
+    cacheToggle->SetValue(mBrainManager->IsAnalysisCacheEnabled() ? 1.0 : 0.0);
+    cacheToggle->SetDirty(false);
+  }
+  SyncBrainLayerInfo();
+
+  mUI->updateResumableImport(mBrainManager->GetResumableImportCount());
+#endif
+}
+
+void UISyncManager::SyncBrainLayerInfo()
+{
+#if IPLUG_EDITOR
+  if (!mUI || !mBrain) return;
+
+  std::string text;
+  for (const auto& layer : mBrain->GetLayerInfo())
+  {
+    char buf[64];
+    const std::string name = layer.chunkSize >= 1024 && layer.chunkSize % 1024 == 0
+      ? std::to_string(layer.chunkSize / 1024) + "K" : std::to_string(layer.chunkSize);
+    if (layer.filesReady < layer.totalFiles)
+      snprintf(buf, sizeof(buf), "%s%s %d/%d", name.c_str(), layer.active ? "*" : "", layer.filesReady, layer.totalFiles);
+    else
+      snprintf(buf, sizeof(buf), "%s%s %.1f MB", name.c_str(), layer.active ? "*" : "", layer.memoryBytes / (1024.0 * 1024.0));
+    if (!text.empty()) text += " | ";
+    text += buf;
+  }
+  if (mAdaptiveChunking.IsTransient() && mChunker)
+    text += " | playing " + std::to_string(mChunker->GetRequestedChunkSize());
+  mUI->updateBrainLayerInfo(text);
+#endif
+}
+
+void UISyncManager::SyncFFTPlanInfo()
+{
+#if IPLUG_EDITOR
+  if (!mUI || !mDSPConfig) return;
+
+  const FFTPlanInfo plan = FFTPlanner::Instance().Plan(mDSPConfig->chunkSize);
+  char buf[64];
+  snprintf(buf, sizeof(buf), "FFT %d (+%.1f%% padding)", plan.fftSize, plan.paddingRatio * 100.0);
+  mUI->updateFFTPlanInfo(buf);
+  mReportedFFTPlanChunkSize = mDSPConfig->chunkSize;
+#endif
+}
+
+void UISyncManager::SyncMatchCacheStats()
+{
+#if IPLUG_EDITOR
+  if (!mUI || !mDSPContext) return;
+
+  std::string text;
+  auto transformer = mDSPContext->GetTransformer();
+  if (auto* sb = dynamic_cast<const BaseSampleBrainTransformer*>(transformer.get()))
+  {
+    const MatchCache::Stats stats = sb->GetMatchCacheStats();
+    if (stats.Lookups() > 0)
+    {
+      char buf[64];
+      snprintf(buf, sizeof(buf), "Cache %.0f%% hits (%llu)", stats.HitRate() * 100.0,
+               (unsigned long long) stats.Lookups());
+      text = buf;
+    }
+  }
+  mUI->updateMatchCacheInfo(text);
+#endif
+}
+
+#if SYNAPTIC_PROFILE
+void UISyncManager::DrainProfiler()
+{
+  if (!mDSPContext) return;
+  // Drained even with the editor closed, so the ring never fills up; only shown blocks are kept
+  mDSPContext->GetProfiler().Drain([this](const StageProfiler::BlockRecord& record) { mProfileStats.Add(record); });
+  if (!mUI) mProfileStats.Reset();
+}
+
+void UISyncManager::SyncProfilerInfo()
+{
+#if IPLUG_EDITOR
+  if (!mUI || !mDSPContext) return;
+
+  std::vector<std::string> rows;
+  for (const auto& row : mProfileStats.Summarize())
+  {
+    char buf[96];
+    snprintf(buf, sizeof(buf), "%-9s p50 %5.1f%%   p99 %5.1f%%   max %6.1f%%", row.name.c_str(),
+             row.p50 * 100.f, row.p99 * 100.f, row.max * 100.f);
+    rows.push_back(buf);
+  }
+  char buf[96];
+  snprintf(buf, sizeof(buf), "%d blocks, %llu dropped (share of block budget)", mProfileStats.GetBlockCount(),
+           (unsigned long long) mDSPContext->GetProfiler().TakeDroppedCount());
+  rows.push_back(buf);
+  mUI->updateProfilerRows(rows);
+  mProfileStats.Reset();
+#endif
+}
+#endif
+
+void UISyncManager::SyncReplayCaptureInfo()
+{
+#if IPLUG_EDITOR
+  if (!mUI || !mDSPContext) return;
+
+  const ReplayCapture::Status status = mDSPContext->GetReplayCapture().GetStatus();
+  char buf[96];
+  if (status.path.empty())
+    snprintf(buf, sizeof(buf), "Not recording");
+  else if (status.active)
+    snprintf(buf, sizeof(buf), status.recording ? "Recording %.1f s" : "Saving...", status.seconds);
+  else if (status.lastSaved)
+    snprintf(buf, sizeof(buf), "Saved %.1f s (%s)", status.seconds, ReplayEndReasonName(status.lastEnd));
+  else
+    snprintf(buf, sizeof(buf), "Not saved (%s)", ReplayEndReasonName(status.lastEnd));
+  mUI->updateReplayCaptureInfo(buf, status.path);
 #endif
 }
 
@@ -207,16 +346,8 @@ void UISyncManager::DrainUiQueue()
         mWindowCoordinator->UpdateChunkerWindowing(*mDSPConfig, mDSPContext->GetTransformerRaw());
 
       // Update latency
-      if (mDSPContext)
-      {
-        auto transformer = mDSPContext->GetTransformer();
-        if (transformer)
-        {
-          int latency = mDSPConfig->chunkSize + transformer->GetAdditionalLatencySamples(
-            mDSPConfig->chunkSize, mDSPConfig->bufferWindowSize);
-          mPlugin->SetLatency(latency);
-        }
-      }
+      if (mDSPContext && mDSPContext->GetTransformer())
+        mPlugin->SetLatency(mDSPContext->ComputeLatencySamples(mDSPConfig->chunkSize, mDSPConfig->bufferWindowSize));
 
 #if IPLUG_EDITOR
       SetPendingUpdate(PendingUpdate::RebuildTransformer);
@@ -228,6 +359,26 @@ void UISyncManager::DrainUiQueue()
 void UISyncManager::OnIdle()
 {
   DrainUiQueue();
+#if SYNAPTIC_PROFILE
+  DrainProfiler();
+#endif
+
+  // Brain snapshots the audio thread has moved past would otherwise wait for the next edit
+  if (mBrain)
+    mBrain->ReclaimSnapshots();
+  // Likewise a chunker layout retired by a chunk size change
+  if (mChunker)
+    mChunker->ReclaimRetiredLayout();
+
+  // Adaptive chunk size follows the input's onset rate; a replay can't reproduce the switches
+  if (mChunker && mBrain && mDSPConfig && mDSPContext)
+  {
+    const IChunkBufferTransformer* transformer = mDSPContext->GetTransformerRaw();
+    const int steadyLatency = mDSPContext->ComputeChunkingLatencySamples(mDSPConfig->chunkSize, mDSPConfig->bufferWindowSize);
+    if (mAdaptiveChunking.Update(mBrainManager->IsAdaptiveChunkingEnabled(), mDSPConfig->chunkSize, steadyLatency,
+                                 transformer ? transformer->GetOutputLeadChunks() : 0, *mChunker, *mBrain))
+      mDSPContext->GetReplayCapture().End(ReplayEndReason::ConfigChanged);
+  }
 
 #if IPLUG_EDITOR
   if (mUI)
@@ -243,6 +394,22 @@ void UISyncManager::OnIdle()
       SyncBrainUIState();
     }
 
+    if (mDSPConfig && mDSPConfig->chunkSize != mReportedFFTPlanChunkSize)
+      SyncFFTPlanInfo();
+
+    // Cache counters change every block; once a second is plenty for a readout
+    const auto now = std::chrono::steady_clock::now();
+    if (now - mLastMatchCacheReport >= std::chrono::seconds(1))
+    {
+      mLastMatchCacheReport = now;
+      SyncMatchCacheStats();
+      SyncBrainLayerInfo();
+#if SYNAPTIC_PROFILE
+      SyncProfilerInfo();
+#endif
+      SyncReplayCaptureInfo();
+    }
+
     if (auto* overlayMgr = ui::ProgressOverlayManager::Get())
       overlayMgr->ProcessPendingUpdates(mUI);
 
@@ -299,15 +466,7 @@ void UISyncManager::OnIdle()
             mPlugin->NInChansConnected(),
             mDSPConfig->chunkSize,
             MakeProgressCallback(overlayMgr),
-            [this, overlayMgr](bool wasCancelled) {
-              if (overlayMgr)
-                overlayMgr->Hide();
-              if (!wasCancelled)
-              {
-                SetPendingUpdate(PendingUpdate::BrainSummary);
-                MarkHostStateDirty();
-              }
-            }
+            MakeImportCompletionCallback(overlayMgr)
           );
         }
       }
@@ -333,6 +492,11 @@ bool UISyncManager::OnMessage(int msgTag, int ctrlTag, int dataSize, const void*
     case kMsgTagBrainCreateNew: return HandleBrainCreateNewMsg();
     case kMsgTagBrainSetCompactMode: return HandleBrainSetCompactModeMsg(ctrlTag);
     case kMsgTagCancelOperation: return HandleCancelOperationMsg();
+    case kMsgTagBrainSetLayer: return HandleBrainSetLayerMsg(ctrlTag);
+    case kMsgTagBrainSetAdaptiveChunking: return HandleBrainSetAdaptiveChunkingMsg(ctrlTag);
+    case kMsgTagBrainSetAnalysisCache: return HandleBrainSetAnalysisCacheMsg(ctrlTag);
+    case kMsgTagBrainResumeImport: return HandleBrainResumeImportMsg();
+    case kMsgTagToggleReplayCapture: return HandleToggleReplayCaptureMsg();
     default: return false;
   }
 }
@@ -440,6 +604,75 @@ bool UISyncManager::HandleBrainSetCompactModeMsg(int enabled)
   return true;
 }
 
+bool UISyncManager::HandleBrainResumeImportMsg()
+{
+  if (mBrainManager->GetResumableImportCount() <= 0 || mBrainManager->IsOperationInProgress()) return false;
+
+  // Capture overlay manager at operation start for multi-instance safety
+  auto* overlayMgr = ui::ProgressOverlayManager::Get();
+  if (overlayMgr)
+    overlayMgr->Show("Importing Files", "Resuming...", 0.0f, true);
+  mBrainManager->ResumeImportAsync(
+    (int)mPlugin->GetSampleRate(),
+    mPlugin->NInChansConnected(),
+    mDSPConfig->chunkSize,
+    MakeProgressCallback(overlayMgr),
+    MakeImportCompletionCallback(overlayMgr));
+  SetPendingUpdate(PendingUpdate::BrainSummary);
+  return true;
+}
+
+bool UISyncManager::HandleToggleReplayCaptureMsg()
+{
+  if (!mDSPContext) return false;
+  ReplayCapture& capture = mDSPContext->GetReplayCapture();
+  if (capture.IsActive())
+  {
+    capture.Stop();
+    return true;
+  }
+  // An edit would end the capture at once
+  if (mBrainManager->IsOperationInProgress()) return false;
+
+  ReplayHeader header;
+  header.sampleRate = mPlugin->GetSampleRate();
+  header.inChans = mPlugin->NInChansConnected();
+  header.outChans = mPlugin->NOutChansConnected();
+  header.config = *mDSPConfig;
+  header.fftSize = mDSPContext->GetChunker().GetFFTSize();
+  header.numParams = mPlugin->NParams();
+  header.bindings = mParamManager->GetBindings();
+  return capture.Start(ReplayCapture::NewPath(), std::move(header), *mBrain);
+}
+
+bool UISyncManager::HandleBrainSetLayerMsg(int ctrlTag)
+{
+  if (ctrlTag == 0) return false;
+  mBrainManager->SetLayerEnabled(std::abs(ctrlTag), ctrlTag > 0);
+  // Layer choice is part of the plugin state
+  MarkHostStateDirty();
+  SetPendingUpdate(PendingUpdate::BrainSummary);
+  return true;
+}
+
+bool UISyncManager::HandleBrainSetAdaptiveChunkingMsg(int enabled)
+{
+  mBrainManager->SetAdaptiveChunking(enabled != 0);
+  // Saved with the layers
+  MarkHostStateDirty();
+  SetPendingUpdate(PendingUpdate::BrainSummary);
+  return true;
+}
+
+bool UISyncManager::HandleBrainSetAnalysisCacheMsg(int enabled)
+{
+  mBrainManager->SetAnalysisCacheEnabled(enabled != 0);
+  // Saved with the layers
+  MarkHostStateDirty();
+  SetPendingUpdate(PendingUpdate::BrainSummary);
+  return true;
+}
+
 synaptic::BrainManager::ProgressFn UISyncManager::MakeProgressCallback(
   ui::ProgressOverlayManager* overlayMgr)
 {
@@ -454,6 +687,19 @@ synaptic::BrainManager::ProgressFn UISyncManager::MakeProgressCallback(
   };
 }
 
+synaptic::BrainManager::CompletionFn UISyncManager::MakeImportCompletionCallback(
+  ui::ProgressOverlayManager* overlayMgr)
+{
+  return [this, overlayMgr](bool) {
+    if (overlayMgr)
+      overlayMgr->Hide();
+    // Files are committed one by one, so a cancelled import still changed the brain (and left
+    // the rest to resume)
+    SetPendingUpdate(PendingUpdate::BrainSummary);
+    SetPendingUpdate(PendingUpdate::MarkDirty);
+  };
+}
+
 synaptic::BrainManager::CompletionFn UISyncManager::MakeStandardCompletionCallback(
   ui::ProgressOverlayManager* overlayMgr)
 {
@@ -9,10 +9,13 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <vector>
 #include <memory>
 #include <functional>
 #include "plugin_src/brain/BrainManager.h"
+#include "plugin_src/audio/StageProfiler.h"
+#include "plugin_src/modules/AdaptiveChunkController.h"
 #include "IPlug_include_in_plug_hdr.h"
 
 namespace synaptic {
@@ -103,6 +106,14 @@ private:
   void DrainUiQueue();
   void SyncBrainUIState();
   void SyncAllUIState();
+  void SyncFFTPlanInfo();
+  void SyncMatchCacheStats();
+  void SyncBrainLayerInfo();
+#if SYNAPTIC_PROFILE
+  void DrainProfiler();
+  void SyncProfilerInfo();
+#endif
+  void SyncReplayCaptureInfo();
 
   // Message handlers
   bool HandleBrainAddFileMsg(int dataSize, const void* pData);
@@ -114,6 +125,13 @@ private:
   bool HandleBrainCreateNewMsg();
   bool HandleBrainSetCompactModeMsg(int enabled);
   bool HandleCancelOperationMsg();
+  bool HandleBrainSetLayerMsg(int ctrlTag);
+  bool HandleBrainSetAdaptiveChunkingMsg(int enabled);
+  bool HandleBrainSetAnalysisCacheMsg(int enabled);
+  bool HandleBrainResumeImportMsg();
+  bool HandleToggleReplayCaptureMsg();
+  // Completion of an import or resumed import: files committed before a cancel show up too
+  synaptic::BrainManager::CompletionFn MakeImportCompletionCallback(ui::ProgressOverlayManager* overlayMgr);
 
   // Callbacks - take overlay manager for multi-instance safety
   synaptic::BrainManager::ProgressFn MakeProgressCallback(ui::ProgressOverlayManager* overlayMgr);
@@ -135,6 +153,12 @@ private:
   // State
   std::atomic<uint32_t> mPendingUpdates { 0 };
   bool mNeedsInitialUIRebuild { true };
+  int mReportedFFTPlanChunkSize { 0 };
+  std::chrono::steady_clock::time_point mLastMatchCacheReport {};
+#if SYNAPTIC_PROFILE
+  StageProfileStats mProfileStats; // blocks since the last report
+#endif
+  AdaptiveChunkController mAdaptiveChunking;
 
   // Pending file import state
   std::vector<synaptic::BrainManager::FileData> mPendingImportFiles;
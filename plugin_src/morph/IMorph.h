@@ -5,6 +5,8 @@
 #endif
 
 #include <memory>
+#include <utility>
+#include <vector>
 #include "../params/DynamicParamSchema.h"
 #include "../Structs.h" // for AudioChunk
 
@@ -12,6 +14,50 @@ namespace synaptic
 {
   class FFTProcessor; // fwd decl
 
+  struct CepstralScratch
+  {
+    std::vector<float> logMagA;
+    std::vector<float> logMagB;
+    std::vector<float> cepA;
+    std::vector<float> cepB;
+    std::vector<float> cepC;
+    std::vector<float> logMagC;
+
+    // Only grows: buffers sized for a larger FFT fit a smaller one without reallocating
+    void EnsureSize(int N)
+    {
+      if ((int) logMagA.size() < N) logMagA.assign((size_t) N, 0.0f);
+      if ((int) logMagB.size() < N) logMagB.assign((size_t) N, 0.0f);
+      if ((int) cepA.size()    < N) cepA.assign((size_t) N, 0.0f);
+      if ((int) cepB.size()    < N) cepB.assign((size_t) N, 0.0f);
+      if ((int) cepC.size()    < N) cepC.assign((size_t) N, 0.0f);
+      if ((int) logMagC.size() < N) logMagC.assign((size_t) N, 0.0f);
+    }
+  };
+
+  // Morph buffers whose size follows the FFT size. A morph allocates its own in OnReset; the
+  // chunker allocates one with every layout it prepares for a chunk size change and hands it over
+  // when the layout is swapped in (IMorph::SwapScratch), so the new size never allocates on the
+  // audio thread.
+  struct MorphScratch
+  {
+    CepstralScratch cepstral;      // CrossSynthesisMorph, WaveMorph
+    std::vector<int> binBand;      // SpectralVocoderMorph: lower band index per bin
+    std::vector<float> binWeight;  // weight of the upper band (lower gets 1-w)
+
+    void Allocate(int fftSize)
+    {
+      if (fftSize <= 0) return;
+      cepstral.EnsureSize(fftSize);
+      const size_t numBins = (size_t) fftSize / 2 + 1;
+      if (binBand.size() < numBins)
+      {
+        binBand.assign(numBins, 0);
+        binWeight.assign(numBins, 0.0f);
+      }
+    }
+  };
+
   struct IMorph : public IDynamicParamOwner
   {
     virtual ~IMorph() {}
@@ -24,6 +70,14 @@ namespace synaptic
     // Whether this morph engages spectral processing (controls windowing/OLA decisions)
     virtual bool IsActive() const { return true; }
 
+    // Called on the audio thread once per output chunk, before Process (if active), with the input
+    // hop (in samples) the chunk spans; ramped parameters (ParamRamp) advance here
+    virtual void AdvanceChunk(int /*hopSamples*/) {}
+
+    // Called on the audio thread when the chunker swaps in a layout: takes the layout's scratch
+    // (sized for its FFT) and leaves ours to be freed with the layout being retired
+    void SwapScratch(MorphScratch& scratch) { std::swap(mScratch, scratch); }
+
     // Default empty dynamic param implementation
     void GetParamDescs(std::vector<ExposedParamDesc>& out, bool /*includeAll*/) const override { out.clear(); }
     bool GetParamAsNumber(const std::string&, double&) const override { return false; }
@@ -32,6 +86,9 @@ namespace synaptic
     bool SetParamFromNumber(const std::string&, double) override { return false; }
     bool SetParamFromBool(const std::string&, bool) override { return false; }
     bool SetParamFromString(const std::string&, const std::string&) override { return false; }
+
+  protected:
+    MorphScratch mScratch;
   };
 }
 
@@ -6,31 +6,12 @@
 
 #include "../Structs.h" // for AudioChunk::ComplexSpectrum
 #include "../audio/FFT.h"
+#include "IMorph.h" // for CepstralScratch
 #include <cmath>
 #include <algorithm> // for std::min
 
 namespace synaptic
 {
-  struct CepstralScratch
-  {
-    std::vector<float> logMagA;
-    std::vector<float> logMagB;
-    std::vector<float> cepA;
-    std::vector<float> cepB;
-    std::vector<float> cepC;
-    std::vector<float> logMagC;
-
-    void EnsureSize(int N)
-    {
-      if ((int) logMagA.size() != N) logMagA.assign((size_t) N, 0.0f);
-      if ((int) logMagB.size() != N) logMagB.assign((size_t) N, 0.0f);
-      if ((int) cepA.size()    != N) cepA.assign((size_t) N, 0.0f);
-      if ((int) cepB.size()    != N) cepB.assign((size_t) N, 0.0f);
-      if ((int) cepC.size()    != N) cepC.assign((size_t) N, 0.0f);
-      if ((int) logMagC.size() != N) logMagC.assign((size_t) N, 0.0f);
-    }
-  };
-
   // Shared cross-synthesis implementation, migrated from legacy Morph class
   inline void LogApply(
     std::vector<std::vector<float>>& a,
@@ -2,6 +2,8 @@
 
 #include "../IMorph.h"
 #include "../MorphUtils.h"
+#include "../../audio/FFTPlanner.h"
+#include "../../audio/ParamRamp.h"
 
 namespace synaptic
 {
@@ -14,9 +16,20 @@ namespace synaptic
       Cepstral
     };
 
-    void OnReset(double /*sampleRate*/, int fftSize, int /*numChannels*/) override
+    void OnReset(double sampleRate, int fftSize, int /*numChannels*/) override
     {
-      mCepstralScratch.EnsureSize(fftSize);
+      // Callers pass the chunk size; the spectra we receive use the padded FFT size
+      mScratch.Allocate(FFTPlanner::Instance().PlanSize(fftSize));
+      mMorphAmount.Reset(sampleRate);
+      mPhaseMorphAmount.Reset(sampleRate);
+      mEmphasis.Reset(sampleRate);
+    }
+
+    void AdvanceChunk(int hopSamples) override
+    {
+      mChunkMorphAmount = mMorphAmount.Advance(hopSamples).Mid();
+      mChunkPhaseMorphAmount = mPhaseMorphAmount.Advance(hopSamples).Mid();
+      mChunkEmphasis = mEmphasis.Advance(hopSamples).Mid();
     }
 
     void Process(AudioChunk& a, AudioChunk& b, FFTProcessor& fft) override
@@ -26,13 +39,13 @@ namespace synaptic
       if (mDomain == MorphDomain::Log)
       {
         LogApply(a.complexSpectrum, b.complexSpectrum, b.fftSize,
-                            (float) mMorphAmount, (float) mPhaseMorphAmount);
+                            (float) mChunkMorphAmount, (float) mChunkPhaseMorphAmount);
       }
       else
       {
         CepstralApply(a.complexSpectrum, b.complexSpectrum, b.fftSize,
-                      (float) mMorphAmount, (float) mPhaseMorphAmount, (float) mEmphasis,
-                      fft, mCepstralScratch);
+                      (float) mChunkMorphAmount, (float) mChunkPhaseMorphAmount, (float) mChunkEmphasis,
+                      fft, mScratch.cepstral);
       }
     }
 
@@ -84,19 +97,34 @@ namespace synaptic
       }
     }
 
+    // In GetParamDescs(out, true) order
+    enum Slot { kSlotMorphAmount, kSlotPhaseMorphAmount, kSlotDomain, kSlotEmphasis };
+
+    bool SetParamSlot(int slot, double value) override
+    {
+      switch (slot)
+      {
+        case kSlotMorphAmount: mMorphAmount.SetTarget(value); return true;
+        case kSlotPhaseMorphAmount: mPhaseMorphAmount.SetTarget(value); return true;
+        case kSlotDomain: mDomain = (int) value == 1 ? MorphDomain::Cepstral : MorphDomain::Log; return true;
+        case kSlotEmphasis: mEmphasis.SetTarget(value); return true;
+      }
+      return false;
+    }
+
     bool SetParamFromNumber(const std::string& id, double v) override
     {
-      if (id == "morphAmount") { mMorphAmount = v; return true; }
-      if (id == "phaseMorphAmount") { mPhaseMorphAmount = v; return true; }
-      if (id == "emphasis") { mEmphasis = v; return true; }
+      if (id == "morphAmount") return SetParamSlot(kSlotMorphAmount, v);
+      if (id == "phaseMorphAmount") return SetParamSlot(kSlotPhaseMorphAmount, v);
+      if (id == "emphasis") return SetParamSlot(kSlotEmphasis, v);
       return false;
     }
 
     bool GetParamAsNumber(const std::string& id, double& out) const override
     {
-      if (id == "morphAmount") { out = mMorphAmount; return true; }
-      if (id == "phaseMorphAmount") { out = mPhaseMorphAmount; return true; }
-      if (id == "emphasis") { out = mEmphasis; return true; }
+      if (id == "morphAmount") { out = mMorphAmount.GetTarget(); return true; }
+      if (id == "phaseMorphAmount") { out = mPhaseMorphAmount.GetTarget(); return true; }
+      if (id == "emphasis") { out = mEmphasis.GetTarget(); return true; }
       return false;
     }
 
@@ -104,8 +132,8 @@ namespace synaptic
     {
       if (id == "morphDomain")
       {
-        if (v == "log") mDomain = MorphDomain::Log;
-        else if (v == "cepstral") mDomain = MorphDomain::Cepstral;
+        if (v == "log") SetParamSlot(kSlotDomain, 0);
+        else if (v == "cepstral") SetParamSlot(kSlotDomain, 1);
         return true;
       }
       return false;
@@ -128,11 +156,14 @@ namespace synaptic
     }
 
   private:
-    double mMorphAmount = 1.0;
-    double mPhaseMorphAmount = 1.0;
-    double mEmphasis = 0.0;
+    ParamRamp mMorphAmount { 1.0 };
+    ParamRamp mPhaseMorphAmount { 1.0 };
+    ParamRamp mEmphasis { 0.0 };
+    // This chunk's values, from AdvanceChunk
+    double mChunkMorphAmount = 1.0;
+    double mChunkPhaseMorphAmount = 1.0;
+    double mChunkEmphasis = 0.0;
     MorphDomain mDomain = MorphDomain::Log;
-    CepstralScratch mCepstralScratch;
   };
 }
 
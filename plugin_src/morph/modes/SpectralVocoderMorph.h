@@ -1,15 +1,102 @@
 #pragma once
 
 #include "../IMorph.h"
+#include "../../audio/FFT.h"
+#include "../../audio/FFTPlanner.h"
+#include "../../audio/ParamRamp.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iterator>
+#include <string>
+#include <vector>
 
 namespace synaptic
 {
+  // Channel vocoder: measures the input chunk's energy in N log-spaced bands and imposes
+  // that envelope onto the matched brain chunk.
+  //
+  // Bands are triangular and overlap their neighbours, so every bin belongs to exactly two
+  // adjacent bands (lower band weight 1-w, upper band weight w). That sparse bin->band map is
+  // precomputed whenever the FFT size, sample rate or band count changes; per chunk the cost
+  // is two O(bins) passes plus one pow() per band.
   class SpectralVocoderMorph final : public IMorph
   {
   public:
-    void OnReset(double /*sampleRate*/, int /*fftSize*/, int /*numChannels*/) override {}
+    static constexpr int kMinBands = 8;   // the smallest of kBandOptions
+    static constexpr int kMaxBands = 64;  // the largest
 
-    void Process(AudioChunk& /*a*/, AudioChunk& /*b*/, FFTProcessor& /*fft*/) override {}
+    void OnReset(double sampleRate, int fftSize, int numChannels) override
+    {
+      mSampleRate = sampleRate > 0.0 ? sampleRate : 48000.0;
+      (void) numChannels;
+      mSensitivity.Reset(mSampleRate);
+      // Callers pass the chunk size; the spectra we receive use the padded FFT size
+      BuildBandMap(FFTPlanner::Instance().PlanSize(fftSize));
+    }
+
+    void AdvanceChunk(int hopSamples) override
+    {
+      mChunkSensitivity = mSensitivity.Advance(hopSamples).Mid();
+    }
+
+    void Process(AudioChunk& a, AudioChunk& b, FFTProcessor& /*fft*/) override
+    {
+      const int fftSize = b.fftSize;
+      if (fftSize <= 0 || a.fftSize != fftSize) return;
+
+      const int numChannels = (int) std::min(a.complexSpectrum.size(), b.complexSpectrum.size());
+      if (numChannels <= 0) return;
+
+      // Recomputed in place after a layout swap changed the FFT size (its scratch fits the new size)
+      if (fftSize != mMapFftSize || mMapDirty)
+        BuildBandMap(fftSize);
+
+      const int numBins = fftSize / 2 + 1;
+      const int numBands = mNumBands;
+      const float exponent = 0.5f * (float) mChunkSensitivity; // energy ratio -> amplitude gain
+
+      for (int c = 0; c < numChannels; ++c)
+      {
+        const float* __restrict aptr = a.complexSpectrum[c].data();
+        float* __restrict bptr = b.complexSpectrum[c].data();
+
+        std::fill(mBandEnergyA.begin(), mBandEnergyA.begin() + numBands, 0.0f);
+        std::fill(mBandEnergyB.begin(), mBandEnergyB.begin() + numBands, 0.0f);
+
+        // 1) Band energies (sparse matrix-vector product, 2 nonzeros per bin)
+        for (int k = 0; k < numBins; ++k)
+        {
+          const int j = mScratch.binBand[k];
+          const float w = mScratch.binWeight[k];
+          const float pa = BinPower(aptr, k, fftSize);
+          const float pb = BinPower(bptr, k, fftSize);
+          mBandEnergyA[j]     += (1.0f - w) * pa;
+          mBandEnergyA[j + 1] += w * pa;
+          mBandEnergyB[j]     += (1.0f - w) * pb;
+          mBandEnergyB[j + 1] += w * pb;
+        }
+
+        // 2) Per-band gains (the only transcendental math, once per band)
+        for (int j = 0; j < numBands; ++j)
+        {
+          const float ea = mBandEnergyA[j];
+          const float eb = mBandEnergyB[j];
+          // An empty brain band has nothing to shape, so it is left untouched
+          const float g = (eb > kEnergyFloor) ? std::pow((ea + kEnergyFloor) / eb, exponent) : 1.0f;
+          mBandGain[j] = std::min(g, kMaxGain);
+        }
+
+        // 3) Spread band gains back to bins through the transposed map
+        for (int k = 0; k < numBins; ++k)
+        {
+          const int j = mScratch.binBand[k];
+          const float w = mScratch.binWeight[k];
+          const float g = (1.0f - w) * mBandGain[j] + w * mBandGain[j + 1];
+          ScaleBin(bptr, k, fftSize, g);
+        }
+      }
+    }
 
     void GetParamDescs(std::vector<ExposedParamDesc>& out, bool /*includeAll*/) const override
     {
@@ -17,27 +104,151 @@ namespace synaptic
       ExposedParamDesc p1;
       p1.id = "vocoderSensitivity";
       p1.label = "Vocoder Sensitivity";
+      p1.tooltip = "How strongly the input's band envelope is imposed on the transformed chunk. 0 = transformed chunk unchanged, 1 = full input envelope.";
       p1.type = ParamType::Number;
       p1.control = ControlType::Slider;
       p1.minValue = 0.0; p1.maxValue = 1.0; p1.step = 0.01; p1.defaultNumber = 1.0;
       out.push_back(p1);
+
+      ExposedParamDesc p2;
+      p2.id = "vocoderBands";
+      p2.label = "Vocoder Bands";
+      p2.tooltip = "Number of log-spaced analysis bands. Fewer bands give a coarse, classic vocoder sound; more bands follow the input's formants more closely.";
+      p2.type = ParamType::Enum;
+      p2.control = ControlType::Select;
+      for (int n : kBandOptions)
+        p2.options.push_back({std::to_string(n), std::to_string(n)});
+      p2.defaultString = "16";
+      out.push_back(p2);
+    }
+
+    enum Slot { kSlotSensitivity, kSlotBands };
+
+    bool SetParamSlot(int slot, double value) override
+    {
+      switch (slot)
+      {
+        case kSlotSensitivity: mSensitivity.SetTarget(value); return true;
+        case kSlotBands:
+        {
+          const int option = std::max(0, std::min((int) std::size(kBandOptions) - 1, (int) value));
+          SetNumBands(kBandOptions[option]);
+          return true;
+        }
+      }
+      return false;
     }
 
     bool SetParamFromNumber(const std::string& id, double v) override
     {
-      if (id == "vocoderSensitivity") { mSensitivity = v; return true; }
+      if (id == "vocoderSensitivity") return SetParamSlot(kSlotSensitivity, v);
       return false;
     }
 
     bool GetParamAsNumber(const std::string& id, double& out) const override
     {
-      if (id == "vocoderSensitivity") { out = mSensitivity; return true; }
+      if (id == "vocoderSensitivity") { out = mSensitivity.GetTarget(); return true; }
+      return false;
+    }
+
+    bool SetParamFromString(const std::string& id, const std::string& v) override
+    {
+      if (id == "vocoderBands")
+      {
+        SetNumBands(std::atoi(v.c_str()));
+        return true;
+      }
+      return false;
+    }
+
+    bool GetParamAsString(const std::string& id, std::string& out) const override
+    {
+      if (id == "vocoderBands") { out = std::to_string(mNumBands); return true; }
       return false;
     }
 
   private:
-    double mSensitivity = 1.0;
-  };
-}
+    static constexpr int kBandOptions[] = {8, 16, 24, 32, 48, 64};
 
+    void SetNumBands(int bands)
+    {
+      const int n = std::max(kMinBands, std::min(kMaxBands, bands));
+      if (n != mNumBands)
+      {
+        mNumBands = n;
+        mMapDirty = true; // rebuilt in place on the next Process, no allocation
+      }
+    }
+
+    static constexpr float kEnergyFloor = 1e-12f;
+    static constexpr float kMaxGain = 32.0f; // +30 dB, keeps near-silent brain bands from exploding
+    static constexpr double kLowestCenterHz = 50.0;
+    static constexpr double kHighestCenterHz = 16000.0;
+
+    // Ordered PFFFT layout: [0]=DC, [1]=Nyquist, then interleaved re/im for bins 1..N/2-1
+    static inline float BinPower(const float* spec, int k, int fftSize)
+    {
+      if (k == 0) return spec[0] * spec[0];
+      if (k == fftSize / 2) return spec[1] * spec[1];
+      const float re = spec[2 * k], im = spec[2 * k + 1];
+      return re * re + im * im;
+    }
 
+    static inline void ScaleBin(float* spec, int k, int fftSize, float g)
+    {
+      if (k == 0) { spec[0] *= g; return; }
+      if (k == fftSize / 2) { spec[1] *= g; return; }
+      spec[2 * k] *= g;
+      spec[2 * k + 1] *= g;
+    }
+
+    void BuildBandMap(int fftSize)
+    {
+      mMapDirty = false;
+      mMapFftSize = fftSize;
+      if (fftSize <= 0) return;
+
+      const int numBins = fftSize / 2 + 1;
+      mScratch.Allocate(fftSize);
+      if ((int) mBandEnergyA.size() != kMaxBands + 1)
+      {
+        mBandEnergyA.assign(kMaxBands + 1, 0.0f);
+        mBandEnergyB.assign(kMaxBands + 1, 0.0f);
+        mBandGain.assign(kMaxBands + 1, 1.0f);
+      }
+
+      const int numBands = mNumBands;
+      const double nyquist = 0.5 * mSampleRate;
+      const double loHz = kLowestCenterHz;
+      const double hiHz = std::max(loHz * 2.0, std::min(kHighestCenterHz, 0.9 * nyquist));
+      const double logLo = std::log(loHz);
+      const double scale = (double) (numBands - 1) / (std::log(hiHz) - logLo);
+      const double binHz = mSampleRate / (double) fftSize;
+
+      for (int k = 0; k < numBins; ++k)
+      {
+        // Fractional band position of this bin's centre frequency
+        const double hz = std::max(loHz, (double) k * binHz);
+        double pos = (std::log(hz) - logLo) * scale;
+        pos = std::max(0.0, std::min((double) (numBands - 1), pos));
+
+        int j = (int) pos;
+        float w = (float) (pos - (double) j);
+        if (j >= numBands - 1) { j = numBands - 2; w = 1.0f; }
+        mScratch.binBand[k] = j;
+        mScratch.binWeight[k] = w;
+      }
+    }
+
+    ParamRamp mSensitivity { 1.0 };
+    double mChunkSensitivity = 1.0; // this chunk's, from AdvanceChunk
+    int mNumBands = 16;
+    double mSampleRate = 48000.0;
+
+    int mMapFftSize = 0;
+    bool mMapDirty = true;
+    std::vector<float> mBandEnergyA;
+    std::vector<float> mBandEnergyB;
+    std::vector<float> mBandGain;
+  };
+}
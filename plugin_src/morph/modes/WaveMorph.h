@@ -2,6 +2,8 @@
 
 #include "../IMorph.h"
 #include "../MorphUtils.h"
+#include "../../audio/FFTPlanner.h"
+#include "../../audio/ParamRamp.h"
 #include <utility>
 
 namespace synaptic
@@ -22,9 +24,20 @@ namespace synaptic
       Triangle,
     };
 
-    void OnReset(double /*sampleRate*/, int fftSize, int /*numChannels*/) override
+    void OnReset(double sampleRate, int fftSize, int /*numChannels*/) override
     {
-      mCepstralScratch.EnsureSize(fftSize);
+      // Callers pass the chunk size; the spectra we receive use the padded FFT size
+      mScratch.Allocate(FFTPlanner::Instance().PlanSize(fftSize));
+      mMorphAmount.Reset(sampleRate);
+      mPhaseMorphAmount.Reset(sampleRate);
+      mEmphasis.Reset(sampleRate);
+    }
+
+    void AdvanceChunk(int hopSamples) override
+    {
+      mChunkMorphAmount = mMorphAmount.Advance(hopSamples).Mid();
+      mChunkPhaseMorphAmount = mPhaseMorphAmount.Advance(hopSamples).Mid();
+      mChunkEmphasis = mEmphasis.Advance(hopSamples).Mid();
     }
 
     void Process(AudioChunk& a, AudioChunk& b, FFTProcessor& fft) override
@@ -66,13 +79,13 @@ namespace synaptic
       // Apply cross synthesis after removing harmonics
       if (mDomain == MorphDomain::Log)
       {
-        LogApply(a.complexSpectrum, b.complexSpectrum, fftSize, (float)mMorphAmount, (float)mPhaseMorphAmount);
+        LogApply(a.complexSpectrum, b.complexSpectrum, fftSize, (float)mChunkMorphAmount, (float)mChunkPhaseMorphAmount);
       }
       else
       {
         CepstralApply(a.complexSpectrum, b.complexSpectrum, fftSize,
-                      (float) mMorphAmount, (float) mPhaseMorphAmount, (float) mEmphasis,
-                      fft, mCepstralScratch);
+                      (float) mChunkMorphAmount, (float) mChunkPhaseMorphAmount, (float) mChunkEmphasis,
+                      fft, mScratch.cepstral);
       }
 
       for (int c = 0; c < numChannels; c++)
@@ -170,13 +183,36 @@ namespace synaptic
       }
     }
 
+    // In GetParamDescs(out, true) order
+    enum Slot { kSlotWaveMorphStart, kSlotWaveHarmonics, kSlotMorphAmount, kSlotPhaseMorphAmount, kSlotWaveShape, kSlotDomain, kSlotEmphasis };
+
+    bool SetParamSlot(int slot, double value) override
+    {
+      switch (slot)
+      {
+        case kSlotWaveMorphStart: mWaveMorphStart = value; return true;
+        case kSlotWaveHarmonics: mWaveHarmonics = (int) value; return true;
+        case kSlotMorphAmount: mMorphAmount.SetTarget(value); return true;
+        case kSlotPhaseMorphAmount: mPhaseMorphAmount.SetTarget(value); return true;
+        case kSlotWaveShape:
+        {
+          const int shape = (int) value;
+          if (shape >= Square && shape <= Triangle) mWaveShape = (WaveMorphShape) shape;
+          return true;
+        }
+        case kSlotDomain: mDomain = (int) value == 1 ? MorphDomain::Cepstral : MorphDomain::Log; return true;
+        case kSlotEmphasis: mEmphasis.SetTarget(value); return true;
+      }
+      return false;
+    }
+
     bool SetParamFromNumber(const std::string& id, double v) override
     {
-      if (id == "waveMorphStart") { mWaveMorphStart = v; return true; }
-      if (id == "waveHarmonics") { mWaveHarmonics = (int)v; return true; }
-      if (id == "morphAmount") { mMorphAmount = v; return true; }
-      if (id == "phaseMorphAmount") { mPhaseMorphAmount = v; return true; }
-      if (id == "emphasis") { mEmphasis = v; return true; }
+      if (id == "waveMorphStart") return SetParamSlot(kSlotWaveMorphStart, v);
+      if (id == "waveHarmonics") return SetParamSlot(kSlotWaveHarmonics, v);
+      if (id == "morphAmount") return SetParamSlot(kSlotMorphAmount, v);
+      if (id == "phaseMorphAmount") return SetParamSlot(kSlotPhaseMorphAmount, v);
+      if (id == "emphasis") return SetParamSlot(kSlotEmphasis, v);
       return false;
     }
 
@@ -184,9 +220,9 @@ namespace synaptic
     {
       if (id == "waveMorphStart") { out = mWaveMorphStart; return true; }
       if (id == "waveHarmonics") { out = mWaveHarmonics; return true; }
-      if (id == "morphAmount") { out = mMorphAmount; return true; }
-      if (id == "phaseMorphAmount") { out = mPhaseMorphAmount; return true; }
-      if (id == "emphasis") { out = mEmphasis; return true; }
+      if (id == "morphAmount") { out = mMorphAmount.GetTarget(); return true; }
+      if (id == "phaseMorphAmount") { out = mPhaseMorphAmount.GetTarget(); return true; }
+      if (id == "emphasis") { out = mEmphasis.GetTarget(); return true; }
       return false;
     }
 
@@ -194,15 +230,15 @@ namespace synaptic
     {
       if (id == "waveShape")
       {
-        if (v == "square") mWaveShape = Square;
-        else if (v == "saw") mWaveShape = Saw;
-        else if (v == "triangle") mWaveShape = Triangle;
+        if (v == "square") SetParamSlot(kSlotWaveShape, Square);
+        else if (v == "saw") SetParamSlot(kSlotWaveShape, Saw);
+        else if (v == "triangle") SetParamSlot(kSlotWaveShape, Triangle);
         return true;
       }
       if (id == "morphDomain")
       {
-        if (v == "log") mDomain = MorphDomain::Log;
-        else if (v == "cepstral") mDomain = MorphDomain::Cepstral;
+        if (v == "log") SetParamSlot(kSlotDomain, 0);
+        else if (v == "cepstral") SetParamSlot(kSlotDomain, 1);
         return true;
       }
       return false;
@@ -246,10 +282,13 @@ namespace synaptic
     WaveMorphShape mWaveShape = Square;
     double mWaveMorphStart = 0.03;
     int mWaveHarmonics = 20;
-    double mMorphAmount = 1.0;
-    double mPhaseMorphAmount = 1.0;
-    double mEmphasis = 0.0;
+    ParamRamp mMorphAmount { 1.0 };
+    ParamRamp mPhaseMorphAmount { 1.0 };
+    ParamRamp mEmphasis { 0.0 };
+    // This chunk's values, from AdvanceChunk
+    double mChunkMorphAmount = 1.0;
+    double mChunkPhaseMorphAmount = 1.0;
+    double mChunkEmphasis = 0.0;
     MorphDomain mDomain = MorphDomain::Log;
-    CepstralScratch mCepstralScratch;
   };
 }
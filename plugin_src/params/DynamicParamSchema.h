@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -34,6 +35,57 @@ namespace synaptic
     std::string defaultString;
   };
 
+  struct IDynamicParamOwner;
+
+  /**
+   * @brief Binding between IParam and transformer/morph parameter
+   */
+  struct TransformerParamBinding
+  {
+    std::string id;
+    synaptic::ParamType type;
+    int paramIdx = -1;
+    std::vector<std::string> enumValues; // For enums: index -> string value mapping
+  };
+
+  /**
+   * @brief The bindings resolved to one owner's parameter slots
+   *
+   * Resolving looks up each binding's id (and enum options) in the owner's schema once, off the
+   * audio thread. Applying a bound value is then an array lookup and one SetParamSlot call, with
+   * no string work or allocation, which is what lets ApplyBindingsTo run on the audio thread.
+   */
+  class BoundParamSlots
+  {
+  public:
+    bool IsResolvedFor(const std::vector<TransformerParamBinding>& bindings) const
+    {
+      return mResolved && mEntries.size() == bindings.size();
+    }
+
+    inline void Resolve(const std::vector<TransformerParamBinding>& bindings, const IDynamicParamOwner& owner);
+
+    /** @brief Apply bindings[bindingIndex]'s value (IParam::Value); false if the owner doesn't have it */
+    inline bool Apply(int bindingIndex, double value, IDynamicParamOwner& owner) const;
+
+    bool RequiresUIRebuild(int bindingIndex) const
+    {
+      return bindingIndex >= 0 && bindingIndex < (int) mEntries.size() && mEntries[bindingIndex].rebuildsUI;
+    }
+
+  private:
+    struct Entry
+    {
+      int slot = -1;
+      ParamType type = ParamType::Number;
+      bool rebuildsUI = false;
+      std::vector<int> options; // binding option index -> owner option index (-1: owner lacks it)
+    };
+
+    std::vector<Entry> mEntries;
+    bool mResolved = false;
+  };
+
   // Owners expose dynamic params through this interface
   struct IDynamicParamOwner
   {
@@ -55,7 +107,84 @@ namespace synaptic
 
     // Check if changing this parameter requires a UI rebuild (e.g., when it controls visibility of other params)
     virtual bool ParamChangeRequiresUIRebuild(const std::string& id) const { return false; }
+
+    // A slot is a parameter's position in GetParamDescs(out, true). Set by slot: Number slots take
+    // the value, Boolean slots value >= 0.5, Enum slots the option index. No string work or
+    // allocation, so it is safe on the audio thread.
+    virtual bool SetParamSlot(int /*slot*/, double /*value*/) { return false; }
+
+    // Bindings resolved to this owner's slots (see ApplyBindings)
+    BoundParamSlots& GetBoundParamSlots() { return mBoundSlots; }
+
+  private:
+    BoundParamSlots mBoundSlots;
   };
+
+  inline void BoundParamSlots::Resolve(const std::vector<TransformerParamBinding>& bindings, const IDynamicParamOwner& owner)
+  {
+    std::vector<ExposedParamDesc> descs;
+    owner.GetParamDescs(descs, true);
+    mEntries.assign(bindings.size(), Entry());
+    for (size_t i = 0; i < bindings.size(); ++i)
+    {
+      const auto& b = bindings[i];
+      auto it = std::find_if(descs.begin(), descs.end(), [&](const ExposedParamDesc& d) { return d.id == b.id; });
+      if (it == descs.end() || it->type != b.type || b.type == ParamType::Text) continue;
+      Entry& e = mEntries[i];
+      e.slot = (int) (it - descs.begin());
+      e.type = b.type;
+      e.rebuildsUI = owner.ParamChangeRequiresUIRebuild(b.id);
+      // Enum values reach the owner as its own option index, even if its options differ from the binding's
+      for (const auto& value : b.enumValues)
+      {
+        auto opt = std::find_if(it->options.begin(), it->options.end(), [&](const ParamOption& o) { return o.value == value; });
+        e.options.push_back(opt == it->options.end() ? -1 : (int) (opt - it->options.begin()));
+      }
+    }
+    mResolved = true;
+  }
+
+  inline bool BoundParamSlots::Apply(int bindingIndex, double value, IDynamicParamOwner& owner) const
+  {
+    if (bindingIndex < 0 || bindingIndex >= (int) mEntries.size()) return false;
+    const Entry& e = mEntries[bindingIndex];
+    if (e.slot < 0) return false;
+    if (e.type == ParamType::Enum)
+    {
+      // Read the way IParam::Int reads it
+      const int idx = static_cast<int>(value);
+      if (idx < 0 || idx >= (int) e.options.size() || e.options[idx] < 0) return false;
+      value = (double) e.options[idx];
+    }
+    return owner.SetParamSlot(e.slot, value);
+  }
+
+  /**
+   * @brief Apply one bound plugin parameter's value (IParam::Value) to @p owner
+   * Resolves the owner's slots first if needed, which only happens before it is handed to the audio thread.
+   */
+  inline void ApplyBindingValue(const std::vector<TransformerParamBinding>& bindings, int bindingIndex, double value,
+                                IDynamicParamOwner* owner)
+  {
+    if (!owner) return;
+    BoundParamSlots& slots = owner->GetBoundParamSlots();
+    if (!slots.IsResolvedFor(bindings)) slots.Resolve(bindings, *owner);
+    slots.Apply(bindingIndex, value, *owner);
+  }
+
+  /** @brief Apply every binding to @p owner; getValue(paramIdx) returns IParam::Value */
+  template <class GetValueFn>
+  void ApplyBindings(const std::vector<TransformerParamBinding>& bindings, IDynamicParamOwner* owner, GetValueFn&& getValue)
+  {
+    if (!owner) return;
+    BoundParamSlots& slots = owner->GetBoundParamSlots();
+    if (!slots.IsResolvedFor(bindings)) slots.Resolve(bindings, *owner);
+    for (int i = 0; i < (int) bindings.size(); ++i)
+    {
+      if (bindings[i].paramIdx < 0) continue;
+      slots.Apply(i, getValue(bindings[i].paramIdx), *owner);
+    }
+  }
 }
 
 
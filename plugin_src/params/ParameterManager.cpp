@@ -302,72 +302,31 @@ namespace synaptic
     if (outNeedsTransformerRebuild) *outNeedsTransformerRebuild = false;
     if (outNeedsMorphRebuild) *outNeedsMorphRebuild = false;
 
-    for (const auto& b : mBindings)
-    {
-      if (b.paramIdx == paramIdx)
-      {
-        if (transformer && transformer->ParamChangeRequiresUIRebuild(b.id) && outNeedsTransformerRebuild)
-          *outNeedsTransformerRebuild = true;
-        if (morph && morph->ParamChangeRequiresUIRebuild(b.id) && outNeedsMorphRebuild)
-          *outNeedsMorphRebuild = true;
-
-        ApplyBindingValue(b, param, transformer, morph);
-        return true;
-      }
-    }
-    return false;
+    // Bindings are laid out densely from mTransformerParamBase
+    const int bindingIdx = paramIdx - mTransformerParamBase;
+    if (mTransformerParamBase < 0 || bindingIdx < 0 || bindingIdx >= (int)mBindings.size()
+        || mBindings[bindingIdx].paramIdx != paramIdx)
+      return false;
+
+    const double value = param->Value();
+    ApplyBindingValue(mBindings, bindingIdx, value, transformer);
+    ApplyBindingValue(mBindings, bindingIdx, value, morph);
+    if (transformer && outNeedsTransformerRebuild)
+      *outNeedsTransformerRebuild = transformer->GetBoundParamSlots().RequiresUIRebuild(bindingIdx);
+    if (morph && outNeedsMorphRebuild)
+      *outNeedsMorphRebuild = morph->GetBoundParamSlots().RequiresUIRebuild(bindingIdx);
+    return true;
   }
 
   // ============================================================================
   // Unified Binding Application
   // ============================================================================
 
-  void ParameterManager::ApplyBindingValue(const TransformerParamBinding& binding, iplug::IParam* param,
-                                           IChunkBufferTransformer* transformer, IMorph* morph)
-  {
-    switch (binding.type)
-    {
-      case ParamType::Number:
-      {
-        const double v = param->Value();
-        if (transformer) transformer->SetParamFromNumber(binding.id, v);
-        if (morph) morph->SetParamFromNumber(binding.id, v);
-        break;
-      }
-      case ParamType::Boolean:
-      {
-        const bool v = param->Bool();
-        if (transformer) transformer->SetParamFromBool(binding.id, v);
-        if (morph) morph->SetParamFromBool(binding.id, v);
-        break;
-      }
-      case ParamType::Enum:
-      {
-        int idx = param->Int();
-        std::string val = (idx >= 0 && idx < (int)binding.enumValues.size())
-          ? binding.enumValues[idx]
-          : std::to_string(idx);
-        if (transformer) transformer->SetParamFromString(binding.id, val);
-        if (morph) morph->SetParamFromString(binding.id, val);
-        break;
-      }
-      case ParamType::Text:
-        break;
-    }
-  }
-
   void ParameterManager::ApplyBindingsTo(iplug::Plugin* plugin, IChunkBufferTransformer* transformer, IMorph* morph)
   {
-    if (!transformer && !morph) return;
-
-    for (const auto& b : mBindings)
-    {
-      if (b.paramIdx < 0) continue;
-      auto* param = plugin->GetParam(b.paramIdx);
-      if (!param) continue;
-
-      ApplyBindingValue(b, param, transformer, morph);
-    }
+    auto value = [plugin](int paramIdx) { return plugin->GetParam(paramIdx)->Value(); };
+    ApplyBindings(mBindings, transformer, value);
+    ApplyBindings(mBindings, morph, value);
   }
 
   // ============================================================================
@@ -396,12 +355,9 @@ namespace synaptic
 
   const TransformerParamBinding* ParameterManager::GetBindingForParam(int paramIdx) const
   {
-    for (const auto& b : mBindings)
-    {
-      if (b.paramIdx == paramIdx)
-        return &b;
-    }
-    return nullptr;
+    const int bindingIdx = paramIdx - mTransformerParamBase;
+    if (mTransformerParamBase < 0 || bindingIdx < 0 || bindingIdx >= (int)mBindings.size()) return nullptr;
+    return mBindings[bindingIdx].paramIdx == paramIdx ? &mBindings[bindingIdx] : nullptr;
   }
 
   // ============================================================================
@@ -499,7 +455,9 @@ namespace synaptic
     const int oldChunkSize = mConfig->chunkSize;
     auto* chunker = GetChunker();
 
-    if (mBrainManager && mBrainManager->IsOperationInProgress())
+    // Rollback from a completing operation, or an import still analyzing with the current window:
+    // apply the value without rechunking
+    if (mBrainManager && (mBrainManager->IsCompletingOperation() || mBrainManager->IsFileOperationRunning()))
     {
       HandleCoreParameterChange(paramIdx, mPlugin->GetParam(paramIdx), *mConfig);
       if (mWindowCoordinator && mDSPContext)
@@ -511,6 +469,10 @@ namespace synaptic
     bool chunkSizeChanged = chunker && mAnalysisWindow
       ? HandleChunkSizeChange(paramIdx, mPlugin->GetParam(paramIdx), *mConfig, mPlugin, *chunker, *mAnalysisWindow)
       : false;
+    // The brain analyzes with its own copy: a running operation keeps the old one and is
+    // superseded by the rechunk queued below
+    if (mBrain && mAnalysisWindow)
+      mBrain->SetWindow(mAnalysisWindow);
 
     if (mWindowCoordinator && mDSPContext)
       mWindowCoordinator->UpdateChunkerWindowing(*mConfig, mDSPContext->GetTransformerRaw());
@@ -555,7 +517,7 @@ namespace synaptic
           else
           {
             config->chunkSize = oldChunkSize;
-            if (chunker) chunker->SetChunkSize(oldChunkSize);
+            if (chunker) chunker->RequestChunkSize(oldChunkSize);
             if (windowCoordinator)
             {
               windowCoordinator->UpdateBrainAnalysisWindow(*config);
@@ -575,6 +537,8 @@ namespace synaptic
     HandleCoreParameterChange(paramIdx, mPlugin->GetParam(paramIdx), *mConfig);
     if (auto* chunker = GetChunker())
       chunker->SetBufferWindowSize(mConfig->bufferWindowSize);
+    // SampleBrain transformers delay their decision by (window - 1) chunks
+    SetLatency(ComputeLatency());
   }
 
   void ParameterManager::HandleAlgorithmParam(int paramIdx)
@@ -602,6 +566,7 @@ namespace synaptic
     HandleCoreParameterChange(paramIdx, mPlugin->GetParam(paramIdx), *mConfig);
     if (mWindowCoordinator && mDSPContext)
       mWindowCoordinator->UpdateChunkerWindowing(*mConfig, mDSPContext->GetTransformerRaw());
+    SetLatency(ComputeLatency()); // window overlap sets the input hop
 
     const bool windowsAreLocked = mPlugin->GetParam(mParamIdxWindowLock)->Bool();
     if (windowsAreLocked)
@@ -659,7 +624,7 @@ namespace synaptic
   {
     const int oldWindowMode = mConfig->analysisWindowMode;
 
-    if (mBrainManager && mBrainManager->IsOperationInProgress())
+    if (mBrainManager && (mBrainManager->IsCompletingOperation() || mBrainManager->IsFileOperationRunning()))
     {
       CheckAndClearPendingUpdate((uint32_t)PendingUpdate::SuppressAnalysisReanalyze);
       HandleCoreParameterChange(paramIdx, mPlugin->GetParam(paramIdx), *mConfig);
@@ -810,6 +775,10 @@ namespace synaptic
     if (HandleDynamicParameterChange(paramIdx, mPlugin->GetParam(paramIdx), transformer, morph,
                                       &needsTransformerRebuild, &needsMorphRebuild))
     {
+      // Low Latency, and Continuity Weight crossing 0, move the latency; only a real change goes to the host
+      const int latency = ComputeLatency();
+      if (latency != mPlugin->GetLatency())
+        SetLatency(latency);
 #if IPLUG_EDITOR
       if (needsTransformerRebuild)
         SetPendingUpdate((uint32_t)PendingUpdate::RebuildTransformer);
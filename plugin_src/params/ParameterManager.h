@@ -37,17 +37,6 @@ namespace synaptic
   class DSPContext;
   class UISyncManager;
 
-  /**
-   * @brief Binding between IParam and transformer/morph parameter
-   */
-  struct TransformerParamBinding
-  {
-    std::string id;
-    synaptic::ParamType type;
-    int paramIdx = -1;
-    std::vector<std::string> enumValues; // For enums: index -> string value mapping
-  };
-
   /**
    * @brief Manages all plugin parameters
    *
@@ -101,7 +90,8 @@ namespace synaptic
     {
       int oldChunkSize = config.chunkSize;
       HandleCoreParameterChange(paramIdx, param, config);
-      chunker.SetChunkSize(config.chunkSize);
+      // Built here, swapped in and crossfaded by the audio thread
+      chunker.RequestChunkSize(config.chunkSize);
       analysisWindow.Set(synaptic::Window::IntToType(config.analysisWindowMode), config.chunkSize);
       return config.chunkSize != oldChunkSize;
     }
@@ -171,6 +161,10 @@ namespace synaptic
     /**
      * @brief Apply all current parameter bindings to transformer and/or morph
      *
+     * Values go in by slot (BoundParamSlots), so this is allocation-free on the audio thread once
+     * the components were bound, which HandleAlgorithmChange/HandleMorphModeChange do before handing
+     * them over.
+     *
      * @param plugin Plugin instance to read parameter values from
      * @param transformer Transformer to apply values to (can be nullptr)
      * @param morph Morph to apply values to (can be nullptr)
@@ -256,9 +250,6 @@ namespace synaptic
 
     // === Internal Helpers ===
 
-    void ApplyBindingValue(const TransformerParamBinding& binding, iplug::IParam* param,
-                          IChunkBufferTransformer* transformer, IMorph* morph);
-    
     AudioStreamChunker* GetChunker() const;
     int ComputeLatency() const;
     void SetLatency(int latency);
@@ -1,7 +1,6 @@
 #include "StateSerializer.h"
 #include "plugin_src/brain/BrainManager.h"
 #include "plugin_src/brain/Brain.h"
-#include "plugin_src/ui/core/ProgressOverlayManager.h"
 #include "IPlugPaths.h"
 #include <cstdio>
 #include <cstring>
@@ -34,31 +33,20 @@ namespace synaptic
       // External mode: store path
       chunk.PutStr(brainMgr.ExternalPath().c_str());
 
-      // If brain has changed, sync it to external file now to persist on project save
+      // If brain has changed, sync it to external file to persist on project save.
+      // The write happens in the background from a snapshot, so the host is not blocked.
       // BUT: skip saving if a rechunk/reanalysis operation is in progress or pending
       // because the brain's metadata might not match the actual analyzed data yet
       if (brainMgr.IsDirty() && !brainMgr.IsOperationInProgress())
-      {
-        // Show progress overlay immediately before the blocking save operation
-        auto* overlayMgr = ui::ProgressOverlayManager::Get();
-        if (overlayMgr)
-          overlayMgr->ShowImmediate("Saving Brain", "Writing brain to external file...");
-
-        iplug::IByteChunk blob;
-        brain.SerializeSnapshotToChunk(blob);
-
-        FILE* fp = fopen(brainMgr.ExternalPath().c_str(), "wb");
-        if (fp)
-        {
-          fwrite(blob.GetData(), 1, (size_t)blob.Size(), fp);
-          fclose(fp);
-          brainMgr.SetDirty(false);
-        }
-
-        // Hide progress overlay immediately after save completes
-        if (overlayMgr)
-          overlayMgr->HideImmediate();
-      }
+        brainMgr.SaveExternalFileAsync(brainMgr.ExternalPath());
+
+      // Content hash of the file as last loaded or written. While a save is queued or running
+      // (including the one just started) the final hash isn't known yet, so none is recorded.
+      const uint64_t contentHash = brainMgr.IsSavePending() ? 0 : brainMgr.ExternalContentHash();
+      uint8_t hasHash = contentHash != 0 ? 1 : 0;
+      chunk.Put(&hasHash);
+      if (hasHash)
+        chunk.Put(&contentHash);
     }
     else
     {
@@ -82,6 +70,20 @@ namespace synaptic
       }
     }
 
+    // Chunk sizes kept as brain layers
+    const std::vector<int> layers = brainMgr.GetLayerChunkSizes();
+    int32_t nLayers = (int32_t) layers.size();
+    chunk.Put(&nLayers);
+    for (int cs : layers)
+    {
+      int32_t v = cs;
+      chunk.Put(&v);
+    }
+    int32_t adaptive = brainMgr.IsAdaptiveChunkingEnabled() ? 1 : 0;
+    chunk.Put(&adaptive);
+    int32_t analysisCache = brainMgr.IsAnalysisCacheEnabled() ? 1 : 0;
+    chunk.Put(&analysisCache);
+
     // Fill in section size
     int end = chunk.Size();
     sectionSize = end - start;
@@ -122,62 +124,84 @@ namespace synaptic
     pos = chunk.Get(&mode, pos);
     if (pos < 0) return start + sectionSize;
 
+    // Everything is read before the brain loads: the settings after the brain data (the analysis
+    // cache especially) decide how it loads
+    std::string externalPath;
+    uint64_t savedHash = 0;
+    int inlinePos = -1;
     if (mode == 1)
     {
-      // External mode: read path and try to load
+      // External mode: read path
       WDL_String p;
       pos = chunk.GetStr(p, pos);
       if (pos < 0) return start + sectionSize;
-
-      std::string externalPath = p.Get();
-      bool useExternal = !externalPath.empty();
-      brainMgr.SetExternalRef(externalPath, useExternal);
-
-      // Try to load from path if readable
-      if (useExternal)
-      {
-        FILE* fp = fopen(externalPath.c_str(), "rb");
-        if (fp)
-        {
-          fseek(fp, 0, SEEK_END);
-          long sz = ftell(fp);
-          fseek(fp, 0, SEEK_SET);
-
-          std::vector<char> data;
-          data.resize((size_t)sz);
-          fread(data.data(), 1, (size_t)sz, fp);
-          fclose(fp);
-
-          // Deserialize brain
-          iplug::IByteChunk in;
-          in.PutBytes(data.data(), (int)data.size());
-          brain.DeserializeSnapshotFromChunk(in, 0, nullptr);
-        }
-      }
+      externalPath = p.Get();
+
+      // Content hash recorded at save time (absent in older states and when it wasn't known)
+      uint8_t hasHash = 0;
+      if (pos >= 0 && pos + (int) sizeof(hasHash) <= start + sectionSize)
+        pos = chunk.Get(&hasHash, pos);
+      if (hasHash && pos >= 0 && pos + (int) sizeof(savedHash) <= start + sectionSize)
+        pos = chunk.Get(&savedHash, pos);
     }
     else
     {
-      // Inline mode: read brain data directly
+      // Inline mode: note where the brain data is and step over it
       int32_t sz = 0;
       pos = chunk.Get(&sz, pos);
       if (pos < 0 || sz < 0) return start + sectionSize;
 
-      // Check if inline brains are enabled
+      // Inline brains disabled: the stored data is skipped
       if (sEnableInlineBrains && sz > 0)
+        inlinePos = pos;
+      pos += sz;
+    }
+
+    // Brain layers (absent in older states)
+    int32_t nLayers = 0;
+    if (pos >= 0 && pos + (int) sizeof(nLayers) <= start + sectionSize)
+    {
+      pos = chunk.Get(&nLayers, pos);
+      std::vector<int> layers;
+      for (int i = 0; i < nLayers && pos >= 0 && pos + (int) sizeof(int32_t) <= start + sectionSize; ++i)
       {
-        int consumed = brain.DeserializeSnapshotFromChunk(chunk, pos, nullptr);
-        if (consumed >= 0)
-          pos = consumed;
-        else
-          pos = start + sectionSize;
+        int32_t cs = 0;
+        pos = chunk.Get(&cs, pos);
+        layers.push_back(cs);
       }
-      else
+      brainMgr.SetLayerChunkSizes(std::move(layers));
+    }
+
+    // Adaptive chunk size (absent in older states: off)
+    int32_t adaptive = 0;
+    if (pos >= 0 && pos + (int) sizeof(adaptive) <= start + sectionSize)
+      pos = chunk.Get(&adaptive, pos);
+    brainMgr.SetAdaptiveChunking(adaptive != 0);
+
+    // Analysis cache (absent in older states: off)
+    int32_t analysisCache = 0;
+    if (pos >= 0 && pos + (int) sizeof(analysisCache) <= start + sectionSize)
+      pos = chunk.Get(&analysisCache, pos);
+    brainMgr.SetAnalysisCacheEnabled(analysisCache != 0);
+
+    if (mode == 1)
+    {
+      const bool useExternal = !externalPath.empty();
+      brainMgr.SetExternalRef(externalPath, useExternal);
+
+      // Try to load from path if readable; instances opening the same file share one copy
+      if (useExternal && brainMgr.LoadExternalFile(externalPath))
       {
-        // Inline brains disabled - skip loading inline brain data
-        // Just advance position by the stored size
-        pos += sz;
+        // Edited elsewhere (another project or instance saved it): flag it in the Brain tab
+        if (savedHash != 0 && savedHash != brainMgr.ExternalContentHash())
+          brainMgr.MarkExternalChanged();
       }
     }
+    else if (inlinePos >= 0)
+    {
+      // Inline mode: read brain data directly
+      brain.DeserializeSnapshotFromChunk(chunk, inlinePos, nullptr);
+    }
 
     return pos;
   }
@@ -54,7 +54,8 @@ namespace synaptic
      *
      * Called after Plugin::UnserializeState() to read brain section.
      * Handles both inline brain data and external file references.
-     * Loads brain from external file if path is valid.
+     * Loads brain from external file if path is valid, after applying the layers, adaptive
+     * chunking and analysis cache settings saved behind it.
      *
      * @param chunk Chunk to read brain state from
      * @param startPos Starting position in chunk
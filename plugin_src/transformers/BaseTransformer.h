@@ -3,12 +3,14 @@
 #include "plugin_src/modules/AudioStreamChunker.h"
 #include "plugin_src/brain/Brain.h"
 #include "../params/DynamicParamSchema.h"
+#include "ChunkMatcher.h"
 #include <cmath>
 #include <string>
 #include <vector>
 #include <utility>
 #include <numeric>
 #include <cstring>
+#include <optional>
 
 // No direct FFT here; transformers consume precomputed spectra from the chunker/brain
 
@@ -36,10 +38,23 @@ namespace synaptic
     // Required lookahead in chunks before processing (to gate scheduling).
     virtual int GetRequiredLookaheadChunks() const = 0;
 
+    // Input chunks held back before an output decision is made. Unlike GetAdditionalLatencySamples
+    // this is counted in input hops, which only the chunker knows (see DSPContext::ComputeLatencySamples).
+    virtual int GetDecisionDelayChunks(int /*bufferWindowSize*/) const { return 0; }
+
+    // Input hops by which output chunks run ahead of the input chunk they were made for, taken off
+    // the latency while the chunker overlap-adds (hop shorter than the chunk). Counted like
+    // GetDecisionDelayChunks.
+    virtual int GetOutputLeadChunks() const { return 0; }
+
     // Whether this transformer's output should be overlap-added by the chunker.
     // If false, the chunker will use simple sequential playback.
     virtual bool WantsOverlapAdd() const { return true; }
 
+    // Emit any chunks still held back for lookahead. Called on the audio thread right before
+    // this transformer is swapped out, so held pool entries are committed instead of leaked.
+    virtual void Flush(AudioStreamChunker& /*chunker*/) {}
+
     // Describe all exposed parameters (schema)
     void GetParamDescs(std::vector<ExposedParamDesc>& out, bool /*includeAll*/) const override { out.clear(); }
 
@@ -229,16 +244,130 @@ namespace synaptic
   // Base class for SampleBrain-based transformers
   // Provides common functionality for transformers that match input chunks
   // against a Brain database using feature-based similarity.
+  //
+  // The matching loop lives here: derived classes only analyze the input chunk and score one
+  // brain candidate. Each input chunk keeps its k best candidates; with a Buffer Window above 1
+  // and a Continuity Weight above 0 the choice is delayed by (window - 1) chunks and made by
+  // ContinuityPathSelector, which trades feature distance against jumps between unrelated brain
+  // chunks. At weight 0 the closest match wins anyway, so nothing is held back.
+  //
+  // Low Latency: an output chunk starts one input hop into its match and reads on through the
+  // brain file for a hop past its end. Its first part is the brain audio matched to the newest
+  // input hop; the rest continues that match until the next chunk's match crossfades over it in
+  // the overlap-add. Output is then ready a hop sooner, for a latency of chunk size minus one hop.
   class BaseSampleBrainTransformer : public IChunkBufferTransformer
   {
   public:
-    void OnReset(double sampleRate, int /*chunkSize*/, int /*bufferWindowSize*/, int /*numChannels*/) override
+    void OnReset(double sampleRate, int /*chunkSize*/, int bufferWindowSize, int numChannels) override
     {
       mSampleRate = (sampleRate > 0.0) ? sampleRate : 48000.0;
+      ConfigureSelectors(bufferWindowSize - 1, numChannels);
     }
 
     void SetBrain(const Brain* brain) { mBrain = brain; }
 
+    void Process(AudioStreamChunker& chunker) override
+    {
+      const int numChannels = chunker.GetNumChannels();
+
+      // Pool indices held from before a chunker reconfiguration no longer exist
+      if (chunker.GetConfigGeneration() != mChunkerGeneration)
+      {
+        mChunkerGeneration = chunker.GetConfigGeneration();
+        ConfigureSelectors(chunker.GetWindowCapacity() - 1, numChannels);
+      }
+
+      if (!mBrain)
+      {
+        Flush(chunker);
+        int idx;
+        while (chunker.PopPendingInputChunkIndex(idx))
+          CommitPassthrough(chunker, idx);
+        return;
+      }
+
+      // One brain snapshot for the whole block: no locking, and edits can't move chunks under us.
+      // A brain layer at the chunker's chunk size is matched against instead, when one is ready.
+      const PinnedBrainView pin(*this, chunker.GetChunkSize());
+
+      // Held layers were built for the other matching mode
+      if (mHeldChannelIndependent != mChannelIndependent)
+      {
+        Flush(chunker);
+        mHeldChannelIndependent = mChannelIndependent;
+      }
+
+      // Decisions are only held back while continuity can change them
+      const int lookahead = (mContinuityWeight > 0.0) ? mLookaheadCapacity : 0;
+      if (lookahead != mLookahead)
+      {
+        mLookahead = lookahead;
+        while (mHeldCount > mLookahead)
+          EmitOldestHeld(chunker);
+      }
+
+      // Brain chunks advance by half their chunk size; an input hop of one chunk skips one brain chunk
+      const int brainHop = std::max(1, (mBrainView->ChunkSize() > 0 ? mBrainView->ChunkSize() : chunker.GetChunkSize()) / 2);
+      const int expectedStep = std::max(1, (int) std::lround((double) chunker.GetInputHopSize() / (double) brainHop));
+      for (auto& sel : mSelectors)
+        sel.SetTransition(mContinuityWeight, expectedStep);
+
+      // Without a transition cost only the best candidate can ever win
+      const int k = (mContinuityWeight > 0.0) ? mCandidateCount : 1;
+      mMatchCache.BeginBlock(mBrainView->ContentVersion(), mBrainView->ChunkSize(), mParamVersion.load(std::memory_order_relaxed), k);
+
+      int idx;
+      while (chunker.TakePendingInputChunkIndex(idx))
+      {
+        const AudioChunk* in = chunker.GetInputChunk(idx);
+        AudioChunk* out = chunker.GetOutputChunk(idx);
+
+        if (!in || !out || in->numFrames <= 0)
+        {
+          chunker.ReleaseChunk(idx);
+          continue;
+        }
+
+        AnalyzeInput(*in, numChannels);
+
+        if (mChannelIndependent)
+        {
+          // For each output channel, independently rank brain chunk+channel pairs
+          for (int ch = 0; ch < numChannels; ++ch)
+          {
+            FindCandidates(ch, mSelectors[ch].NextLayer(k));
+            mSelectors[ch].PushLayer();
+          }
+        }
+        else
+        {
+          // Average-based: rank whole brain chunks
+          FindCandidates(-1, mSelectors[0].NextLayer(k));
+          mSelectors[0].PushLayer();
+        }
+
+        mHeld[(mHeldHead + mHeldCount) % (int) mHeld.size()] = idx;
+        ++mHeldCount;
+        while (mHeldCount > mLookahead)
+          EmitOldestHeld(chunker);
+      }
+    }
+
+    void Flush(AudioStreamChunker& chunker) override
+    {
+      if (chunker.GetConfigGeneration() != mChunkerGeneration)
+      {
+        // Chunker was reconfigured since these were taken; the indices are stale
+        mHeldCount = 0;
+        for (auto& sel : mSelectors) sel.Reset();
+        return;
+      }
+      const PinnedBrainView pin(*this, chunker.GetChunkSize());
+      while (mHeldCount > 0)
+        EmitOldestHeld(chunker);
+      for (auto& sel : mSelectors) sel.Reset();
+    }
+
     int GetAdditionalLatencySamples(int /*chunkSize*/, int /*bufferWindowSize*/) const override
     {
       return 0;
@@ -249,10 +378,31 @@ namespace synaptic
       return 0;
     }
 
+    // Lookup statistics of the scan-result cache (safe to call from any thread)
+    MatchCache::Stats GetMatchCacheStats() const { return mMatchCache.GetStats(); }
+    void ResetMatchCacheStats() { mMatchCache.ResetStats(); }
+
+    int GetDecisionDelayChunks(int bufferWindowSize) const override
+    {
+      if (mContinuityWeight <= 0.0) return 0;
+      return std::max(0, std::min(ContinuityPathSelector::kMaxLookahead, bufferWindowSize - 1));
+    }
+
+    int GetOutputLeadChunks() const override { return mLowLatency ? 1 : 0; }
+
     // Common parameter getters/setters
+    bool GetParamAsNumber(const std::string& id, double& out) const override
+    {
+      if (id == "continuityWeight") { out = mContinuityWeight; return true; }
+      if (id == "candidateCount") { out = (double) mCandidateCount; return true; }
+      return GetDerivedParamAsNumber(id, out);
+    }
+
     bool GetParamAsBool(const std::string& id, bool& out) const override
     {
       if (id == "channelIndependent") { out = mChannelIndependent; return true; }
+      if (id == "matchCache") { out = mUseMatchCache; return true; }
+      if (id == "lowLatency") { out = mLowLatency; return true; }
       return GetDerivedParamAsBool(id, out);
     }
 
@@ -261,24 +411,75 @@ namespace synaptic
       return GetDerivedParamAsString(id, out);
     }
 
+    // Any accepted change may alter scores, so it also retires cached scan results
+    bool SetParamSlot(int slot, double value) override
+    {
+      bool handled = true;
+      switch (slot)
+      {
+        case kSlotChannelIndependent: mChannelIndependent = value >= 0.5; break;
+        case kSlotContinuityWeight: mContinuityWeight = std::max(0.0, value); break;
+        case kSlotCandidateCount: mCandidateCount = std::max(1, std::min(TopKMatches::kMaxK, (int) std::lround(value))); break;
+        case kSlotMatchCache: mUseMatchCache = value >= 0.5; break;
+        case kSlotLowLatency: mLowLatency = value >= 0.5; break;
+        default: handled = slot >= kNumCommonSlots && SetDerivedParamSlot(slot - kNumCommonSlots, value); break;
+      }
+      if (handled) ++mParamVersion;
+      return handled;
+    }
+
+    bool SetParamFromNumber(const std::string& id, double v) override
+    {
+      if (id == "continuityWeight") return SetParamSlot(kSlotContinuityWeight, v);
+      if (id == "candidateCount") return SetParamSlot(kSlotCandidateCount, v);
+      const bool handled = SetDerivedParamFromNumber(id, v);
+      if (handled) ++mParamVersion;
+      return handled;
+    }
+
     bool SetParamFromBool(const std::string& id, bool v) override
     {
-      if (id == "channelIndependent") { mChannelIndependent = v; return true; }
-      return SetDerivedParamFromBool(id, v);
+      if (id == "channelIndependent") return SetParamSlot(kSlotChannelIndependent, v ? 1.0 : 0.0);
+      if (id == "matchCache") return SetParamSlot(kSlotMatchCache, v ? 1.0 : 0.0);
+      if (id == "lowLatency") return SetParamSlot(kSlotLowLatency, v ? 1.0 : 0.0);
+      const bool handled = SetDerivedParamFromBool(id, v);
+      if (handled) ++mParamVersion;
+      return handled;
     }
 
     bool SetParamFromString(const std::string& id, const std::string& v) override
     {
-      return SetDerivedParamFromString(id, v);
+      const bool handled = SetDerivedParamFromString(id, v);
+      if (handled) ++mParamVersion;
+      return handled;
     }
 
   protected:
+    // Analyze one input chunk; results are kept by the derived class for ScoreCandidate
+    virtual void AnalyzeInput(const AudioChunk& in, int numChannels) = 0;
+
+    // Feature distance between the analyzed input and a brain chunk (lower is better).
+    // brainChannel/inputChannel are -1 when matching on channel-averaged features.
+    // Return +infinity to exclude the candidate.
+    virtual double ScoreCandidate(const BrainChunk& bc, int brainChannel, int inputChannel) const = 0;
+
+    // Quantized features of the analyzed input (inputChannel -1 = averaged) used as the match
+    // cache key. Only features that affect ScoreCandidate should be added. Return false to bypass the cache.
+    virtual bool BuildMatchKey(int /*inputChannel*/, MatchKey& /*key*/) const { return false; }
+
     // Hook methods for derived classes to add their own parameters
+    virtual bool GetDerivedParamAsNumber(const std::string& /*id*/, double& /*out*/) const { return false; }
     virtual bool GetDerivedParamAsBool(const std::string& /*id*/, bool& /*out*/) const { return false; }
     virtual bool GetDerivedParamAsString(const std::string& /*id*/, std::string& /*out*/) const { return false; }
+    virtual bool SetDerivedParamFromNumber(const std::string& /*id*/, double /*v*/) { return false; }
     virtual bool SetDerivedParamFromBool(const std::string& /*id*/, bool /*v*/) { return false; }
     virtual bool SetDerivedParamFromString(const std::string& /*id*/, const std::string& /*v*/) { return false; }
 
+    // Slots of AddCommonParamDescs, in order; a derived class's own descs follow them, and it gets
+    // its slots counted from 0 in SetDerivedParamSlot
+    enum CommonParamSlot { kSlotChannelIndependent, kSlotContinuityWeight, kSlotCandidateCount, kSlotMatchCache, kSlotLowLatency, kNumCommonSlots };
+    virtual bool SetDerivedParamSlot(int /*slot*/, double /*value*/) { return false; }
+
     // Helper to add common parameter descriptors
     void AddCommonParamDescs(std::vector<ExposedParamDesc>& out) const
     {
@@ -290,21 +491,64 @@ namespace synaptic
       p1.control = ControlType::Checkbox;
       p1.defaultBool = false;
       out.push_back(p1);
+
+      ExposedParamDesc p2;
+      p2.id = "continuityWeight";
+      p2.label = "Continuity Weight";
+      p2.tooltip = "Penalty for jumping to an unrelated brain chunk instead of continuing the previous one. Looks ahead (Buffer Window - 1) chunks to pick the smoothest path. 0 = always pick the closest match.";
+      p2.type = ParamType::Number;
+      p2.control = ControlType::Slider;
+      p2.minValue = 0.0;
+      p2.maxValue = 2.0;
+      p2.step = 0.01;
+      p2.defaultNumber = 0.0;
+      out.push_back(p2);
+
+      ExposedParamDesc p3;
+      p3.id = "candidateCount";
+      p3.label = "Candidates";
+      p3.tooltip = "Number of best-matching brain chunks kept per input chunk when Continuity Weight is above 0.";
+      p3.type = ParamType::Number;
+      p3.control = ControlType::NumberBox;
+      p3.minValue = 1.0;
+      p3.maxValue = (double) TopKMatches::kMaxK;
+      p3.step = 1.0;
+      p3.defaultNumber = 8.0;
+      out.push_back(p3);
+
+      ExposedParamDesc p4;
+      p4.id = "matchCache";
+      p4.label = "Match Cache";
+      p4.tooltip = "Reuse the brain search result when an input chunk's features are nearly identical to a recent one (within a quarter semitone and 0.5 dB). Saves CPU on loops and sustained notes, but the reused match can differ from a fresh search.";
+      p4.type = ParamType::Boolean;
+      p4.control = ControlType::Checkbox;
+      p4.defaultBool = false;
+      out.push_back(p4);
+
+      ExposedParamDesc p5;
+      p5.id = "lowLatency";
+      p5.label = "Low Latency";
+      p5.tooltip = "Play each match from the newest hop of its input chunk, continuing it until the next match crossfades in. Cuts latency by one hop (to half the chunk size at 50% overlap). Needs Overlap-Add.";
+      p5.type = ParamType::Boolean;
+      p5.control = ControlType::Checkbox;
+      p5.defaultBool = false;
+      out.push_back(p5);
     }
 
     // Centralized copy helper for matched brain chunks across arbitrary channel mappings.
     // If both vectors are empty, copies all channels 0..numOutChannels-1 from matching brain channels.
+    // leadFrames > 0 copies from that far into the match instead (Low Latency).
     void CopyBrainChannelsToOutput(const BrainChunk* match,
                                    int chunkSize,
                                    int numOutChannels,
                                    AudioChunk& out,
+                                   int leadFrames,
                                    const std::vector<int>& brainSrcChans = std::vector<int>(),
                                    const std::vector<int>& outChans = std::vector<int>()) const
     {
       if (!match || chunkSize <= 0 || numOutChannels <= 0) return;
 
-      const int framesToWrite = std::min(chunkSize, match->audio.numFrames);
-      const int srcChans = (int) match->audio.channelSamples.size();
+      const int srcChans = match->NumChannels();
 
       // Ensure output buffers sized
       if ((int) out.channelSamples.size() != numOutChannels)
@@ -317,10 +561,11 @@ namespace synaptic
       {
         if (och < 0 || och >= numOutChannels) return;
         const int srcIdx = (sch >= 0 && sch < srcChans) ? sch : 0;
-        for (int i = 0; i < framesToWrite; ++i)
-          out.channelSamples[och][i] = match->audio.channelSamples[srcIdx][i];
-        for (int i = framesToWrite; i < chunkSize; ++i)
-          out.channelSamples[och][i] = 0.0;
+        // Zero-fills past the brain chunk's frames (and for channel-less chunks)
+        if (leadFrames > 0)
+          match->ReadChannelAhead(srcIdx, leadFrames, out.channelSamples[och].data(), chunkSize);
+        else
+          match->ReadChannel(srcIdx, out.channelSamples[och].data(), chunkSize);
       };
 
       if (brainSrcChans.empty() && outChans.empty())
@@ -335,8 +580,8 @@ namespace synaptic
           doPair(brainSrcChans[i], outChans[i]);
       }
 
-      // Copy spectra if available
-      if (match->audio.fftSize > 0)
+      // Copy spectra if available (they don't describe audio read from further on)
+      if (match->audio.fftSize > 0 && leadFrames <= 0)
       {
         out.fftSize = match->audio.fftSize;
         if ((int) out.complexSpectrum.size() != numOutChannels)
@@ -369,7 +614,169 @@ namespace synaptic
     double mSampleRate = 48000.0;
     bool mChannelIndependent = false;
 
-  };
-}
+  private:
+    // k-best candidates for one input channel (-1 = averaged), from the cache when possible
+    void FindCandidates(int inputChannel, TopKMatches& layer)
+    {
+      mKeyScratch.Clear();
+      const bool cacheable = mUseMatchCache && BuildMatchKey(inputChannel, mKeyScratch);
+      if (cacheable)
+      {
+        mKeyScratch.Add(inputChannel < 0 ? 0 : 1); // averaged and per-channel scans rank different things
+        if (mMatchCache.Lookup(mKeyScratch, layer)) return;
+      }
+
+      ScanBrainTopK(*mBrainView, inputChannel >= 0,
+        [&](const BrainChunk& bc, int bch) { return ScoreCandidate(bc, bch, inputChannel); }, layer);
 
+      if (cacheable)
+        mMatchCache.Store(mKeyScratch, layer);
+    }
+
+    // Sized for the Buffer Window here, so Continuity Weight can start and stop holding without allocating
+    void ConfigureSelectors(int lookahead, int numChannels)
+    {
+      mLookaheadCapacity = std::max(0, std::min(ContinuityPathSelector::kMaxLookahead, lookahead));
+      mLookahead = (mContinuityWeight > 0.0) ? mLookaheadCapacity : 0;
+      mSelectors.resize((size_t) std::max(1, numChannels));
+      for (auto& sel : mSelectors)
+        sel.Configure(mLookaheadCapacity);
+      mHeld.assign((size_t) ContinuityPathSelector::kMaxLookahead + 1, -1);
+      mHeldHead = 0;
+      mHeldCount = 0;
+      mHeldChannelIndependent = mChannelIndependent;
+    }
+
+    // Decide the oldest held input chunk, write its match and hand it to the output queue
+    void EmitOldestHeld(AudioStreamChunker& chunker)
+    {
+      const int idx = mHeld[mHeldHead];
+      mHeldHead = (mHeldHead + 1) % (int) mHeld.size();
+      --mHeldCount;
+
+      AudioChunk* out = chunker.GetOutputChunk(idx);
+      const int numChannels = chunker.GetNumChannels();
+      const int chunkSize = chunker.GetChunkSize();
+      // Leading needs the next chunk to overlap the continuation; sequential playback would only cut to it
+      const int hopSize = chunker.GetInputHopSize();
+      const int leadFrames = (mLowLatency && hopSize < chunkSize) ? hopSize : 0;
+      if (!out)
+      {
+        for (auto& sel : mSelectors) { MatchCandidate unused; sel.PopDecision(unused); }
+        chunker.ReleaseChunk(idx);
+        return;
+      }
+
+      if ((int) out->channelSamples.size() != numChannels)
+        out->channelSamples.assign(numChannels, std::vector<iplug::sample>(chunkSize, 0.0));
+      for (int ch = 0; ch < numChannels; ++ch)
+        if ((int) out->channelSamples[ch].size() < chunkSize)
+          out->channelSamples[ch].assign(chunkSize, 0.0);
 
+      if (mHeldChannelIndependent)
+      {
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+          MatchCandidate m;
+          mSelectors[ch].PopDecision(m);
+          const BrainChunk* match = mBrainView ? mBrainView->Chunk(m.chunkIndex) : nullptr;
+          if (match)
+          {
+            mSrcChan[0] = m.srcChannel;
+            mDstChan[0] = ch;
+            CopyBrainChannelsToOutput(match, chunkSize, numChannels, *out, leadFrames, mSrcChan, mDstChan);
+          }
+          else
+          {
+            // No match found for this channel - output silence
+            std::fill(out->channelSamples[ch].begin(), out->channelSamples[ch].begin() + chunkSize, 0.0);
+          }
+        }
+
+        // Commit output chunk (RMS calculated automatically)
+        chunker.CommitOutputChunk(idx, chunkSize);
+      }
+      else
+      {
+        MatchCandidate m;
+        mSelectors[0].PopDecision(m);
+        const BrainChunk* match = mBrainView ? mBrainView->Chunk(m.chunkIndex) : nullptr;
+        if (match)
+        {
+          CopyBrainChannelsToOutput(match, chunkSize, numChannels, *out, leadFrames);
+          chunker.CommitOutputChunk(idx, std::min(chunkSize, match->audio.numFrames));
+        }
+        else
+        {
+          // No match found - output silence
+          for (int ch = 0; ch < numChannels; ++ch)
+            std::fill(out->channelSamples[ch].begin(), out->channelSamples[ch].begin() + chunkSize, 0.0);
+          chunker.CommitOutputChunk(idx, chunkSize);
+        }
+      }
+
+      chunker.ReleaseChunk(idx);
+    }
+
+    // Opens mBrainView for the duration of a Process or Flush call (a nested call reuses it)
+    class PinnedBrainView
+    {
+    public:
+      PinnedBrainView(BaseSampleBrainTransformer& owner, int chunkSize)
+        : mOwner(owner), mOwnsView(!owner.mBrainView && owner.mBrain)
+      {
+        if (mOwnsView) mOwner.mBrainView.emplace(*mOwner.mBrain, chunkSize);
+      }
+      ~PinnedBrainView() { if (mOwnsView) mOwner.mBrainView.reset(); }
+      PinnedBrainView(const PinnedBrainView&) = delete;
+      PinnedBrainView& operator=(const PinnedBrainView&) = delete;
+
+    private:
+      BaseSampleBrainTransformer& mOwner;
+      const bool mOwnsView;
+    };
+
+    // Fallback when no brain is set: copy input to output unchanged
+    static void CommitPassthrough(AudioStreamChunker& chunker, int idx)
+    {
+      const AudioChunk* in = chunker.GetInputChunk(idx);
+      AudioChunk* out = chunker.GetOutputChunk(idx);
+      if (!in || !out) return;
+
+      const int numChannels = (int) in->channelSamples.size();
+      const int chunkSize = chunker.GetChunkSize();
+      if ((int) out->channelSamples.size() != numChannels)
+        out->channelSamples.assign(numChannels, std::vector<iplug::sample>(chunkSize, 0.0));
+      for (int ch = 0; ch < numChannels; ++ch)
+      {
+        const int copyN = std::min((int) in->channelSamples[ch].size(), chunkSize);
+        if (copyN > 0)
+          std::memcpy(out->channelSamples[ch].data(), in->channelSamples[ch].data(),
+                      sizeof(iplug::sample) * copyN);
+      }
+      chunker.CommitOutputChunk(idx, in->numFrames);
+    }
+
+    double mContinuityWeight = 0.0;
+    int mCandidateCount = 8;
+    bool mUseMatchCache = false;
+    bool mLowLatency = false;
+    std::atomic<uint32_t> mParamVersion { 0 }; // written by param setters, read by Process
+    MatchCache mMatchCache;
+    MatchKey mKeyScratch;
+    std::optional<Brain::ReadScope> mBrainView; // open while Process/Flush runs
+
+    // Lookahead state: one selector per output channel (only [0] is used when averaging),
+    // and the pool indices of the input chunks whose decision is still pending
+    int mLookaheadCapacity = 0; // Buffer Window - 1
+    int mLookahead = 0;         // chunks held now: the capacity, or 0 at Continuity Weight 0
+    std::vector<ContinuityPathSelector> mSelectors = std::vector<ContinuityPathSelector>(1);
+    std::vector<int> mHeld = std::vector<int>(ContinuityPathSelector::kMaxLookahead + 1, -1);
+    int mHeldHead = 0;
+    int mHeldCount = 0;
+    bool mHeldChannelIndependent = false;
+    uint32_t mChunkerGeneration = 0;
+    std::vector<int> mSrcChan = std::vector<int>(1, 0);
+    std::vector<int> mDstChan = std::vector<int>(1, 0);
+  };
+}
@@ -0,0 +1,421 @@
+/**
+ * @file ChunkMatcher.h
+ * @brief Shared brain-matching kernel: k-best scan and continuity-aware path selection
+ *
+ * ScanBrainTopK walks the brain once and keeps the k lowest-scoring candidates for an input
+ * chunk. ContinuityPathSelector buffers those candidate lists for a few input chunks and picks,
+ * with a small Viterbi search, the sequence that minimizes feature distance plus a transition
+ * cost that favours playing brain chunks in their original order. MatchCache remembers scan
+ * results for recently seen (quantized) input features so repeated material skips the scan.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "plugin_src/brain/Brain.h"
+
+namespace synaptic
+{
+  /** @brief One brain chunk (and source channel) proposed for an input chunk */
+  struct MatchCandidate
+  {
+    int chunkIndex = -1;        // global brain chunk index
+    int srcChannel = 0;         // brain channel the score was computed on
+    int fileId = -1;
+    int chunkIndexInFile = -1;
+    double score = 0.0;         // feature distance, lower is better
+  };
+
+  /**
+   * @brief Fixed-capacity list of the k best candidates, sorted by ascending score
+   *
+   * Equal scores keep their scan order, so with k == 1 the result is exactly the
+   * first argmin a plain linear scan would find.
+   */
+  class TopKMatches
+  {
+  public:
+    static constexpr int kMaxK = 16;
+
+    void Reset(int k)
+    {
+      mK = std::max(1, std::min(kMaxK, k));
+      mCount = 0;
+    }
+
+    int Count() const { return mCount; }
+    const MatchCandidate& operator[](int i) const { return mItems[i]; }
+
+    // Scores at or above this cannot enter the list
+    double WorstScore() const
+    {
+      return (mCount < mK) ? std::numeric_limits<double>::infinity() : mItems[mCount - 1].score;
+    }
+
+    void Offer(const MatchCandidate& c)
+    {
+      if (!(c.score < WorstScore())) return;
+      int pos = std::min(mCount, mK - 1);
+      while (pos > 0 && mItems[pos - 1].score > c.score)
+      {
+        mItems[pos] = mItems[pos - 1];
+        --pos;
+      }
+      mItems[pos] = c;
+      if (mCount < mK) ++mCount;
+    }
+
+  private:
+    std::array<MatchCandidate, kMaxK> mItems;
+    int mK = 1;
+    int mCount = 0;
+  };
+
+  /**
+   * @brief Scan every brain chunk and keep the best candidates in @p out
+   *
+   * Reads through a Brain::ReadScope, so the scan is lock-free and sees one consistent snapshot.
+   * @param perChannel If true, every brain channel is scored separately (scoreFn receives its index);
+   *                   otherwise scoreFn receives -1 and should use the chunk's averaged features.
+   * @param scoreFn    double(const BrainChunk&, int brainChannel); return +inf to skip a candidate.
+   */
+  template <typename ScoreFn>
+  inline void ScanBrainTopK(const Brain::ReadScope& brain, bool perChannel, ScoreFn&& scoreFn, TopKMatches& out)
+  {
+    const int total = brain.TotalChunks();
+    for (int bi = 0; bi < total; ++bi)
+    {
+      const BrainChunk* bc = brain.Chunk(bi);
+      if (!bc) continue;
+
+      MatchCandidate c;
+      c.chunkIndex = bi;
+      c.fileId = bc->fileId;
+      c.chunkIndexInFile = bc->chunkIndexInFile;
+
+      if (!perChannel)
+      {
+        c.score = scoreFn(*bc, -1);
+        out.Offer(c);
+        continue;
+      }
+
+      const int bChans = bc->NumChannels();
+      for (int bch = 0; bch < bChans; ++bch)
+      {
+        c.srcChannel = bch;
+        c.score = scoreFn(*bc, bch);
+        out.Offer(c);
+      }
+    }
+  }
+
+  /**
+   * @brief Fixed-lag Viterbi over per-chunk candidate lists
+   *
+   * Each pushed layer holds the k best candidates for one input chunk. A decision for the
+   * oldest layer is made by searching the cheapest path through all buffered layers, starting
+   * from the previously emitted candidate, so the emitted sequence is always a consistent path.
+   * All storage is sized in Configure(); pushing and deciding never allocate.
+   */
+  class ContinuityPathSelector
+  {
+  public:
+    static constexpr int kMaxLookahead = 32;
+
+    void Configure(int lookahead)
+    {
+      mLookahead = std::max(0, std::min(kMaxLookahead, lookahead));
+      const int layers = mLookahead + 1;
+      mLayers.resize(layers);
+      mCost.assign((size_t) layers * TopKMatches::kMaxK, 0.0);
+      mBack.assign((size_t) layers * TopKMatches::kMaxK, 0);
+      Reset();
+    }
+
+    void Reset()
+    {
+      mHead = 0;
+      mCount = 0;
+      mHasPrev = false;
+    }
+
+    /**
+     * @param weight       Cost of a jump to an unrelated chunk (0 disables continuity)
+     * @param expectedStep chunkIndexInFile advance that counts as seamless continuation
+     */
+    void SetTransition(double weight, int expectedStep)
+    {
+      mWeight = std::max(0.0, weight);
+      mExpectedStep = std::max(1, expectedStep);
+    }
+
+    int GetLookahead() const { return mLookahead; }
+    int PendingCount() const { return mCount; }
+
+    /** @brief Slot for the next layer; fill it, then call PushLayer() */
+    TopKMatches& NextLayer(int k)
+    {
+      TopKMatches& layer = mLayers[(mHead + mCount) % (int) mLayers.size()];
+      layer.Reset(k);
+      return layer;
+    }
+
+    void PushLayer()
+    {
+      if (mCount < (int) mLayers.size()) ++mCount;
+    }
+
+    /**
+     * @brief Decide the oldest buffered layer and drop it
+     * @return false if nothing is buffered; out.chunkIndex is -1 if that layer had no candidates
+     */
+    bool PopDecision(MatchCandidate& out)
+    {
+      if (mCount == 0) return false;
+
+      const int cap = (int) mLayers.size();
+      // Search only through the leading run of non-empty layers
+      int n = 0;
+      while (n < mCount && mLayers[(mHead + n) % cap].Count() > 0) ++n;
+
+      if (n == 0)
+      {
+        out = MatchCandidate();
+        mHasPrev = false;
+      }
+      else
+      {
+        out = Layer(0)[Solve(n)];
+        mPrev = out;
+        mHasPrev = true;
+      }
+
+      mHead = (mHead + 1) % cap;
+      --mCount;
+      return true;
+    }
+
+  private:
+    const TopKMatches& Layer(int ordinal) const { return mLayers[(mHead + ordinal) % (int) mLayers.size()]; }
+
+    double TransitionCost(const MatchCandidate& from, const MatchCandidate& to) const
+    {
+      if (mWeight <= 0.0) return 0.0;
+      if (from.fileId == to.fileId && from.fileId >= 0)
+      {
+        if (to.chunkIndexInFile == from.chunkIndexInFile + mExpectedStep) return 0.0;
+        if (to.chunkIndexInFile == from.chunkIndexInFile) return 0.5 * mWeight; // held note
+      }
+      return mWeight;
+    }
+
+    // Returns the candidate index in layer 0 on the cheapest path through layers [0, n)
+    int Solve(int n)
+    {
+      const int K = TopKMatches::kMaxK;
+      const TopKMatches& first = Layer(0);
+      for (int j = 0; j < first.Count(); ++j)
+        mCost[j] = first[j].score + (mHasPrev ? TransitionCost(mPrev, first[j]) : 0.0);
+
+      for (int m = 1; m < n; ++m)
+      {
+        const TopKMatches& prev = Layer(m - 1);
+        const TopKMatches& cur = Layer(m);
+        const double* prevCost = &mCost[(size_t) (m - 1) * K];
+        double* cost = &mCost[(size_t) m * K];
+        int* back = &mBack[(size_t) m * K];
+        for (int j = 0; j < cur.Count(); ++j)
+        {
+          double best = std::numeric_limits<double>::infinity();
+          int bestI = 0;
+          for (int i = 0; i < prev.Count(); ++i)
+          {
+            const double v = prevCost[i] + TransitionCost(prev[i], cur[j]);
+            if (v < best) { best = v; bestI = i; }
+          }
+          cost[j] = cur[j].score + best;
+          back[j] = bestI;
+        }
+      }
+
+      const double* lastCost = &mCost[(size_t) (n - 1) * K];
+      int state = 0;
+      for (int j = 1; j < Layer(n - 1).Count(); ++j)
+        if (lastCost[j] < lastCost[state]) state = j;
+      for (int m = n - 1; m > 0; --m)
+        state = mBack[(size_t) m * K + state];
+      return state;
+    }
+
+    std::vector<TopKMatches> mLayers = std::vector<TopKMatches>(1); // ring of lookahead+1 layers
+    std::vector<double> mCost = std::vector<double>(TopKMatches::kMaxK, 0.0);
+    std::vector<int> mBack = std::vector<int>(TopKMatches::kMaxK, 0);
+    int mHead = 0;
+    int mCount = 0;
+    int mLookahead = 0;
+
+    double mWeight = 0.0;
+    int mExpectedStep = 1;
+    MatchCandidate mPrev;
+    bool mHasPrev = false;
+  };
+
+  /**
+   * @brief Quantized input features identifying a scan result
+   *
+   * Two input chunks with the same key are treated as the same query; the quantization
+   * steps (chosen by the transformer) decide how close "the same" is.
+   */
+  struct MatchKey
+  {
+    static constexpr int kMaxLen = 12;
+
+    std::array<int32_t, kMaxLen> q {};
+    int len = 0;
+
+    void Clear() { len = 0; }
+    void Add(int32_t v) { if (len < kMaxLen) q[len++] = v; }
+
+    // Quantize v to steps of 1/stepsPerUnit, saturating instead of overflowing
+    void AddQuantized(double v, double stepsPerUnit)
+    {
+      const double x = std::round(v * stepsPerUnit);
+      Add((int32_t) std::max(-2.0e9, std::min(2.0e9, std::isfinite(x) ? x : 0.0)));
+    }
+
+    uint64_t Hash() const
+    {
+      uint64_t h = 1469598103934665603ull; // FNV-1a over the quantized values
+      for (int i = 0; i < len; ++i)
+      {
+        h ^= (uint32_t) q[i];
+        h *= 1099511628211ull;
+      }
+      return h ^ (h >> 29);
+    }
+
+    bool operator==(const MatchKey& o) const
+    {
+      if (len != o.len) return false;
+      for (int i = 0; i < len; ++i)
+        if (q[i] != o.q[i]) return false;
+      return true;
+    }
+  };
+
+  /**
+   * @brief Fixed-size hash cache from MatchKey to the k-best list of a brain scan
+   *
+   * Real-time safe: all slots are allocated up front, lookups probe at most kProbe slots and
+   * stores overwrite in place. Entries are only valid for the brain contents (and the chunk size
+   * of the layer read), parameter set and k they were computed with; BeginBlock() clears the
+   * table when any of those change.
+   * Hit/miss counters are atomics so the UI thread can read them while audio runs.
+   */
+  class MatchCache
+  {
+  public:
+    static constexpr int kCapacity = 256; // power of two
+    static constexpr int kProbe = 4;
+
+    struct Stats
+    {
+      uint64_t hits = 0;
+      uint64_t misses = 0;
+      uint64_t Lookups() const { return hits + misses; }
+      double HitRate() const { return Lookups() > 0 ? (double) hits / (double) Lookups() : 0.0; }
+    };
+
+    MatchCache() : mSlots(kCapacity) {}
+
+    // Call once per processing block with the current context; clears stale entries
+    void BeginBlock(uint32_t brainVersion, int brainChunkSize, uint32_t paramVersion, int k)
+    {
+      if (brainVersion == mBrainVersion && brainChunkSize == mBrainChunkSize && paramVersion == mParamVersion && k == mK)
+        return;
+      mBrainVersion = brainVersion;
+      mBrainChunkSize = brainChunkSize;
+      mParamVersion = paramVersion;
+      mK = k;
+      Invalidate();
+    }
+
+    void Invalidate()
+    {
+      for (auto& slot : mSlots) slot.valid = false;
+    }
+
+    bool Lookup(const MatchKey& key, TopKMatches& out)
+    {
+      const uint64_t h = key.Hash();
+      for (int p = 0; p < kProbe; ++p)
+      {
+        const Slot& slot = mSlots[(size_t) ((h + (uint64_t) p) & (kCapacity - 1))];
+        if (slot.valid && slot.hash == h && slot.key == key)
+        {
+          out = slot.matches;
+          mHits.fetch_add(1, std::memory_order_relaxed);
+          return true;
+        }
+      }
+      mMisses.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+
+    void Store(const MatchKey& key, const TopKMatches& matches)
+    {
+      const uint64_t h = key.Hash();
+      // First free probe slot, otherwise a hash-chosen victim
+      size_t target = (size_t) ((h + ((h >> 32) % kProbe)) & (kCapacity - 1));
+      for (int p = 0; p < kProbe; ++p)
+      {
+        const size_t i = (size_t) ((h + (uint64_t) p) & (kCapacity - 1));
+        if (!mSlots[i].valid) { target = i; break; }
+      }
+      Slot& slot = mSlots[target];
+      slot.key = key;
+      slot.hash = h;
+      slot.matches = matches;
+      slot.valid = true;
+    }
+
+    Stats GetStats() const
+    {
+      Stats s;
+      s.hits = mHits.load(std::memory_order_relaxed);
+      s.misses = mMisses.load(std::memory_order_relaxed);
+      return s;
+    }
+
+    void ResetStats()
+    {
+      mHits.store(0, std::memory_order_relaxed);
+      mMisses.store(0, std::memory_order_relaxed);
+    }
+
+  private:
+    struct Slot
+    {
+      MatchKey key;
+      uint64_t hash = 0;
+      TopKMatches matches;
+      bool valid = false;
+    };
+
+    std::vector<Slot> mSlots;
+    uint32_t mBrainVersion = 0xFFFFFFFFu;
+    int mBrainChunkSize = -1;
+    uint32_t mParamVersion = 0xFFFFFFFFu;
+    int mK = -1;
+    std::atomic<uint64_t> mHits { 0 };
+    std::atomic<uint64_t> mMisses { 0 };
+  };
+}
@@ -3,6 +3,7 @@
 #include "../BaseTransformer.h"
 #include "plugin_src/audio/FeatureAnalysis.h"
 #include "plugin_src/audio/FFT.h"
+#include <limits>
 
 namespace synaptic
 {
@@ -10,258 +11,6 @@ namespace synaptic
   class ExpandedSimpleSampleBrainTransformer final : public BaseSampleBrainTransformer
   {
   public:
-
-    void Process(AudioStreamChunker& chunker) override
-    {
-      if (!mBrain)
-      {
-        // fallback passthrough
-        int idx;
-        while (chunker.PopPendingInputChunkIndex(idx))
-        {
-          // Simple passthrough when no brain
-          const AudioChunk* in = chunker.GetInputChunk(idx);
-          AudioChunk* out = chunker.GetOutputChunk(idx);
-          if (in && out)
-          {
-            const int numChannels = (int)in->channelSamples.size();
-            const int chunkSize = chunker.GetChunkSize();
-            if ((int)out->channelSamples.size() != numChannels)
-              out->channelSamples.assign(numChannels, std::vector<iplug::sample>(chunkSize, 0.0));
-            for (int ch = 0; ch < numChannels; ++ch)
-            {
-              const int copyN = std::min((int)in->channelSamples[ch].size(), chunkSize);
-              if (copyN > 0)
-                std::memcpy(out->channelSamples[ch].data(), in->channelSamples[ch].data(),
-                           sizeof(iplug::sample) * copyN);
-            }
-            chunker.CommitOutputChunk(idx, in->numFrames);
-          }
-        }
-        return;
-      }
-
-      const int numChannels = chunker.GetNumChannels();
-
-      int idx;
-      while (chunker.PopPendingInputChunkIndex(idx))
-      {
-        // NEW API: Access input and output from same entry
-        const AudioChunk* in = chunker.GetInputChunk(idx);
-        AudioChunk* out = chunker.GetOutputChunk(idx);
-
-        if (!in || !out || in->numFrames <= 0)
-          continue;
-
-        // Analyze input chunk using precomputed spectra and FeatureAnalysis
-        const double nyquist = 0.5 * mSampleRate;
-        std::vector<std::vector<float>> inFeatures(numChannels, std::vector<float>(7, 0.0f));
-        std::vector<float> inFeaturesAvg(7, 0.0f);
-        std::vector<double> inFftDominantHz(numChannels, 0.0);
-        double inFftDominantHzAvg = 0.0;
-
-        if (in->fftSize > 0)
-        {
-          (void)inFftDominantHzAvg; // Suppress unused variable warning if not used in mChannelIndependent block
-          (void)inFeaturesAvg;      // Suppress unused variable warning if not used in mChannelIndependent block
-
-          for (int ch = 0; ch < numChannels; ++ch)
-          {
-            if (ch >= (int)in->complexSpectrum.size() || in->complexSpectrum[ch].empty())
-              continue;
-
-            const float* ordered = in->complexSpectrum[ch].data();
-            // Dominant freq
-            double domHz = FFTProcessor::DominantFreqHzFromOrderedSpectrum(ordered, in->fftSize, mSampleRate);
-            if (domHz < 20.0) domHz = 20.0;
-            if (domHz > nyquist - 20.0) domHz = nyquist - 20.0;
-            inFftDominantHz[ch] = domHz;
-            inFftDominantHzAvg += domHz;
-
-            // Extended features from ordered spectrum
-            auto features = FeatureAnalysis::GetFeatures((float*)ordered, in->fftSize, (int)mSampleRate);
-            inFeatures[ch] = features;
-            for (int f = 0; f < 7; ++f)
-              inFeaturesAvg[f] += features[f];
-          }
-          for (int f = 0; f < 7; ++f)
-            inFeaturesAvg[f] /= (numChannels > 0) ? (float)numChannels : 1.0f;
-          inFftDominantHzAvg /= (numChannels > 0) ? (double)numChannels : 1.0;
-        }
-
-        // Prepare output chunk (already allocated in same entry as input)
-        const int chunkSize = chunker.GetChunkSize();
-        if ((int)out->channelSamples.size() != numChannels)
-          out->channelSamples.assign(numChannels, std::vector<iplug::sample>(chunkSize, 0.0));
-        for (int ch = 0; ch < numChannels; ++ch)
-          if ((int)out->channelSamples[ch].size() < chunkSize)
-            out->channelSamples[ch].assign(chunkSize, 0.0);
-
-        if (mChannelIndependent)
-        {
-          // For each output channel, independently pick best brain chunk+channel
-          const int total = mBrain->GetTotalChunks();
-          bool foundAnyMatch = false;
-          for (int ch = 0; ch < numChannels; ++ch)
-          {
-            int bestChunk = -1;
-            int bestSrcCh = 0;
-            double bestScore = 1e9;
-
-            for (int bi = 0; bi < total; ++bi)
-            {
-              const BrainChunk* bc = mBrain->GetChunkByGlobalIndex(bi);
-              if (!bc) continue;
-              const int bChans = (int) bc->audio.channelSamples.size();
-
-              for (int bch = 0; bch < bChans; ++bch)
-              {
-                // Get brain chunk features for this channel
-                const auto& bFeatures = (bch < (int)bc->extendedFeaturesPerChannel.size())
-                  ? bc->extendedFeaturesPerChannel[bch]
-                  : bc->avgExtendedFeatures;
-
-                if (bFeatures.size() < 7) continue;
-
-                // Compute weighted distance
-                double score = 0.0;
-
-                // FFT Dominant Frequency (like Simple SampleBrain)
-                const double bFftFreq = (bch < (int)bc->fftDominantHzPerChannel.size())
-                  ? bc->fftDominantHzPerChannel[bch]
-                  : bc->avgFftDominantHz;
-                const double inFftFreq = (ch < (int)inFftDominantHz.size()) ? inFftDominantHz[ch] : 0.0;
-                double dFft = std::abs(inFftFreq - bFftFreq) / nyquist;
-                score += mWeightFftFrequency * dFft;
-
-                // Feature 0: Fundamental Frequency (f0 from Harmonic Product Spectrum)
-                double df0 = std::abs(inFeatures[ch][0] - bFeatures[0]) / nyquist;
-                score += mWeightFundFrequency * df0;
-
-                // Amplitude (use RMS)
-                const double br = (bch < (int) bc->rmsPerChannel.size()) ? (double) bc->rmsPerChannel[bch] : (double) bc->avgRms;
-                double da = std::abs(in->rms - br);
-                if (da > 1.0) da = 1.0;
-                score += mWeightAmplitude * da;
-
-                // Features 1-6: Affinity, Sharpness, Harmonicity, Monotony, MeanAffinity, MeanContrast
-                const double weights[6] = {
-                  mWeightAffinity, mWeightSharpness, mWeightHarmonicity,
-                  mWeightMonotony, mWeightMeanAffinity, mWeightMeanContrast
-                };
-
-                for (int f = 1; f < 7; ++f)
-                {
-                  double diff = std::abs(inFeatures[ch][f] - bFeatures[f]);
-                  // Normalize by a reasonable range (features are already mostly normalized)
-                  score += weights[f-1] * std::min(1.0, diff);
-                }
-
-                if (score < bestScore)
-                {
-                  bestScore = score;
-                  bestChunk = bi;
-                  bestSrcCh = bch;
-                }
-              }
-            }
-
-            if (bestChunk >= 0)
-            {
-              foundAnyMatch = true;
-              const BrainChunk* match = mBrain->GetChunkByGlobalIndex(bestChunk);
-              std::vector<int> src = { bestSrcCh };
-              std::vector<int> dst = { ch };
-              CopyBrainChannelsToOutput(match, chunkSize, numChannels, *out, src, dst);
-            }
-            else
-            {
-              // No match found for this channel - output silence
-              for (int i = 0; i < chunkSize; ++i)
-                out->channelSamples[ch][i] = 0.0;
-            }
-          }
-
-          // Commit output chunk (RMS calculated automatically)
-          chunker.CommitOutputChunk(idx, chunkSize);
-        }
-        else
-        {
-          // Average-based: pick one brain chunk, copy its channels
-          int bestIdx = -1;
-          double bestScore = 1e9;
-          const int total = mBrain->GetTotalChunks();
-
-          for (int bi = 0; bi < total; ++bi)
-          {
-            const BrainChunk* bc = mBrain->GetChunkByGlobalIndex(bi);
-            if (!bc) continue;
-
-            const auto& bFeatures = bc->avgExtendedFeatures;
-            if (bFeatures.size() < 7) continue;
-
-            // Compute weighted distance using average features
-            double score = 0.0;
-
-            // FFT Dominant Frequency
-            double dFft = std::abs(inFftDominantHzAvg - bc->avgFftDominantHz) / nyquist;
-            score += mWeightFftFrequency * dFft;
-
-            // Feature 0: Fundamental Frequency (f0)
-            double df0 = std::abs(inFeaturesAvg[0] - bFeatures[0]) / nyquist;
-            score += mWeightFundFrequency * df0;
-
-            // Amplitude
-            double da = std::abs(in->rms - (double)bc->avgRms);
-            if (da > 1.0) da = 1.0;
-            score += mWeightAmplitude * da;
-
-            // Features 1-6
-            const double weights[6] = {
-              mWeightAffinity, mWeightSharpness, mWeightHarmonicity,
-              mWeightMonotony, mWeightMeanAffinity, mWeightMeanContrast
-            };
-
-            for (int f = 1; f < 7; ++f)
-            {
-              double diff = std::abs(inFeaturesAvg[f] - bFeatures[f]);
-              score += weights[f-1] * std::min(1.0, diff);
-            }
-
-            if (score < bestScore)
-            {
-              bestScore = score;
-              bestIdx = bi;
-            }
-          }
-
-          if (bestIdx < 0)
-          {
-            // No match found - output silence
-            for (int ch = 0; ch < numChannels; ++ch)
-              for (int i = 0; i < chunkSize; ++i)
-                out->channelSamples[ch][i] = 0.0;
-            chunker.CommitOutputChunk(idx, chunkSize);
-            continue;
-          }
-
-          const BrainChunk* match = mBrain->GetChunkByGlobalIndex(bestIdx);
-          if (!match)
-          {
-            // No match found - output silence
-            for (int ch = 0; ch < numChannels; ++ch)
-              for (int i = 0; i < chunkSize; ++i)
-                out->channelSamples[ch][i] = 0.0;
-            chunker.CommitOutputChunk(idx, chunkSize);
-            continue;
-          }
-
-          CopyBrainChannelsToOutput(match, chunkSize, numChannels, *out);
-          chunker.CommitOutputChunk(idx, std::min(chunkSize, match->audio.numFrames));
-        }
-      }
-    }
-
     // Exposed parameters implementation
     void GetParamDescs(std::vector<ExposedParamDesc>& out, bool /*includeAll*/) const override
     {
@@ -337,7 +86,123 @@ namespace synaptic
       }
     }
 
-    bool GetParamAsNumber(const std::string& id, double& out) const override
+  protected:
+    void AnalyzeInput(const AudioChunk& in, int numChannels) override
+    {
+      // Analyze input chunk using precomputed spectra and FeatureAnalysis
+      const double nyquist = 0.5 * mSampleRate;
+      mInRms = in.rms;
+      if ((int) mInFeatures.size() != numChannels)
+        mInFeatures.assign(numChannels, std::vector<float>(7, 0.0f));
+      for (auto& f : mInFeatures)
+        std::fill(f.begin(), f.end(), 0.0f);
+      mInFeaturesAvg.assign(7, 0.0f);
+      mInFftDominantHz.assign(numChannels, 0.0);
+      mInFftDominantHzAvg = 0.0;
+
+      if (in.fftSize > 0)
+      {
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+          if (ch >= (int)in.complexSpectrum.size() || in.complexSpectrum[ch].empty())
+            continue;
+
+          const float* ordered = in.complexSpectrum[ch].data();
+          // Dominant freq
+          double domHz = FFTProcessor::DominantFreqHzFromOrderedSpectrum(ordered, in.fftSize, mSampleRate);
+          if (domHz < 20.0) domHz = 20.0;
+          if (domHz > nyquist - 20.0) domHz = nyquist - 20.0;
+          mInFftDominantHz[ch] = domHz;
+          mInFftDominantHzAvg += domHz;
+
+          // Extended features from ordered spectrum
+          auto features = FeatureAnalysis::GetFeatures((float*)ordered, in.fftSize, (int)mSampleRate);
+          mInFeatures[ch] = features;
+          for (int f = 0; f < 7; ++f)
+            mInFeaturesAvg[f] += features[f];
+        }
+        for (int f = 0; f < 7; ++f)
+          mInFeaturesAvg[f] /= (numChannels > 0) ? (float)numChannels : 1.0f;
+        mInFftDominantHzAvg /= (numChannels > 0) ? (double)numChannels : 1.0;
+      }
+    }
+
+    double ScoreCandidate(const BrainChunk& bc, int bch, int ch) const override
+    {
+      const double nyquist = 0.5 * mSampleRate;
+
+      // Get brain chunk features for this channel (or the chunk average)
+      const auto& bFeatures = (bch >= 0 && bch < (int)bc.extendedFeaturesPerChannel.size())
+        ? bc.extendedFeaturesPerChannel[bch]
+        : bc.avgExtendedFeatures;
+      if (bFeatures.size() < 7) return std::numeric_limits<double>::infinity();
+
+      const std::vector<float>& inFeatures = (ch >= 0) ? mInFeatures[ch] : mInFeaturesAvg;
+
+      // Compute weighted distance
+      double score = 0.0;
+
+      // FFT Dominant Frequency (like Simple SampleBrain)
+      const double bFftFreq = (bch >= 0 && bch < (int)bc.fftDominantHzPerChannel.size())
+        ? bc.fftDominantHzPerChannel[bch]
+        : bc.avgFftDominantHz;
+      const double inFftFreq = (ch >= 0) ? mInFftDominantHz[ch] : mInFftDominantHzAvg;
+      double dFft = std::abs(inFftFreq - bFftFreq) / nyquist;
+      score += mWeightFftFrequency * dFft;
+
+      // Feature 0: Fundamental Frequency (f0 from Harmonic Product Spectrum)
+      double df0 = std::abs(inFeatures[0] - bFeatures[0]) / nyquist;
+      score += mWeightFundFrequency * df0;
+
+      // Amplitude (use RMS)
+      const double br = (bch >= 0 && bch < (int) bc.rmsPerChannel.size()) ? (double) bc.rmsPerChannel[bch] : (double) bc.avgRms;
+      double da = std::abs(mInRms - br);
+      if (da > 1.0) da = 1.0;
+      score += mWeightAmplitude * da;
+
+      // Features 1-6: Affinity, Sharpness, Harmonicity, Monotony, MeanAffinity, MeanContrast
+      const double weights[6] = {
+        mWeightAffinity, mWeightSharpness, mWeightHarmonicity,
+        mWeightMonotony, mWeightMeanAffinity, mWeightMeanContrast
+      };
+
+      for (int f = 1; f < 7; ++f)
+      {
+        double diff = std::abs(inFeatures[f] - bFeatures[f]);
+        // Normalize by a reasonable range (features are already mostly normalized)
+        score += weights[f-1] * std::min(1.0, diff);
+      }
+
+      return score;
+    }
+
+    bool BuildMatchKey(int ch, MatchKey& key) const override
+    {
+      const std::vector<float>& inFeatures = (ch >= 0) ? mInFeatures[ch] : mInFeaturesAvg;
+      if (inFeatures.size() < 7) return false;
+
+      // Only features with a non-zero weight affect the score
+      if (mWeightFftFrequency > 0.0)
+      {
+        const double hz = (ch >= 0) ? mInFftDominantHz[ch] : mInFftDominantHzAvg;
+        key.AddQuantized(std::log2(std::max(1.0, hz)), 48.0); // quarter semitones
+      }
+      if (mWeightFundFrequency > 0.0)
+        key.AddQuantized(std::log2(std::max(1.0, (double) inFeatures[0])), 48.0);
+      if (mWeightAmplitude > 0.0)
+        key.AddQuantized(20.0 * std::log10(std::max(1e-6, mInRms)), 2.0); // 0.5 dB
+
+      const double weights[6] = {
+        mWeightAffinity, mWeightSharpness, mWeightHarmonicity,
+        mWeightMonotony, mWeightMeanAffinity, mWeightMeanContrast
+      };
+      for (int f = 1; f < 7; ++f)
+        if (weights[f-1] > 0.0)
+          key.AddQuantized(inFeatures[f], 64.0);
+      return true;
+    }
+
+    bool GetDerivedParamAsNumber(const std::string& id, double& out) const override
     {
       if (id == "weightFftFrequency") { out = mWeightFftFrequency; return true; }
       if (id == "weightFundFrequency") { out = mWeightFundFrequency; return true; }
@@ -351,25 +216,49 @@ namespace synaptic
       return false;
     }
 
-  protected:
     // No derived bool/string params in this transformer
-    // (base class handles inputWindow and channelIndependent)
+    // (base class handles channelIndependent and the continuity params)
+
+    bool SetDerivedParamFromNumber(const std::string& id, double v) override
+    {
+      if (id == "weightFftFrequency") return SetDerivedParamSlot(kSlotWeightFftFrequency, v);
+      if (id == "weightFundFrequency") return SetDerivedParamSlot(kSlotWeightFundFrequency, v);
+      if (id == "weightAmplitude") return SetDerivedParamSlot(kSlotWeightAmplitude, v);
+      if (id == "weightAffinity") return SetDerivedParamSlot(kSlotWeightAffinity, v);
+      if (id == "weightSharpness") return SetDerivedParamSlot(kSlotWeightSharpness, v);
+      if (id == "weightHarmonicity") return SetDerivedParamSlot(kSlotWeightHarmonicity, v);
+      if (id == "weightMonotony") return SetDerivedParamSlot(kSlotWeightMonotony, v);
+      if (id == "weightMeanAffinity") return SetDerivedParamSlot(kSlotWeightMeanAffinity, v);
+      if (id == "weightMeanContrast") return SetDerivedParamSlot(kSlotWeightMeanContrast, v);
+      return false;
+    }
 
-    bool SetParamFromNumber(const std::string& id, double v) override
+    bool SetDerivedParamSlot(int slot, double value) override
     {
-      if (id == "weightFftFrequency") { mWeightFftFrequency = v; return true; }
-      if (id == "weightFundFrequency") { mWeightFundFrequency = v; return true; }
-      if (id == "weightAmplitude") { mWeightAmplitude = v; return true; }
-      if (id == "weightAffinity") { mWeightAffinity = v; return true; }
-      if (id == "weightSharpness") { mWeightSharpness = v; return true; }
-      if (id == "weightHarmonicity") { mWeightHarmonicity = v; return true; }
-      if (id == "weightMonotony") { mWeightMonotony = v; return true; }
-      if (id == "weightMeanAffinity") { mWeightMeanAffinity = v; return true; }
-      if (id == "weightMeanContrast") { mWeightMeanContrast = v; return true; }
+      switch (slot)
+      {
+        case kSlotWeightFftFrequency: mWeightFftFrequency = value; return true;
+        case kSlotWeightFundFrequency: mWeightFundFrequency = value; return true;
+        case kSlotWeightAmplitude: mWeightAmplitude = value; return true;
+        case kSlotWeightAffinity: mWeightAffinity = value; return true;
+        case kSlotWeightSharpness: mWeightSharpness = value; return true;
+        case kSlotWeightHarmonicity: mWeightHarmonicity = value; return true;
+        case kSlotWeightMonotony: mWeightMonotony = value; return true;
+        case kSlotWeightMeanAffinity: mWeightMeanAffinity = value; return true;
+        case kSlotWeightMeanContrast: mWeightMeanContrast = value; return true;
+      }
       return false;
     }
 
   private:
+    // In GetParamDescs order, after the common params
+    enum DerivedSlot
+    {
+      kSlotWeightFftFrequency, kSlotWeightFundFrequency, kSlotWeightAmplitude,
+      kSlotWeightAffinity, kSlotWeightSharpness, kSlotWeightHarmonicity,
+      kSlotWeightMonotony, kSlotWeightMeanAffinity, kSlotWeightMeanContrast
+    };
+
     double mWeightFftFrequency = 1.0;       // FFT dominant frequency (like Simple SampleBrain)
     double mWeightFundFrequency = 0.0;      // Fundamental frequency (f0 from Harmonic Product Spectrum)
     double mWeightAmplitude = 1.0;
@@ -379,6 +268,13 @@ namespace synaptic
     double mWeightMonotony = 0.0;
     double mWeightMeanAffinity = 0.0;
     double mWeightMeanContrast = 0.0;
+
+    // Features of the input chunk currently being matched
+    double mInRms = 0.0;
+    std::vector<std::vector<float>> mInFeatures;
+    std::vector<float> mInFeaturesAvg;
+    std::vector<double> mInFftDominantHz;
+    double mInFftDominantHzAvg = 0.0;
   };
 }
 
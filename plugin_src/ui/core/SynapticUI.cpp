@@ -107,6 +107,18 @@ void SynapticUI::rebuild()
   mBrainStatusControl = nullptr;
   mBrainDropControl = nullptr;
   mCreateNewBrainButton = nullptr;
+  mResumeImportButton = nullptr;
+  mFFTPlanInfoControl = nullptr;
+  mMatchCacheInfoControl = nullptr;
+  mBrainLayerToggles.clear();
+  mBrainLayerInfoControl = nullptr;
+  mAdaptiveChunkingToggle = nullptr;
+  mAnalysisCacheToggle = nullptr;
+#if SYNAPTIC_PROFILE
+  mProfilerRowControls.clear();
+#endif
+  mReplayStatusControl = nullptr;
+  mReplayPathControl = nullptr;
   mProgressOverlay = nullptr;
   mTransformerCardPanel = nullptr;
   mMorphCardPanel = nullptr;
@@ -514,6 +526,83 @@ void SynapticUI::setCompactModeToggle(IVToggleControl* ctrl)
   mCompactModeToggle = ctrl;
 }
 
+void SynapticUI::updateResumableImport(int fileCount)
+{
+#if IPLUG_EDITOR
+  if (!mResumeImportButton) return;
+  const std::string label = fileCount > 0 ? "Resume Import (" + std::to_string(fileCount) + ")" : "Resume Import";
+  mResumeImportButton->SetLabelStr(label.c_str());
+  mResumeImportButton->SetDisabled(fileCount <= 0);
+  mResumeImportButton->SetDirty(false);
+#endif
+}
+
+void SynapticUI::updateFFTPlanInfo(const std::string& text)
+{
+#if IPLUG_EDITOR
+  if (mFFTPlanInfoControl)
+  {
+    mFFTPlanInfoControl->SetStr(text.c_str());
+    mFFTPlanInfoControl->SetDirty(false);
+  }
+#endif
+}
+
+void SynapticUI::updateMatchCacheInfo(const std::string& text)
+{
+#if IPLUG_EDITOR
+  if (mMatchCacheInfoControl && std::string(mMatchCacheInfoControl->GetStr()) != text)
+  {
+    mMatchCacheInfoControl->SetStr(text.c_str());
+    mMatchCacheInfoControl->SetDirty(false);
+  }
+#endif
+}
+
+void SynapticUI::updateBrainLayerInfo(const std::string& text)
+{
+#if IPLUG_EDITOR
+  if (mBrainLayerInfoControl && std::string(mBrainLayerInfoControl->GetStr()) != text)
+  {
+    mBrainLayerInfoControl->SetStr(text.c_str());
+    mBrainLayerInfoControl->SetDirty(false);
+  }
+#endif
+}
+
+#if SYNAPTIC_PROFILE
+void SynapticUI::updateProfilerRows(const std::vector<std::string>& rows)
+{
+#if IPLUG_EDITOR
+  for (size_t i = 0; i < mProfilerRowControls.size(); ++i)
+  {
+    const std::string text = i < rows.size() ? rows[i] : std::string();
+    if (mProfilerRowControls[i] && std::string(mProfilerRowControls[i]->GetStr()) != text)
+    {
+      mProfilerRowControls[i]->SetStr(text.c_str());
+      mProfilerRowControls[i]->SetDirty(false);
+    }
+  }
+#endif
+}
+#endif
+
+void SynapticUI::updateReplayCaptureInfo(const std::string& status, const std::string& path)
+{
+#if IPLUG_EDITOR
+  if (mReplayStatusControl && std::string(mReplayStatusControl->GetStr()) != status)
+  {
+    mReplayStatusControl->SetStr(status.c_str());
+    mReplayStatusControl->SetDirty(false);
+  }
+  if (mReplayPathControl && std::string(mReplayPathControl->GetStr()) != path)
+  {
+    mReplayPathControl->SetStr(path.c_str());
+    mReplayPathControl->SetDirty(false);
+  }
+#endif
+}
+
 void SynapticUI::updateBrainFileList(const std::vector<BrainFileEntry>& files)
 {
 #if IPLUG_EDITOR
@@ -529,7 +618,7 @@ void SynapticUI::updateBrainFileList(const std::vector<BrainFileEntry>& files)
 #endif
 }
 
-void SynapticUI::updateBrainState(bool useExternal, const std::string& externalPath)
+void SynapticUI::updateBrainState(bool useExternal, const std::string& externalPath, bool externalChanged)
 {
 #if IPLUG_EDITOR
   mHasBrainLoaded = useExternal;
@@ -542,7 +631,7 @@ void SynapticUI::updateBrainState(bool useExternal, const std::string& externalP
       std::string filename = (lastSlash != std::string::npos)
         ? externalPath.substr(lastSlash + 1)
         : externalPath;
-      mBrainStatusControl->SetStorageMode(filename);
+      mBrainStatusControl->SetStorageMode(externalChanged ? filename + " (changed since project save)" : filename);
     }
     else
     {
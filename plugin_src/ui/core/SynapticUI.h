@@ -23,6 +23,7 @@
 #include "../styles/UIStyles.h"
 #include "../layout/UILayout.h"
 #include "../controls/UIControls.h"
+#include "../../audio/StageProfiler.h"
 #include "../dynamic/DynamicParamManager.h"
 
 namespace synaptic {
@@ -92,10 +93,30 @@ public:
   void setBrainStatusControl(class BrainStatusControl* ctrl);
   void setBrainDropControl(class BrainFileDropControl* ctrl);
   void setCreateNewBrainButton(ig::IControl* ctrl);
+  void setResumeImportButton(ig::IVButtonControl* ctrl) { mResumeImportButton = ctrl; }
+  void updateResumableImport(int fileCount);
   void setCompactModeToggle(ig::IVToggleControl* ctrl);
+  void setFFTPlanInfoControl(ig::ITextControl* ctrl) { mFFTPlanInfoControl = ctrl; }
+  void updateFFTPlanInfo(const std::string& text);
+  void setMatchCacheInfoControl(ig::ITextControl* ctrl) { mMatchCacheInfoControl = ctrl; }
+  void updateMatchCacheInfo(const std::string& text);
+  void setBrainLayerToggles(const std::vector<ig::IVToggleControl*>& toggles) { mBrainLayerToggles = toggles; }
+  const std::vector<ig::IVToggleControl*>& getBrainLayerToggles() const { return mBrainLayerToggles; }
+  void setBrainLayerInfoControl(ig::ITextControl* ctrl) { mBrainLayerInfoControl = ctrl; }
+  void updateBrainLayerInfo(const std::string& text);
+  void setAdaptiveChunkingToggle(ig::IVToggleControl* ctrl) { mAdaptiveChunkingToggle = ctrl; }
+  ig::IVToggleControl* getAdaptiveChunkingToggle() const { return mAdaptiveChunkingToggle; }
+  void setAnalysisCacheToggle(ig::IVToggleControl* ctrl) { mAnalysisCacheToggle = ctrl; }
+  ig::IVToggleControl* getAnalysisCacheToggle() const { return mAnalysisCacheToggle; }
+#if SYNAPTIC_PROFILE
+  void setProfilerRowControls(const std::vector<ig::ITextControl*>& rows) { mProfilerRowControls = rows; }
+  void updateProfilerRows(const std::vector<std::string>& rows);
+#endif
+  void setReplayCaptureInfoControls(ig::ITextControl* status, ig::ITextControl* path) { mReplayStatusControl = status; mReplayPathControl = path; }
+  void updateReplayCaptureInfo(const std::string& status, const std::string& path);
   ig::IVToggleControl* getCompactModeToggle() const { return mCompactModeToggle; }
   void updateBrainFileList(const std::vector<struct BrainFileEntry>& files);
-  void updateBrainState(bool useExternal, const std::string& externalPath);
+  void updateBrainState(bool useExternal, const std::string& externalPath, bool externalChanged = false);
 
   // Progress overlay management
   void ShowProgressOverlay(const std::string& title, const std::string& message, float progress = 0.0f, bool showCancelButton = true);
@@ -146,7 +167,19 @@ private:
   class BrainStatusControl* mBrainStatusControl { nullptr };
   class BrainFileDropControl* mBrainDropControl { nullptr };
   ig::IControl* mCreateNewBrainButton { nullptr };
+  ig::IVButtonControl* mResumeImportButton { nullptr };
   ig::IVToggleControl* mCompactModeToggle { nullptr };
+  ig::ITextControl* mFFTPlanInfoControl { nullptr };
+  ig::ITextControl* mMatchCacheInfoControl { nullptr };
+  std::vector<ig::IVToggleControl*> mBrainLayerToggles;
+  ig::ITextControl* mBrainLayerInfoControl { nullptr };
+  ig::IVToggleControl* mAdaptiveChunkingToggle { nullptr };
+  ig::IVToggleControl* mAnalysisCacheToggle { nullptr };
+#if SYNAPTIC_PROFILE
+  std::vector<ig::ITextControl*> mProfilerRowControls;
+#endif
+  ig::ITextControl* mReplayStatusControl { nullptr };
+  ig::ITextControl* mReplayPathControl { nullptr };
   bool mHasBrainLoaded { false };
 
   class ProgressOverlay* mProgressOverlay { nullptr };
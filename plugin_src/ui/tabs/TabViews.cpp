@@ -17,6 +17,7 @@
 #include "../layout/UILayout.h"
 #include "SynapticResynthesis.h"
 #include "plugin_src/ui_bridge/MessageTags.h"
+#include "plugin_src/audio/StageProfiler.h"
 
 using namespace iplug;
 using namespace igraphics;
@@ -71,6 +72,12 @@ void BuildDSPTab(SynapticUI& ui, const IRECT& bounds, const UILayout& layout, fl
     algoControl->SetTooltip("Select the algorithm used to transform audio chunks (typically by replacing chunks from Brain, like Samplebrain transformers.)");
     ui.attach(algoControl, ControlGroup::DSP);
 
+    // Match cache hit rate for SampleBrain transformers (filled in by UISyncManager)
+    auto* cacheInfo = new ITextControl(IRECT(transformerRow.R + 8.f, transformerRow.T, transformerCard.R - layout.cardPadding, transformerRow.B), "", kSmallText);
+    cacheInfo->SetTooltip("Share of input chunks whose brain search result was reused from the match cache, and the total number of searches.");
+    ui.attach(cacheInfo, ControlGroup::DSP);
+    ui.setMatchCacheInfoControl(cacheInfo);
+
     // Reserve space for dynamic transformer parameters below dropdown
     IRECT transformerParamBounds = IRECT(
       transformerCard.L + layout.cardPadding,
@@ -283,6 +290,65 @@ void BuildDSPTab(SynapticUI& ui, const IRECT& bounds, const UILayout& layout, fl
 
     colY[col] = audioCard.B + layout.sectionGap;
   }
+
+#if SYNAPTIC_PROFILE
+  // AUDIO THREAD PROFILE CARD (rows filled in by UISyncManager)
+  {
+    const int numRows = StageProfileStats::kNumRows + 1; // + summary line
+    const float rowH = 18.f;
+    const float cardH = layout.cardPadding * 2.f + 24.f + numRows * rowH;
+    const int col = nextCol();
+    IRECT profileCard = columnRect(col, colY[col], cardH);
+    ui.attach(new CardPanel(profileCard, "AUDIO THREAD PROFILE"), ControlGroup::DSP);
+
+    std::vector<ITextControl*> rows;
+    float rowY = profileCard.T + layout.cardPadding + 24.f;
+    for (int i = 0; i < numRows; ++i, rowY += rowH)
+    {
+      auto* row = new ITextControl(IRECT(profileCard.L + layout.cardPadding, rowY, profileCard.R - layout.cardPadding, rowY + rowH), "", kSmallText);
+      ui.attach(row, ControlGroup::DSP);
+      rows.push_back(row);
+    }
+    ui.setProfilerRowControls(rows);
+
+    colY[col] = profileCard.B + layout.sectionGap;
+  }
+#endif
+
+  // SESSION REPLAY CARD (status filled in by UISyncManager)
+  {
+    const float btnWidth = 200.f;
+    const float btnHeight = 45.f;
+    const float rowH = 18.f;
+    const float cardH = layout.cardPadding * 2.f + 32.f + btnHeight + 8.f + 2 * rowH;
+    const int col = nextCol();
+    IRECT replayCard = columnRect(col, colY[col], cardH);
+    ui.attach(new CardPanel(replayCard, "SESSION REPLAY"), ControlGroup::DSP);
+
+    const float btnX = replayCard.L + (replayCard.W() - btnWidth) / 2.f;
+    float rowY = replayCard.T + layout.cardPadding + 32.f;
+    IRECT recordBtnRect = IRECT(btnX, rowY, btnX + btnWidth, rowY + btnHeight);
+    auto* recordBtn = new IVButtonControl(recordBtnRect, [](IControl* pCaller) {
+      auto* pGraphics = pCaller->GetUI();
+      auto* pDelegate = dynamic_cast<iplug::IEditorDelegate*>(pGraphics->GetDelegate());
+      if (pDelegate) {
+        pDelegate->SendArbitraryMsgFromUI(synaptic::kMsgTagToggleReplayCapture, kNoTag, 0, nullptr);
+      }
+    }, "Record / Stop", kButtonStyle);
+    recordBtn->SetTooltip("Record the input audio and parameter changes (with a copy of the brain) to a replay file, for reproducing a problem offline");
+    ui.attach(recordBtn, ControlGroup::DSP);
+    rowY += btnHeight + 8.f;
+
+    const float textL = replayCard.L + layout.cardPadding;
+    const float textR = replayCard.R - layout.cardPadding;
+    auto* statusText = new ITextControl(IRECT(textL, rowY, textR, rowY + rowH), "", kSmallText);
+    ui.attach(statusText, ControlGroup::DSP);
+    auto* pathText = new ITextControl(IRECT(textL, rowY + rowH, textR, rowY + 2 * rowH), "", kSmallText);
+    ui.attach(pathText, ControlGroup::DSP);
+    ui.setReplayCaptureInfoControls(statusText, pathText);
+
+    colY[col] = replayCard.B + layout.sectionGap;
+  }
 }
 
 void BuildBrainTab(SynapticUI& ui, const IRECT& bounds, const UILayout& layout, float startY)
@@ -369,7 +435,7 @@ void BuildBrainTab(SynapticUI& ui, const IRECT& bounds, const UILayout& layout,
 
   // BRAIN ANALYSIS CARD
   {
-    const float cardH = 175.f; // Increased by 10px for bottom padding
+    const float cardH = 332.f; // Includes the layers row, its readout, adaptive chunking and the analysis cache
     const int col = nextCol();
     IRECT analysisCard = columnRect(col, colY[col], cardH);
     ui.attach(new CardPanel(analysisCard, "BRAIN ANALYSIS"), ControlGroup::Brain);
@@ -394,6 +460,12 @@ void BuildBrainTab(SynapticUI& ui, const IRECT& bounds, const UILayout& layout,
     chunkSizeControl->SetTooltip("Number of audio samples in each chunk, in Brain AND processing. Larger chunks are quicker, but the resynthesized sound is less granular. Changing this triggers rechunking.");
     ui.attach(chunkSizeControl, ControlGroup::Brain);
 
+    // FFT size the planner picked for this chunk size (filled in by UISyncManager)
+    auto* fftInfo = new ITextControl(chunkSizeRow.GetReducedFromLeft(labelWidth + controlWidth + 16.f), "", kSmallText);
+    fftInfo->SetTooltip("Transform size used for spectral processing and analysis, and how much zero-padding it adds to each chunk. Chunk sizes with little padding waste less CPU.");
+    ui.attach(fftInfo, ControlGroup::Brain);
+    ui.setFFTPlanInfoControl(fftInfo);
+
     rowY += layout.controlHeight + 10.f;
 
     // Analysis Window with lock
@@ -437,6 +509,92 @@ void BuildBrainTab(SynapticUI& ui, const IRECT& bounds, const UILayout& layout,
     analysisLockButton->SetTooltip("Lock/unlock synchronization between Output Window and Analysis Window");
     ui.attach(analysisLockButton, ControlGroup::Brain);
 
+    rowY += layout.controlHeight + 10.f;
+
+    // Layers - chunk sizes the brain keeps analyzed in the background, for instant switching
+    IRECT layersRow = IRECT(analysisCard.L + layout.cardPadding, rowY, analysisCard.R - layout.cardPadding, rowY + layout.controlHeight);
+    ui.attach(new ITextControl(layersRow.GetFromLeft(labelWidth), "Layers", kLabelText), ControlGroup::Brain);
+
+    const int numLayers = (int) (sizeof(synaptic::BrainManager::kLayerPresetSizes) / sizeof(int));
+    const IRECT layerToggles = layersRow.GetReducedFromLeft(labelWidth + 8.f);
+    std::vector<IVToggleControl*> layerControls;
+    for (int i = 0; i < numLayers; ++i)
+    {
+      const int layerSize = synaptic::BrainManager::kLayerPresetSizes[i];
+      const std::string name = layerSize >= 1024 ? std::to_string(layerSize / 1024) + "K" : std::to_string(layerSize);
+      auto* layerToggle = new IVToggleControl(
+        layerToggles.SubRectHorizontal(numLayers, i).GetPadded(-2.f),
+        [layerSize](IControl* pCaller) {
+          auto* pGraphics = pCaller->GetUI();
+          auto* pDelegate = dynamic_cast<iplug::IEditorDelegate*>(pGraphics->GetDelegate());
+          if (pDelegate) {
+            const int tag = pCaller->GetValue() > 0.5 ? layerSize : -layerSize;
+            pDelegate->SendArbitraryMsgFromUI(synaptic::kMsgTagBrainSetLayer, tag, 0, nullptr);
+          }
+        },
+        "",
+        kSynapticStyle,
+        name.c_str(),
+        name.c_str()
+      );
+      layerToggle->SetTooltip("Keep the brain chunked and analyzed at this chunk size as well, so switching Chunk Size to it is instant instead of triggering rechunking. Each layer costs memory (see below) and is not saved in brain files.");
+      ui.attach(layerToggle, ControlGroup::Brain);
+      layerControls.push_back(layerToggle);
+    }
+    ui.setBrainLayerToggles(layerControls);
+
+    rowY += layout.controlHeight + 6.f;
+
+    // Per-layer readiness and memory (filled in by UISyncManager)
+    auto* layerInfo = new ITextControl(IRECT(analysisCard.L + layout.cardPadding, rowY, analysisCard.R - layout.cardPadding, rowY + 16.f), "", kSmallText);
+    layerInfo->SetTooltip("Memory used by the active chunking (*) and each layer; layers still being analyzed show how many files are ready.");
+    ui.attach(layerInfo, ControlGroup::Brain);
+    ui.setBrainLayerInfoControl(layerInfo);
+
+    rowY += 16.f + 6.f;
+
+    // Adaptive chunk size - plays percussive passages at a shorter ready layer
+    IRECT adaptiveRow = IRECT(analysisCard.L + layout.cardPadding, rowY, analysisCard.R - layout.cardPadding, rowY + layout.controlHeight);
+    ui.attach(new ITextControl(adaptiveRow.GetFromLeft(labelWidth), "Adaptive Chunk Size", kLabelText), ControlGroup::Brain);
+    auto* adaptiveToggle = new IVToggleControl(
+      adaptiveRow.GetFromLeft(controlWidth).GetTranslated(labelWidth + 8.f, 0.f),
+      [](IControl* pCaller) {
+        auto* pGraphics = pCaller->GetUI();
+        auto* pDelegate = dynamic_cast<iplug::IEditorDelegate*>(pGraphics->GetDelegate());
+        if (pDelegate)
+          pDelegate->SendArbitraryMsgFromUI(synaptic::kMsgTagBrainSetAdaptiveChunking, pCaller->GetValue() > 0.5 ? 1 : 0, 0, nullptr);
+      },
+      "",
+      kSynapticStyle,
+      "OFF",
+      "ON"
+    );
+    adaptiveToggle->SetTooltip("Switch to the largest ready layer of at most half the Chunk Size while the input is percussive (many onsets), and back for sustained material. Needs such a layer; latency stays that of the Chunk Size.");
+    ui.attach(adaptiveToggle, ControlGroup::Brain);
+    ui.setAdaptiveChunkingToggle(adaptiveToggle);
+
+    rowY += layout.controlHeight + 6.f;
+
+    // Analysis cache - keeps compact brains' analysis on disk between loads
+    IRECT cacheRow = IRECT(analysisCard.L + layout.cardPadding, rowY, analysisCard.R - layout.cardPadding, rowY + layout.controlHeight);
+    ui.attach(new ITextControl(cacheRow.GetFromLeft(labelWidth), "Analysis Cache", kLabelText), ControlGroup::Brain);
+    auto* cacheToggle = new IVToggleControl(
+      cacheRow.GetFromLeft(controlWidth).GetTranslated(labelWidth + 8.f, 0.f),
+      [](IControl* pCaller) {
+        auto* pGraphics = pCaller->GetUI();
+        auto* pDelegate = dynamic_cast<iplug::IEditorDelegate*>(pGraphics->GetDelegate());
+        if (pDelegate)
+          pDelegate->SendArbitraryMsgFromUI(synaptic::kMsgTagBrainSetAnalysisCache, pCaller->GetValue() > 0.5 ? 1 : 0, 0, nullptr);
+      },
+      "",
+      kSynapticStyle,
+      "OFF",
+      "ON"
+    );
+    cacheToggle->SetTooltip("Keep the analysis of compact brains in this machine's cache folder, so loading or rechunking the same audio again skips the analysis. Uses up to 2 GB of disk; the least recently used entries are deleted first.");
+    ui.attach(cacheToggle, ControlGroup::Brain);
+    ui.setAnalysisCacheToggle(cacheToggle);
+
     colY[col] = analysisCard.B + layout.sectionGap;
   }
 
@@ -490,6 +648,19 @@ void BuildBrainTab(SynapticUI& ui, const IRECT& bounds, const UILayout& layout,
     ejectBtn->SetTooltip("Ejects the current Brain file. This unreferences the external brain file, and clears the loaded brain data.");
     ui.attach(ejectBtn, ControlGroup::Brain);
 
+    IRECT resumeBtnRect = IRECT(btnStartX + btnWidth + btnGapH, btnY, btnStartX + btnWidth + btnGapH + btnWidth, btnY + btnHeight);
+    auto* resumeBtn = new IVButtonControl(resumeBtnRect, [](IControl* pCaller) {
+      auto* pGraphics = pCaller->GetUI();
+      auto* pDelegate = dynamic_cast<iplug::IEditorDelegate*>(pGraphics->GetDelegate());
+      if (pDelegate) {
+        pDelegate->SendArbitraryMsgFromUI(synaptic::kMsgTagBrainResumeImport, kNoTag, 0, nullptr);
+      }
+    }, "Resume Import", kButtonStyle);
+    resumeBtn->SetTooltip("Import the files a cancelled or interrupted import did not get to. Files already imported stay in the brain; for an external brain they are saved to it one by one.");
+    resumeBtn->SetDisabled(true);
+    ui.attach(resumeBtn, ControlGroup::Brain);
+    ui.setResumeImportButton(resumeBtn);
+
     btnY += btnHeight + btnGapV + 4.f;
 
     // Compact Mode toggle
@@ -516,7 +687,7 @@ void BuildBrainTab(SynapticUI& ui, const IRECT& bounds, const UILayout& layout,
       "OFF",
       "ON"
     );
-    compactToggle->SetTooltip("Enable compact storage format for brain files. This reduces file size by around 8x, storing only the file audio themselves (32bit) and some metadata; but this is at the cost of load times, as chunking & analysis must be performed every load.");
+    compactToggle->SetTooltip("Enable compact storage format for brain files. This roughly halves file size, storing only the file audio themselves and some metadata without the analysis data; but this is at the cost of load times, as chunking & analysis must be performed every load.");
     ui.attach(compactToggle, ControlGroup::Brain);
     ui.setCompactModeToggle(compactToggle);
 
@@ -32,6 +32,7 @@ namespace synaptic
     kMsgTagSetOutputWindowMode = MsgTagCategory::kDSP + 2,
     kMsgTagSetAnalysisWindowMode = MsgTagCategory::kDSP + 3,
     kMsgTagTransformerSetParam = MsgTagCategory::kDSP + 4,
+    kMsgTagToggleReplayCapture = MsgTagCategory::kDSP + 5,
 
     // === Brain Management Messages (100-199) ===
     kMsgTagBrainAddFile = MsgTagCategory::kBrain + 0,
@@ -43,6 +44,10 @@ namespace synaptic
     kMsgTagBrainCreateNew = MsgTagCategory::kBrain + 6,
     kMsgTagBrainSetCompactMode = MsgTagCategory::kBrain + 7,
     kMsgTagCancelOperation = MsgTagCategory::kBrain + 8,
+    kMsgTagBrainSetLayer = MsgTagCategory::kBrain + 9, // ctrlTag: +chunk size to keep the layer, -chunk size to drop it
+    kMsgTagBrainResumeImport = MsgTagCategory::kBrain + 10,
+    kMsgTagBrainSetAdaptiveChunking = MsgTagCategory::kBrain + 11, // ctrlTag: 1 on, 0 off
+    kMsgTagBrainSetAnalysisCache = MsgTagCategory::kBrain + 12, // ctrlTag: 1 on, 0 off
 
     // === UI Lifecycle Messages (200-299) ===
     kMsgTagUiReady = MsgTagCategory::kUI + 0,